@@ -20,6 +20,7 @@
  *
  */
 
+#include "common/atomic.h"
 #include "common/util.h"
 #include "common/system.h"
 #include "common/textconsole.h"
@@ -39,10 +40,13 @@ namespace Audio {
 
 /**
  * Channel used by the default Mixer implementation.
+ *
+ * Once a channel is published to the mixer callback, it is only accessed
+ * from there; see MixerImpl.
  */
 class Channel {
 public:
-	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent);
+	Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream, DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int typeVolume);
 	~Channel();
 
 	/**
@@ -62,29 +66,18 @@ public:
 	bool isFinished() const { return _stream->endOfStream(); }
 
 	/**
-	 * Queries whether the channel is a permanent channel.
-	 * A permanent channel is not affected by a Mixer::stopAll
-	 * call.
-	 */
-	bool isPermanent() const { return _permanent; }
-
-	/**
-	 * Returns the id of the channel.
-	 */
-	int getId() const { return _id; }
-
-	/**
-	 * Pauses or unpaused the channel in a recursive fashion.
+	 * Pauses or unpauses the channel. The pause level is tracked by the
+	 * mixer.
 	 *
 	 * @param paused true, when the channel should be paused.
 	 *               false when it should be unpaused.
 	 */
-	void pause(bool paused);
+	void setPaused(bool paused) { _paused = paused; }
 
 	/**
 	 * Queries whether the channel is currently paused.
 	 */
-	bool isPaused() const { return (_pauseLevel != 0); }
+	bool isPaused() const { return _paused; }
 
 	/**
 	 * Sets the channel's own volume.
@@ -93,13 +86,6 @@ public:
 	 */
 	void setVolume(const byte volume);
 
-	/**
-	 * Gets the channel's own volume.
-	 *
-	 * @return volume
-	 */
-	byte getVolume();
-
 	/**
 	 * Sets the channel's balance setting.
 	 *
@@ -107,23 +93,13 @@ public:
 	 */
 	void setBalance(const int8 balance);
 
-	/**
-	 * Gets the channel's balance setting.
-	 *
-	 * @return balance
-	 */
-	int8 getBalance();
-
 	/**
 	 * Notifies the channel that the global sound type
 	 * volume settings changed.
+	 *
+	 * @param volume effective volume of the sound type, 0 if muted
 	 */
-	void notifyGlobalVolChange() { updateChannelVolumes(); }
-
-	/**
-	 * Queries how long the channel has been playing.
-	 */
-	Timestamp getElapsedTime();
+	void setTypeVolume(int volume);
 
 	/**
 	 * Queries the channel's sound type.
@@ -131,37 +107,29 @@ public:
 	Mixer::SoundType getType() const { return _type; }
 
 	/**
-	 * Sets the channel's sound handle.
-	 *
-	 * @param handle new handle
+	 * Queries the number of samples played before the last mix call.
 	 */
-	void setHandle(const SoundHandle handle) { _handle = handle; }
+	uint32 getSamplesConsumed() const { return _samplesConsumed; }
 
 	/**
-	 * Queries the channel's sound handle.
+	 * Queries the time of the last mix call.
 	 */
-	SoundHandle getHandle() const { return _handle; }
+	uint32 getMixerTimeStamp() const { return _mixerTimeStamp; }
 
 private:
 	const Mixer::SoundType _type;
-	SoundHandle _handle;
-	bool _permanent;
-	int _pauseLevel;
-	int _id;
+	bool _paused;
 
 	byte _volume;
 	int8 _balance;
+	int _typeVolume;
 
 	void updateChannelVolumes();
 	st_volume_t _volL, _volR;
 
-	Mixer *_mixer;
-
 	uint32 _samplesConsumed;
 	uint32 _samplesDecoded;
 	uint32 _mixerTimeStamp;
-	uint32 _pauseStartTime;
-	uint32 _pauseTime;
 
 	RateConverter *_converter;
 	Common::DisposablePtr<AudioStream> _stream;
@@ -173,12 +141,31 @@ private:
 
 
 MixerImpl::MixerImpl(OSystem *system, uint sampleRate)
-	: _syst(system), _mutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings() {
+	: _syst(system), _mutex(), _mixMutex(), _sampleRate(sampleRate), _mixerReady(false), _handleSeed(0), _soundTypeSettings(),
+	  _mixingChannel(0), _stoppedChannel(0), _typeVolumesChanged(0) {
 
 	assert(sampleRate > 0);
 
-	for (int i = 0; i != NUM_CHANNELS; i++)
+	for (int i = 0; i != NUM_CHANNELS; i++) {
 		_channels[i] = 0;
+		_handles[i] = 0;
+		_channelInfo[i].id = -1;
+		_channelInfo[i].type = kPlainSoundType;
+		_channelInfo[i].permanent = false;
+		_channelInfo[i].volume = kMaxChannelVolume;
+		_channelInfo[i].balance = 0;
+		_channelInfo[i].pauseLevel = 0;
+		_channelInfo[i].pauseStartTime = 0;
+		_channelInfo[i].pauseEndTime = 0;
+		_channelInfo[i].pauseTime = 0;
+		_channelTiming[i].sequence = 0;
+		_channelTiming[i].samplesConsumed = 0;
+		_channelTiming[i].mixerTimeStamp = 0;
+		_channelSettings[i].changed = 0;
+	}
+
+	for (int i = 0; i != ARRAYSIZE(_typeVolumes); i++)
+		_typeVolumes[i] = getTypeVolume((SoundType)i);
 }
 
 MixerImpl::~MixerImpl() {
@@ -194,10 +181,102 @@ uint MixerImpl::getOutputRate() const {
 	return _sampleRate;
 }
 
-void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
+int MixerImpl::getTypeVolume(SoundType type) const {
+	return _soundTypeSettings[type].mute ? 0 : _soundTypeSettings[type].volume;
+}
+
+int MixerImpl::findChannel(SoundHandle handle) const {
+	const int index = handle._val % NUM_CHANNELS;
+	if (!Common::atomicLoad(&_channels[index]) || _handles[index] != handle._val)
+		return -1;
+	return index;
+}
+
+Channel *MixerImpl::detachChannel(int index) {
+	Channel *chan = Common::atomicLoad(&_channels[index]);
+	if (!chan || !Common::atomicCompareAndSwap(&_channels[index], chan, (Channel *)0))
+		return 0;
+
+	// The mixer callback may have picked up the channel just before it was
+	// detached. The caller releases _mutex and passes the channel to
+	// deleteChannel(), which waits for that.
+	return chan;
+}
+
+void MixerImpl::deleteChannel(Channel *chan) {
+	if (!chan)
+		return;
+
+	{
+		Common::StackLock lock(_mixMutex);
+
+		// A stream which stops its own channel from inside the mixer
+		// callback gets here too: the callback deletes the channel once the
+		// stream returns.
+		if (chan == _mixingChannel) {
+			_stoppedChannel = chan;
+			return;
+		}
+	}
+
+	delete chan;
+}
+
+void MixerImpl::pauseChannel(int index, bool paused) {
+	ChannelInfo &info = _channelInfo[index];
+
+	if (paused) {
+		info.pauseLevel++;
+
+		if (info.pauseLevel == 1) {
+			info.pauseStartTime = g_system->getMillis();
+			updateChannelSettings(index);
+		}
+	} else if (info.pauseLevel > 0) {
+		info.pauseLevel--;
+
+		if (!info.pauseLevel) {
+			info.pauseEndTime = g_system->getMillis();
+			info.pauseTime = info.pauseEndTime - info.pauseStartTime;
+			info.pauseStartTime = 0;
+			updateChannelSettings(index);
+		}
+	}
+}
+
+void MixerImpl::updateChannelSettings(int index) {
+	const ChannelInfo &info = _channelInfo[index];
+	ChannelSettings &settings = _channelSettings[index];
+
+	settings.volume = info.volume;
+	settings.balance = info.balance;
+	settings.paused = info.pauseLevel > 0;
+	Common::atomicStore(&settings.changed, 1u);
+}
+
+void MixerImpl::updateTypeVolume(SoundType type) {
+	_typeVolumes[type] = getTypeVolume(type);
+	Common::atomicStore(&_typeVolumesChanged, 1u);
+}
+
+void MixerImpl::applySettings(Channel *chan, int index, bool typeVolumesChanged) {
+	if (typeVolumesChanged)
+		chan->setTypeVolume(Common::atomicLoad(&_typeVolumes[chan->getType()]));
+
+	// Clear the flag first, so a change made while we read the settings is
+	// applied next time
+	ChannelSettings &settings = _channelSettings[index];
+	if (Common::atomicLoad(&settings.changed) && Common::atomicCompareAndSwap(&settings.changed, 1u, 0u)) {
+		chan->setVolume(settings.volume);
+		chan->setBalance(settings.balance);
+		chan->setPaused(settings.paused != 0);
+	}
+}
+
+void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan, int id, byte volume, int8 balance, bool permanent) {
 	int index = -1;
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] == 0) {
+		if (Common::atomicLoad(&_channels[i]) == 0) {
 			index = i;
 			break;
 		}
@@ -208,15 +287,33 @@ void MixerImpl::insertChannel(SoundHandle *handle, Channel *chan) {
 		return;
 	}
 
-	_channels[index] = chan;
+	ChannelInfo &info = _channelInfo[index];
+	info.id = id;
+	info.type = chan->getType();
+	info.permanent = permanent;
+	info.volume = volume;
+	info.balance = balance;
+	info.pauseLevel = 0;
+	info.pauseStartTime = 0;
+	info.pauseEndTime = 0;
+	info.pauseTime = 0;
+
+	_channelTiming[index].samplesConsumed = 0;
+	_channelTiming[index].mixerTimeStamp = 0;
 
 	SoundHandle chanHandle;
 	chanHandle._val = index + (_handleSeed * NUM_CHANNELS);
 
-	chan->setHandle(chanHandle);
+	_handles[index] = chanHandle._val;
 	_handleSeed++;
 	if (handle)
 		*handle = chanHandle;
+
+	// Replace the settings of the slot's previous channel
+	updateChannelSettings(index);
+
+	// Hand the channel over to the mixer callback
+	Common::atomicStore(&_channels[index], chan);
 }
 
 void MixerImpl::playStream(
@@ -240,7 +337,7 @@ void MixerImpl::playStream(
 	// Prevent duplicate sounds
 	if (id != -1) {
 		for (int i = 0; i != NUM_CHANNELS; i++)
-			if (_channels[i] != 0 && _channels[i]->getId() == id) {
+			if (Common::atomicLoad(&_channels[i]) != 0 && _channelInfo[i].id == id) {
 				// Delete the stream if were asked to auto-dispose it.
 				// Note: This could cause trouble if the client code does not
 				// yet expect the stream to be gone. The primary example to
@@ -258,17 +355,15 @@ void MixerImpl::playStream(
 #endif
 
 	// Create the channel
-	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, id, permanent);
+	Channel *chan = new Channel(this, type, stream, autofreeStream, reverseStereo, getTypeVolume(type));
 	chan->setVolume(volume);
 	chan->setBalance(balance);
-	insertChannel(handle, chan);
+	insertChannel(handle, chan, id, volume, balance, permanent);
 }
 
 int MixerImpl::mixCallback(byte *samples, uint len) {
 	assert(samples);
 
-	Common::StackLock lock(_mutex);
-
 	int16 *buf = (int16 *)samples;
 	// we store stereo, 16-bit samples
 	assert(len % 4 == 0);
@@ -280,64 +375,102 @@ int MixerImpl::mixCallback(byte *samples, uint len) {
 	//  zero the buf
 	memset(buf, 0, 2 * len * sizeof(int16));
 
+	Common::StackLock lock(_mixMutex);
+
+	const bool typeVolumesChanged = Common::atomicLoad(&_typeVolumesChanged) &&
+	                                Common::atomicCompareAndSwap(&_typeVolumesChanged, 1u, 0u);
+
 	// mix all channels
 	int res = 0, tmp;
-	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i]) {
-			if (_channels[i]->isFinished()) {
-				delete _channels[i];
-				_channels[i] = 0;
-			} else if (!_channels[i]->isPaused()) {
-				tmp = _channels[i]->mix(buf, len);
-
-				if (tmp > res)
-					res = tmp;
+	for (int i = 0; i != NUM_CHANNELS; i++) {
+		Channel *chan = Common::atomicLoad(&_channels[i]);
+		if (!chan)
+			continue;
+
+		applySettings(chan, i, typeVolumesChanged);
+
+		if (chan->isFinished()) {
+			// Unless a stop call detached the channel in the meantime, it
+			// is ours to delete
+			if (Common::atomicCompareAndSwap(&_channels[i], chan, (Channel *)0))
+				delete chan;
+		} else if (!chan->isPaused()) {
+			_mixingChannel = chan;
+			tmp = chan->mix(buf, len);
+			_mixingChannel = 0;
+
+			if (tmp > res)
+				res = tmp;
+
+			if (_stoppedChannel) {
+				// The stream stopped its own channel
+				delete _stoppedChannel;
+				_stoppedChannel = 0;
+				continue;
 			}
+
+			ChannelTiming &timing = _channelTiming[i];
+			timing.sequence++;
+			Common::memoryBarrier();
+			timing.samplesConsumed = chan->getSamplesConsumed();
+			timing.mixerTimeStamp = chan->getMixerTimeStamp();
+			Common::memoryBarrier();
+			timing.sequence++;
 		}
+	}
 
 	return res;
 }
 
 void MixerImpl::stopAll() {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && !_channels[i]->isPermanent()) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+	Channel *stopped[NUM_CHANNELS];
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			stopped[i] = _channelInfo[i].permanent ? 0 : detachChannel(i);
 	}
+
+	for (int i = 0; i != NUM_CHANNELS; i++)
+		deleteChannel(stopped[i]);
 }
 
 void MixerImpl::stopID(int id) {
-	Common::StackLock lock(_mutex);
-	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			delete _channels[i];
-			_channels[i] = 0;
-		}
+	Channel *stopped[NUM_CHANNELS];
+
+	{
+		Common::StackLock lock(_mutex);
+		for (int i = 0; i != NUM_CHANNELS; i++)
+			stopped[i] = _channelInfo[i].id == id ? detachChannel(i) : 0;
 	}
+
+	for (int i = 0; i != NUM_CHANNELS; i++)
+		deleteChannel(stopped[i]);
 }
 
 void MixerImpl::stopHandle(SoundHandle handle) {
-	Common::StackLock lock(_mutex);
+	Channel *stopped;
 
-	// Simply ignore stop requests for handles of sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return;
+	{
+		Common::StackLock lock(_mutex);
 
-	delete _channels[index];
-	_channels[index] = 0;
+		// Simply ignore stop requests for handles of sounds that already terminated
+		const int index = findChannel(handle);
+		if (index == -1)
+			return;
+
+		stopped = detachChannel(index);
+	}
+
+	deleteChannel(stopped);
 }
 
 void MixerImpl::muteSoundType(SoundType type, bool mute) {
 	assert(0 <= type && type < ARRAYSIZE(_soundTypeSettings));
-	_soundTypeSettings[type].mute = mute;
 
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	Common::StackLock lock(_mutex);
+	_soundTypeSettings[type].mute = mute;
+	updateTypeVolume(type);
 }
 
 bool MixerImpl::isSoundTypeMuted(SoundType type) const {
@@ -348,37 +481,43 @@ bool MixerImpl::isSoundTypeMuted(SoundType type) const {
 void MixerImpl::setChannelVolume(SoundHandle handle, byte volume) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->setVolume(volume);
+	_channelInfo[index].volume = volume;
+	updateChannelSettings(index);
 }
 
 byte MixerImpl::getChannelVolume(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_mutex);
+
+	const int index = findChannel(handle);
+	if (index == -1)
 		return 0;
 
-	return _channels[index]->getVolume();
+	return _channelInfo[index].volume;
 }
 
 void MixerImpl::setChannelBalance(SoundHandle handle, int8 balance) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->setBalance(balance);
+	_channelInfo[index].balance = balance;
+	updateChannelSettings(index);
 }
 
 int8 MixerImpl::getChannelBalance(SoundHandle handle) {
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	Common::StackLock lock(_mutex);
+
+	const int index = findChannel(handle);
+	if (index == -1)
 		return 0;
 
-	return _channels[index]->getBalance();
+	return _channelInfo[index].balance;
 }
 
 uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
@@ -388,18 +527,57 @@ uint32 MixerImpl::getSoundElapsedTime(SoundHandle handle) {
 Timestamp MixerImpl::getElapsedTime(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
 
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
-		return Timestamp(0, _sampleRate);
+	Audio::Timestamp ts(0, _sampleRate);
+
+	const int index = findChannel(handle);
+	if (index == -1)
+		return ts;
+
+	// Take a consistent snapshot of what the mixer callback published
+	const ChannelTiming &timing = _channelTiming[index];
+	uint32 sequence, samplesConsumed, mixerTimeStamp;
+	do {
+		sequence = Common::atomicLoad(&timing.sequence);
+		samplesConsumed = timing.samplesConsumed;
+		mixerTimeStamp = timing.mixerTimeStamp;
+		Common::memoryBarrier();
+	} while ((sequence & 1) || sequence != timing.sequence);
+
+	if (mixerTimeStamp == 0)
+		return ts;
+
+	const ChannelInfo &info = _channelInfo[index];
+	uint32 delta = 0;
+
+	if (info.pauseLevel) {
+		delta = info.pauseStartTime - mixerTimeStamp;
+	} else {
+		delta = g_system->getMillis() - mixerTimeStamp;
+
+		// Only a pause after the last mix call delayed the playback
+		if (info.pauseEndTime >= mixerTimeStamp)
+			delta -= info.pauseTime;
+	}
+
+	// Convert the number of samples into a time duration.
+
+	ts = ts.addFrames(samplesConsumed);
+	ts = ts.addMsecs(delta);
+
+	// In theory it would seem like a good idea to limit the approximation
+	// so that it never exceeds the theoretical upper bound set by
+	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
+	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
+	// isn't invoked at the regular intervals that I first imagined.
 
-	return _channels[index]->getElapsedTime();
+	return ts;
 }
 
 void MixerImpl::pauseAll(bool paused) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0) {
-			_channels[i]->pause(paused);
+		if (Common::atomicLoad(&_channels[i]) != 0) {
+			pauseChannel(i, paused);
 		}
 	}
 }
@@ -407,8 +585,8 @@ void MixerImpl::pauseAll(bool paused) {
 void MixerImpl::pauseID(int id, bool paused) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++) {
-		if (_channels[i] != 0 && _channels[i]->getId() == id) {
-			_channels[i]->pause(paused);
+		if (Common::atomicLoad(&_channels[i]) != 0 && _channelInfo[i].id == id) {
+			pauseChannel(i, paused);
 			return;
 		}
 	}
@@ -418,39 +596,38 @@ void MixerImpl::pauseHandle(SoundHandle handle, bool paused) {
 	Common::StackLock lock(_mutex);
 
 	// Simply ignore (un)pause requests for sounds that already terminated
-	const int index = handle._val % NUM_CHANNELS;
-	if (!_channels[index] || _channels[index]->getHandle()._val != handle._val)
+	const int index = findChannel(handle);
+	if (index == -1)
 		return;
 
-	_channels[index]->pause(paused);
+	pauseChannel(index, paused);
 }
 
 bool MixerImpl::isSoundIDActive(int id) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getId() == id)
+		if (Common::atomicLoad(&_channels[i]) && _channelInfo[i].id == id)
 			return true;
 	return false;
 }
 
 int MixerImpl::getSoundID(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	if (_channels[index] && _channels[index]->getHandle()._val == handle._val)
-		return _channels[index]->getId();
+	const int index = findChannel(handle);
+	if (index != -1)
+		return _channelInfo[index].id;
 	return 0;
 }
 
 bool MixerImpl::isSoundHandleActive(SoundHandle handle) {
 	Common::StackLock lock(_mutex);
-	const int index = handle._val % NUM_CHANNELS;
-	return _channels[index] && _channels[index]->getHandle()._val == handle._val;
+	return findChannel(handle) != -1;
 }
 
 bool MixerImpl::hasActiveChannelOfType(SoundType type) {
 	Common::StackLock lock(_mutex);
 	for (int i = 0; i != NUM_CHANNELS; i++)
-		if (_channels[i] && _channels[i]->getType() == type)
+		if (Common::atomicLoad(&_channels[i]) && _channelInfo[i].type == type)
 			return true;
 	return false;
 }
@@ -469,11 +646,7 @@ void MixerImpl::setVolumeForSoundType(SoundType type, int volume) {
 
 	Common::StackLock lock(_mutex);
 	_soundTypeSettings[type].volume = volume;
-
-	for (int i = 0; i != NUM_CHANNELS; ++i) {
-		if (_channels[i] && _channels[i]->getType() == type)
-			_channels[i]->notifyGlobalVolChange();
-	}
+	updateTypeVolume(type);
 }
 
 int MixerImpl::getVolumeForSoundType(SoundType type) const {
@@ -488,16 +661,17 @@ int MixerImpl::getVolumeForSoundType(SoundType type) const {
 #pragma mark -
 
 Channel::Channel(Mixer *mixer, Mixer::SoundType type, AudioStream *stream,
-                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int id, bool permanent)
-    : _type(type), _mixer(mixer), _id(id), _permanent(permanent), _volume(Mixer::kMaxChannelVolume),
-      _balance(0), _pauseLevel(0), _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0),
-      _pauseStartTime(0), _pauseTime(0), _converter(0),
+                 DisposeAfterUse::Flag autofreeStream, bool reverseStereo, int typeVolume)
+    : _type(type), _paused(false), _volume(Mixer::kMaxChannelVolume), _balance(0), _typeVolume(typeVolume),
+      _samplesConsumed(0), _samplesDecoded(0), _mixerTimeStamp(0), _converter(0),
       _stream(stream, autofreeStream) {
 	assert(mixer);
 	assert(stream);
 
 	// Get a rate converter instance
 	_converter = makeRateConverter(_stream->getRate(), mixer->getOutputRate(), _stream->isStereo(), reverseStereo);
+
+	updateChannelVolumes();
 }
 
 Channel::~Channel() {
@@ -509,17 +683,14 @@ void Channel::setVolume(const byte volume) {
 	updateChannelVolumes();
 }
 
-byte Channel::getVolume() {
-	return _volume;
-}
-
 void Channel::setBalance(const int8 balance) {
 	_balance = balance;
 	updateChannelVolumes();
 }
 
-int8 Channel::getBalance() {
-	return _balance;
+void Channel::setTypeVolume(int volume) {
+	_typeVolume = volume;
+	updateChannelVolumes();
 }
 
 void Channel::updateChannelVolumes() {
@@ -531,70 +702,20 @@ void Channel::updateChannelVolumes() {
 	// volume is in the range 0 - kMaxMixerVolume.
 	// Hence, the vol_l/vol_r values will be in that range, too
 
-	if (!_mixer->isSoundTypeMuted(_type)) {
-		int vol = _mixer->getVolumeForSoundType(_type) * _volume;
-
-		if (_balance == 0) {
-			_volL = vol / Mixer::kMaxChannelVolume;
-			_volR = vol / Mixer::kMaxChannelVolume;
-		} else if (_balance < 0) {
-			_volL = vol / Mixer::kMaxChannelVolume;
-			_volR = ((127 + _balance) * vol) / (Mixer::kMaxChannelVolume * 127);
-		} else {
-			_volL = ((127 - _balance) * vol) / (Mixer::kMaxChannelVolume * 127);
-			_volR = vol / Mixer::kMaxChannelVolume;
-		}
-	} else {
-		_volL = _volR = 0;
-	}
-}
-
-void Channel::pause(bool paused) {
-	//assert((paused && _pauseLevel >= 0) || (!paused && _pauseLevel));
-
-	if (paused) {
-		_pauseLevel++;
+	int vol = _typeVolume * _volume;
 
-		if (_pauseLevel == 1)
-			_pauseStartTime = g_system->getMillis();
-	} else if (_pauseLevel > 0) {
-		_pauseLevel--;
-
-		if (!_pauseLevel) {
-			_pauseTime = (g_system->getMillis() - _pauseStartTime);
-			_pauseStartTime = 0;
-		}
+	if (_balance == 0) {
+		_volL = vol / Mixer::kMaxChannelVolume;
+		_volR = vol / Mixer::kMaxChannelVolume;
+	} else if (_balance < 0) {
+		_volL = vol / Mixer::kMaxChannelVolume;
+		_volR = ((127 + _balance) * vol) / (Mixer::kMaxChannelVolume * 127);
+	} else {
+		_volL = ((127 - _balance) * vol) / (Mixer::kMaxChannelVolume * 127);
+		_volR = vol / Mixer::kMaxChannelVolume;
 	}
 }
 
-Timestamp Channel::getElapsedTime() {
-	const uint32 rate = _mixer->getOutputRate();
-	uint32 delta = 0;
-
-	Audio::Timestamp ts(0, rate);
-
-	if (_mixerTimeStamp == 0)
-		return ts;
-
-	if (isPaused())
-		delta = _pauseStartTime - _mixerTimeStamp;
-	else
-		delta = g_system->getMillis() - _mixerTimeStamp - _pauseTime;
-
-	// Convert the number of samples into a time duration.
-
-	ts = ts.addFrames(_samplesConsumed);
-	ts = ts.addMsecs(delta);
-
-	// In theory it would seem like a good idea to limit the approximation
-	// so that it never exceeds the theoretical upper bound set by
-	// _samplesDecoded. Meanwhile, back in the real world, doing so makes
-	// the Broken Sword cutscenes noticeably jerkier. I guess the mixer
-	// isn't invoked at the regular intervals that I first imagined.
-
-	return ts;
-}
-
 int Channel::mix(int16 *data, uint len) {
 	assert(_stream);
 
@@ -606,7 +727,6 @@ int Channel::mix(int16 *data, uint len) {
 		assert(_converter);
 		_samplesConsumed = _samplesDecoded;
 		_mixerTimeStamp = g_system->getMillis();
-		_pauseTime = 0;
 		res = _converter->flow(*_stream, data, len, _volL, _volR);
 		_samplesDecoded += res;
 	}
@@ -55,8 +55,24 @@ private:
 	};
 
 	OSystem *_syst;
+
+	/**
+	 * Serializes the calls from the different threads of the program. The
+	 * mixer callback never takes it, and nobody waits for the callback while
+	 * holding it, so streams may call the mixer from inside the callback.
+	 */
 	Common::Mutex _mutex;
 
+	/**
+	 * Held by the mixer callback during a mix pass. Stop calls take it after
+	 * releasing _mutex, to wait until the callback is done with the channels
+	 * they detached; other calls never take it, so the callback only ever
+	 * waits for a stop call to check _mixingChannel. As the mutex is
+	 * recursive, a stream stopping channels from inside the callback gets
+	 * through.
+	 */
+	Common::Mutex _mixMutex;
+
 	const uint _sampleRate;
 	bool _mixerReady;
 	uint32 _handleSeed;
@@ -69,7 +85,74 @@ private:
 	};
 
 	SoundTypeSettings _soundTypeSettings[4];
-	Channel *_channels[NUM_CHANNELS];
+
+	/**
+	 * The playing channels. A channel is published here once it is set up
+	 * completely. Whoever clears a slot (the mixer callback for a finished
+	 * channel, or a stop call) with atomicCompareAndSwap owns the channel
+	 * and deletes it.
+	 */
+	Channel *volatile _channels[NUM_CHANNELS];
+	volatile uint32 _handles[NUM_CHANNELS];
+
+	/**
+	 * Channel the mixer callback is mixing right now, and a channel which
+	 * its own stream stopped meanwhile, which the callback deletes once the
+	 * stream returns. Both are protected by _mixMutex.
+	 */
+	Channel *_mixingChannel;
+	Channel *_stoppedChannel;
+
+	/**
+	 * Channel settings as seen by the rest of the program. These are
+	 * protected by _mutex, the mixer callback gets its own copy through
+	 * _channelSettings.
+	 */
+	struct ChannelInfo {
+		int id;
+		SoundType type;
+		bool permanent;
+		byte volume;
+		int8 balance;
+
+		int pauseLevel;
+		uint32 pauseStartTime;
+		uint32 pauseEndTime;
+		uint32 pauseTime;
+	};
+
+	ChannelInfo _channelInfo[NUM_CHANNELS];
+
+	/**
+	 * Playback position of each channel, written by the mixer callback.
+	 * The sequence number is odd while an update is in progress.
+	 */
+	struct ChannelTiming {
+		volatile uint32 sequence;
+		uint32 samplesConsumed;
+		uint32 mixerTimeStamp;
+	};
+
+	ChannelTiming _channelTiming[NUM_CHANNELS];
+
+	/**
+	 * Latest settings of each channel for the mixer callback. They are
+	 * written under _mutex, followed by setting the changed flag; the
+	 * callback clears the flag before it reads them. Only the latest values
+	 * matter, so changing them never has to wait for the callback.
+	 */
+	struct ChannelSettings {
+		volatile int32 volume;
+		volatile int32 balance;
+		volatile int32 paused;
+		volatile uint32 changed;
+	};
+
+	ChannelSettings _channelSettings[NUM_CHANNELS];
+
+	/** Effective volume of each sound type for the mixer callback, likewise */
+	volatile int32 _typeVolumes[4];
+	volatile uint32 _typeVolumesChanged;
 
 
 public:
@@ -120,7 +203,17 @@ public:
 	virtual uint getOutputRate() const;
 
 protected:
-	void insertChannel(SoundHandle *handle, Channel *chan);
+	void insertChannel(SoundHandle *handle, Channel *chan, int id, byte volume, int8 balance, bool permanent);
+
+private:
+	int getTypeVolume(SoundType type) const;
+	int findChannel(SoundHandle handle) const;
+	Channel *detachChannel(int index);
+	void deleteChannel(Channel *chan);
+	void pauseChannel(int index, bool paused);
+	void updateChannelSettings(int index);
+	void updateTypeVolume(SoundType type);
+	void applySettings(Channel *chan, int index, bool typeVolumesChanged);
 
 public:
 	/**
@@ -12,6 +12,8 @@ MODULE_OBJS := \
 	mpu401.o \
 	musicplugin.o \
 	null.o \
+	prefetch.o \
+	rate_mix.o \
 	timestamp.o \
 	decoders/aac.o \
 	decoders/adpcm.o \
@@ -38,6 +40,7 @@ MODULE_OBJS := \
 	softsynth/adlib.o \
 	softsynth/cms.o \
 	softsynth/opl/dbopl.o \
+	softsynth/opl/dbopl_block.o \
 	softsynth/opl/dosbox.o \
 	softsynth/opl/mame.o \
 	softsynth/fmtowns_pc98/towns_audio.o \
@@ -48,6 +51,7 @@ MODULE_OBJS := \
 	softsynth/fmtowns_pc98/towns_pc98_plugins.o \
 	softsynth/appleiigs.o \
 	softsynth/fluidsynth.o \
+	softsynth/midiring.o \
 	softsynth/mt32.o \
 	softsynth/eas.o \
 	softsynth/pcspk.o \
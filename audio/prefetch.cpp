@@ -0,0 +1,270 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/prefetch.h"
+
+#include "common/atomic.h"
+#include "common/ptr.h"
+#include "common/util.h"
+#include "common/workerpool.h"
+
+namespace Audio {
+
+/**
+ * Ring buffer of decoded samples. It is filled from the source stream by
+ * fill() and drained by read(), which may run on different threads.
+ *
+ * With a worker pool, the fills run as jobs on it. The owning stream never
+ * waits for such a job: release() hands the buffer over to the queued job,
+ * which deletes it when done. This way, deleting a stream on the mixer
+ * thread never waits for a decode in progress. Queuing a fill from the
+ * mixer thread takes the pool's lock, but the pool only holds it to update
+ * its queue.
+ */
+class PrefetchBuffer {
+public:
+	PrefetchBuffer(AudioStream *source, DisposeAfterUse::Flag disposeAfterUse, uint lookahead, Common::WorkerPool *pool);
+
+	/**
+	 * Decode from the source stream until the buffer is full, or the source
+	 * has no more data.
+	 */
+	void fill();
+
+	/**
+	 * Queue a job on the pool which fills the buffer, unless one is queued
+	 * already.
+	 */
+	void requestFill();
+
+	/**
+	 * Copy up to numSamples decoded samples into buffer.
+	 * @return the number of samples copied
+	 */
+	int read(int16 *buffer, int numSamples);
+
+	/**
+	 * Delete the buffer, or let the queued job delete it once it is done.
+	 * The buffer must not be used afterwards.
+	 */
+	void release();
+
+	bool isStereo() const { return _isStereo; }
+	int getRate() const { return _rate; }
+
+	bool endOfData() const;
+	bool endOfStream() const;
+
+private:
+	~PrefetchBuffer();
+
+	enum State {
+		kStateIdle,		///< No fill is queued
+		kStateQueued,	///< A fill is queued or running
+		kStateReleased	///< The stream is gone, the queued fill deletes the buffer
+	};
+
+	static void fillJob(void *param);
+
+	/**
+	 * Counts the fills on the pool. It is never waited for: it only exists
+	 * because the pool needs one, and it has to outlive the buffers.
+	 */
+	static int32 _pendingFills;
+
+	Common::WorkerPool *_pool;
+	volatile uint32 _state;
+
+	Common::DisposablePtr<AudioStream> _source;
+	const bool _isStereo;
+	const int _rate;
+
+	int16 *_samples;
+	uint32 _size;	///< Size of _samples, a power of two
+
+	// Positions only ever grow; the index into _samples is pos & (_size - 1)
+	volatile uint32 _readPos;
+	volatile uint32 _writePos;
+
+	volatile uint32 _sourceEndOfData;
+	volatile uint32 _sourceEndOfStream;
+};
+
+int32 PrefetchBuffer::_pendingFills = 0;
+
+PrefetchBuffer::PrefetchBuffer(AudioStream *source, DisposeAfterUse::Flag disposeAfterUse, uint lookahead, Common::WorkerPool *pool)
+	: _pool(pool), _state(kStateIdle),
+	  _source(source, disposeAfterUse), _isStereo(source->isStereo()), _rate(source->getRate()),
+	  _readPos(0), _writePos(0), _sourceEndOfData(0), _sourceEndOfStream(0) {
+
+	const uint32 samples = (uint32)_rate * (_isStereo ? 2 : 1) * lookahead / 1000;
+
+	_size = 1024;
+	while (_size < samples)
+		_size <<= 1;
+
+	_samples = new int16[_size];
+}
+
+PrefetchBuffer::~PrefetchBuffer() {
+	delete[] _samples;
+}
+
+void PrefetchBuffer::fill() {
+	// Stereo samples come in pairs, keep them together
+	const uint32 alignMask = _isStereo ? ~1U : ~0U;
+	uint32 write = _writePos;
+
+	while (true) {
+		const uint32 space = _size - (write - Common::atomicLoad(&_readPos));
+		const uint32 pos = write & (_size - 1);
+		const int len = MIN(space, _size - pos) & alignMask;
+		if (len == 0)
+			break;
+
+		const int got = _source->readBuffer(_samples + pos, len);
+		if (got > 0) {
+			write += got;
+			Common::atomicStore(&_writePos, write);
+		}
+
+		if (got < len)
+			break;
+	}
+
+	Common::atomicStore(&_sourceEndOfStream, (uint32)_source->endOfStream());
+	Common::atomicStore(&_sourceEndOfData, (uint32)_source->endOfData());
+}
+
+void PrefetchBuffer::requestFill() {
+	if (Common::atomicLoad(&_sourceEndOfData))
+		return;
+
+	if (Common::atomicCompareAndSwap(&_state, (uint32)kStateIdle, (uint32)kStateQueued))
+		_pool->addJob(&fillJob, this, &_pendingFills);
+}
+
+void PrefetchBuffer::fillJob(void *param) {
+	PrefetchBuffer *buffer = (PrefetchBuffer *)param;
+
+	buffer->fill();
+
+	// Samples read in the meantime are refilled by the next request
+	if (!Common::atomicCompareAndSwap(&buffer->_state, (uint32)kStateQueued, (uint32)kStateIdle))
+		delete buffer;
+}
+
+void PrefetchBuffer::release() {
+	while (true) {
+		if (Common::atomicCompareAndSwap(&_state, (uint32)kStateIdle, (uint32)kStateReleased)) {
+			delete this;
+			return;
+		}
+
+		// The fill may finish right now, then try again
+		if (Common::atomicCompareAndSwap(&_state, (uint32)kStateQueued, (uint32)kStateReleased))
+			return;
+	}
+}
+
+int PrefetchBuffer::read(int16 *buffer, int numSamples) {
+	uint32 read = _readPos;
+	const int total = MIN<uint32>(numSamples, Common::atomicLoad(&_writePos) - read);
+
+	for (int done = 0; done < total; ) {
+		const uint32 pos = read & (_size - 1);
+		const int len = MIN<uint32>(total - done, _size - pos);
+
+		memcpy(buffer + done, _samples + pos, len * sizeof(int16));
+		done += len;
+		read += len;
+	}
+
+	Common::atomicStore(&_readPos, read);
+	return total;
+}
+
+bool PrefetchBuffer::endOfData() const {
+	// The flag is published after the last samples, so check it first
+	const bool sourceEnd = Common::atomicLoad(&_sourceEndOfData) != 0;
+	return sourceEnd && Common::atomicLoad(&_writePos) == _readPos;
+}
+
+bool PrefetchBuffer::endOfStream() const {
+	const bool sourceEnd = Common::atomicLoad(&_sourceEndOfStream) != 0;
+	return sourceEnd && Common::atomicLoad(&_writePos) == _readPos;
+}
+
+class PrefetchingAudioStreamImpl : public PrefetchingAudioStream {
+public:
+	PrefetchingAudioStreamImpl(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint lookahead);
+	~PrefetchingAudioStreamImpl();
+
+	virtual int readBuffer(int16 *buffer, const int numSamples);
+	virtual bool isStereo() const { return _buffer->isStereo(); }
+	virtual int getRate() const { return _buffer->getRate(); }
+	virtual bool endOfData() const { return _buffer->endOfData(); }
+	virtual bool endOfStream() const { return _buffer->endOfStream(); }
+
+	virtual uint32 getUnderrunCount() const { return Common::atomicLoad(&_underruns); }
+
+private:
+	PrefetchBuffer *_buffer;
+	bool _usesPool;
+	volatile uint32 _underruns;
+};
+
+PrefetchingAudioStreamImpl::PrefetchingAudioStreamImpl(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint lookahead)
+	: _buffer(0), _usesPool(false), _underruns(0) {
+	// Without worker threads, the jobs would only run when waited for
+	_usesPool = pool && pool->getThreadCount() > 0;
+	_buffer = new PrefetchBuffer(stream, disposeAfterUse, lookahead, _usesPool ? pool : 0);
+
+	// Start with a full buffer, the jobs only keep it filled
+	_buffer->fill();
+}
+
+PrefetchingAudioStreamImpl::~PrefetchingAudioStreamImpl() {
+	_buffer->release();
+}
+
+int PrefetchingAudioStreamImpl::readBuffer(int16 *buffer, const int numSamples) {
+	if (!_usesPool)
+		_buffer->fill();
+
+	const int samples = _buffer->read(buffer, numSamples);
+
+	if (samples < numSamples && !_buffer->endOfData())
+		Common::atomicStore(&_underruns, _underruns + 1);
+
+	if (_usesPool)
+		_buffer->requestFill();
+
+	return samples;
+}
+
+PrefetchingAudioStream *makePrefetchingAudioStream(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint lookahead) {
+	assert(stream);
+	return new PrefetchingAudioStreamImpl(stream, disposeAfterUse, pool, lookahead);
+}
+
+} // End of namespace Audio
@@ -0,0 +1,74 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_PREFETCH_H
+#define AUDIO_PREFETCH_H
+
+#include "common/scummsys.h"
+#include "common/types.h"
+
+#include "audio/audiostream.h"
+
+namespace Common {
+class WorkerPool;
+}
+
+namespace Audio {
+
+/**
+ * An AudioStream which decodes another stream ahead of time, so that
+ * readBuffer() only copies already decoded samples. This moves the work of
+ * compressed formats like MP3, Vorbis or FLAC out of the mixer callback.
+ *
+ * The decoding is done by jobs on a worker pool, which readBuffer() queues
+ * whenever it has taken samples out of the buffer. Without a pool, or with
+ * a pool without threads, the stream decodes in readBuffer() like any other
+ * stream.
+ *
+ * The source stream is only accessed by the decoding, so it must not be
+ * used otherwise while the prefetching stream exists.
+ */
+class PrefetchingAudioStream : public AudioStream {
+public:
+	/**
+	 * Return how often readBuffer() could not return all requested
+	 * samples, although the source stream had more data.
+	 */
+	virtual uint32 getUnderrunCount() const = 0;
+};
+
+/**
+ * Factory function for a PrefetchingAudioStream.
+ *
+ * @param stream           the stream to decode ahead
+ * @param disposeAfterUse  whether to delete the source stream along with the
+ *                         prefetching stream
+ * @param pool             the worker pool to decode on, usually
+ *                         g_system->getWorkerPool(), or 0
+ * @param lookahead        amount of audio to decode ahead, in milliseconds;
+ *                         this should cover several mixer callbacks
+ */
+PrefetchingAudioStream *makePrefetchingAudioStream(AudioStream *stream, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint lookahead = 250);
+
+} // End of namespace Audio
+
+#endif
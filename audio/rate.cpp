@@ -30,6 +30,7 @@
 
 #include "audio/audiostream.h"
 #include "audio/rate.h"
+#include "audio/rate_mix.h"
 #include "audio/mixer.h"
 #include "common/frac.h"
 #include "common/textconsole.h"
@@ -67,6 +68,13 @@ protected:
 	/** fractional position increment in the output stream */
 	long opos_inc;
 
+	/** resampled sample(s), waiting to be mixed into the output buffer */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	MixBufferProc mixProc;
+
+	int resample(AudioStream &input, st_sample_t *out, int frames);
+
 public:
 	SimpleRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
@@ -95,20 +103,17 @@ SimpleRateConverter<stereo, reverseStereo>::SimpleRateConverter(st_rate_t inrate
 	opos_inc = inrate / outrate;
 
 	inLen = 0;
+
+	mixProc = getMixBufferProc(stereo, reverseStereo);
 }
 
 /*
- * Processed signed long samples from ibuf to obuf.
- * Return number of sample pairs processed.
+ * Resample up to 'frames' sample frames into out.
+ * Return number of sample frames produced.
  */
 template<bool stereo, bool reverseStereo>
-int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
-
-	ostart = obuf;
-	oend = obuf + osamp * 2;
-
-	while (obuf < oend) {
+int SimpleRateConverter<stereo, reverseStereo>::resample(AudioStream &input, st_sample_t *out, int frames) {
+	for (int i = 0; i < frames; ++i) {
 
 		// read enough input samples so that opos >= 0
 		do {
@@ -117,7 +122,7 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
 				if (inLen <= 0)
-					return (obuf - ostart) / 2;
+					return i;
 			}
 			inLen -= (stereo ? 2 : 1);
 			opos--;
@@ -126,20 +131,37 @@ int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 			}
 		} while (opos >= 0);
 
-		st_sample_t out0, out1;
-		out0 = *inPtr++;
-		out1 = (stereo ? *inPtr++ : out0);
+		*out++ = *inPtr++;
+		if (stereo)
+			*out++ = *inPtr++;
 
 		// Increment output position
 		opos += opos_inc;
+	}
+	return frames;
+}
 
-		// output left channel
-		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int SimpleRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
+
+	ostart = obuf;
+	oend = obuf + osamp * 2;
+
+	while (obuf < oend) {
+		const int frames = MIN<int>((oend - obuf) / 2, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
+		const int produced = resample(input, outBuf, frames);
 
-		// output right channel
-		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+		// mix the resampled frames into the output buffer
+		mixProc(obuf, outBuf, produced, vol_l, vol_r);
+		obuf += produced * 2;
 
-		obuf += 2;
+		if (produced < frames)
+			break;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -173,6 +195,13 @@ protected:
 	/** current sample(s) in the input stream (left/right channel) */
 	st_sample_t icur0, icur1;
 
+	/** interpolated sample(s), waiting to be mixed into the output buffer */
+	st_sample_t outBuf[INTERMEDIATE_BUFFER_SIZE];
+
+	MixBufferProc mixProc;
+
+	int resample(AudioStream &input, st_sample_t *out, int frames);
+
 public:
 	LinearRateConverter(st_rate_t inrate, st_rate_t outrate);
 	int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
@@ -204,29 +233,26 @@ LinearRateConverter<stereo, reverseStereo>::LinearRateConverter(st_rate_t inrate
 	icur0 = icur1 = 0;
 
 	inLen = 0;
+
+	mixProc = getMixBufferProc(stereo, reverseStereo);
 }
 
 /*
- * Processed signed long samples from ibuf to obuf.
- * Return number of sample pairs processed.
+ * Interpolate up to 'frames' sample frames into out.
+ * Return number of sample frames produced.
  */
 template<bool stereo, bool reverseStereo>
-int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
-	st_sample_t *ostart, *oend;
-
-	ostart = obuf;
-	oend = obuf + osamp * 2;
-
-	while (obuf < oend) {
+int LinearRateConverter<stereo, reverseStereo>::resample(AudioStream &input, st_sample_t *out, int frames) {
+	for (int i = 0; i < frames; ++i) {
 
-		// read enough input samples so that opos < 0
+		// read enough input samples so that opos < FRAC_ONE
 		while ((frac_t)FRAC_ONE <= opos) {
 			// Check if we have to refill the buffer
 			if (inLen == 0) {
 				inPtr = inBuf;
 				inLen = input.readBuffer(inBuf, ARRAYSIZE(inBuf));
 				if (inLen <= 0)
-					return (obuf - ostart) / 2;
+					return i;
 			}
 			inLen -= (stereo ? 2 : 1);
 			ilast0 = icur0;
@@ -238,27 +264,38 @@ int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_samp
 			opos -= FRAC_ONE;
 		}
 
-		// Loop as long as the outpos trails behind, and as long as there is
-		// still space in the output buffer.
-		while (opos < (frac_t)FRAC_ONE && obuf < oend) {
-			// interpolate
-			st_sample_t out0, out1;
-			out0 = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
-			out1 = (stereo ?
-						  (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS)) :
-						  out0);
+		// interpolate
+		*out++ = (st_sample_t)(ilast0 + (((icur0 - ilast0) * opos + FRAC_HALF) >> FRAC_BITS));
+		if (stereo)
+			*out++ = (st_sample_t)(ilast1 + (((icur1 - ilast1) * opos + FRAC_HALF) >> FRAC_BITS));
+
+		// Increment output position
+		opos += opos_inc;
+	}
+	return frames;
+}
+
+/*
+ * Processed signed long samples from ibuf to obuf.
+ * Return number of sample pairs processed.
+ */
+template<bool stereo, bool reverseStereo>
+int LinearRateConverter<stereo, reverseStereo>::flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	st_sample_t *ostart, *oend;
 
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+	ostart = obuf;
+	oend = obuf + osamp * 2;
 
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+	while (obuf < oend) {
+		const int frames = MIN<int>((oend - obuf) / 2, ARRAYSIZE(outBuf) / (stereo ? 2 : 1));
+		const int produced = resample(input, outBuf, frames);
 
-			obuf += 2;
+		// mix the interpolated frames into the output buffer
+		mixProc(obuf, outBuf, produced, vol_l, vol_r);
+		obuf += produced * 2;
 
-			// Increment output position
-			opos += opos_inc;
-		}
+		if (produced < frames)
+			break;
 	}
 	return (obuf - ostart) / 2;
 }
@@ -274,8 +311,9 @@ template<bool stereo, bool reverseStereo>
 class CopyRateConverter : public RateConverter {
 	st_sample_t *_buffer;
 	st_size_t _bufferSize;
+	MixBufferProc _mixProc;
 public:
-	CopyRateConverter() : _buffer(0), _bufferSize(0) {}
+	CopyRateConverter() : _buffer(0), _bufferSize(0), _mixProc(getMixBufferProc(stereo, reverseStereo)) {}
 	~CopyRateConverter() {
 		free(_buffer);
 	}
@@ -283,11 +321,6 @@ public:
 	virtual int flow(AudioStream &input, st_sample_t *obuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
 		assert(input.isStereo() == stereo);
 
-		st_sample_t *ptr;
-		st_size_t len;
-
-		st_sample_t *ostart = obuf;
-
 		if (stereo)
 			osamp *= 2;
 
@@ -302,24 +335,14 @@ public:
 			error("[CopyRateConverter::flow] Cannot allocate memory for temp buffer");
 
 		// Read up to 'osamp' samples into our temporary buffer
-		len = input.readBuffer(_buffer, osamp);
+		const int len = input.readBuffer(_buffer, osamp);
+		if (len <= 0)
+			return 0;
 
 		// Mix the data into the output buffer
-		ptr = _buffer;
-		for (; len > 0; len -= (stereo ? 2 : 1)) {
-			st_sample_t out0, out1;
-			out0 = *ptr++;
-			out1 = (stereo ? *ptr++ : out0);
-
-			// output left channel
-			clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
-
-			// output right channel
-			clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
-
-			obuf += 2;
-		}
-		return (obuf - ostart) / 2;
+		const int frames = len / (stereo ? 2 : 1);
+		_mixProc(obuf, _buffer, frames, vol_l, vol_r);
+		return frames;
 	}
 
 	virtual int drain(st_sample_t *obuf, st_size_t osamp, st_volume_t vol) {
@@ -0,0 +1,304 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * The volume scaling and clamped adding which every rate converter applies
+ * to its output. The vectorized versions compute exactly the same results
+ * as the scalar one:
+ *
+ * - the 16x16 bit products are formed in 32 bits, so no precision is lost,
+ * - the division by kMaxMixerVolume (256) rounds towards zero, like the
+ *   C division operator does,
+ * - the quotient always fits into 16 bits when the volume is at most
+ *   kMaxMixerVolume, so the saturating pack is lossless and the saturating
+ *   16 bit add equals clampedAdd().
+ *
+ * Volumes above kMaxMixerVolume are handed to the scalar code.
+ */
+
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_AVX2
+#include <immintrin.h>
+#endif
+#ifdef SCUMMVM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "audio/rate_mix.h"
+#include "audio/mixer.h"
+#include "common/util.h"
+
+namespace Audio {
+
+template<bool stereo, bool reverseStereo>
+static void mixBufferScalar(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	for (; osamp > 0; --osamp) {
+		st_sample_t out0, out1;
+		out0 = *ibuf++;
+		out1 = (stereo ? *ibuf++ : out0);
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
+#if !defined(OUTPUT_UNSIGNED_AUDIO)
+
+static inline bool isVolumeInRange(st_volume_t vol_l, st_volume_t vol_r) {
+	return vol_l <= Audio::Mixer::kMaxMixerVolume && vol_r <= Audio::Mixer::kMaxMixerVolume;
+}
+
+#ifdef SCUMMVM_SSE2
+
+SCUMMVM_TARGET_SSE2 static inline __m128i scaleSamplesSSE2(__m128i in, __m128i vol) {
+	const __m128i lo = _mm_mullo_epi16(in, vol);
+	const __m128i hi = _mm_mulhi_epi16(in, vol);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+
+	// Add 255 to negative products so the shift rounds towards zero
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_srli_epi32(_mm_srai_epi32(p0, 31), 24)), 8);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_srli_epi32(_mm_srai_epi32(p1, 31), 24)), 8);
+
+	return _mm_packs_epi32(p0, p1);
+}
+
+SCUMMVM_TARGET_SSE2 static inline void mixSamplesSSE2(st_sample_t *obuf, __m128i in, __m128i vol) {
+	const __m128i out = _mm_loadu_si128((const __m128i *)obuf);
+	_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(out, scaleSamplesSSE2(in, vol)));
+}
+
+template<bool stereo, bool reverseStereo>
+SCUMMVM_TARGET_SSE2 static void mixBufferSSE2(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	if (!isVolumeInRange(vol_l, vol_r)) {
+		mixBufferScalar<stereo, reverseStereo>(obuf, ibuf, osamp, vol_l, vol_r);
+		return;
+	}
+
+	// Volumes in output order: obuf[reverseStereo] is scaled by vol_l
+	const int16 vol0 = reverseStereo ? vol_r : vol_l;
+	const int16 vol1 = reverseStereo ? vol_l : vol_r;
+	const __m128i vol = _mm_set_epi16(vol1, vol0, vol1, vol0, vol1, vol0, vol1, vol0);
+
+	if (stereo) {
+		for (; osamp >= 4; osamp -= 4) {
+			__m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+			if (reverseStereo)
+				in = _mm_shufflehi_epi16(_mm_shufflelo_epi16(in, 0xB1), 0xB1);
+			mixSamplesSSE2(obuf, in, vol);
+			ibuf += 8;
+			obuf += 8;
+		}
+	} else {
+		for (; osamp >= 8; osamp -= 8) {
+			const __m128i in = _mm_loadu_si128((const __m128i *)ibuf);
+			mixSamplesSSE2(obuf,     _mm_unpacklo_epi16(in, in), vol);
+			mixSamplesSSE2(obuf + 8, _mm_unpackhi_epi16(in, in), vol);
+			ibuf += 8;
+			obuf += 16;
+		}
+	}
+
+	mixBufferScalar<stereo, reverseStereo>(obuf, ibuf, osamp, vol_l, vol_r);
+}
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_AVX2
+
+SCUMMVM_TARGET_AVX2 static inline void mixSamplesAVX2(st_sample_t *obuf, __m256i in, __m256i vol) {
+	const __m256i lo = _mm256_mullo_epi16(in, vol);
+	const __m256i hi = _mm256_mulhi_epi16(in, vol);
+	// The unpack and pack instructions both work per 128 bit lane, so the
+	// sample order is preserved.
+	__m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+	__m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+
+	// Add 255 to negative products so the shift rounds towards zero
+	p0 = _mm256_srai_epi32(_mm256_add_epi32(p0, _mm256_srli_epi32(_mm256_srai_epi32(p0, 31), 24)), 8);
+	p1 = _mm256_srai_epi32(_mm256_add_epi32(p1, _mm256_srli_epi32(_mm256_srai_epi32(p1, 31), 24)), 8);
+
+	const __m256i out = _mm256_loadu_si256((const __m256i *)obuf);
+	_mm256_storeu_si256((__m256i *)obuf, _mm256_adds_epi16(out, _mm256_packs_epi32(p0, p1)));
+}
+
+template<bool stereo, bool reverseStereo>
+SCUMMVM_TARGET_AVX2 static void mixBufferAVX2(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	if (!isVolumeInRange(vol_l, vol_r)) {
+		mixBufferScalar<stereo, reverseStereo>(obuf, ibuf, osamp, vol_l, vol_r);
+		return;
+	}
+
+	// Volumes in output order: obuf[reverseStereo] is scaled by vol_l
+	const int16 vol0 = reverseStereo ? vol_r : vol_l;
+	const int16 vol1 = reverseStereo ? vol_l : vol_r;
+	const __m256i vol = _mm256_set_epi16(vol1, vol0, vol1, vol0, vol1, vol0, vol1, vol0,
+	                                     vol1, vol0, vol1, vol0, vol1, vol0, vol1, vol0);
+
+	if (stereo) {
+		for (; osamp >= 8; osamp -= 8) {
+			__m256i in = _mm256_loadu_si256((const __m256i *)ibuf);
+			if (reverseStereo)
+				in = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(in, 0xB1), 0xB1);
+			mixSamplesAVX2(obuf, in, vol);
+			ibuf += 16;
+			obuf += 16;
+		}
+	} else {
+		for (; osamp >= 16; osamp -= 16) {
+			const __m256i in = _mm256_loadu_si256((const __m256i *)ibuf);
+			const __m256i lo = _mm256_unpacklo_epi16(in, in);
+			const __m256i hi = _mm256_unpackhi_epi16(in, in);
+			mixSamplesAVX2(obuf,      _mm256_permute2x128_si256(lo, hi, 0x20), vol);
+			mixSamplesAVX2(obuf + 16, _mm256_permute2x128_si256(lo, hi, 0x31), vol);
+			ibuf += 16;
+			obuf += 32;
+		}
+	}
+
+	mixBufferScalar<stereo, reverseStereo>(obuf, ibuf, osamp, vol_l, vol_r);
+}
+
+#endif // SCUMMVM_AVX2
+
+#ifdef SCUMMVM_NEON
+
+static inline int32x4_t divideByMaxVolumeNEON(int32x4_t p) {
+	// Add 255 to negative products so the shift rounds towards zero
+	const uint32x4_t bias = vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(p, 31)), 24);
+	return vshrq_n_s32(vaddq_s32(p, vreinterpretq_s32_u32(bias)), 8);
+}
+
+static inline void mixSamplesNEON(st_sample_t *obuf, int16x8_t in, int16x8_t vol) {
+	const int32x4_t p0 = divideByMaxVolumeNEON(vmull_s16(vget_low_s16(in), vget_low_s16(vol)));
+	const int32x4_t p1 = divideByMaxVolumeNEON(vmull_s16(vget_high_s16(in), vget_high_s16(vol)));
+	const int16x8_t scaled = vcombine_s16(vqmovn_s32(p0), vqmovn_s32(p1));
+	vst1q_s16(obuf, vqaddq_s16(vld1q_s16(obuf), scaled));
+}
+
+template<bool stereo, bool reverseStereo>
+static void mixBufferNEON(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r) {
+	if (!isVolumeInRange(vol_l, vol_r)) {
+		mixBufferScalar<stereo, reverseStereo>(obuf, ibuf, osamp, vol_l, vol_r);
+		return;
+	}
+
+	// Volumes in output order: obuf[reverseStereo] is scaled by vol_l
+	const int16 vol0 = reverseStereo ? vol_r : vol_l;
+	const int16 vol1 = reverseStereo ? vol_l : vol_r;
+	const int16 volTable[8] = { vol0, vol1, vol0, vol1, vol0, vol1, vol0, vol1 };
+	const int16x8_t vol = vld1q_s16(volTable);
+
+	if (stereo) {
+		for (; osamp >= 4; osamp -= 4) {
+			int16x8_t in = vld1q_s16(ibuf);
+			if (reverseStereo)
+				in = vrev32q_s16(in);
+			mixSamplesNEON(obuf, in, vol);
+			ibuf += 8;
+			obuf += 8;
+		}
+	} else {
+		for (; osamp >= 8; osamp -= 8) {
+			const int16x8_t in = vld1q_s16(ibuf);
+			const int16x8x2_t dup = vzipq_s16(in, in);
+			mixSamplesNEON(obuf,     dup.val[0], vol);
+			mixSamplesNEON(obuf + 8, dup.val[1], vol);
+			ibuf += 8;
+			obuf += 16;
+		}
+	}
+
+	mixBufferScalar<stereo, reverseStereo>(obuf, ibuf, osamp, vol_l, vol_r);
+}
+
+#endif // SCUMMVM_NEON
+
+#endif // !OUTPUT_UNSIGNED_AUDIO
+
+#define MIX_BUFFER_PROC(impl, stereo, reverseStereo) \
+	(stereo ? (reverseStereo ? &impl<true, true> : &impl<true, false>) \
+	        : (reverseStereo ? &impl<false, true> : &impl<false, false>))
+
+MixBufferProc getMixBufferProc(bool stereo, bool reverseStereo, MixBufferImpl impl) {
+	switch (impl) {
+	case kMixBufferScalar:
+		return MIX_BUFFER_PROC(mixBufferScalar, stereo, reverseStereo);
+
+#if !defined(OUTPUT_UNSIGNED_AUDIO)
+#ifdef SCUMMVM_SSE2
+	case kMixBufferSSE2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+			return MIX_BUFFER_PROC(mixBufferSSE2, stereo, reverseStereo);
+		break;
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kMixBufferAVX2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+			return MIX_BUFFER_PROC(mixBufferAVX2, stereo, reverseStereo);
+		break;
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kMixBufferNEON:
+		if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+			return MIX_BUFFER_PROC(mixBufferNEON, stereo, reverseStereo);
+		break;
+#endif
+#endif // !OUTPUT_UNSIGNED_AUDIO
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+#undef MIX_BUFFER_PROC
+
+MixBufferProc getMixBufferProc(bool stereo, bool reverseStereo) {
+	static const MixBufferImpl preferred[] = {
+		kMixBufferAVX2,
+		kMixBufferSSE2,
+		kMixBufferNEON
+	};
+
+	for (int i = 0; i < ARRAYSIZE(preferred); ++i) {
+		MixBufferProc proc = getMixBufferProc(stereo, reverseStereo, preferred[i]);
+		if (proc)
+			return proc;
+	}
+
+	return getMixBufferProc(stereo, reverseStereo, kMixBufferScalar);
+}
+
+} // End of namespace Audio
@@ -0,0 +1,63 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_RATE_MIX_H
+#define AUDIO_RATE_MIX_H
+
+#include "audio/rate.h"
+
+namespace Audio {
+
+/**
+ * Mixes osamp sample frames from ibuf into the interleaved stereo buffer
+ * obuf. ibuf holds osamp samples for mono input and 2 * osamp samples for
+ * stereo input. Each sample is scaled by vol_l resp. vol_r (which must not
+ * exceed Mixer::kMaxMixerVolume) and added to obuf with clamping, exactly
+ * like clampedAdd() does.
+ */
+typedef void (*MixBufferProc)(st_sample_t *obuf, const st_sample_t *ibuf, st_size_t osamp, st_volume_t vol_l, st_volume_t vol_r);
+
+enum MixBufferImpl {
+	kMixBufferScalar,
+	kMixBufferSSE2,
+	kMixBufferAVX2,
+	kMixBufferNEON,
+
+	kMixBufferImplCount
+};
+
+/**
+ * Return the mixing routine for the given channel layout using a specific
+ * implementation, or 0 if that implementation is not available on this
+ * build or CPU. kMixBufferScalar is always available; it is the reference
+ * the vectorized versions have to match.
+ */
+MixBufferProc getMixBufferProc(bool stereo, bool reverseStereo, MixBufferImpl impl);
+
+/**
+ * Return the fastest mixing routine available for the given channel layout.
+ */
+MixBufferProc getMixBufferProc(bool stereo, bool reverseStereo);
+
+} // End of namespace Audio
+
+#endif
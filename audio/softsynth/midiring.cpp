@@ -0,0 +1,84 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/softsynth/midiring.h"
+
+#include "common/atomic.h"
+
+MidiEventRing::MidiEventRing() {
+	clear();
+}
+
+void MidiEventRing::clear() {
+	_eventRead = _eventWrite = 0;
+	_sysExRead = _sysExWrite = 0;
+}
+
+bool MidiEventRing::push(uint32 msg, uint32 timestamp, const byte *data, uint32 length) {
+	const uint32 eventWrite = _eventWrite;
+	if (eventWrite - Common::atomicLoad(&_eventRead) >= kEventCount)
+		return false;
+
+	// SysEx data has to be in one piece; if it does not fit before the end
+	// of the ring, it starts over at the beginning.
+	uint32 dataPos = _sysExWrite;
+	if (length) {
+		if (length > kSysExBufferSize)
+			return false;
+		if ((dataPos & (kSysExBufferSize - 1)) + length > kSysExBufferSize)
+			dataPos = (dataPos + kSysExBufferSize - 1) & ~(kSysExBufferSize - 1);
+		if (dataPos + length - Common::atomicLoad(&_sysExRead) > kSysExBufferSize)
+			return false;
+
+		memcpy(_sysExData + (dataPos & (kSysExBufferSize - 1)), data, length);
+	}
+
+	Entry &entry = _events[eventWrite & (kEventCount - 1)];
+	entry.msg = msg;
+	entry.timestamp = timestamp;
+	entry.dataPos = dataPos;
+	entry.dataEnd = _sysExWrite = dataPos + length;
+
+	Common::atomicStore(&_eventWrite, eventWrite + 1);
+	return true;
+}
+
+bool MidiEventRing::peek(Event &event) const {
+	const uint32 eventRead = _eventRead;
+	if (eventRead == Common::atomicLoad(&_eventWrite))
+		return false;
+
+	const Entry &entry = _events[eventRead & (kEventCount - 1)];
+	event.msg = entry.msg;
+	event.timestamp = entry.timestamp;
+	event.length = entry.dataEnd - entry.dataPos;
+	event.data = event.length ? _sysExData + (entry.dataPos & (kSysExBufferSize - 1)) : 0;
+	return true;
+}
+
+void MidiEventRing::pop() {
+	const uint32 eventRead = _eventRead;
+	assert(eventRead != _eventWrite);
+
+	Common::atomicStore(&_sysExRead, _events[eventRead & (kEventCount - 1)].dataEnd);
+	Common::atomicStore(&_eventRead, eventRead + 1);
+}
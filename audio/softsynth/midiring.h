@@ -0,0 +1,94 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_SOFTSYNTH_MIDIRING_H
+#define AUDIO_SOFTSYNTH_MIDIRING_H
+
+#include "common/scummsys.h"
+
+/**
+ * A fixed size queue of timestamped MIDI events, which passes them from one
+ * thread to another without locking: the writer never waits for the reader
+ * and vice versa. There may only be one writer and one reader at a time,
+ * so several writers have to be serialized by their caller.
+ *
+ * SysEx data is copied into a separate byte ring and stays in one piece.
+ * When the queue is full, new events are dropped.
+ */
+class MidiEventRing {
+public:
+	enum {
+		kEventCount = 4096,			///< Capacity of the event ring, a power of two
+		kSysExBufferSize = 65536	///< Size of the SysEx data ring, a power of two
+	};
+
+	struct Event {
+		uint32 msg;				///< The MIDI message, as given to push()
+		uint32 timestamp;		///< The timestamp, as given to push()
+		const byte *data;		///< The SysEx data, or 0
+		uint32 length;			///< The length of the SysEx data
+	};
+
+	MidiEventRing();
+
+	/** Drop all events. Neither the reader nor the writer may be active. */
+	void clear();
+
+	/**
+	 * Append an event with optional SysEx data, which is copied.
+	 *
+	 * @return false if the event did not fit and was dropped
+	 */
+	bool push(uint32 msg, uint32 timestamp, const byte *data = 0, uint32 length = 0);
+
+	/**
+	 * Return the oldest event without removing it. Its data stays valid
+	 * until pop() is called.
+	 *
+	 * @return false if there is no event
+	 */
+	bool peek(Event &event) const;
+
+	/** Remove the oldest event, which peek() returned. */
+	void pop();
+
+private:
+	struct Entry {
+		uint32 msg;
+		uint32 timestamp;
+		uint32 dataPos;		///< Position of the SysEx data in _sysExData
+		uint32 dataEnd;		///< Position after the SysEx data
+	};
+
+	// The ring positions only ever grow; the index is pos & (size - 1).
+	// The read positions are only written by the reader, the write
+	// positions only by the writer.
+	Entry _events[kEventCount];
+	volatile uint32 _eventRead;
+	volatile uint32 _eventWrite;
+
+	byte _sysExData[kSysExBufferSize];
+	volatile uint32 _sysExRead;
+	uint32 _sysExWrite;
+};
+
+#endif
@@ -29,13 +29,17 @@
 #include "audio/softsynth/emumidi.h"
 #include "audio/musicplugin.h"
 #include "audio/mpu401.h"
+#include "audio/softsynth/midiring.h"
 
+#include "common/atomic.h"
 #include "common/config-manager.h"
 #include "common/debug.h"
 #include "common/error.h"
 #include "common/events.h"
 #include "common/file.h"
+#include "common/mutex.h"
 #include "common/system.h"
+#include "common/timer.h"
 #include "common/util.h"
 #include "common/archive.h"
 #include "common/textconsole.h"
@@ -389,119 +393,239 @@ MidiChannel *MidiDriver_MT32::getPercussionChannel() {
 	return &_midiChannels[9];
 }
 
-// This code should be used when calling the timer callback from the mixer thread is undesirable.
-// Note that it results in less accurate timing.
-#if 0
-class MidiEvent_MT32 {
-public:
-	MidiEvent_MT32 *_next;
-	uint32 _msg; // 0xFFFFFFFF indicates a sysex message
-	byte *_data;
-	uint32 _len;
-
-	MidiEvent_MT32(uint32 msg, byte *data, uint32 len) {
-		_msg = msg;
-		if (len > 0) {
-			_data = new byte[len];
-			memcpy(_data, data, len);
-		}
-		_len = len;
-		_next = NULL;
-	}
-
-	MidiEvent_MT32() {
-		if (_len > 0)
-			delete _data;
-	}
-};
+////////////////////////////////////////
+//
+// MidiDriver_ThreadedMT32
+//
+////////////////////////////////////////
 
+/**
+ * An MT-32 driver which runs the music player from a timer instead of the
+ * mixer thread. MIDI events are passed to the rendering in the mixer thread
+ * through a fixed size ring, so sending never waits for the rendering and
+ * the rendering never waits for a sender.
+ *
+ * Every event is stamped with the sample position it is meant for, derived
+ * from the number of timer ticks so far. The timer may run late and fire
+ * several ticks in a row; the stamps keep the events apart anyway. Events
+ * are scheduled at least one mixer callback ahead of the rendering, so the
+ * rendering can play them at the exact sample.
+ */
 class MidiDriver_ThreadedMT32 : public MidiDriver_MT32 {
 private:
-	OSystem::Mutex _eventMutex;
-	MidiEvent_MT32 *_events;
-	TimerManager::TimerProc _timer_proc;
+	enum {
+		kSysExMessage = 0xFFFFFFFF,
+		kMaxTimers = 4,
+		FIXP_SHIFT = 16
+	};
+
+	MidiEventRing _events;
+
+	/** Serializes the senders, the rendering never takes it */
+	Common::Mutex _sendMutex;
+
+	// Sender side, in 16.16 fixed point samples
+	uint32 _eventTime;
+	uint32 _eventTimeFrac;
+	uint32 _samplesPerTick;
+	bool _droppedEvents;
+
+	// Published by the rendering
+	volatile uint32 _renderPos;
+	volatile uint32 _renderAhead;
+
+	/**
+	 * The timer manager tells timers apart by their proc, so every driver
+	 * gets one of its own out of s_timerProcs. s_timerUsed tracks which
+	 * are taken; drivers are only created and destroyed on the main thread.
+	 */
+	static const Common::TimerManager::TimerProc s_timerProcs[kMaxTimers];
+	static bool s_timerUsed[kMaxTimers];
+	int _timer;
+
+	Common::TimerManager::TimerProc _timerProc;
+	void *_timerParam;
+
+	template<int N>
+	static void timerCallback(void *refCon);
+	void onTick();
+
+	void pushEvent(uint32 msg, const byte *data, uint32 len);
+	void playEvent(const MidiEventRing::Event &event);
 
-	void pushMidiEvent(MidiEvent_MT32 *event);
-	MidiEvent_MT32 *popMidiEvent();
+public:
+	MidiDriver_ThreadedMT32(Audio::Mixer *mixer);
+	~MidiDriver_ThreadedMT32();
 
-protected:
+	/** Return whether another driver can be created. */
+	static bool hasFreeTimer();
+
+	int open();
+	void close();
 	void send(uint32 b);
 	void sysEx(const byte *msg, uint16 length);
+	void setTimerCallback(void *timer_param, Common::TimerManager::TimerProc timer_proc);
 
-public:
-	MidiDriver_ThreadedMT32(Audio::Mixer *mixer);
+	// AudioStream API
+	int readBuffer(int16 *data, const int numSamples);
+};
 
-	void onTimer();
-	void close();
-	void setTimerCallback(void *timer_param, TimerManager::TimerProc timer_proc);
+const Common::TimerManager::TimerProc MidiDriver_ThreadedMT32::s_timerProcs[kMaxTimers] = {
+	&MidiDriver_ThreadedMT32::timerCallback<0>,
+	&MidiDriver_ThreadedMT32::timerCallback<1>,
+	&MidiDriver_ThreadedMT32::timerCallback<2>,
+	&MidiDriver_ThreadedMT32::timerCallback<3>
 };
 
+bool MidiDriver_ThreadedMT32::s_timerUsed[kMaxTimers] = { false, false, false, false };
 
-MidiDriver_ThreadedMT32::MidiDriver_ThreadedMT32(Audio::Mixer *mixer) : MidiDriver_MT32(mixer) {
-	_events = NULL;
-	_timer_proc = NULL;
+MidiDriver_ThreadedMT32::MidiDriver_ThreadedMT32(Audio::Mixer *mixer) : MidiDriver_MT32(mixer),
+	_eventTime(0), _eventTimeFrac(0), _samplesPerTick(0), _droppedEvents(false),
+	_renderPos(0), _renderAhead(0), _timer(-1), _timerProc(0), _timerParam(0) {
+	for (uint i = 0; i < ARRAYSIZE(s_timerUsed); ++i) {
+		if (!s_timerUsed[i]) {
+			s_timerUsed[i] = true;
+			_timer = i;
+			break;
+		}
+	}
+	assert(_timer >= 0);
+}
+
+MidiDriver_ThreadedMT32::~MidiDriver_ThreadedMT32() {
+	// The timer is removed by close()
+	s_timerUsed[_timer] = false;
+}
+
+bool MidiDriver_ThreadedMT32::hasFreeTimer() {
+	for (uint i = 0; i < ARRAYSIZE(s_timerUsed); ++i) {
+		if (!s_timerUsed[i])
+			return true;
+	}
+	return false;
+}
+
+int MidiDriver_ThreadedMT32::open() {
+	if (_isOpen)
+		return MERR_ALREADY_OPEN;
+
+	_events.clear();
+	_eventTime = _eventTimeFrac = 0;
+	_droppedEvents = false;
+	_renderPos = 0;
+	// Until the mixer tells otherwise, schedule 50ms ahead
+	_renderAhead = getRate() / 20;
+
+	const int d = getRate() / _baseFreq;
+	const int r = getRate() % _baseFreq;
+	_samplesPerTick = (d << FIXP_SHIFT) + (r << FIXP_SHIFT) / _baseFreq;
+
+	return MidiDriver_MT32::open();
 }
 
 void MidiDriver_ThreadedMT32::close() {
 	MidiDriver_MT32::close();
-	while ((popMidiEvent() != NULL)) {
-		// Just eat any leftover events
-	}
+
+	// Just drop any leftover events
+	_events.clear();
 }
 
-void MidiDriver_ThreadedMT32::setTimerCallback(void *timer_param, TimerManager::TimerProc timer_proc) {
-	if (!_timer_proc || !timer_proc) {
-		if (_timer_proc)
-			_vm->_timer->removeTimerProc(_timer_proc);
-		_timer_proc = timer_proc;
-		if (timer_proc)
-			_vm->_timer->installTimerProc(timer_proc, getBaseTempo(), timer_param, "MT32tempo");
-	}
+void MidiDriver_ThreadedMT32::setTimerCallback(void *timer_param, Common::TimerManager::TimerProc timer_proc) {
+	Common::TimerManager *timerManager = g_system->getTimerManager();
+
+	if (_timerProc)
+		timerManager->removeTimerProc(s_timerProcs[_timer]);
+
+	_timerProc = timer_proc;
+	_timerParam = timer_param;
+
+	if (timer_proc)
+		timerManager->installTimerProc(s_timerProcs[_timer], getBaseTempo(), this, Common::String::format("MT32tempo%d", _timer));
 }
 
-void MidiDriver_ThreadedMT32::pushMidiEvent(MidiEvent_MT32 *event) {
-	Common::StackLock lock(_eventMutex);
-	if (_events == NULL) {
-		_events = event;
-	} else {
-		MidiEvent_MT32 *last = _events;
-		while (last->_next != NULL)
-			last = last->_next;
-		last->_next = event;
+template<int N>
+void MidiDriver_ThreadedMT32::timerCallback(void *refCon) {
+	MidiDriver_ThreadedMT32 *driver = (MidiDriver_ThreadedMT32 *)refCon;
+	driver->onTick();
+	(*driver->_timerProc)(driver->_timerParam);
+}
+
+void MidiDriver_ThreadedMT32::onTick() {
+	Common::StackLock lock(_sendMutex);
+
+	_eventTimeFrac += _samplesPerTick;
+	_eventTime += _eventTimeFrac >> FIXP_SHIFT;
+	_eventTimeFrac &= (1 << FIXP_SHIFT) - 1;
+
+	// The timer and the mixer run off different clocks. If the events
+	// would be late, or the rendering fell far behind (e.g. because the
+	// mixer is paused), start over from the current render position.
+	const uint32 renderAhead = Common::atomicLoad(&_renderAhead);
+	const int32 lead = (int32)(_eventTime - Common::atomicLoad(&_renderPos));
+	if (lead < 0 || lead > (int32)(renderAhead * 4)) {
+		_eventTime = Common::atomicLoad(&_renderPos) + renderAhead;
+		_eventTimeFrac = 0;
 	}
 }
 
-MidiEvent_MT32 *MidiDriver_ThreadedMT32::popMidiEvent() {
-	Common::StackLock lock(_eventMutex);
-	MidiEvent_MT32 *event;
-	event = _events;
-	if (event != NULL)
-		_events = event->_next;
-	return event;
+void MidiDriver_ThreadedMT32::pushEvent(uint32 msg, const byte *data, uint32 len) {
+	Common::StackLock lock(_sendMutex);
+
+	if (!_events.push(msg, _eventTime, data, len)) {
+		if (!_droppedEvents)
+			warning("MT32emu: Event queue overflow, dropping MIDI events");
+		_droppedEvents = true;
+	}
 }
 
 void MidiDriver_ThreadedMT32::send(uint32 b) {
-	MidiEvent_MT32 *event = new MidiEvent_MT32(b, NULL, 0);
-	pushMidiEvent(event);
+	pushEvent(b, 0, 0);
 }
 
 void MidiDriver_ThreadedMT32::sysEx(const byte *msg, uint16 length) {
-	MidiEvent_MT32 *event = new MidiEvent_MT32(0xFFFFFFFF, msg, length);
-	pushMidiEvent(event);
+	pushEvent(kSysExMessage, msg, length);
+}
+
+void MidiDriver_ThreadedMT32::playEvent(const MidiEventRing::Event &event) {
+	if (event.msg == kSysExMessage)
+		MidiDriver_MT32::sysEx(event.data, event.length);
+	else
+		MidiDriver_MT32::send(event.msg);
 }
 
-void MidiDriver_ThreadedMT32::onTimer() {
-	MidiEvent_MT32 *event;
-	while ((event = popMidiEvent()) != NULL) {
-		if (event->_msg == 0xFFFFFFFF) {
-			MidiDriver_MT32::sysEx(event->_data, event->_len);
-		} else {
-			MidiDriver_MT32::send(event->_msg);
+int MidiDriver_ThreadedMT32::readBuffer(int16 *data, const int numSamples) {
+	const uint32 len = numSamples / 2;
+
+	// Events have to be scheduled at least one mixer callback ahead
+	if (len > Common::atomicLoad(&_renderAhead))
+		Common::atomicStore(&_renderAhead, len);
+
+	uint32 renderPos = _renderPos;
+
+	for (uint32 done = 0; done < len; ) {
+		uint32 step = len - done;
+
+		// Play all events which are due, and render up to the next one
+		MidiEventRing::Event event;
+		while (_events.peek(event)) {
+			const int32 delta = (int32)(event.timestamp - renderPos);
+			if (delta > 0) {
+				step = MIN<uint32>(step, delta);
+				break;
+			}
+
+			playEvent(event);
+			_events.pop();
 		}
-		delete event;
+
+		generateSamples(data + done * 2, step);
+		done += step;
+		renderPos += step;
+		Common::atomicStore(&_renderPos, renderPos);
 	}
+
+	return numSamples;
 }
-#endif
 
 
 // Plugin interface
@@ -541,7 +665,13 @@ Common::Error MT32EmuMusicPlugin::createInstance(MidiDriver **mididriver, MidiDr
 	if (ConfMan.hasKey("extrapath"))
 		SearchMan.addDirectory("extrapath", ConfMan.get("extrapath"));
 
-	*mididriver = new MidiDriver_MT32(g_system->getMixer());
+	// The threaded driver runs the music player from a timer, instead of
+	// the mixer callback. It is experimental, so it has to be enabled with
+	// mt32_threaded.
+	if (ConfMan.hasKey("mt32_threaded") && ConfMan.getBool("mt32_threaded") && MidiDriver_ThreadedMT32::hasFreeTimer())
+		*mididriver = new MidiDriver_ThreadedMT32(g_system->getMixer());
+	else
+		*mididriver = new MidiDriver_MT32(g_system->getMixer());
 
 	return Common::kNoError;
 }
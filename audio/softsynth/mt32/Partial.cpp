@@ -429,13 +429,9 @@ float *Partial::mixBuffersRingMix(float *buf1, float *buf2, unsigned long len) {
 		return buf1;
 	}
 
-	while (len--) {
-		// FIXME: At this point we have no idea whether this is remotely correct...
-		*buf1 = *buf1 * *buf2 + *buf1;
-		buf1++;
-		buf2++;
-	}
-	return buf1;
+	// FIXME: At this point we have no idea whether this is remotely correct...
+	getSampleOps()->ringModulate(buf1, buf2, len);
+	return buf1 + len;
 }
 
 float *Partial::mixBuffersRing(float *buf1, float *buf2, unsigned long len) {
@@ -446,13 +442,9 @@ float *Partial::mixBuffersRing(float *buf1, float *buf2, unsigned long len) {
 		return NULL;
 	}
 
-	while (len--) {
-		// FIXME: At this point we have no idea whether this is remotely correct...
-		*buf1 = *buf1 * *buf2;
-		buf1++;
-		buf2++;
-	}
-	return buf1;
+	// FIXME: At this point we have no idea whether this is remotely correct...
+	getSampleOps()->multiply(buf1, buf2, len);
+	return buf1 + len;
 }
 
 bool Partial::hasRingModulatingSlave() const {
@@ -524,12 +516,11 @@ bool Partial::produceOutput(float *leftBuf, float *rightBuf, unsigned long lengt
 		}
 	}
 
-	for (unsigned int i = 0; i < numGenerated; i++) {
-		*leftBuf++ = partialBuf[i] * stereoVolume.leftVol;
-	}
-	for (unsigned int i = 0; i < numGenerated; i++) {
-		*rightBuf++ = partialBuf[i] * stereoVolume.rightVol;
-	}
+	const SampleOps *ops = getSampleOps();
+	ops->scale(leftBuf, partialBuf, stereoVolume.leftVol, numGenerated);
+	ops->scale(rightBuf, partialBuf, stereoVolume.rightVol, numGenerated);
+	leftBuf += numGenerated;
+	rightBuf += numGenerated;
 	while (numGenerated < length) {
 		*leftBuf++ = 0.0f;
 		*rightBuf++ = 0.0f;
@@ -0,0 +1,448 @@
+/*
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "SampleOps.h"
+
+namespace MT32Emu {
+
+static inline Bit16s clipBit16s(Bit32s a) {
+	// Clamp values above 32767 to 32767, and values below -32768 to -32768
+	if ((a + 32768) & ~65535) {
+		return (a >> 31) ^ 32767;
+	}
+	return a;
+}
+
+// Keeps the float to integer conversions defined; anything beyond this is
+// clipped anyway. NaN ends up at the lower bound.
+static const float CONVERSION_LIMIT = 65536.0f;
+
+static inline float clampForConversion(float a) {
+	if (!(a >= -CONVERSION_LIMIT)) {
+		return -CONVERSION_LIMIT;
+	}
+	if (a > CONVERSION_LIMIT) {
+		return CONVERSION_LIMIT;
+	}
+	return a;
+}
+
+// Macro for killing denormalled numbers, as in freeverb.h
+static inline float undenormalise(float x) {
+	union {
+		float f;
+		Bit32u i;
+	} u;
+	u.f = x;
+	if ((u.i & 0x7f800000) == 0) {
+		return 0.0f;
+	}
+	return x;
+}
+
+static void mixScalar(float *target, const float *source, Bit32u len) {
+	while (len--) {
+		*target++ += *source++;
+	}
+}
+
+static void subtractScalar(float *target, const float *source, Bit32u len) {
+	while (len--) {
+		*target++ -= *source++;
+	}
+}
+
+static void scaleScalar(float *target, const float *source, float factor, Bit32u len) {
+	while (len--) {
+		*target++ = *source++ * factor;
+	}
+}
+
+static void multiplyScalar(float *target, const float *source, Bit32u len) {
+	while (len--) {
+		*target++ *= *source++;
+	}
+}
+
+static void ringModulateScalar(float *target, const float *source, Bit32u len) {
+	while (len--) {
+		*target = *target * *source + *target;
+		target++;
+		source++;
+	}
+}
+
+static void truncateToBit16sScalar(Bit16s *target, const float *source, float gain, Bit32u len) {
+	while (len--) {
+		*target++ = clipBit16s((Bit32s)clampForConversion(*source++ * gain));
+	}
+}
+
+static void floorToBit16sScalar(Bit16s *target, const float *source, float gain, Bit32u len) {
+	while (len--) {
+		*target++ = clipBit16s((Bit32s)floor(clampForConversion(*source++ * gain)));
+	}
+}
+
+static void mixOutputScalar(Bit16s *stream, const Bit16s *left1, const Bit16s *left2, const Bit16s *left3,
+                            const Bit16s *right1, const Bit16s *right2, const Bit16s *right3, Bit32u len) {
+	for (Bit32u i = 0; i < len; i++) {
+		stream[0] = clipBit16s((Bit32s)left1[i] + (Bit32s)left2[i] + (Bit32s)left3[i]);
+		stream[1] = clipBit16s((Bit32s)right1[i] + (Bit32s)right2[i] + (Bit32s)right3[i]);
+		stream += 2;
+	}
+}
+
+static void allpassScalar(float *buffer, float *samples, float feedback, Bit32u len) {
+	while (len--) {
+		float input = *samples;
+		float bufout = undenormalise(*buffer);
+		*samples++ = -input + bufout;
+		*buffer++ = input + (bufout * feedback);
+	}
+}
+
+static void combFeedScalar(float *buffer, const float *input, const float *filterstore, float feedback, Bit32u len) {
+	while (len--) {
+		*buffer++ = *input++ + (*filterstore++ * feedback);
+	}
+}
+
+static const SampleOps scalarOps = {
+	mixScalar,
+	subtractScalar,
+	scaleScalar,
+	multiplyScalar,
+	ringModulateScalar,
+	truncateToBit16sScalar,
+	floorToBit16sScalar,
+	mixOutputScalar,
+	allpassScalar,
+	combFeedScalar
+};
+
+#ifdef SCUMMVM_SSE2
+
+SCUMMVM_TARGET_SSE2 static void mixSSE2(float *target, const float *source, Bit32u len) {
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		_mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target), _mm_loadu_ps(source)));
+	}
+	mixScalar(target, source, len);
+}
+
+SCUMMVM_TARGET_SSE2 static void subtractSSE2(float *target, const float *source, Bit32u len) {
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		_mm_storeu_ps(target, _mm_sub_ps(_mm_loadu_ps(target), _mm_loadu_ps(source)));
+	}
+	subtractScalar(target, source, len);
+}
+
+SCUMMVM_TARGET_SSE2 static void scaleSSE2(float *target, const float *source, float factor, Bit32u len) {
+	const __m128 f = _mm_set1_ps(factor);
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		_mm_storeu_ps(target, _mm_mul_ps(_mm_loadu_ps(source), f));
+	}
+	scaleScalar(target, source, factor, len);
+}
+
+SCUMMVM_TARGET_SSE2 static void multiplySSE2(float *target, const float *source, Bit32u len) {
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		_mm_storeu_ps(target, _mm_mul_ps(_mm_loadu_ps(target), _mm_loadu_ps(source)));
+	}
+	multiplyScalar(target, source, len);
+}
+
+SCUMMVM_TARGET_SSE2 static void ringModulateSSE2(float *target, const float *source, Bit32u len) {
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		const __m128 t = _mm_loadu_ps(target);
+		_mm_storeu_ps(target, _mm_add_ps(_mm_mul_ps(t, _mm_loadu_ps(source)), t));
+	}
+	ringModulateScalar(target, source, len);
+}
+
+SCUMMVM_TARGET_SSE2 static inline __m128 clampForConversionSSE2(__m128 a) {
+	// maxps returns the second operand if either one is NaN
+	a = _mm_max_ps(a, _mm_set1_ps(-CONVERSION_LIMIT));
+	return _mm_min_ps(a, _mm_set1_ps(CONVERSION_LIMIT));
+}
+
+SCUMMVM_TARGET_SSE2 static void truncateToBit16sSSE2(Bit16s *target, const float *source, float gain, Bit32u len) {
+	const __m128 g = _mm_set1_ps(gain);
+	for (; len >= 8; len -= 8, target += 8, source += 8) {
+		const __m128i lo = _mm_cvttps_epi32(clampForConversionSSE2(_mm_mul_ps(_mm_loadu_ps(source), g)));
+		const __m128i hi = _mm_cvttps_epi32(clampForConversionSSE2(_mm_mul_ps(_mm_loadu_ps(source + 4), g)));
+		_mm_storeu_si128((__m128i *)target, _mm_packs_epi32(lo, hi));
+	}
+	truncateToBit16sScalar(target, source, gain, len);
+}
+
+SCUMMVM_TARGET_SSE2 static inline __m128i floorSSE2(__m128 a) {
+	// Truncate, then correct the negative non-integers
+	const __m128i t = _mm_cvttps_epi32(a);
+	const __m128 above = _mm_cmpgt_ps(_mm_cvtepi32_ps(t), a);
+	return _mm_add_epi32(t, _mm_castps_si128(above));
+}
+
+SCUMMVM_TARGET_SSE2 static void floorToBit16sSSE2(Bit16s *target, const float *source, float gain, Bit32u len) {
+	const __m128 g = _mm_set1_ps(gain);
+	for (; len >= 8; len -= 8, target += 8, source += 8) {
+		const __m128i lo = floorSSE2(clampForConversionSSE2(_mm_mul_ps(_mm_loadu_ps(source), g)));
+		const __m128i hi = floorSSE2(clampForConversionSSE2(_mm_mul_ps(_mm_loadu_ps(source + 4), g)));
+		_mm_storeu_si128((__m128i *)target, _mm_packs_epi32(lo, hi));
+	}
+	floorToBit16sScalar(target, source, gain, len);
+}
+
+SCUMMVM_TARGET_SSE2 static inline __m128i sumStreamsSSE2(const Bit16s *s1, const Bit16s *s2, const Bit16s *s3) {
+	const __m128i a = _mm_loadu_si128((const __m128i *)s1);
+	const __m128i b = _mm_loadu_si128((const __m128i *)s2);
+	const __m128i c = _mm_loadu_si128((const __m128i *)s3);
+
+	// Sign extend to 32 bits, so the sum does not saturate halfway
+	__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16);
+	__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16);
+	lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(b, b), 16));
+	hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(b, b), 16));
+	lo = _mm_add_epi32(lo, _mm_srai_epi32(_mm_unpacklo_epi16(c, c), 16));
+	hi = _mm_add_epi32(hi, _mm_srai_epi32(_mm_unpackhi_epi16(c, c), 16));
+
+	return _mm_packs_epi32(lo, hi);
+}
+
+SCUMMVM_TARGET_SSE2 static void mixOutputSSE2(Bit16s *stream, const Bit16s *left1, const Bit16s *left2, const Bit16s *left3,
+                                              const Bit16s *right1, const Bit16s *right2, const Bit16s *right3, Bit32u len) {
+	Bit32u i = 0;
+	for (; i + 8 <= len; i += 8, stream += 16) {
+		const __m128i left = sumStreamsSSE2(left1 + i, left2 + i, left3 + i);
+		const __m128i right = sumStreamsSSE2(right1 + i, right2 + i, right3 + i);
+		_mm_storeu_si128((__m128i *)stream, _mm_unpacklo_epi16(left, right));
+		_mm_storeu_si128((__m128i *)(stream + 8), _mm_unpackhi_epi16(left, right));
+	}
+	mixOutputScalar(stream, left1 + i, left2 + i, left3 + i, right1 + i, right2 + i, right3 + i, len - i);
+}
+
+SCUMMVM_TARGET_SSE2 static inline __m128 undenormaliseSSE2(__m128 a) {
+	const __m128i exponent = _mm_and_si128(_mm_castps_si128(a), _mm_set1_epi32(0x7f800000));
+	const __m128 denormal = _mm_castsi128_ps(_mm_cmpeq_epi32(exponent, _mm_setzero_si128()));
+	return _mm_andnot_ps(denormal, a);
+}
+
+SCUMMVM_TARGET_SSE2 static void allpassSSE2(float *buffer, float *samples, float feedback, Bit32u len) {
+	const __m128 f = _mm_set1_ps(feedback);
+	for (; len >= 4; len -= 4, buffer += 4, samples += 4) {
+		const __m128 input = _mm_loadu_ps(samples);
+		const __m128 bufout = undenormaliseSSE2(_mm_loadu_ps(buffer));
+		_mm_storeu_ps(samples, _mm_sub_ps(bufout, input));
+		_mm_storeu_ps(buffer, _mm_add_ps(input, _mm_mul_ps(bufout, f)));
+	}
+	allpassScalar(buffer, samples, feedback, len);
+}
+
+SCUMMVM_TARGET_SSE2 static void combFeedSSE2(float *buffer, const float *input, const float *filterstore, float feedback, Bit32u len) {
+	const __m128 f = _mm_set1_ps(feedback);
+	for (; len >= 4; len -= 4, buffer += 4, input += 4, filterstore += 4) {
+		_mm_storeu_ps(buffer, _mm_add_ps(_mm_loadu_ps(input), _mm_mul_ps(_mm_loadu_ps(filterstore), f)));
+	}
+	combFeedScalar(buffer, input, filterstore, feedback, len);
+}
+
+static const SampleOps sse2Ops = {
+	mixSSE2,
+	subtractSSE2,
+	scaleSSE2,
+	multiplySSE2,
+	ringModulateSSE2,
+	truncateToBit16sSSE2,
+	floorToBit16sSSE2,
+	mixOutputSSE2,
+	allpassSSE2,
+	combFeedSSE2
+};
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_NEON
+
+static void mixNEON(float *target, const float *source, Bit32u len) {
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		vst1q_f32(target, vaddq_f32(vld1q_f32(target), vld1q_f32(source)));
+	}
+	mixScalar(target, source, len);
+}
+
+static void subtractNEON(float *target, const float *source, Bit32u len) {
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		vst1q_f32(target, vsubq_f32(vld1q_f32(target), vld1q_f32(source)));
+	}
+	subtractScalar(target, source, len);
+}
+
+static void scaleNEON(float *target, const float *source, float factor, Bit32u len) {
+	const float32x4_t f = vdupq_n_f32(factor);
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		vst1q_f32(target, vmulq_f32(vld1q_f32(source), f));
+	}
+	scaleScalar(target, source, factor, len);
+}
+
+static void multiplyNEON(float *target, const float *source, Bit32u len) {
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		vst1q_f32(target, vmulq_f32(vld1q_f32(target), vld1q_f32(source)));
+	}
+	multiplyScalar(target, source, len);
+}
+
+static void ringModulateNEON(float *target, const float *source, Bit32u len) {
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		const float32x4_t t = vld1q_f32(target);
+		// Not vmlaq_f32, which may be fused and round differently
+		vst1q_f32(target, vaddq_f32(vmulq_f32(t, vld1q_f32(source)), t));
+	}
+	ringModulateScalar(target, source, len);
+}
+
+static inline float32x4_t clampForConversionNEON(float32x4_t a) {
+	// vmaxq_f32 would keep NaN, so select explicitly
+	const float32x4_t lower = vdupq_n_f32(-CONVERSION_LIMIT);
+	a = vbslq_f32(vcgeq_f32(a, lower), a, lower);
+	return vminq_f32(a, vdupq_n_f32(CONVERSION_LIMIT));
+}
+
+static void truncateToBit16sNEON(Bit16s *target, const float *source, float gain, Bit32u len) {
+	const float32x4_t g = vdupq_n_f32(gain);
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		const int32x4_t t = vcvtq_s32_f32(clampForConversionNEON(vmulq_f32(vld1q_f32(source), g)));
+		vst1_s16(target, vqmovn_s32(t));
+	}
+	truncateToBit16sScalar(target, source, gain, len);
+}
+
+static void floorToBit16sNEON(Bit16s *target, const float *source, float gain, Bit32u len) {
+	const float32x4_t g = vdupq_n_f32(gain);
+	for (; len >= 4; len -= 4, target += 4, source += 4) {
+		const float32x4_t a = clampForConversionNEON(vmulq_f32(vld1q_f32(source), g));
+		// Truncate, then correct the negative non-integers
+		const int32x4_t t = vcvtq_s32_f32(a);
+		const uint32x4_t above = vcgtq_f32(vcvtq_f32_s32(t), a);
+		vst1_s16(target, vqmovn_s32(vaddq_s32(t, vreinterpretq_s32_u32(above))));
+	}
+	floorToBit16sScalar(target, source, gain, len);
+}
+
+static inline int16x4_t sumStreamsNEON(const Bit16s *s1, const Bit16s *s2, const Bit16s *s3) {
+	int32x4_t sum = vmovl_s16(vld1_s16(s1));
+	sum = vaddw_s16(sum, vld1_s16(s2));
+	sum = vaddw_s16(sum, vld1_s16(s3));
+	return vqmovn_s32(sum);
+}
+
+static void mixOutputNEON(Bit16s *stream, const Bit16s *left1, const Bit16s *left2, const Bit16s *left3,
+                          const Bit16s *right1, const Bit16s *right2, const Bit16s *right3, Bit32u len) {
+	Bit32u i = 0;
+	for (; i + 4 <= len; i += 4, stream += 8) {
+		int16x4x2_t out;
+		out.val[0] = sumStreamsNEON(left1 + i, left2 + i, left3 + i);
+		out.val[1] = sumStreamsNEON(right1 + i, right2 + i, right3 + i);
+		vst2_s16(stream, out);
+	}
+	mixOutputScalar(stream, left1 + i, left2 + i, left3 + i, right1 + i, right2 + i, right3 + i, len - i);
+}
+
+static inline float32x4_t undenormaliseNEON(float32x4_t a) {
+	const uint32x4_t bits = vreinterpretq_u32_f32(a);
+	const uint32x4_t normal = vtstq_u32(bits, vdupq_n_u32(0x7f800000));
+	return vreinterpretq_f32_u32(vandq_u32(bits, normal));
+}
+
+static void allpassNEON(float *buffer, float *samples, float feedback, Bit32u len) {
+	const float32x4_t f = vdupq_n_f32(feedback);
+	for (; len >= 4; len -= 4, buffer += 4, samples += 4) {
+		const float32x4_t input = vld1q_f32(samples);
+		const float32x4_t bufout = undenormaliseNEON(vld1q_f32(buffer));
+		vst1q_f32(samples, vsubq_f32(bufout, input));
+		vst1q_f32(buffer, vaddq_f32(input, vmulq_f32(bufout, f)));
+	}
+	allpassScalar(buffer, samples, feedback, len);
+}
+
+static void combFeedNEON(float *buffer, const float *input, const float *filterstore, float feedback, Bit32u len) {
+	const float32x4_t f = vdupq_n_f32(feedback);
+	for (; len >= 4; len -= 4, buffer += 4, input += 4, filterstore += 4) {
+		vst1q_f32(buffer, vaddq_f32(vld1q_f32(input), vmulq_f32(vld1q_f32(filterstore), f)));
+	}
+	combFeedScalar(buffer, input, filterstore, feedback, len);
+}
+
+static const SampleOps neonOps = {
+	mixNEON,
+	subtractNEON,
+	scaleNEON,
+	multiplyNEON,
+	ringModulateNEON,
+	truncateToBit16sNEON,
+	floorToBit16sNEON,
+	mixOutputNEON,
+	allpassNEON,
+	combFeedNEON
+};
+
+#endif // SCUMMVM_NEON
+
+const SampleOps *getSampleOps(SampleOpsImpl impl) {
+	switch (impl) {
+	case SampleOpsImpl_SCALAR:
+		return &scalarOps;
+#ifdef SCUMMVM_SSE2
+	case SampleOpsImpl_SSE2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureSSE2)) {
+			return &sse2Ops;
+		}
+		break;
+#endif
+#ifdef SCUMMVM_NEON
+	case SampleOpsImpl_NEON:
+		if (Common::hasCPUFeature(Common::kCPUFeatureNEON)) {
+			return &neonOps;
+		}
+		break;
+#endif
+	default:
+		break;
+	}
+	return NULL;
+}
+
+const SampleOps *getSampleOps() {
+	static const SampleOps *best = NULL;
+	if (best == NULL) {
+		for (int impl = SampleOpsImpl_COUNT - 1; best == NULL; impl--) {
+			best = getSampleOps((SampleOpsImpl)impl);
+		}
+	}
+	return best;
+}
+
+}
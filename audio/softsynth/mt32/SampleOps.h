@@ -0,0 +1,89 @@
+/*
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_SAMPLEOPS_H
+#define MT32EMU_SAMPLEOPS_H
+
+#include "Structures.h"
+
+namespace MT32Emu {
+
+/**
+ * The per sample loops of the rendering, which work on whole blocks and
+ * thus can be vectorized. Every implementation computes exactly the same
+ * results as the scalar one, as long as the float operations themselves
+ * follow IEEE single precision (SSE2, AArch64 NEON). 32-bit ARM NEON
+ * flushes denormals to zero, which may change the 16-bit output by one
+ * for signals which are practically silent.
+ *
+ * Converted values are clamped to +/-65536 before the conversion to
+ * integers, so huge and NaN values saturate like in the scalar code on x86.
+ */
+struct SampleOps {
+	/** target[i] += source[i] */
+	void (*mix)(float *target, const float *source, Bit32u len);
+	/** target[i] -= source[i] */
+	void (*subtract)(float *target, const float *source, Bit32u len);
+	/** target[i] = source[i] * factor */
+	void (*scale)(float *target, const float *source, float factor, Bit32u len);
+	/** target[i] *= source[i] */
+	void (*multiply)(float *target, const float *source, Bit32u len);
+	/** target[i] = target[i] * source[i] + target[i] */
+	void (*ringModulate)(float *target, const float *source, Bit32u len);
+
+	/** target[i] = clip((Bit32s)(source[i] * gain)) */
+	void (*truncateToBit16s)(Bit16s *target, const float *source, float gain, Bit32u len);
+	/** target[i] = clip((Bit32s)floor(source[i] * gain)) */
+	void (*floorToBit16s)(Bit16s *target, const float *source, float gain, Bit32u len);
+
+	/**
+	 * Sum up the three left and three right streams with clipping into
+	 * interleaved stereo.
+	 */
+	void (*mixOutput)(Bit16s *stream, const Bit16s *left1, const Bit16s *left2, const Bit16s *left3,
+	                  const Bit16s *right1, const Bit16s *right2, const Bit16s *right3, Bit32u len);
+
+	/**
+	 * Run len samples through a Freeverb allpass filter, in place. buffer
+	 * points to the delay line at the current position, len must not
+	 * exceed the space left in the delay line.
+	 */
+	void (*allpass)(float *buffer, float *samples, float feedback, Bit32u len);
+	/** buffer[i] = input[i] + filterstore[i] * feedback */
+	void (*combFeed)(float *buffer, const float *input, const float *filterstore, float feedback, Bit32u len);
+};
+
+enum SampleOpsImpl {
+	SampleOpsImpl_SCALAR,
+	SampleOpsImpl_SSE2,
+	SampleOpsImpl_NEON,
+
+	SampleOpsImpl_COUNT
+};
+
+/**
+ * Return a specific implementation, or NULL if it is not available on this
+ * build or CPU. SampleOpsImpl_SCALAR is always available.
+ */
+const SampleOps *getSampleOps(SampleOpsImpl impl);
+
+/**
+ * Return the fastest implementation available.
+ */
+const SampleOps *getSampleOps();
+
+}
+
+#endif
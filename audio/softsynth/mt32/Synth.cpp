@@ -58,14 +58,6 @@ static inline void clearIfNonNull(Bit16s *stream, Bit32u len) {
 	}
 }
 
-static inline void mix(float *target, const float *stream, Bit32u len) {
-	while (len--) {
-		*target += *stream;
-		stream++;
-		target++;
-	}
-}
-
 static inline void clearFloats(float *leftBuf, float *rightBuf, Bit32u len) {
 	// FIXME: Use memset() where compatibility is guaranteed (if this turns out to be a win)
 	while (len--) {
@@ -74,57 +66,31 @@ static inline void clearFloats(float *leftBuf, float *rightBuf, Bit32u len) {
 	}
 }
 
-static inline Bit16s clipBit16s(Bit32s a) {
-	// Clamp values above 32767 to 32767, and values below -32768 to -32768
-	if ((a + 32768) & ~65535) {
-		return (a >> 31) ^ 32767;
-	}
-	return a;
-}
-
 static void floatToBit16s_nice(Bit16s *target, const float *source, Bit32u len, float outputGain) {
-	float gain = outputGain * 16384.0f;
-	while (len--) {
-		// Since we're not shooting for accuracy here, don't worry about the rounding mode.
-		*target = clipBit16s((Bit32s)(*source * gain));
-		source++;
-		target++;
-	}
+	// Since we're not shooting for accuracy here, don't worry about the rounding mode.
+	getSampleOps()->truncateToBit16s(target, source, outputGain * 16384.0f, len);
 }
 
 static void floatToBit16s_pure(Bit16s *target, const float *source, Bit32u len, float /*outputGain*/) {
-	while (len--) {
-		*target = clipBit16s((Bit32s)floor(*source * 8192.0f));
-		source++;
-		target++;
-	}
+	getSampleOps()->floorToBit16s(target, source, 8192.0f, len);
 }
 
 static void floatToBit16s_reverb(Bit16s *target, const float *source, Bit32u len, float outputGain) {
-	float gain = outputGain * 8192.0f;
-	while (len--) {
-		*target = clipBit16s((Bit32s)floor(*source * gain));
-		source++;
-		target++;
-	}
+	getSampleOps()->floorToBit16s(target, source, outputGain * 8192.0f, len);
 }
 
 static void floatToBit16s_generation1(Bit16s *target, const float *source, Bit32u len, float outputGain) {
-	float gain = outputGain * 8192.0f;
+	getSampleOps()->floorToBit16s(target, source, outputGain * 8192.0f, len);
 	while (len--) {
-		*target = clipBit16s((Bit32s)floor(*source * gain));
 		*target = (*target & 0x8000) | ((*target << 1) & 0x7FFE);
-		source++;
 		target++;
 	}
 }
 
 static void floatToBit16s_generation2(Bit16s *target, const float *source, Bit32u len, float outputGain) {
-	float gain = outputGain * 8192.0f;
+	getSampleOps()->floorToBit16s(target, source, outputGain * 8192.0f, len);
 	while (len--) {
-		*target = clipBit16s((Bit32s)floor(*source * gain));
 		*target = (*target & 0x8000) | ((*target << 1) & 0x7FFE) | ((*target >> 14) & 0x0001);
-		source++;
 		target++;
 	}
 }
@@ -310,14 +276,17 @@ LoadResult Synth::loadPCMROM(const char *filename) {
 		closeFile(file);
 		return LoadResult_Invalid;
 	}
+	Bit8u *romData = new Bit8u[2 * pcmROMSize];
+	file->read(romData, 2 * pcmROMSize);
 	if (file->err()) {
+		delete[] romData;
 		closeFile(file);
 		return LoadResult_Unreadable;
 	}
-	LoadResult rc = LoadResult_OK;
+	closeFile(file);
 	for (int i = 0; i < pcmROMSize; i++) {
-		Bit8u s = file->readByte();
-		Bit8u c = file->readByte();
+		Bit8u s = romData[i * 2];
+		Bit8u c = romData[i * 2 + 1];
 
 		int order[16] = {0, 9, 1, 2, 3, 4, 5, 6, 7, 10, 11, 12, 13, 14, 15, 8};
 
@@ -343,8 +312,8 @@ LoadResult Synth::loadPCMROM(const char *filename) {
 
 		pcmROMData[i] = lin;
 	}
-	closeFile(file);
-	return rc;
+	delete[] romData;
+	return LoadResult_OK;
 }
 
 bool Synth::initPCMList(Bit16u mapAddress, Bit16u count) {
@@ -1332,11 +1301,8 @@ void Synth::render(Bit16s *stream, Bit32u len) {
 	while (len > 0) {
 		Bit32u thisLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
 		renderStreams(tmpNonReverbLeft, tmpNonReverbRight, tmpReverbDryLeft, tmpReverbDryRight, tmpReverbWetLeft, tmpReverbWetRight, thisLen);
-		for (Bit32u i = 0; i < thisLen; i++) {
-			stream[0] = clipBit16s((Bit32s)tmpNonReverbLeft[i] + (Bit32s)tmpReverbDryLeft[i] + (Bit32s)tmpReverbWetLeft[i]);
-			stream[1] = clipBit16s((Bit32s)tmpNonReverbRight[i] + (Bit32s)tmpReverbDryRight[i] + (Bit32s)tmpReverbWetRight[i]);
-			stream += 2;
-		}
+		getSampleOps()->mixOutput(stream, tmpNonReverbLeft, tmpReverbDryLeft, tmpReverbWetLeft, tmpNonReverbRight, tmpReverbDryRight, tmpReverbWetRight, thisLen);
+		stream += thisLen * 2;
 		len -= thisLen;
 	}
 }
@@ -1438,12 +1404,13 @@ void Synth::renderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16s
 
 // FIXME: Using more temporary buffers than we need to
 void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16s *reverbDryLeft, Bit16s *reverbDryRight, Bit16s *reverbWetLeft, Bit16s *reverbWetRight, Bit32u len) {
+	const SampleOps *ops = getSampleOps();
 	clearFloats(&tmpBufMixLeft[0], &tmpBufMixRight[0], len);
 	if (!reverbEnabled) {
 		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
 			if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-				mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-				mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+				ops->mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
+				ops->mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
 			}
 		}
 		if (nonReverbLeft != NULL) {
@@ -1460,8 +1427,8 @@ void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16
 		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
 			if (!partialManager->shouldReverb(i)) {
 				if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-					mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-					mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+					ops->mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
+					ops->mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
 				}
 			}
 		}
@@ -1476,8 +1443,8 @@ void Synth::doRenderStreams(Bit16s *nonReverbLeft, Bit16s *nonReverbRight, Bit16
 		for (unsigned int i = 0; i < MT32EMU_MAX_PARTIALS; i++) {
 			if (partialManager->shouldReverb(i)) {
 				if (partialManager->produceOutput(i, &tmpBufPartialLeft[0], &tmpBufPartialRight[0], len)) {
-					mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
-					mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
+					ops->mix(&tmpBufMixLeft[0], &tmpBufPartialLeft[0], len);
+					ops->mix(&tmpBufMixRight[0], &tmpBufPartialRight[0], len);
 				}
 			}
 		}
@@ -17,6 +17,19 @@ void allpass::setbuffer(float *buf, int size)
 	bufsize = size;
 }
 
+void allpass::processBlock(float *samples, int len, const MT32Emu::SampleOps *ops)
+{
+	while (len > 0) {
+		int n = bufsize - bufidx;
+		if (n > len) n = len;
+		ops->allpass(buffer + bufidx, samples, feedback, n);
+		bufidx += n;
+		if (bufidx >= bufsize) bufidx = 0;
+		samples += n;
+		len -= n;
+	}
+}
+
 void allpass::mute()
 {
 	for (int i=0; i<bufsize; i++)
@@ -56,6 +69,28 @@ void comb::setbuffer(float *buf, int size)
 	bufsize = size;
 }
 
+void comb::processBlock(const float *input, float *output, float *store, int len, const MT32Emu::SampleOps *ops)
+{
+	while (len > 0) {
+		int n = bufsize - bufidx;
+		if (n > len) n = len;
+		float *buf = buffer + bufidx;
+		// The lowpass in the feedback loop runs sample by sample; the
+		// delay line is read and written in one go
+		for (int i = 0; i < n; i++) {
+			output[i] = undenormalise(buf[i]);
+			filterstore = undenormalise((output[i]*damp2) + (filterstore*damp1));
+			store[i] = filterstore;
+		}
+		ops->combFeed(buf, input, store, feedback, n);
+		bufidx += n;
+		if (bufidx >= bufsize) bufidx = 0;
+		input += n;
+		output += n;
+		len -= n;
+	}
+}
+
 void comb::mute()
 {
 	for (int i=0; i<bufsize; i++)
@@ -101,21 +136,31 @@ revmodel::revmodel(float scaletuning)
 	int bufsize;
 
 	// Allocate buffers for the components
+	blocksize = 0x7FFFFFFF;
 	for (i = 0; i < numcombs; i++) {
 		bufsize = int(scaletuning * combtuning[i]);
 		combL[i].setbuffer(new float[bufsize], bufsize);
+		if (bufsize < blocksize) blocksize = bufsize;
 		bufsize += int(scaletuning * stereospread);
 		combR[i].setbuffer(new float[bufsize], bufsize);
 	}
 	for (i = 0; i < numallpasses; i++) {
 		bufsize = int(scaletuning * allpasstuning[i]);
 		allpassL[i].setbuffer(new float[bufsize], bufsize);
+		if (bufsize < blocksize) blocksize = bufsize;
 		allpassL[i].setfeedback(0.5f);
 		bufsize += int(scaletuning * stereospread);
 		allpassR[i].setbuffer(new float[bufsize], bufsize);
 		allpassR[i].setfeedback(0.5f);
 	}
 
+	blockbuffers = new float[5 * blocksize];
+	blockinput = blockbuffers;
+	blockL = blockinput + blocksize;
+	blockR = blockL + blocksize;
+	blockcomb = blockR + blocksize;
+	blockstore = blockcomb + blocksize;
+
 	// Set default values
 	dry = initialdry;
 	wet = initialwet*scalewet;
@@ -141,6 +186,7 @@ revmodel::~revmodel()
 		allpassL[i].deletebuffer();
 		allpassR[i].deletebuffer();
 	}
+	delete[] blockbuffers;
 }
 
 void revmodel::mute()
@@ -168,45 +214,63 @@ void revmodel::mute()
 
 void revmodel::process(const float *inputL, const float *inputR, float *outputL, float *outputR, long numsamples)
 {
-	float outL,outR,input;
+	const MT32Emu::SampleOps *ops = MT32Emu::getSampleOps();
+	int i, len;
 
-	while (numsamples-- > 0)
+	// Each filter processes a whole block before the next one, which gives
+	// the same results as going through all of them sample by sample
+	while (numsamples > 0)
 	{
-		int i;
+		len = numsamples < blocksize ? (int)numsamples : blocksize;
+
+		for (i=0; i<len; i++)
+		{
+			float input = (inputL[i] + inputR[i]) * gain;
 
-		outL = outR = 0;
-		input = (*inputL + *inputR) * gain;
+			// Implementation of 2-stage IIR single-pole low-pass filter
+			// found at the entrance of reverb processing on real devices
+			filtprev1 += (input - filtprev1) * filtval;
+			filtprev2 += (filtprev1 - filtprev2) * filtval;
+			blockinput[i] = filtprev2;
 
-		// Implementation of 2-stage IIR single-pole low-pass filter
-		// found at the entrance of reverb processing on real devices
-		filtprev1 += (input - filtprev1) * filtval;
-		filtprev2 += (filtprev1 - filtprev2) * filtval;
-		input = filtprev2;
+			blockL[i] = blockR[i] = 0;
+		}
 
-		int s = -1;
-		// Accumulate comb filters in parallel
+		// Accumulate comb filters in parallel, with alternating signs
 		for (i=0; i<numcombs; i++)
 		{
-			outL += s * combL[i].process(input);
-			outR += s * combR[i].process(input);
-			s = -s;
+			combL[i].processBlock(blockinput, blockcomb, blockstore, len, ops);
+			if (i & 1)
+				ops->mix(blockL, blockcomb, len);
+			else
+				ops->subtract(blockL, blockcomb, len);
+
+			combR[i].processBlock(blockinput, blockcomb, blockstore, len, ops);
+			if (i & 1)
+				ops->mix(blockR, blockcomb, len);
+			else
+				ops->subtract(blockR, blockcomb, len);
 		}
 
 		// Feed through allpasses in series
 		for (i=0; i<numallpasses; i++)
 		{
-			outL = allpassL[i].process(outL);
-			outR = allpassR[i].process(outR);
+			allpassL[i].processBlock(blockL, len, ops);
+			allpassR[i].processBlock(blockR, len, ops);
 		}
 
 		// Calculate output REPLACING anything already there
-		*outputL = outL*wet1 + outR*wet2;
-		*outputR = outR*wet1 + outL*wet2;
-		
-		inputL++;
-		inputR++;
-		outputL++;
-		outputR++;
+		for (i=0; i<len; i++)
+		{
+			outputL[i] = blockL[i]*wet1 + blockR[i]*wet2;
+			outputR[i] = blockR[i]*wet1 + blockL[i]*wet2;
+		}
+
+		inputL += len;
+		inputR += len;
+		outputL += len;
+		outputR += len;
+		numsamples -= len;
 	}
 }
 
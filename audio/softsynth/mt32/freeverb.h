@@ -1,6 +1,8 @@
 #ifndef _freeverb_
 #define _freeverb_
 
+#include "SampleOps.h"
+
 // Reverb model tuning values
 //
 // Written by Jezar at Dreampoint, June 2000
@@ -60,6 +62,7 @@ public:
 	        void    setbuffer(float *buf, int size);
 	        void    deletebuffer();
 	inline  float   process(float inp);
+	        void    processBlock(float *samples, int len, const MT32Emu::SampleOps *ops);
 	        void    mute();
 	        void    setfeedback(float val);
 	        float   getfeedback();
@@ -101,6 +104,7 @@ public:
 	        void    setbuffer(float *buf, int size);
 	        void    deletebuffer();
 	inline  float   process(float inp);
+	        void    processBlock(const float *input, float *output, float *store, int len, const MT32Emu::SampleOps *ops);
 	        void    mute();
 	        void    setdamp(float val);
 	        float   getdamp();
@@ -177,6 +181,16 @@ private:
 	float filtprev1;
 	float filtprev2;
 
+	// Scratch buffers for block processing; blocksize is the shortest
+	// delay line, so no filter reads what it wrote in the same block
+	int    blocksize;
+	float  *blockbuffers;
+	float  *blockinput;
+	float  *blockL;
+	float  *blockR;
+	float  *blockcomb;
+	float  *blockstore;
+
 	// Comb filters
 	comb   combL[numcombs];
 	comb   combR[numcombs];
@@ -9,6 +9,7 @@ MODULE_OBJS := \
 	Partial.o \
 	PartialManager.o \
 	Poly.o \
+	SampleOps.o \
 	Synth.o \
 	TVA.o \
 	TVF.o \
@@ -100,6 +100,7 @@ const unsigned int MAX_PRERENDER_SAMPLES = 1024;
 }
 
 #include "Structures.h"
+#include "SampleOps.h"
 #include "common/file.h"
 #include "Tables.h"
 #include "Poly.h"
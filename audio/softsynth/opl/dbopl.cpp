@@ -35,6 +35,7 @@
 // Last synch with DOSBox SVN trunk r3752
 
 #include "dbopl.h"
+#include "dbopl_block.h"
 
 #ifndef DISABLE_DOSBOX_OPL
 
@@ -146,7 +147,9 @@ static Bit16u SinTable[ 512 ];
 
 //6 is just 0 shifted and masked
 
-static Bit16s WaveTable[ 8 * 512 ];
+//The extra entry at the end allows the block operations to gather 32 bit
+//words at 16 bit entries
+static Bit16s WaveTable[ 8 * 512 + 1 ];
 //Distance into WaveTable the wave starts
 static const Bit16u WaveBaseTable[8] = {
 	0x000, 0x200, 0x200, 0x800,
@@ -595,6 +598,44 @@ INLINE Bits Operator::GetSample( Bits modulation ) {
 	}
 }
 
+#if ( DBOPL_WAVE != WAVE_TABLEMUL )
+#error "The block wise rendering requires WAVE_TABLEMUL"
+#endif
+
+//Multiplier for GetWave of a volume, 0 when silent
+static INLINE Bit32s VolumeMul( Bitu vol ) {
+	if ( ENV_SILENT( vol ) )
+		return 0;
+	return MulTable[ vol >> ENV_EXTRA ];
+}
+
+//Fill mul with the volume multipliers of the next samples, returns true if they're all silent
+bool Operator::ForwardVolumeBlock( Bit32u samples, Bit32s* mul ) {
+	//The envelope can't change while off or holding the sustain level
+	if ( state == OFF || ( state == SUSTAIN && ( reg20 & MASK_SUSTAIN ) ) ) {
+		Bit32s value = VolumeMul( ForwardVolume() );
+		for ( Bitu i = 0; i < samples; i++ ) {
+			mul[ i ] = value;
+		}
+		return value == 0;
+	}
+	for ( Bitu i = 0; i < samples; i++ ) {
+		mul[ i ] = VolumeMul( ForwardVolume() );
+	}
+	return false;
+}
+
+//Same as calling GetSample for every sample, modulation can be 0 for none
+void Operator::GetSampleBlock( Chip* chip, Bit32u samples, const Bit32s* modulation, Bit32s* output ) {
+	if ( ForwardVolumeBlock( samples, chip->blockMul ) ) {
+		//Simply forward the wave
+		waveIndex += waveCurrent * samples;
+		memset( output, 0, sizeof( Bit32s ) * samples );
+		return;
+	}
+	chip->blockOps->wave( output, modulation, chip->blockMul, &waveIndex, waveCurrent, WAVE_SH, waveBase, waveMask, samples );
+}
+
 Operator::Operator() {
 	chanData = 0;
 	freqMul = 0;
@@ -838,6 +879,24 @@ INLINE void Channel::GeneratePercussion( Chip* chip, Bit32s* output ) {
 	}
 }
 
+void Channel::GenerateFeedbackBlock( Chip* chip, Bit32u samples, Bit32s* output ) {
+	Operator* modulator = Op( 0 );
+	Bit32s* mul = chip->blockMul;
+	Bit32u* phase = chip->blockPhase;
+	modulator->ForwardVolumeBlock( samples, mul );
+	chip->blockOps->phase( phase, &modulator->waveIndex, modulator->waveCurrent, WAVE_SH, samples );
+	//Every sample depends on the previous two, so this has to stay serial
+	const Bit16s* waveBase = modulator->waveBase;
+	const Bit32u waveMask = modulator->waveMask;
+	for ( Bitu i = 0; i < samples; i++ ) {
+		//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
+		Bit32s mod = (Bit32u)((old[0] + old[1])) >> feedback;
+		old[0] = old[1];
+		old[1] = ( waveBase[ ( phase[ i ] + mod ) & waveMask ] * mul[ i ] ) >> MUL_SH;
+		output[ i ] = old[0];
+	}
+}
+
 template<SynthMode mode>
 Channel* Channel::BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output ) {
 	switch( mode ) {
@@ -911,81 +970,58 @@ Channel* Channel::BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output ) {
 		Op( 4 )->Prepare( chip );
 		Op( 5 )->Prepare( chip );
 	}
-	for ( Bitu i = 0; i < samples; i++ ) {
-		//Early out for percussion handlers
-		if ( mode == sm2Percussion ) {
+	//Percussion is generated sample by sample
+	if ( mode == sm2Percussion ) {
+		for ( Bitu i = 0; i < samples; i++ ) {
 			GeneratePercussion<false>( chip, output + i );
-			continue;	//Prevent some unitialized value bitching
-		} else if ( mode == sm3Percussion ) {
+		}
+		return( this + 3 );
+	} else if ( mode == sm3Percussion ) {
+		for ( Bitu i = 0; i < samples; i++ ) {
 			GeneratePercussion<true>( chip, output + i * 2 );
-			continue;	//Prevent some unitialized value bitching
 		}
+		return( this + 3 );
+	}
 
-		//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
-		Bit32s mod = (Bit32u)((old[0] + old[1])) >> feedback;
-		old[0] = old[1];
-		old[1] = Op(0)->GetSample( mod );
-		Bit32s sample;
-		Bit32s out0 = old[0];
-		if ( mode == sm2AM || mode == sm3AM ) {
-			sample = out0 + Op(1)->GetSample( 0 );
-		} else if ( mode == sm2FM || mode == sm3FM ) {
-			sample = Op(1)->GetSample( out0 );
-		} else if ( mode == sm3FMFM ) {
-			Bits next = Op(1)->GetSample( out0 );
-			next = Op(2)->GetSample( next );
-			sample = Op(3)->GetSample( next );
-		} else if ( mode == sm3AMFM ) {
-			sample = out0;
-			Bits next = Op(1)->GetSample( 0 );
-			next = Op(2)->GetSample( next );
-			sample += Op(3)->GetSample( next );
-		} else if ( mode == sm3FMAM ) {
-			sample = Op(1)->GetSample( out0 );
-			Bits next = Op(2)->GetSample( 0 );
-			sample += Op(3)->GetSample( next );
-		} else if ( mode == sm3AMAM ) {
-			sample = out0;
-			Bits next = Op(1)->GetSample( 0 );
-			sample += Op(2)->GetSample( next );
-			sample += Op(3)->GetSample( 0 );
-		}
-		switch( mode ) {
-		case sm2AM:
-		case sm2FM:
-			output[ i ] += sample;
-			break;
-		case sm3AM:
-		case sm3FM:
-		case sm3FMFM:
-		case sm3AMFM:
-		case sm3FMAM:
-		case sm3AMAM:
-			output[ i * 2 + 0 ] += sample & maskLeft;
-			output[ i * 2 + 1 ] += sample & maskRight;
-			break;
-		case sm2Percussion:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		case sm3Percussion:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		case sm4Start:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		case sm6Start:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		}
+	//Run the operators one after another over the whole block, they only
+	//depend on the output of the previous operator for the same sample
+	const BlockOps* ops = chip->blockOps;
+	Bit32s* out0 = chip->blockFeedback;
+	Bit32s* sample = chip->blockSample;
+	Bit32s* temp = chip->blockTemp;
+	GenerateFeedbackBlock( chip, samples, out0 );
+	if ( mode == sm2AM || mode == sm3AM ) {
+		Op(1)->GetSampleBlock( chip, samples, 0, sample );
+		ops->mix( sample, out0, samples );
+	} else if ( mode == sm2FM || mode == sm3FM ) {
+		Op(1)->GetSampleBlock( chip, samples, out0, sample );
+	} else if ( mode == sm3FMFM ) {
+		Op(1)->GetSampleBlock( chip, samples, out0, temp );
+		Op(2)->GetSampleBlock( chip, samples, temp, temp );
+		Op(3)->GetSampleBlock( chip, samples, temp, sample );
+	} else if ( mode == sm3AMFM ) {
+		Op(1)->GetSampleBlock( chip, samples, 0, temp );
+		Op(2)->GetSampleBlock( chip, samples, temp, temp );
+		Op(3)->GetSampleBlock( chip, samples, temp, sample );
+		ops->mix( sample, out0, samples );
+	} else if ( mode == sm3FMAM ) {
+		Op(1)->GetSampleBlock( chip, samples, out0, sample );
+		Op(2)->GetSampleBlock( chip, samples, 0, temp );
+		Op(3)->GetSampleBlock( chip, samples, temp, temp );
+		ops->mix( sample, temp, samples );
+	} else if ( mode == sm3AMAM ) {
+		Op(1)->GetSampleBlock( chip, samples, 0, temp );
+		Op(2)->GetSampleBlock( chip, samples, temp, sample );
+		Op(3)->GetSampleBlock( chip, samples, 0, temp );
+		ops->mix( sample, out0, samples );
+		ops->mix( sample, temp, samples );
+	}
+	if ( mode == sm2AM || mode == sm2FM ) {
+		ops->mix( output, sample, samples );
+	} else {
+		ops->mixStereo( output, sample, maskLeft, maskRight, samples );
 	}
+
 	switch( mode ) {
 	case sm2AM:
 	case sm2FM:
@@ -1024,6 +1060,7 @@ Chip::Chip() {
 	regBD = 0;
 	reg104 = 0;
 	opl3Active = 0;
+	blockOps = getBlockOps();
 }
 
 INLINE Bit32u Chip::ForwardNoise() {
@@ -1221,7 +1258,7 @@ Bit32u Chip::WriteAddr( Bit32u port, Bit8u val ) {
 
 void Chip::GenerateBlock2( Bitu total, Bit32s* output ) {
 	while ( total > 0 ) {
-		Bit32u samples = ForwardLFO( total );
+		Bit32u samples = ForwardLFO( total < (Bitu)BLOCK_MAX ? total : (Bitu)BLOCK_MAX );
 		memset(output, 0, sizeof(Bit32s) * samples);
 		int count = 0;
 		for( Channel* ch = chan; ch < chan + 9; ) {
@@ -1235,7 +1272,7 @@ void Chip::GenerateBlock2( Bitu total, Bit32s* output ) {
 
 void Chip::GenerateBlock3( Bitu total, Bit32s* output  ) {
 	while ( total > 0 ) {
-		Bit32u samples = ForwardLFO( total );
+		Bit32u samples = ForwardLFO( total < (Bitu)BLOCK_MAX ? total : (Bitu)BLOCK_MAX );
 		memset(output, 0, sizeof(Bit32s) * samples * 2);
 		int count = 0;
 		for( Channel* ch = chan; ch < chan + 18; ) {
@@ -61,6 +61,7 @@ typedef uint32 Bit32u;
 struct Chip;
 struct Operator;
 struct Channel;
+struct BlockOps;
 
 #if (DBOPL_WAVE == WAVE_HANDLER)
 typedef Bits ( DB_FASTCALL *WaveHandler) ( Bitu i, Bitu volume );
@@ -91,6 +92,11 @@ enum {
 	SHIFT_KEYCODE = 24
 };
 
+//Maximum amount of samples the channels render in one go
+enum {
+	BLOCK_MAX = 256
+};
+
 struct Operator {
 public:
 	//Masks for operator 20 values
@@ -178,6 +184,10 @@ public:
 
 	Bits GetSample( Bits modulation );
 	Bits GetWave( Bitu index, Bitu vol );
+
+	//Block wise versions of ForwardVolume and GetSample, see BlockOps
+	bool ForwardVolumeBlock( Bit32u samples, Bit32s* mul );
+	void GetSampleBlock( Chip* chip, Bit32u samples, const Bit32s* modulation, Bit32s* output );
 public:
 	Operator();
 };
@@ -212,6 +222,9 @@ struct Channel {
 	template< bool opl3Mode >
 	void GeneratePercussion( Chip* chip, Bit32s* output );
 
+	//Run the first operator with its feedback, output is delayed by one sample
+	void GenerateFeedbackBlock( Chip* chip, Bit32u samples, Bit32s* output );
+
 	//Generate blocks of data in specific modes
 	template<SynthMode mode>
 	Channel* BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output );
@@ -254,6 +267,15 @@ struct Chip {
 	//0 or -1 when enabled
 	Bit8s opl3Active;
 
+	//Vectorized loops used by the channels
+	const BlockOps* blockOps;
+	//Scratch buffers for rendering the channels block wise
+	Bit32s blockMul[ BLOCK_MAX ];
+	Bit32u blockPhase[ BLOCK_MAX ];
+	Bit32s blockFeedback[ BLOCK_MAX ];
+	Bit32s blockSample[ BLOCK_MAX ];
+	Bit32s blockTemp[ BLOCK_MAX ];
+
 	//Return the maximum amount of samples before and LFO change
 	Bit32u ForwardLFO( Bit32u samples );
 	Bit32u ForwardNoise();
@@ -0,0 +1,398 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_AVX2
+#include <immintrin.h>
+#endif
+#ifdef SCUMMVM_NEON
+#include <arm_neon.h>
+#endif
+
+#include "audio/softsynth/opl/dbopl_block.h"
+#include "common/util.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+
+namespace OPL {
+namespace DOSBox {
+namespace DBOPL {
+
+// The wave and volume tables use 16.16 fixed point, see MUL_SH in dbopl.cpp
+#define BLOCK_MUL_SH 16
+
+static void phaseScalar(Bit32u *index, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift, Bit32u samples) {
+	Bit32u counter = *waveIndex;
+	for (Bit32u i = 0; i < samples; ++i) {
+		counter += waveAdd;
+		index[i] = counter >> waveShift;
+	}
+	*waveIndex = counter;
+}
+
+template<bool modulated>
+static inline void waveSamplesScalar(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u &counter, Bit32u waveAdd, Bit32u waveShift,
+                                     const Bit16s *waveBase, Bit32u waveMask, Bit32u samples) {
+	for (Bit32u i = 0; i < samples; ++i) {
+		counter += waveAdd;
+		Bit32u index = counter >> waveShift;
+		if (modulated)
+			index += mod[i];
+		out[i] = (waveBase[index & waveMask] * mul[i]) >> BLOCK_MUL_SH;
+	}
+}
+
+static void waveScalar(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift,
+                       const Bit16s *waveBase, Bit32u waveMask, Bit32u samples) {
+	if (mod)
+		waveSamplesScalar<true>(out, mod, mul, *waveIndex, waveAdd, waveShift, waveBase, waveMask, samples);
+	else
+		waveSamplesScalar<false>(out, mod, mul, *waveIndex, waveAdd, waveShift, waveBase, waveMask, samples);
+}
+
+static void mixScalar(Bit32s *output, const Bit32s *input, Bit32u samples) {
+	for (Bit32u i = 0; i < samples; ++i)
+		output[i] += input[i];
+}
+
+static void mixStereoScalar(Bit32s *output, const Bit32s *input, Bit32s maskLeft, Bit32s maskRight, Bit32u samples) {
+	for (Bit32u i = 0; i < samples; ++i) {
+		output[i * 2 + 0] += input[i] & maskLeft;
+		output[i * 2 + 1] += input[i] & maskRight;
+	}
+}
+
+static const BlockOps blockOpsScalar = {
+	phaseScalar,
+	waveScalar,
+	mixScalar,
+	mixStereoScalar
+};
+
+#ifdef SCUMMVM_SSE2
+
+/**
+ * The phase counters of four consecutive samples, starting with the
+ * counter of the next sample. The adds wrap around like the scalar ones.
+ */
+SCUMMVM_TARGET_SSE2 static inline __m128i firstCountersSSE2(Bit32u counter, Bit32u waveAdd) {
+	return _mm_add_epi32(_mm_set1_epi32(counter), _mm_set_epi32(waveAdd * 4, waveAdd * 3, waveAdd * 2, waveAdd));
+}
+
+// SSE2 lacks a 32 bit multiplication with a 32 bit result; the lower half
+// of the unsigned 64 bit product is the same for signed operands, though.
+SCUMMVM_TARGET_SSE2 static inline __m128i mulloSSE2(__m128i a, __m128i b) {
+	const __m128i even = _mm_mul_epu32(a, b);
+	const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+SCUMMVM_TARGET_SSE2 static void phaseSSE2(Bit32u *index, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift, Bit32u samples) {
+	const __m128i shift = _mm_cvtsi32_si128(waveShift);
+	const __m128i step = _mm_set1_epi32(waveAdd * 4);
+	__m128i counters = firstCountersSSE2(*waveIndex, waveAdd);
+
+	Bit32u i = 0;
+	for (; i + 4 <= samples; i += 4) {
+		_mm_storeu_si128((__m128i *)(index + i), _mm_srl_epi32(counters, shift));
+		counters = _mm_add_epi32(counters, step);
+	}
+
+	*waveIndex += i * waveAdd;
+	phaseScalar(index + i, waveIndex, waveAdd, waveShift, samples - i);
+}
+
+template<bool modulated>
+SCUMMVM_TARGET_SSE2 static inline void waveSamplesSSE2(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift,
+                                                      const Bit16s *waveBase, Bit32u waveMask, Bit32u samples) {
+	const __m128i shift = _mm_cvtsi32_si128(waveShift);
+	const __m128i step = _mm_set1_epi32(waveAdd * 4);
+	const __m128i mask = _mm_set1_epi32(waveMask);
+	__m128i counters = firstCountersSSE2(*waveIndex, waveAdd);
+
+	Bit32u i = 0;
+	for (; i + 4 <= samples; i += 4) {
+		__m128i index = _mm_srl_epi32(counters, shift);
+		if (modulated)
+			index = _mm_add_epi32(index, _mm_loadu_si128((const __m128i *)(mod + i)));
+		counters = _mm_add_epi32(counters, step);
+
+		// There is no gather in SSE2, so look up the wave table one by one
+		Bit32u offsets[4];
+		_mm_storeu_si128((__m128i *)offsets, _mm_and_si128(index, mask));
+		const __m128i wave = _mm_set_epi32(waveBase[offsets[3]], waveBase[offsets[2]], waveBase[offsets[1]], waveBase[offsets[0]]);
+
+		const __m128i product = mulloSSE2(wave, _mm_loadu_si128((const __m128i *)(mul + i)));
+		_mm_storeu_si128((__m128i *)(out + i), _mm_srai_epi32(product, BLOCK_MUL_SH));
+	}
+
+	*waveIndex += i * waveAdd;
+	waveSamplesScalar<modulated>(out + i, modulated ? mod + i : 0, mul + i, *waveIndex, waveAdd, waveShift, waveBase, waveMask, samples - i);
+}
+
+SCUMMVM_TARGET_SSE2 static void waveSSE2(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift,
+                                         const Bit16s *waveBase, Bit32u waveMask, Bit32u samples) {
+	if (mod)
+		waveSamplesSSE2<true>(out, mod, mul, waveIndex, waveAdd, waveShift, waveBase, waveMask, samples);
+	else
+		waveSamplesSSE2<false>(out, mod, mul, waveIndex, waveAdd, waveShift, waveBase, waveMask, samples);
+}
+
+SCUMMVM_TARGET_SSE2 static void mixSSE2(Bit32s *output, const Bit32s *input, Bit32u samples) {
+	Bit32u i = 0;
+	for (; i + 4 <= samples; i += 4) {
+		const __m128i sum = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(output + i)), _mm_loadu_si128((const __m128i *)(input + i)));
+		_mm_storeu_si128((__m128i *)(output + i), sum);
+	}
+	mixScalar(output + i, input + i, samples - i);
+}
+
+SCUMMVM_TARGET_SSE2 static void mixStereoSSE2(Bit32s *output, const Bit32s *input, Bit32s maskLeft, Bit32s maskRight, Bit32u samples) {
+	const __m128i mask = _mm_set_epi32(maskRight, maskLeft, maskRight, maskLeft);
+
+	Bit32u i = 0;
+	for (; i + 4 <= samples; i += 4) {
+		const __m128i in = _mm_loadu_si128((const __m128i *)(input + i));
+		__m128i *out = (__m128i *)(output + i * 2);
+		const __m128i low = _mm_and_si128(_mm_unpacklo_epi32(in, in), mask);
+		const __m128i high = _mm_and_si128(_mm_unpackhi_epi32(in, in), mask);
+		_mm_storeu_si128(out, _mm_add_epi32(_mm_loadu_si128(out), low));
+		_mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), high));
+	}
+	mixStereoScalar(output + i * 2, input + i, maskLeft, maskRight, samples - i);
+}
+
+static const BlockOps blockOpsSSE2 = {
+	phaseSSE2,
+	waveSSE2,
+	mixSSE2,
+	mixStereoSSE2
+};
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_AVX2
+
+template<bool modulated>
+SCUMMVM_TARGET_AVX2 static inline void waveSamplesAVX2(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift,
+                                                      const Bit16s *waveBase, Bit32u waveMask, Bit32u samples) {
+	const __m128i shift = _mm_cvtsi32_si128(waveShift);
+	const __m256i step = _mm256_set1_epi32(waveAdd * 8);
+	const __m256i mask = _mm256_set1_epi32(waveMask);
+	const Bit32u counter = *waveIndex;
+	__m256i counters = _mm256_add_epi32(_mm256_set1_epi32(counter),
+		_mm256_set_epi32(waveAdd * 8, waveAdd * 7, waveAdd * 6, waveAdd * 5, waveAdd * 4, waveAdd * 3, waveAdd * 2, waveAdd));
+
+	Bit32u i = 0;
+	for (; i + 8 <= samples; i += 8) {
+		__m256i index = _mm256_srl_epi32(counters, shift);
+		if (modulated)
+			index = _mm256_add_epi32(index, _mm256_loadu_si256((const __m256i *)(mod + i)));
+		counters = _mm256_add_epi32(counters, step);
+
+		// Gather 32 bits at each 16 bit entry and sign extend the lower
+		// half; this is why the table has to be readable one entry further.
+		__m256i wave = _mm256_i32gather_epi32((const int *)waveBase, _mm256_and_si256(index, mask), 2);
+		wave = _mm256_srai_epi32(_mm256_slli_epi32(wave, 16), 16);
+
+		const __m256i product = _mm256_mullo_epi32(wave, _mm256_loadu_si256((const __m256i *)(mul + i)));
+		_mm256_storeu_si256((__m256i *)(out + i), _mm256_srai_epi32(product, BLOCK_MUL_SH));
+	}
+
+	*waveIndex += i * waveAdd;
+	waveSamplesScalar<modulated>(out + i, modulated ? mod + i : 0, mul + i, *waveIndex, waveAdd, waveShift, waveBase, waveMask, samples - i);
+}
+
+SCUMMVM_TARGET_AVX2 static void waveAVX2(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift,
+                                         const Bit16s *waveBase, Bit32u waveMask, Bit32u samples) {
+	if (mod)
+		waveSamplesAVX2<true>(out, mod, mul, waveIndex, waveAdd, waveShift, waveBase, waveMask, samples);
+	else
+		waveSamplesAVX2<false>(out, mod, mul, waveIndex, waveAdd, waveShift, waveBase, waveMask, samples);
+}
+
+SCUMMVM_TARGET_AVX2 static void mixAVX2(Bit32s *output, const Bit32s *input, Bit32u samples) {
+	Bit32u i = 0;
+	for (; i + 8 <= samples; i += 8) {
+		const __m256i sum = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(output + i)), _mm256_loadu_si256((const __m256i *)(input + i)));
+		_mm256_storeu_si256((__m256i *)(output + i), sum);
+	}
+	mixScalar(output + i, input + i, samples - i);
+}
+
+// The phase counters and the stereo mixing gain nothing from the wider
+// registers, so the AVX2 set shares them with SSE2 (which AVX2 implies).
+static const BlockOps blockOpsAVX2 = {
+	phaseSSE2,
+	waveAVX2,
+	mixAVX2,
+	mixStereoSSE2
+};
+
+#endif // SCUMMVM_AVX2
+
+#ifdef SCUMMVM_NEON
+
+static inline uint32x4_t firstCountersNEON(Bit32u counter, Bit32u waveAdd) {
+	const Bit32u steps[4] = { waveAdd, waveAdd * 2, waveAdd * 3, waveAdd * 4 };
+	return vaddq_u32(vdupq_n_u32(counter), vld1q_u32(steps));
+}
+
+static void phaseNEON(Bit32u *index, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift, Bit32u samples) {
+	const int32x4_t shift = vdupq_n_s32(-(int32)waveShift);
+	const uint32x4_t step = vdupq_n_u32(waveAdd * 4);
+	uint32x4_t counters = firstCountersNEON(*waveIndex, waveAdd);
+
+	Bit32u i = 0;
+	for (; i + 4 <= samples; i += 4) {
+		vst1q_u32(index + i, vshlq_u32(counters, shift));
+		counters = vaddq_u32(counters, step);
+	}
+
+	*waveIndex += i * waveAdd;
+	phaseScalar(index + i, waveIndex, waveAdd, waveShift, samples - i);
+}
+
+template<bool modulated>
+static inline void waveSamplesNEON(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift,
+                                   const Bit16s *waveBase, Bit32u waveMask, Bit32u samples) {
+	const int32x4_t shift = vdupq_n_s32(-(int32)waveShift);
+	const uint32x4_t step = vdupq_n_u32(waveAdd * 4);
+	const uint32x4_t mask = vdupq_n_u32(waveMask);
+	uint32x4_t counters = firstCountersNEON(*waveIndex, waveAdd);
+
+	Bit32u i = 0;
+	for (; i + 4 <= samples; i += 4) {
+		uint32x4_t index = vshlq_u32(counters, shift);
+		if (modulated)
+			index = vaddq_u32(index, vreinterpretq_u32_s32(vld1q_s32(mod + i)));
+		counters = vaddq_u32(counters, step);
+
+		Bit32u offsets[4];
+		vst1q_u32(offsets, vandq_u32(index, mask));
+		const Bit32s values[4] = { waveBase[offsets[0]], waveBase[offsets[1]], waveBase[offsets[2]], waveBase[offsets[3]] };
+
+		const int32x4_t product = vmulq_s32(vld1q_s32(values), vld1q_s32(mul + i));
+		vst1q_s32(out + i, vshrq_n_s32(product, BLOCK_MUL_SH));
+	}
+
+	*waveIndex += i * waveAdd;
+	waveSamplesScalar<modulated>(out + i, modulated ? mod + i : 0, mul + i, *waveIndex, waveAdd, waveShift, waveBase, waveMask, samples - i);
+}
+
+static void waveNEON(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift,
+                     const Bit16s *waveBase, Bit32u waveMask, Bit32u samples) {
+	if (mod)
+		waveSamplesNEON<true>(out, mod, mul, waveIndex, waveAdd, waveShift, waveBase, waveMask, samples);
+	else
+		waveSamplesNEON<false>(out, mod, mul, waveIndex, waveAdd, waveShift, waveBase, waveMask, samples);
+}
+
+static void mixNEON(Bit32s *output, const Bit32s *input, Bit32u samples) {
+	Bit32u i = 0;
+	for (; i + 4 <= samples; i += 4)
+		vst1q_s32(output + i, vaddq_s32(vld1q_s32(output + i), vld1q_s32(input + i)));
+	mixScalar(output + i, input + i, samples - i);
+}
+
+static void mixStereoNEON(Bit32s *output, const Bit32s *input, Bit32s maskLeft, Bit32s maskRight, Bit32u samples) {
+	const int32x4_t maskL = vdupq_n_s32(maskLeft);
+	const int32x4_t maskR = vdupq_n_s32(maskRight);
+
+	Bit32u i = 0;
+	for (; i + 4 <= samples; i += 4) {
+		const int32x4_t in = vld1q_s32(input + i);
+		int32x4x2_t out = vld2q_s32(output + i * 2);
+		out.val[0] = vaddq_s32(out.val[0], vandq_s32(in, maskL));
+		out.val[1] = vaddq_s32(out.val[1], vandq_s32(in, maskR));
+		vst2q_s32(output + i * 2, out);
+	}
+	mixStereoScalar(output + i * 2, input + i, maskLeft, maskRight, samples - i);
+}
+
+static const BlockOps blockOpsNEON = {
+	phaseNEON,
+	waveNEON,
+	mixNEON,
+	mixStereoNEON
+};
+
+#endif // SCUMMVM_NEON
+
+const BlockOps *getBlockOps(BlockOpsImpl impl) {
+	switch (impl) {
+	case kBlockOpsScalar:
+		return &blockOpsScalar;
+
+#ifdef SCUMMVM_SSE2
+	case kBlockOpsSSE2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+			return &blockOpsSSE2;
+		break;
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kBlockOpsAVX2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+			return &blockOpsAVX2;
+		break;
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kBlockOpsNEON:
+		if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+			return &blockOpsNEON;
+		break;
+#endif
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+const BlockOps *getBlockOps() {
+	static const BlockOpsImpl preferred[] = {
+		kBlockOpsAVX2,
+		kBlockOpsSSE2,
+		kBlockOpsNEON
+	};
+
+	for (int i = 0; i < ARRAYSIZE(preferred); ++i) {
+		const BlockOps *ops = getBlockOps(preferred[i]);
+		if (ops)
+			return ops;
+	}
+
+	return getBlockOps(kBlockOpsScalar);
+}
+
+} // End of namespace DBOPL
+} // End of namespace DOSBox
+} // End of namespace OPL
+
+#endif // !DISABLE_DOSBOX_OPL
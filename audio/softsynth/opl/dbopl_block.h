@@ -0,0 +1,100 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_SOFTSYNTH_OPL_DBOPL_BLOCK_H
+#define AUDIO_SOFTSYNTH_OPL_DBOPL_BLOCK_H
+
+#include "audio/softsynth/opl/dbopl.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+
+namespace OPL {
+namespace DOSBox {
+namespace DBOPL {
+
+/**
+ * The per sample loops of the block wise channel rendering, which can be
+ * vectorized. Every implementation computes exactly the same results as
+ * the scalar one.
+ *
+ * The operators' envelope generators and the feedback of the first operator
+ * of a channel depend on the previous sample, so they are not part of this
+ * and are evaluated in plain C++ by the channels.
+ *
+ * Buffers do not need any particular alignment.
+ */
+struct BlockOps {
+	/**
+	 * Advance the phase counter of an operator:
+	 * index[i] = (*waveIndex += waveAdd) >> waveShift
+	 */
+	void (*phase)(Bit32u *index, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift, Bit32u samples);
+
+	/**
+	 * Generate the output of an operator:
+	 * out[i] = (waveBase[((*waveIndex += waveAdd) >> waveShift) + mod[i]) & waveMask] * mul[i]) >> 16
+	 *
+	 * mod may be 0 for an operator which is not modulated, and may be the
+	 * same buffer as out. mul holds the 16.16 fixed point volume of every
+	 * sample and has to be 0 for silent samples. waveBase has to be readable
+	 * up to waveBase[waveMask + 1].
+	 */
+	void (*wave)(Bit32s *out, const Bit32s *mod, const Bit32s *mul, Bit32u *waveIndex, Bit32u waveAdd, Bit32u waveShift,
+	             const Bit16s *waveBase, Bit32u waveMask, Bit32u samples);
+
+	/** output[i] += input[i] */
+	void (*mix)(Bit32s *output, const Bit32s *input, Bit32u samples);
+
+	/**
+	 * Add a channel to interleaved stereo output:
+	 * output[i * 2] += input[i] & maskLeft, output[i * 2 + 1] += input[i] & maskRight
+	 */
+	void (*mixStereo)(Bit32s *output, const Bit32s *input, Bit32s maskLeft, Bit32s maskRight, Bit32u samples);
+};
+
+enum BlockOpsImpl {
+	kBlockOpsScalar,
+	kBlockOpsSSE2,
+	kBlockOpsAVX2,
+	kBlockOpsNEON,
+
+	kBlockOpsImplCount
+};
+
+/**
+ * Return a specific implementation, or 0 if it is not available on this
+ * build or CPU. kBlockOpsScalar is always available.
+ */
+const BlockOps *getBlockOps(BlockOpsImpl impl);
+
+/**
+ * Return the fastest implementation available.
+ */
+const BlockOps *getBlockOps();
+
+} // End of namespace DBOPL
+} // End of namespace DOSBox
+} // End of namespace OPL
+
+#endif // !DISABLE_DOSBOX_OPL
+
+#endif
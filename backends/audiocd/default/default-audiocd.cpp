@@ -22,6 +22,7 @@
 
 #include "backends/audiocd/default/default-audiocd.h"
 #include "audio/audiostream.h"
+#include "audio/prefetch.h"
 #include "common/system.h"
 
 DefaultAudioCDManager::DefaultAudioCDManager() {
@@ -67,9 +68,12 @@ void DefaultAudioCDManager::play(int track, int numLoops, int startFrame, int du
 			while all other positive numbers indicate precisely the number of desired
 			repetitions. Finally, -1 means infinitely many
 			*/
+			Audio::AudioStream *loop = Audio::makeLoopingAudioStream(stream, start, end, (numLoops < 1) ? numLoops + 1 : numLoops);
+
+			// The tracks are compressed, so decode them off the mixer thread
 			_emulating = true;
 			_mixer->playStream(Audio::Mixer::kMusicSoundType, &_handle,
-			                        Audio::makeLoopingAudioStream(stream, start, end, (numLoops < 1) ? numLoops + 1 : numLoops), -1, _cd.volume, _cd.balance);
+			                        Audio::makePrefetchingAudioStream(loop, DisposeAfterUse::YES, g_system->getWorkerPool()), -1, _cd.volume, _cd.balance);
 		} else {
 			_emulating = false;
 			if (!only_emulate)
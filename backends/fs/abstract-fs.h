@@ -158,6 +158,19 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Returns the size and the modification time of the object referred by
+	 * this path, which together tell whether a file may have changed since
+	 * it was last looked at.
+	 *
+	 * @note The default implementation returns false, for backends which
+	 * cannot provide this information cheaply.
+	 *
+	 * @param size	the size of the file in bytes
+	 * @param modificationTime	the modification time, in seconds in an arbitrary epoch
+	 * @return true if the information is available, false otherwise.
+	 */
+	virtual bool getFileStamp(uint32 &size, uint32 &modificationTime) const { return false; }
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -32,6 +32,7 @@
 #include "common/textconsole.h"
 #include "common/translation.h"
 #include "common/util.h"
+#include "common/workerpool.h"
 #ifdef USE_RGB_COLOR
 #include "common/list.h"
 #endif
@@ -88,6 +89,78 @@ static const int s_gfxModeSwitchTable[][4] = {
 		{ GFX_NORMAL, GFX_DOTMATRIX, -1, -1 }
 	};
 
+/** A horizontal band of a rect, which a job on the worker pool scales */
+struct ScalerBand {
+	ScalerProc *scalerProc;
+	const uint8 *srcPtr;
+	uint32 srcPitch;
+	uint8 *dstPtr;
+	uint32 dstPitch;
+	int width;
+	int height;
+};
+
+static void scaleBand(void *param) {
+	const ScalerBand *band = (const ScalerBand *)param;
+	band->scalerProc(band->srcPtr, band->srcPitch, band->dstPtr, band->dstPitch, band->width, band->height);
+}
+
+/**
+ * Scale a rect like scalerProc(srcPtr, srcPitch, dstPtr, dstPitch, width,
+ * height) would, splitting large rects into horizontal bands which are
+ * scaled in parallel on the worker pool. scaleFactor is the number of
+ * destination rows per source row.
+ *
+ * All scalers only read their source area (plus a one pixel border) and
+ * write their own destination rows, so this gives the same result as
+ * scaling the rect in one go. Bands start at even rows, which keeps the
+ * DotMatrix pattern. The NASM versions of HQ2x and HQ3x keep their state
+ * in global variables, so they always scale the whole rect at once.
+ */
+static void scaleRect(Common::WorkerPool *pool, ScalerProc *scalerProc, const uint8 *srcPtr, uint32 srcPitch,
+                      uint8 *dstPtr, uint32 dstPitch, int width, int height, int scaleFactor) {
+	enum {
+		/** Rects smaller than this (in source pixels) are not split */
+		kMinParallelPixels = 128 * 64,
+		kMaxBands = 8
+	};
+
+	int bands = pool ? MIN<int>(pool->getThreadCount() + 1, kMaxBands) : 1;
+
+#if defined(USE_NASM) && defined(USE_HQ_SCALERS)
+	if (scalerProc == HQ2x || scalerProc == HQ3x)
+		bands = 1;
+#endif
+
+	if (bands == 1 || width * height < kMinParallelPixels || height < bands * 2) {
+		scalerProc(srcPtr, srcPitch, dstPtr, dstPitch, width, height);
+		return;
+	}
+
+	// Round the band height up to an even number of rows
+	const int bandHeight = ((height + bands - 1) / bands + 1) & ~1;
+
+	// The pool gets all bands but the first one, which this thread scales
+	// meanwhile
+	ScalerBand jobs[kMaxBands];
+	Common::JobGroup group(pool);
+	int job = 0;
+	for (int y = bandHeight; y < height; y += bandHeight, ++job) {
+		ScalerBand &band = jobs[job];
+		band.scalerProc = scalerProc;
+		band.srcPtr = srcPtr + y * srcPitch;
+		band.srcPitch = srcPitch;
+		band.dstPtr = dstPtr + y * scaleFactor * dstPitch;
+		band.dstPitch = dstPitch;
+		band.width = width;
+		band.height = MIN(bandHeight, height - y);
+		group.add(scaleBand, &band);
+	}
+
+	scalerProc(srcPtr, srcPitch, dstPtr, dstPitch, width, bandHeight);
+	group.wait();
+}
+
 #ifdef USE_SCALERS
 static int cursorStretch200To240(uint8 *buf, uint32 pitch, int width, int height, int srcX, int srcY, int origSrcY);
 #endif
@@ -1088,8 +1161,8 @@ void SurfaceSdlGraphicsManager::internUpdateScreen() {
 					dst_y = real2Aspect(dst_y);
 
 				assert(scalerProc != NULL);
-				scalerProc((byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
-					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h);
+				scaleRect(g_system->getWorkerPool(), scalerProc, (byte *)srcSurf->pixels + (r->x * 2 + 2) + (r->y + 1) * srcPitch, srcPitch,
+					(byte *)_hwscreen->pixels + rx1 * 2 + dst_y * dstPitch, dstPitch, r->w, dst_h, scale1);
 			}
 
 			r->x = rx1;
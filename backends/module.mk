@@ -68,7 +68,8 @@ MODULE_OBJS += \
 	mixer/sdl/sdl-mixer.o \
 	mutex/sdl/sdl-mutex.o \
 	plugins/sdl/sdl-provider.o \
-	timer/sdl/sdl-timer.o
+	timer/sdl/sdl-timer.o \
+	workerpool/sdl/sdl-workerpool.o
 	
 # SDL 1.3 removed audio CD support
 ifndef USE_SDL13
@@ -81,9 +82,11 @@ ifdef POSIX
 MODULE_OBJS += \
 	fs/posix/posix-fs.o \
 	fs/posix/posix-fs-factory.o \
+	mutex/posix/posix-mutex.o \
 	plugins/posix/posix-provider.o \
 	saves/posix/posix-saves.o \
-	taskbar/unity/unity-taskbar.o
+	taskbar/unity/unity-taskbar.o \
+	workerpool/posix/posix-workerpool.o
 endif
 
 ifdef MACOSX
@@ -20,15 +20,35 @@
  *
  */
 
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
 #include "backends/modular-backend.h"
 #include "base/main.h"
 
 #if defined(USE_NULL_DRIVER)
+#include "backends/mutex/null/null-mutex.h"
+#include "backends/graphics/null/null-graphics.h"
+#include "backends/events/default/default-events.h"
 #include "backends/saves/default/default-saves.h"
 #include "backends/timer/default/default-timer.h"
+#if defined(POSIX)
+#include "backends/mutex/posix/posix-mutex.h"
+#include "backends/workerpool/posix/posix-workerpool.h"
+#endif
 #include "audio/mixer_intern.h"
+#include "common/config-manager.h"
+#include "common/EventRecorder.h"
 #include "common/scummsys.h"
 
+#include <stdio.h>
+
+#if defined(POSIX)
+#include <sys/time.h>
+#include <sys/resource.h>
+#elif defined(WIN32)
+#include <windows.h>
+#endif
+
 /*
  * Include header files needed for the getFilesystemFactory() method.
  */
@@ -40,7 +60,22 @@
 	#include "backends/fs/windows/windows-fs-factory.h"
 #endif
 
-class OSystem_NULL : public ModularBackend {
+/**
+ * Statistics gathered while running with --benchmark.
+ */
+struct NullBenchmarkStats {
+	uint32 frames;
+	uint64 updateScreenMicros;
+
+	uint32 mixCalls;
+	uint32 mixSamples;
+	uint64 mixMicros;
+
+	uint64 startMicros;
+	uint64 endMicros;
+};
+
+class OSystem_NULL : public ModularBackend, Common::EventSource {
 public:
 	OSystem_NULL();
 	virtual ~OSystem_NULL();
@@ -49,14 +84,60 @@ public:
 
 	virtual bool pollEvent(Common::Event &event);
 
+	virtual void updateScreen();
+
 	virtual uint32 getMillis();
 	virtual void delayMillis(uint msecs);
 	virtual void getTimeAndDate(TimeDate &t) const {}
 
 	virtual void logMessage(LogMessageType::Type type, const char *message);
+
+	/**
+	 * Print the benchmark statistics as JSON, either to the file set with
+	 * --benchmark-output or to stdout. Does nothing without --benchmark.
+	 */
+	void reportBenchmark();
+
+protected:
+	virtual Common::EventSource *getDefaultEventSource() { return this; }
+
+private:
+	enum {
+		kOutputRate = 22050,
+		kMixBufferSamples = 1024
+	};
+
+	/**
+	 * In benchmark mode, the mixer and the timers are driven from the
+	 * main thread: this runs all timer callbacks and mixes all audio
+	 * which is due at the current (virtual) time.
+	 */
+	void runBenchmarkTasks();
+
+	static uint64 getMicros();
+
+	bool _benchmark;
+	uint32 _benchmarkFrames;
+	Common::String _benchmarkOutput;
+	bool _benchmarkQuitSent;
+	bool _inBenchmarkTasks;
+
+	/** Time the backend was created at, for getMillis() outside of benchmark mode */
+	uint64 _startMicros;
+	/** Time skipped by delayMillis() calls in benchmark mode */
+	uint32 _virtualMillis;
+	/** Number of samples mixed since the benchmark started */
+	uint64 _mixedSamples;
+	byte *_mixBuffer;
+
+	NullBenchmarkStats _stats;
 };
 
-OSystem_NULL::OSystem_NULL() {
+OSystem_NULL::OSystem_NULL() :
+	_benchmark(false), _benchmarkFrames(0), _benchmarkQuitSent(false), _inBenchmarkTasks(false),
+	_startMicros(getMicros()), _virtualMillis(0), _mixedSamples(0), _mixBuffer(0) {
+	memset(&_stats, 0, sizeof(_stats));
+
 	#if defined(__amigaos4__)
 		_fsFactory = new AmigaOSFilesystemFactory();
 	#elif defined(POSIX)
@@ -69,34 +150,203 @@ OSystem_NULL::OSystem_NULL() {
 }
 
 OSystem_NULL::~OSystem_NULL() {
+	// The timer and event managers still need the mutex manager, which
+	// the ModularBackend destructor deletes first.
+	delete _timerManager;
+	_timerManager = 0;
+	delete _eventManager;
+	_eventManager = 0;
+
+	delete[] _mixBuffer;
 }
 
 void OSystem_NULL::initBackend() {
+#if defined(POSIX)
+	uint workerThreads = PosixWorkerPool::getDefaultThreadCount();
+	if (ConfMan.hasKey("worker_threads"))
+		workerThreads = MAX(ConfMan.getInt("worker_threads"), 0);
+
+	// Jobs on the pool share mutexes with the rest of the program, so these
+	// have to be real ones then
+	if (workerThreads > 0) {
+		_mutexManager = new PosixMutexManager();
+		_workerPool = new PosixWorkerPool(workerThreads);
+	} else {
+		_mutexManager = new NullMutexManager();
+	}
+#else
 	_mutexManager = new NullMutexManager();
+#endif
 	_timerManager = new DefaultTimerManager();
 	_eventManager = new DefaultEventManager(this);
 	_savefileManager = new DefaultSaveFileManager();
 	_graphicsManager = new NullGraphicsManager();
-	_mixer = new Audio::MixerImpl(this, 22050);
+	_mixer = new Audio::MixerImpl(this, kOutputRate);
+
+	_benchmark = ConfMan.getBool("benchmark");
+	if (_benchmark) {
+		if (ConfMan.hasKey("benchmark_frames"))
+			_benchmarkFrames = ConfMan.getInt("benchmark_frames");
+		if (ConfMan.hasKey("benchmark_output"))
+			_benchmarkOutput = ConfMan.get("benchmark_output");
 
-	((Audio::MixerImpl *)_mixer)->setReady(false);
+		// Without a real audio thread and timer interrupt, we drive both
+		// from the main thread; see runBenchmarkTasks().
+		_mixBuffer = new byte[kMixBufferSamples * 4];
+		((Audio::MixerImpl *)_mixer)->setReady(true);
+		_stats.startMicros = getMicros();
+	} else {
+		((Audio::MixerImpl *)_mixer)->setReady(false);
 
-	// Note that both the mixer and the timer manager are useless
-	// this way; they need to be hooked into the system somehow to
-	// be functional. Of course, can't do that in a NULL backend :).
+		// Note that both the mixer and the timer manager are useless
+		// this way; they need to be hooked into the system somehow to
+		// be functional. Of course, can't do that in a NULL backend :).
+	}
 
 	ModularBackend::initBackend();
 }
 
 bool OSystem_NULL::pollEvent(Common::Event &event) {
+	if (!_benchmark)
+		return false;
+
+	runBenchmarkTasks();
+
+	if (_benchmarkFrames && _stats.frames >= _benchmarkFrames && !_benchmarkQuitSent) {
+		_benchmarkQuitSent = true;
+		event.type = Common::EVENT_QUIT;
+		return true;
+	}
+
 	return false;
 }
 
+void OSystem_NULL::updateScreen() {
+	if (!_benchmark) {
+		ModularBackend::updateScreen();
+		return;
+	}
+
+	const uint64 start = getMicros();
+	ModularBackend::updateScreen();
+	_stats.updateScreenMicros += getMicros() - start;
+	_stats.frames++;
+
+	runBenchmarkTasks();
+}
+
 uint32 OSystem_NULL::getMillis() {
-	return 0;
+	if (!_benchmark)
+		return (uint32)((getMicros() - _startMicros) / 1000);
+
+	// Real time passes as usual, but every delay is skipped instantly
+	uint32 millis = (uint32)((getMicros() - _stats.startMicros) / 1000) + _virtualMillis;
+	g_eventRec.processMillis(millis);
+	return millis;
 }
 
 void OSystem_NULL::delayMillis(uint msecs) {
+	if (!_benchmark)
+		return;
+
+	if (!g_eventRec.processDelayMillis(msecs))
+		_virtualMillis += msecs;
+
+	runBenchmarkTasks();
+}
+
+void OSystem_NULL::runBenchmarkTasks() {
+	if (_inBenchmarkTasks)
+		return;
+	_inBenchmarkTasks = true;
+
+	((DefaultTimerManager *)_timerManager)->handler();
+
+	const uint64 dueSamples = (uint64)getMillis() * kOutputRate / 1000;
+	while (_mixedSamples < dueSamples) {
+		const uint32 len = (uint32)MIN<uint64>(dueSamples - _mixedSamples, kMixBufferSamples);
+
+		const uint64 start = getMicros();
+		((Audio::MixerImpl *)_mixer)->mixCallback(_mixBuffer, len * 4);
+		_stats.mixMicros += getMicros() - start;
+		_stats.mixCalls++;
+		_stats.mixSamples += len;
+
+		_mixedSamples += len;
+	}
+
+	_inBenchmarkTasks = false;
+}
+
+uint64 OSystem_NULL::getMicros() {
+#if defined(POSIX)
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return (uint64)tv.tv_sec * 1000000 + tv.tv_usec;
+#elif defined(WIN32)
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	return (uint64)(counter.QuadPart * 1000000 / frequency.QuadPart);
+#else
+	return 0;
+#endif
+}
+
+void OSystem_NULL::reportBenchmark() {
+	if (!_benchmark)
+		return;
+
+	_stats.endMicros = getMicros();
+
+	// The peak resident set size is the closest portable approximation
+	// of the peak heap usage.
+	long peakMemoryKB = -1;
+#if defined(POSIX)
+	struct rusage usage;
+	if (!getrusage(RUSAGE_SELF, &usage)) {
+#if defined(__APPLE__)
+		peakMemoryKB = usage.ru_maxrss / 1024;
+#else
+		peakMemoryKB = usage.ru_maxrss;
+#endif
+	}
+#endif
+
+	const double wallSeconds = (_stats.endMicros - _stats.startMicros) / 1000000.0;
+
+	FILE *output = stdout;
+	if (!_benchmarkOutput.empty()) {
+		output = fopen(_benchmarkOutput.c_str(), "w");
+		if (!output) {
+			warning("Could not open benchmark output file '%s'", _benchmarkOutput.c_str());
+			output = stdout;
+		}
+	}
+
+	fprintf(output, "{\n");
+	fprintf(output, "  \"frames\": %u,\n", _stats.frames);
+	fprintf(output, "  \"wall_time_ms\": %.3f,\n", wallSeconds * 1000.0);
+	fprintf(output, "  \"skipped_delay_ms\": %u,\n", _virtualMillis);
+	fprintf(output, "  \"fps\": %.3f,\n", wallSeconds > 0 ? _stats.frames / wallSeconds : 0.0);
+	fprintf(output, "  \"update_screen\": {\n");
+	fprintf(output, "    \"calls\": %u,\n", _stats.frames);
+	fprintf(output, "    \"total_us\": %.0f,\n", (double)_stats.updateScreenMicros);
+	fprintf(output, "    \"avg_us\": %.3f\n", _stats.frames ? (double)_stats.updateScreenMicros / _stats.frames : 0.0);
+	fprintf(output, "  },\n");
+	fprintf(output, "  \"mixer\": {\n");
+	fprintf(output, "    \"calls\": %u,\n", _stats.mixCalls);
+	fprintf(output, "    \"samples\": %u,\n", _stats.mixSamples);
+	fprintf(output, "    \"total_us\": %.0f,\n", (double)_stats.mixMicros);
+	fprintf(output, "    \"avg_us\": %.3f\n", _stats.mixCalls ? (double)_stats.mixMicros / _stats.mixCalls : 0.0);
+	fprintf(output, "  },\n");
+	fprintf(output, "  \"peak_memory_kb\": %ld\n", peakMemoryKB);
+	fprintf(output, "}\n");
+
+	if (output != stdout)
+		fclose(output);
+	else
+		fflush(output);
 }
 
 void OSystem_NULL::logMessage(LogMessageType::Type type, const char *message) {
@@ -121,6 +371,7 @@ int main(int argc, char *argv[]) {
 
 	// Invoke the actual ScummVM main entry point:
 	int res = scummvm_main(argc, argv);
+	((OSystem_NULL *)g_system)->reportBenchmark();
 	delete (OSystem_NULL *)g_system;
 	return res;
 }
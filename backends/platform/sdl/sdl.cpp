@@ -46,6 +46,7 @@
 #include "backends/events/sdl/sdl-events.h"
 #include "backends/mutex/sdl/sdl-mutex.h"
 #include "backends/timer/sdl/sdl-timer.h"
+#include "backends/workerpool/sdl/sdl-workerpool.h"
 #include "backends/graphics/surfacesdl/surfacesdl-graphics.h"
 #ifdef USE_OPENGL
 #include "backends/graphics/openglsdl/openglsdl-graphics.h"
@@ -97,6 +98,10 @@ OSystem_SDL::~OSystem_SDL() {
 	_audiocdManager = 0;
 	delete _mixerManager;
 	_mixerManager = 0;
+	// The worker pool goes after the mixer, since streams played by the
+	// mixer and the audio CD emulation queue jobs on it
+	delete _workerPool;
+	_workerPool = 0;
 	delete _timerManager;
 	_timerManager = 0;
 	delete _mutexManager;
@@ -206,6 +211,15 @@ void OSystem_SDL::initBackend() {
 
 	}
 
+	if (_workerPool == 0) {
+		uint workerThreads = SdlWorkerPool::getDefaultThreadCount();
+		if (ConfMan.hasKey("worker_threads"))
+			workerThreads = MAX(ConfMan.getInt("worker_threads"), 0);
+
+		if (workerThreads > 0)
+			_workerPool = new SdlWorkerPool(workerThreads);
+	}
+
 	// Setup a custom program icon.
 	setupIcon();
 
@@ -0,0 +1,158 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+
+#include "common/scummsys.h"
+
+#if defined(POSIX)
+
+#include "backends/workerpool/posix/posix-workerpool.h"
+#include "common/array.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+struct PosixWorkerPool::Sync {
+	pthread_mutex_t mutex;
+	pthread_cond_t jobAdded;
+	pthread_cond_t jobDone;
+	Common::Array<pthread_t> threads;
+};
+
+PosixWorkerPool::PosixWorkerPool(uint threadCount) : _sync(new Sync()), _quit(false) {
+	pthread_mutex_init(&_sync->mutex, 0);
+	pthread_cond_init(&_sync->jobAdded, 0);
+	pthread_cond_init(&_sync->jobDone, 0);
+
+	for (uint i = 0; i < threadCount; ++i) {
+		pthread_t thread;
+		if (pthread_create(&thread, 0, workerThreadEntry, this)) {
+			warning("Could not create worker thread");
+			break;
+		}
+
+		_sync->threads.push_back(thread);
+	}
+}
+
+PosixWorkerPool::~PosixWorkerPool() {
+	pthread_mutex_lock(&_sync->mutex);
+	_quit = true;
+	pthread_cond_broadcast(&_sync->jobAdded);
+	pthread_mutex_unlock(&_sync->mutex);
+
+	for (uint i = 0; i < _sync->threads.size(); ++i)
+		pthread_join(_sync->threads[i], 0);
+
+	// Without threads, nobody ran the jobs yet
+	pthread_mutex_lock(&_sync->mutex);
+	while (!_jobs.empty())
+		runNextJob();
+	pthread_mutex_unlock(&_sync->mutex);
+
+	pthread_cond_destroy(&_sync->jobDone);
+	pthread_cond_destroy(&_sync->jobAdded);
+	pthread_mutex_destroy(&_sync->mutex);
+	delete _sync;
+}
+
+uint PosixWorkerPool::getThreadCount() const {
+	return _sync->threads.size();
+}
+
+uint PosixWorkerPool::getDefaultThreadCount() {
+#if defined(_SC_NPROCESSORS_ONLN)
+	const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus > 1)
+		return MIN<long>(cpus, 8) - 1;
+#endif
+	return 0;
+}
+
+void PosixWorkerPool::addJob(JobProc proc, void *param, int32 *pending) {
+	Job job;
+	job.proc = proc;
+	job.param = param;
+	job.pending = pending;
+
+	pthread_mutex_lock(&_sync->mutex);
+	++*pending;
+	_jobs.push_back(job);
+	pthread_cond_signal(&_sync->jobAdded);
+	pthread_mutex_unlock(&_sync->mutex);
+}
+
+void PosixWorkerPool::waitForJobs(const int32 *pending) {
+	pthread_mutex_lock(&_sync->mutex);
+	while (*pending) {
+		// Rather than idling, run the queued jobs we wait for. Other jobs
+		// are left to the worker threads: they may take much longer, or
+		// expect not to run in the middle of what the caller is doing.
+		if (!runNextJob(pending))
+			pthread_cond_wait(&_sync->jobDone, &_sync->mutex);
+	}
+	pthread_mutex_unlock(&_sync->mutex);
+}
+
+bool PosixWorkerPool::runNextJob(const int32 *pending) {
+	Common::List<Job>::iterator i = _jobs.begin();
+	while (i != _jobs.end() && pending && i->pending != pending)
+		++i;
+	if (i == _jobs.end())
+		return false;
+
+	const Job job = *i;
+	_jobs.erase(i);
+
+	pthread_mutex_unlock(&_sync->mutex);
+	job.proc(job.param);
+	pthread_mutex_lock(&_sync->mutex);
+
+	if (!--*job.pending)
+		pthread_cond_broadcast(&_sync->jobDone);
+	return true;
+}
+
+void *PosixWorkerPool::workerThreadEntry(void *arg) {
+	PosixWorkerPool *pool = (PosixWorkerPool *)arg;
+
+	pthread_mutex_lock(&pool->_sync->mutex);
+	// On quitting, the queue is drained first: queued jobs may own data
+	// which they free when done
+	while (true) {
+		if (!pool->_jobs.empty())
+			pool->runNextJob();
+		else if (pool->_quit)
+			break;
+		else
+			pthread_cond_wait(&pool->_sync->jobAdded, &pool->_sync->mutex);
+	}
+	pthread_mutex_unlock(&pool->_sync->mutex);
+
+	return 0;
+}
+
+#endif
@@ -0,0 +1,76 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_WORKERPOOL_POSIX_WORKERPOOL_H
+#define BACKENDS_WORKERPOOL_POSIX_WORKERPOOL_H
+
+#include "common/workerpool.h"
+#include "common/list.h"
+
+/**
+ * Worker pool based on POSIX threads.
+ */
+class PosixWorkerPool : public Common::WorkerPool {
+public:
+	PosixWorkerPool(uint threadCount);
+	virtual ~PosixWorkerPool();
+
+	/**
+	 * Return the number of worker threads to use if none was configured:
+	 * one less than the number of online CPUs, up to a maximum of 7.
+	 */
+	static uint getDefaultThreadCount();
+
+	virtual uint getThreadCount() const;
+	virtual void addJob(JobProc proc, void *param, int32 *pending);
+	virtual void waitForJobs(const int32 *pending);
+
+private:
+	struct Job {
+		JobProc proc;
+		void *param;
+		int32 *pending;
+	};
+
+	/**
+	 * Run the first queued job, or only the first one of the jobs counted
+	 * by pending if that is given. Must be called with _mutex locked.
+	 *
+	 * @return false if there was no such job
+	 */
+	bool runNextJob(const int32 *pending = 0);
+
+	static void *workerThreadEntry(void *arg);
+
+	/**
+	 * The threads, and the mutex and conditions protecting the queue. They
+	 * are kept out of this header, so that it does not pull in the system
+	 * headers which common/forbidden.h would trip over.
+	 */
+	struct Sync;
+	Sync *_sync;
+
+	Common::List<Job> _jobs;
+	bool _quit;
+};
+
+#endif
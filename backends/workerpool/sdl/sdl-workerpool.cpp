@@ -0,0 +1,156 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#undef ARRAYSIZE // winnt.h defines ARRAYSIZE, but we want our own one...
+#endif
+
+#include "common/scummsys.h"
+
+#if defined(SDL_BACKEND)
+
+#include "backends/workerpool/sdl/sdl-workerpool.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#if defined(POSIX)
+#include <unistd.h>
+#endif
+
+SdlWorkerPool::SdlWorkerPool(uint threadCount) : _quit(false) {
+	_mutex = SDL_CreateMutex();
+	_jobAdded = SDL_CreateCond();
+	_jobDone = SDL_CreateCond();
+
+	for (uint i = 0; i < threadCount; ++i) {
+		SDL_Thread *thread = SDL_CreateThread(workerThreadEntry, this);
+		if (!thread) {
+			warning("Could not create worker thread: %s", SDL_GetError());
+			break;
+		}
+
+		_threads.push_back(thread);
+	}
+}
+
+SdlWorkerPool::~SdlWorkerPool() {
+	SDL_LockMutex(_mutex);
+	_quit = true;
+	SDL_CondBroadcast(_jobAdded);
+	SDL_UnlockMutex(_mutex);
+
+	for (uint i = 0; i < _threads.size(); ++i)
+		SDL_WaitThread(_threads[i], NULL);
+
+	// Without threads, nobody ran the jobs yet
+	SDL_LockMutex(_mutex);
+	while (!_jobs.empty())
+		runNextJob();
+	SDL_UnlockMutex(_mutex);
+
+	SDL_DestroyCond(_jobDone);
+	SDL_DestroyCond(_jobAdded);
+	SDL_DestroyMutex(_mutex);
+}
+
+uint SdlWorkerPool::getDefaultThreadCount() {
+#if defined(WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	if (info.dwNumberOfProcessors > 1)
+		return MIN<DWORD>(info.dwNumberOfProcessors, 8) - 1;
+#elif defined(POSIX) && defined(_SC_NPROCESSORS_ONLN)
+	const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus > 1)
+		return MIN<long>(cpus, 8) - 1;
+#endif
+	return 0;
+}
+
+void SdlWorkerPool::addJob(JobProc proc, void *param, int32 *pending) {
+	Job job;
+	job.proc = proc;
+	job.param = param;
+	job.pending = pending;
+
+	SDL_LockMutex(_mutex);
+	++*pending;
+	_jobs.push_back(job);
+	SDL_CondSignal(_jobAdded);
+	SDL_UnlockMutex(_mutex);
+}
+
+void SdlWorkerPool::waitForJobs(const int32 *pending) {
+	SDL_LockMutex(_mutex);
+	while (*pending) {
+		// Rather than idling, run the queued jobs we wait for. Other jobs
+		// are left to the worker threads: they may take much longer, or
+		// expect not to run in the middle of what the caller is doing.
+		if (!runNextJob(pending))
+			SDL_CondWait(_jobDone, _mutex);
+	}
+	SDL_UnlockMutex(_mutex);
+}
+
+bool SdlWorkerPool::runNextJob(const int32 *pending) {
+	Common::List<Job>::iterator i = _jobs.begin();
+	while (i != _jobs.end() && pending && i->pending != pending)
+		++i;
+	if (i == _jobs.end())
+		return false;
+
+	const Job job = *i;
+	_jobs.erase(i);
+
+	SDL_UnlockMutex(_mutex);
+	job.proc(job.param);
+	SDL_LockMutex(_mutex);
+
+	if (!--*job.pending)
+		SDL_CondBroadcast(_jobDone);
+	return true;
+}
+
+int SDLCALL SdlWorkerPool::workerThreadEntry(void *arg) {
+	SdlWorkerPool *pool = (SdlWorkerPool *)arg;
+
+	SDL_LockMutex(pool->_mutex);
+	// On quitting, the queue is drained first: queued jobs may own data
+	// which they free when done
+	while (true) {
+		if (!pool->_jobs.empty())
+			pool->runNextJob();
+		else if (pool->_quit)
+			break;
+		else
+			SDL_CondWait(pool->_jobAdded, pool->_mutex);
+	}
+	SDL_UnlockMutex(pool->_mutex);
+
+	return 0;
+}
+
+#endif
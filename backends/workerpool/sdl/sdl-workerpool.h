@@ -0,0 +1,75 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_WORKERPOOL_SDL_WORKERPOOL_H
+#define BACKENDS_WORKERPOOL_SDL_WORKERPOOL_H
+
+#include "backends/platform/sdl/sdl-sys.h"
+#include "common/workerpool.h"
+#include "common/array.h"
+#include "common/list.h"
+
+/**
+ * Worker pool based on SDL threads.
+ */
+class SdlWorkerPool : public Common::WorkerPool {
+public:
+	SdlWorkerPool(uint threadCount);
+	virtual ~SdlWorkerPool();
+
+	/**
+	 * Return the number of worker threads to use if none was configured:
+	 * one less than the number of online CPUs, up to a maximum of 7.
+	 */
+	static uint getDefaultThreadCount();
+
+	virtual uint getThreadCount() const { return _threads.size(); }
+	virtual void addJob(JobProc proc, void *param, int32 *pending);
+	virtual void waitForJobs(const int32 *pending);
+
+private:
+	struct Job {
+		JobProc proc;
+		void *param;
+		int32 *pending;
+	};
+
+	/**
+	 * Run the first queued job, or only the first one of the jobs counted
+	 * by pending if that is given. Must be called with _mutex locked.
+	 *
+	 * @return false if there was no such job
+	 */
+	bool runNextJob(const int32 *pending = 0);
+
+	static int SDLCALL workerThreadEntry(void *arg);
+
+	SDL_mutex *_mutex;
+	SDL_cond *_jobAdded;
+	SDL_cond *_jobDone;
+
+	Common::List<Job> _jobs;
+	Common::Array<SDL_Thread *> _threads;
+	bool _quit;
+};
+
+#endif
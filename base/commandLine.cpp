@@ -27,6 +27,8 @@
 
 #include <limits.h>
 
+#include "engines/detectioncache.h"
+#include "engines/gamescanner.h"
 #include "engines/metaengine.h"
 #include "base/commandLine.h"
 #include "base/plugins.h"
@@ -38,6 +40,7 @@
 #include "common/system.h"
 #include "common/textconsole.h"
 
+#include "gui/launcher.h"
 #include "gui/ThemeEngine.h"
 
 #include "audio/musicplugin.h"
@@ -68,6 +71,11 @@ static const char HELP_STRING[] =
 	"  -z, --list-games         Display list of supported games and exit\n"
 	"  -t, --list-targets       Display list of configured targets and exit\n"
 	"  --list-saves=TARGET      Display a list of savegames for the game (TARGET) specified\n"
+	"  -a, --add                Add all games from the current directory, or the one\n"
+	"                           given with --path before it, to the configuration\n"
+	"                           and exit\n"
+	"  --recursive              Before --add, also add the games from all\n"
+	"                           subdirectories\n"
 #if defined(WIN32) && !defined(_WIN32_WCE) && !defined(__SYMBIAN32__)
 	"  --console                Enable the console window (default:enabled)\n"
 #endif
@@ -118,6 +126,9 @@ static const char HELP_STRING[] =
 	"  --aspect-ratio           Enable aspect ratio correction\n"
 	"  --render-mode=MODE       Enable additional render modes (cga, ega, hercGreen,\n"
 	"                           hercAmber, amiga)\n"
+	"  --worker-threads=NUM     Number of helper threads used for decoding videos\n"
+	"                           and scaling graphics (default: one less than the\n"
+	"                           number of CPUs, max 7)\n"
 	"\n"
 #if defined(ENABLE_SKY) || defined(ENABLE_QUEEN)
 	"  --alt-intro              Use alternative intro for CD versions of Beneath a\n"
@@ -136,6 +147,14 @@ static const char HELP_STRING[] =
 	"  --dimuse-tempo=NUM       Set internal Digital iMuse tempo (10 - 100) per second\n"
 	"                           (default: 10)\n"
 #endif
+#endif
+#ifdef USE_NULL_DRIVER
+	"\n"
+	"  --benchmark              Run the game headless as fast as possible and print\n"
+	"                           performance statistics as JSON when it quits\n"
+	"  --benchmark-frames=NUM   Quit the game after NUM frames (default: 0 = run\n"
+	"                           until the game quits)\n"
+	"  --benchmark-output=FILE  Write the statistics to FILE instead of stdout\n"
 #endif
 	"\n"
 	"The meaning of boolean long options can be inverted by prefixing them with\n"
@@ -237,6 +256,13 @@ void registerDefaults() {
 	ConfMan.registerDefault("record_temp_file_name", "record.tmp");
 	ConfMan.registerDefault("record_time_file_name", "record.time");
 
+	ConfMan.registerDefault("detection_cache", "detection.cache");
+
+#ifdef USE_NULL_DRIVER
+	ConfMan.registerDefault("benchmark", false);
+	ConfMan.registerDefault("benchmark_frames", 0);
+#endif
+
 }
 
 //
@@ -350,6 +376,12 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_COMMAND('z', "list-games")
 			END_OPTION
 
+			DO_COMMAND('a', "add")
+			END_OPTION
+
+			DO_LONG_OPTION_BOOL("recursive")
+			END_OPTION
+
 #ifdef DETECTOR_TESTING_HACK
 			// HACK FIXME TODO: This command is intentionally *not* documented!
 			DO_LONG_COMMAND("test-detector")
@@ -390,6 +422,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION_INT("output-rate")
 			END_OPTION
 
+			DO_LONG_OPTION_INT("worker-threads")
+			END_OPTION
+
 			DO_OPTION_BOOL('f', "fullscreen")
 			END_OPTION
 
@@ -550,6 +585,17 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION("record-time-file-name")
 			END_OPTION
 
+#ifdef USE_NULL_DRIVER
+			DO_LONG_OPTION_BOOL("benchmark")
+			END_OPTION
+
+			DO_LONG_OPTION_INT("benchmark-frames")
+			END_OPTION
+
+			DO_LONG_OPTION("benchmark-output")
+			END_OPTION
+#endif
+
 #ifdef IPHONE
 			// This is automatically set when launched from the Springboard.
 			DO_LONG_OPTION_OPT("launchedFromSB", 0)
@@ -571,18 +617,14 @@ unknownOption:
 	return Common::String();
 }
 
-/** List all supported game IDs, i.e. all games which any loaded plugin supports. */
+/** List all supported game IDs, i.e. all games which any plugin supports. */
 static void listGames() {
 	printf("Game ID              Full Title                                            \n"
 	       "-------------------- ------------------------------------------------------\n");
 
-	const EnginePlugin::List &plugins = EngineMan.getPlugins();
-	EnginePlugin::List::const_iterator iter = plugins.begin();
-	for (iter = plugins.begin(); iter != plugins.end(); ++iter) {
-		GameList list = (**iter)->getSupportedGames();
-		for (GameList::iterator v = list.begin(); v != list.end(); ++v) {
-			printf("%-20s %s\n", v->gameid().c_str(), v->description().c_str());
-		}
+	const GameList list = EngineMan.getSupportedGames();
+	for (GameList::const_iterator v = list.begin(); v != list.end(); ++v) {
+		printf("%-20s %s\n", v->gameid().c_str(), v->description().c_str());
 	}
 }
 
@@ -711,6 +753,74 @@ static void listAudioDevices() {
 }
 
 
+/** Returns whether a target for the given game in the given path exists. */
+static bool isGameConfigured(const Common::String &path, const GameDescriptor &game) {
+	const Common::ConfigManager::DomainMap &domains = ConfMan.getGameDomains();
+	for (Common::ConfigManager::DomainMap::const_iterator iter = domains.begin(); iter != domains.end(); ++iter) {
+		Common::String domainPath(iter->_value.getVal("path"));
+		while (domainPath != "/" && domainPath.lastChar() == '/')
+			domainPath.deleteLastChar();
+
+		if (domainPath == path &&
+		    iter->_value.getVal("gameid") == game.getVal("gameid") &&
+		    iter->_value.getVal("platform") == game.getVal("platform") &&
+		    iter->_value.getVal("language") == game.getVal("language"))
+			return true;
+	}
+
+	return false;
+}
+
+/** Adds all games in a directory, and optionally its subdirectories, to the config. */
+static Common::Error addGames(const Common::String &path, bool recursive) {
+	// FIXME HACK
+	g_system->initBackend();
+
+	Common::FSNode dir(path);
+	if (!dir.isDirectory())
+		return Common::Error(Common::kPathNotDirectory, path);
+
+	uint added = 0, skipped = 0;
+	const uint32 start = g_system->getMillis();
+
+	GameScanner scanner(dir, recursive, g_system->getWorkerPool());
+	while (!scanner.isFinished()) {
+		Common::FSNode gameDir;
+		GameList candidates;
+		if (!scanner.scanNextDirectory(gameDir, candidates))
+			continue;
+
+		Common::String gamePath(gameDir.getPath());
+		while (gamePath != "/" && gamePath.lastChar() == '/')
+			gamePath.deleteLastChar();
+
+		for (GameList::iterator game = candidates.begin(); game != candidates.end(); ++game) {
+			if (isGameConfigured(gamePath, *game)) {
+				skipped++;
+				continue;
+			}
+
+			(*game)["path"] = gamePath;
+			Common::String target = GUI::addGameToConf(*game);
+			printf("Added target '%s': %s (%s)\n", target.c_str(), game->description().c_str(), gamePath.c_str());
+			added++;
+		}
+	}
+
+	DetectionCache::instance().flush();
+	ConfMan.flushToDisk();
+
+	const uint32 millis = g_system->getMillis() - start;
+	printf("Added %u games, skipped %u games which were added before\n", added, skipped);
+	printf("Scanned %u directories with %u entries in %u.%03u s", scanner.getScannedCount(),
+	       scanner.getListedCount(), millis / 1000, millis % 1000);
+	if (millis)
+		printf(" (%.1f directories/s)", scanner.getScannedCount() * 1000.0 / millis);
+	printf("\n");
+
+	return Common::kNoError;
+}
+
 #ifdef DETECTOR_TESTING_HACK
 static void runDetectorTest() {
 	// HACK: The following code can be used to test the detection code of our
@@ -907,6 +1017,22 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 #endif // DISABLE_COMMAND_LINE
 
 
+/** Store the command line settings into the transient domain of the config manager. */
+static void storeSettings(const Common::StringMap &settings) {
+	for (Common::StringMap::const_iterator x = settings.begin(); x != settings.end(); ++x) {
+		Common::String key(x->_key);
+		Common::String value(x->_value);
+
+		// Replace any "-" in the key by "_" (e.g. change "save-slot" to "save_slot").
+		for (Common::String::iterator c = key.begin(); c != key.end(); ++c)
+			if (*c == '-')
+				*c = '_';
+
+		// Store it into ConfMan.
+		ConfMan.set(key, value, Common::ConfigManager::kTransientDomain);
+	}
+}
+
 bool processSettings(Common::String &command, Common::StringMap &settings, Common::Error &err) {
 	err = Common::kNoError;
 
@@ -918,9 +1044,16 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 	if (command == "list-targets") {
 		listTargets();
 		return true;
-	} else if (command == "list-games") {
+	}
+	else if (command == "list-games") {
 		listGames();
 		return true;
+	} else if (command == "add") {
+		const Common::String path = settings.contains("path") ? settings["path"] : ".";
+		const bool recursive = settings.contains("recursive") && settings["recursive"] == "true";
+		storeSettings(settings);
+		err = addGames(path, recursive);
+		return true;
 	} else if (command == "list-saves") {
 		err = listSaves(settings["list-saves"].c_str());
 		return true;
@@ -958,8 +1091,9 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 	// domain (i.e. a target) matching this argument, or alternatively
 	// whether there is a gameid matching that name.
 	if (!command.empty()) {
-		GameDescriptor gd = EngineMan.findGame(command);
-		if (ConfMan.hasGameDomain(command) || !gd.gameid().empty()) {
+		// Only look for a gameid if there is no such target, as that may
+		// load all engine plugins
+		if (ConfMan.hasGameDomain(command) || !EngineMan.findGame(command).gameid().empty()) {
 			bool idCameFromCommandLine = false;
 
 			// WORKAROUND: Fix for bug #1719463: "DETECTOR: Launching
@@ -986,18 +1120,7 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 
 
 	// Finally, store the command line settings into the config manager.
-	for (Common::StringMap::const_iterator x = settings.begin(); x != settings.end(); ++x) {
-		Common::String key(x->_key);
-		Common::String value(x->_value);
-
-		// Replace any "-" in the key by "_" (e.g. change "save-slot" to "save_slot").
-		for (Common::String::iterator c = key.begin(); c != key.end(); ++c)
-			if (*c == '-')
-				*c = '_';
-
-		// Store it into ConfMan.
-		ConfMan.set(key, value, Common::ConfigManager::kTransientDomain);
-	}
+	storeSettings(settings);
 
 	return false;
 }
@@ -356,8 +356,8 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 		settings.erase("debugflags");
 	}
 
+	// Engine plugins are loaded on demand, if the plugin files are indexed
 	PluginManager::instance().init();
- 	PluginManager::instance().loadAllPlugins(); // load plugins for cached plugin manager
 
 	// If we received an invalid music parameter via command line we check this here.
 	// We can't check this before loading the music plugins.
@@ -478,9 +478,6 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 
 			// Clear the active config domain
 			ConfMan.setActiveDomain("");
-
-			PluginManager::instance().loadAllPlugins(); // only for cached manager
-
 		} else {
 			GUI::displayErrorDialog(_("Could not find any engine capable of running the selected game"));
 		}
@@ -4,6 +4,7 @@ MODULE_OBJS := \
 	main.o \
 	commandLine.o \
 	plugins.o \
+	pluginindex.o \
 	version.o
 
 # Include common rules
@@ -0,0 +1,161 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "base/pluginindex.h"
+
+#include "common/algorithm.h"
+#include "common/endian.h"
+#include "common/stream.h"
+
+enum {
+	kIndexVersion = 1,
+
+	/** Upper limit for strings read from the index file, to reject broken files */
+	kMaxStringLength = 65536
+};
+
+static const uint32 kIndexTag = MKTAG('P', 'I', 'D', 'X');
+
+namespace {
+
+struct GameIdLess {
+	bool operator()(const GameDescriptor &x, const GameDescriptor &y) const {
+		return x.gameid() < y.gameid();
+	}
+};
+
+} // End of anonymous namespace
+
+void PluginIndex::clear(const Common::String &stamp) {
+	_stamp = stamp;
+	_games.clear();
+	_engines.clear();
+}
+
+void PluginIndex::addEngine(const Common::String &name, const Common::String &originalCopyright) {
+	if (!_engines.contains(name))
+		_engines[name] = originalCopyright;
+}
+
+void PluginIndex::addGame(const Common::String &gameId, const Common::String &description, const Common::String &fileName) {
+	if (_games.contains(gameId))
+		return;
+
+	GameEntry &entry = _games[gameId];
+	entry.description = description;
+	entry.fileName = fileName;
+}
+
+Common::String PluginIndex::getFileName(const Common::String &gameId) const {
+	GameMap::const_iterator i = _games.find(gameId);
+	if (i == _games.end())
+		return Common::String();
+	return i->_value.fileName;
+}
+
+GameList PluginIndex::getGames() const {
+	GameList games;
+	for (GameMap::const_iterator i = _games.begin(); i != _games.end(); ++i)
+		games.push_back(GameDescriptor(i->_key, i->_value.description));
+
+	// The hash map does not keep the order of the plugins
+	Common::sort(games.begin(), games.end(), GameIdLess());
+	return games;
+}
+
+static void writeString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint32LE(str.size());
+	stream.write(str.c_str(), str.size());
+}
+
+static bool readString(Common::ReadStream &stream, Common::String &str) {
+	const uint32 size = stream.readUint32LE();
+	if (stream.eos() || stream.err() || size > kMaxStringLength)
+		return false;
+
+	char buffer[256];
+	str.clear();
+	for (uint32 left = size; left > 0; ) {
+		const uint32 chunk = MIN<uint32>(left, sizeof(buffer));
+		if (stream.read(buffer, chunk) != chunk)
+			return false;
+		str += Common::String(buffer, chunk);
+		left -= chunk;
+	}
+
+	return true;
+}
+
+void PluginIndex::save(Common::WriteStream &stream) const {
+	stream.writeUint32BE(kIndexTag);
+	stream.writeUint32LE(kIndexVersion);
+	writeString(stream, _stamp);
+
+	stream.writeUint32LE(_engines.size());
+	for (Common::StringMap::const_iterator i = _engines.begin(); i != _engines.end(); ++i) {
+		writeString(stream, i->_key);
+		writeString(stream, i->_value);
+	}
+
+	stream.writeUint32LE(_games.size());
+	for (GameMap::const_iterator i = _games.begin(); i != _games.end(); ++i) {
+		writeString(stream, i->_key);
+		writeString(stream, i->_value.description);
+		writeString(stream, i->_value.fileName);
+	}
+}
+
+bool PluginIndex::load(Common::ReadStream &stream) {
+	if (stream.readUint32BE() != kIndexTag || stream.readUint32LE() != kIndexVersion)
+		return false;
+
+	Common::String stamp;
+	Common::StringMap engines;
+	GameMap games;
+
+	if (!readString(stream, stamp))
+		return false;
+
+	for (uint32 count = stream.readUint32LE(); count > 0; count--) {
+		Common::String name, originalCopyright;
+		if (!readString(stream, name) || !readString(stream, originalCopyright))
+			return false;
+		engines[name] = originalCopyright;
+	}
+
+	for (uint32 count = stream.readUint32LE(); count > 0; count--) {
+		Common::String gameId;
+		GameEntry entry;
+		if (!readString(stream, gameId) || !readString(stream, entry.description) || !readString(stream, entry.fileName))
+			return false;
+		games[gameId] = entry;
+	}
+
+	if (stream.eos() || stream.err())
+		return false;
+
+	// Only use the index if it could be read in full
+	_stamp = stamp;
+	_engines = engines;
+	_games = games;
+	return true;
+}
@@ -0,0 +1,99 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BASE_PLUGININDEX_H
+#define BASE_PLUGININDEX_H
+
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/str.h"
+
+#include "engines/game.h"
+
+namespace Common {
+class ReadStream;
+class WriteStream;
+}
+
+/**
+ * The index of the engine plugins, which lets the plugin manager list the
+ * supported games and the engines, and find the plugin file running a game,
+ * without loading any plugin. It is kept in a file of its own, next to the
+ * config file, and is only valid for the plugins matching its stamp.
+ */
+class PluginIndex {
+public:
+	/** Drop everything, and make the index belong to the given stamp. */
+	void clear(const Common::String &stamp);
+
+	const Common::String &getStamp() const { return _stamp; }
+
+	/**
+	 * Add an engine, unless there is one of the same name already. Like
+	 * the plugins in memory, the first one wins.
+	 */
+	void addEngine(const Common::String &name, const Common::String &originalCopyright);
+
+	/**
+	 * Add a game, unless there is one with the same id already.
+	 *
+	 * @param fileName	the file of the plugin supporting the game, or an
+	 *			empty string for a static plugin
+	 */
+	void addGame(const Common::String &gameId, const Common::String &description, const Common::String &fileName);
+
+	/**
+	 * Return the file of the plugin supporting a game, or an empty string
+	 * if the game is unknown or supported by a static plugin.
+	 */
+	Common::String getFileName(const Common::String &gameId) const;
+
+	/** Return all games, sorted by their ids. */
+	GameList getGames() const;
+
+	/** Return the original copyright of each engine, keyed by its name. */
+	const Common::StringMap &getEngines() const { return _engines; }
+
+	/**
+	 * Read the index from a stream. Broken or outdated data is ignored, and
+	 * leaves the index as it was.
+	 *
+	 * @return true if the index was read
+	 */
+	bool load(Common::ReadStream &stream);
+
+	void save(Common::WriteStream &stream) const;
+
+private:
+	struct GameEntry {
+		Common::String description;
+		Common::String fileName;
+	};
+
+	typedef Common::HashMap<Common::String, GameEntry> GameMap;
+
+	Common::String _stamp;
+	GameMap _games;
+	Common::StringMap _engines;
+};
+
+#endif
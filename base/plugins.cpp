@@ -21,8 +21,9 @@
  */
 
 #include "base/plugins.h"
+#include "base/pluginindex.h"
 
-#include "common/func.h"
+#include "common/algorithm.h"
 #include "common/debug.h"
 #include "common/config-manager.h"
 
@@ -226,7 +227,7 @@ PluginManager &PluginManager::instance() {
 	return *_instance;
 }
 
-PluginManager::PluginManager() {
+PluginManager::PluginManager() : _index(0) {
 	// Always add the static plugin provider.
 	addPluginProvider(new StaticPluginProvider());
 }
@@ -235,6 +236,12 @@ PluginManager::~PluginManager() {
 	// Explicitly unload all loaded plugins
 	unloadAllPlugins();
 
+	delete _index;
+
+	// Delete the engine plugins, which are kept around when unloaded
+	for (PluginList::iterator p = _allEnginePlugins.begin(); p != _allEnginePlugins.end(); ++p)
+		delete *p;
+
 	// Delete the plugin providers
 	for (ProviderList::iterator pp = _providers.begin();
 	                            pp != _providers.end();
@@ -247,15 +254,12 @@ void PluginManager::addPluginProvider(PluginProvider *pp) {
 	_providers.push_back(pp);
 }
 
-/**
- * This should only be called once by main()
- **/
-void PluginManagerUncached::init() {
+void PluginManager::init() {
 	unloadAllPlugins();
+	for (PluginList::iterator p = _allEnginePlugins.begin(); p != _allEnginePlugins.end(); ++p)
+		delete *p;
 	_allEnginePlugins.clear();
 
-	unloadPluginsExcept(PLUGIN_TYPE_ENGINE, NULL, false);	// empty the engine plugins
-
 	for (ProviderList::iterator pp = _providers.begin();
 	                            pp != _providers.end();
 	                            ++pp) {
@@ -269,23 +273,29 @@ void PluginManagerUncached::init() {
 			if ((*pp)->isFilePluginProvider()) {
 				_allEnginePlugins.push_back(*p);
 			} else if ((*p)->loadPlugin()) { // and this is the proper method
-				if ((*p)->getType() == PLUGIN_TYPE_ENGINE) {
-					(*p)->unloadPlugin();
+				if ((*p)->getType() == PLUGIN_TYPE_ENGINE)
 					_allEnginePlugins.push_back(*p);
-				} else {	// add non-engine plugins to the 'in-memory' list
-							// these won't ever get unloaded
-					addToPluginsInMemList(*p);
-				}
+				addToPluginsInMemList(*p);
+			} else {
+				delete *p;
 			}
- 		}
- 	}
+		}
+	}
+
+	// Without an index, there is no telling which plugin is needed
+	if (!updatePluginIndex())
+		loadAllPlugins();
 }
 
 /**
- * Try to load the plugin by searching in the ConfigManager for a matching
- * gameId under the domain 'plugin_files'.
+ * Try to load the plugin by searching in the plugin index for a matching
+ * gameId, or without an index, in the ConfigManager under the domain
+ * 'plugin_files'.
  **/
-bool PluginManagerUncached::loadPluginFromGameId(const Common::String &gameId) {
+bool PluginManager::loadPluginFromGameId(const Common::String &gameId) {
+	if (_index)
+		return loadPluginByFileName(_index->getFileName(gameId));
+
 	Common::ConfigManager::Domain *domain = ConfMan.getDomain("plugin_files");
 
 	if (domain) {
@@ -300,6 +310,38 @@ bool PluginManagerUncached::loadPluginFromGameId(const Common::String &gameId) {
 	return false;
 }
 
+/**
+ * Load a plugin with a filename taken from ConfigManager, keeping the
+ * plugins already in memory.
+ **/
+bool PluginManager::loadPluginByFileName(const Common::String &filename) {
+	if (filename.empty())
+		return false;
+
+	PluginList::iterator i;
+	for (i = _allEnginePlugins.begin(); i != _allEnginePlugins.end(); ++i) {
+		if (Common::String((*i)->getFileName()) != filename)
+			continue;
+
+		if (isPluginInMem(*i))
+			return true;
+		if ((*i)->loadPlugin()) {
+			addToPluginsInMemList(*i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * This should only be called once by main()
+ **/
+void PluginManagerUncached::init() {
+	PluginManager::init();
+
+	unloadPluginsExcept(PLUGIN_TYPE_ENGINE, NULL, false);	// empty the engine plugins
+}
+
 /**
  * Load a plugin with a filename taken from ConfigManager.
  **/
@@ -367,11 +409,13 @@ bool PluginManagerUncached::loadNextPlugin() {
  * one plugin in memory at a time.
  **/
 void PluginManager::loadAllPlugins() {
-	for (ProviderList::iterator pp = _providers.begin();
-	                            pp != _providers.end();
-	                            ++pp) {
-		PluginList pl((*pp)->getPlugins());
-		Common::for_each(pl.begin(), pl.end(), Common::bind1st(Common::mem_fun(&PluginManager::tryLoadPlugin), this));
+	for (uint i = 0; i < _allEnginePlugins.size(); i++) {
+		Plugin *plugin = _allEnginePlugins[i];
+		if (!isPluginInMem(plugin) && plugin->loadPlugin()) {
+			// This may drop a duplicate of the plugin from the list
+			addToPluginsInMemList(plugin);
+			i = Common::find(_allEnginePlugins.begin(), _allEnginePlugins.end(), plugin) - _allEnginePlugins.begin();
+		}
 	}
 }
 
@@ -387,7 +431,7 @@ void PluginManager::unloadPluginsExcept(PluginType type, const Plugin *plugin, b
 			found = *p;
 		} else {
 			(*p)->unloadPlugin();
-			if (deletePlugin)
+			if (deletePlugin && type != PLUGIN_TYPE_ENGINE)
 				delete *p;
 		}
 	}
@@ -397,20 +441,9 @@ void PluginManager::unloadPluginsExcept(PluginType type, const Plugin *plugin, b
 	}
 }
 
-/*
- * Used only by the cached plugin manager since it deletes the plugin.
- */
-bool PluginManager::tryLoadPlugin(Plugin *plugin) {
-	assert(plugin);
-	// Try to load the plugin
-	if (plugin->loadPlugin()) {
-		addToPluginsInMemList(plugin);
-		return true;
-	} else {
-		// Failed to load the plugin
-		delete plugin;
-		return false;
-	}
+bool PluginManager::isPluginInMem(const Plugin *plugin) const {
+	const PluginList &pl = _pluginsInMem[PLUGIN_TYPE_ENGINE];
+	return Common::find(pl.begin(), pl.end(), plugin) != pl.end();
 }
 
 /**
@@ -426,6 +459,15 @@ void PluginManager::addToPluginsInMemList(Plugin *plugin) {
 		if (!strcmp(plugin->getName(), (*pl)->getName())) {
 			// Found a duplicated module. Replace the old one.
 			found = true;
+			(*pl)->unloadPlugin();
+			if (plugin->getType() == PLUGIN_TYPE_ENGINE) {
+				// Engine plugins are kept around unloaded. Drop the replaced
+				// one for good, or loading all plugins would load it again
+				// and swap the two back and forth.
+				PluginList::iterator old = Common::find(_allEnginePlugins.begin(), _allEnginePlugins.end(), *pl);
+				if (old != _allEnginePlugins.end())
+					_allEnginePlugins.remove_at(old - _allEnginePlugins.begin());
+			}
 			delete *pl;
 			*pl = plugin;
 			debug(1, "Replaced the duplicated plugin: '%s'", plugin->getName());
@@ -441,12 +483,126 @@ void PluginManager::addToPluginsInMemList(Plugin *plugin) {
 
 // Engine plugins
 
+#include "base/version.h"
+#include "common/md5.h"
+#include "common/memstream.h"
+#include "common/system.h"
+#include "engines/detectioncache.h"
 #include "engines/metaengine.h"
 
 namespace Common {
 DECLARE_SINGLETON(EngineManager);
 }
 
+namespace {
+
+struct EngineNameLess {
+	bool operator()(const EngineManager::EngineInfo &x, const EngineManager::EngineInfo &y) const {
+		return x.name.compareToIgnoreCase(y.name) < 0;
+	}
+};
+
+} // End of anonymous namespace
+
+Common::String PluginManager::getEnginePluginsSignature(bool *complete) const {
+	Common::String signature(gScummVMFullVersion);
+	if (complete)
+		*complete = true;
+
+	for (PluginList::const_iterator p = _allEnginePlugins.begin(); p != _allEnginePlugins.end(); ++p) {
+		// Static plugins always have their plugin object
+		if (!(*p)->getFileName()) {
+			signature += Common::String("\n") + (*p)->getName();
+			continue;
+		}
+
+		uint32 size, modificationTime;
+		if (Common::FSNode((*p)->getFileName()).getFileStamp(size, modificationTime)) {
+			signature += Common::String::format("\n%s\t%u\t%u", (*p)->getFileName(), size, modificationTime);
+		} else {
+			signature += Common::String("\n") + (*p)->getFileName();
+			if (complete)
+				*complete = false;
+		}
+	}
+
+	return signature;
+}
+
+/**
+ * The index is rebuilt whenever the plugins change, so it is kept out of the
+ * config file, in a file next to it.
+ */
+static Common::FSNode getPluginIndexFile() {
+	return Common::FSNode(g_system->getDefaultConfigFileName() + ".plugins");
+}
+
+bool PluginManager::updatePluginIndex() {
+	delete _index;
+	_index = 0;
+
+	bool hasFiles = false;
+	for (PluginList::const_iterator p = _allEnginePlugins.begin(); p != _allEnginePlugins.end(); ++p) {
+		if ((*p)->getFileName())
+			hasFiles = true;
+	}
+
+	// The index is only valid for the very plugin files it was built from
+	bool complete;
+	const Common::String signature = getEnginePluginsSignature(&complete);
+	if (!hasFiles || !complete)
+		return false;
+
+	Common::MemoryReadStream stream((const byte *)signature.c_str(), signature.size());
+	const Common::String stamp = Common::computeStreamMD5AsString(stream);
+
+	const Common::FSNode indexFile = getPluginIndexFile();
+	PluginIndex *index = new PluginIndex();
+
+	Common::SeekableReadStream *in = indexFile.exists() ? indexFile.createReadStream() : 0;
+	const bool loaded = in && index->load(*in) && index->getStamp() == stamp;
+	delete in;
+	if (loaded) {
+		_index = index;
+		return true;
+	}
+
+	debug(1, "Building the index of the plugin files");
+	index->clear(stamp);
+
+	// The static plugins are indexed as well, so that the index alone can
+	// list all games and engines
+	for (PluginList::const_iterator p = _allEnginePlugins.begin(); p != _allEnginePlugins.end(); ++p) {
+		if (!(*p)->loadPlugin())
+			continue;
+
+		const EnginePlugin &engine = *(const EnginePlugin *)*p;
+		index->addEngine(engine.getName(), engine->getOriginalCopyright());
+
+		// Like the plugins in memory, the first plugin supporting a game wins
+		const char *fileName = (*p)->getFileName();
+		const GameList games = engine->getSupportedGames();
+		for (GameList::const_iterator game = games.begin(); game != games.end(); ++game)
+			index->addGame(game->gameid(), game->description(), fileName ? fileName : "");
+
+		if (fileName)
+			(*p)->unloadPlugin();
+	}
+
+	// Without a writable index file, the index is built on every start
+	Common::WriteStream *out = indexFile.createWriteStream();
+	if (out) {
+		index->save(*out);
+		out->finalize();
+		if (out->err())
+			warning("Could not write the plugin index '%s'", indexFile.getPath().c_str());
+		delete out;
+	}
+
+	_index = index;
+	return true;
+}
+
 /**
  * This function works for both cached and uncached PluginManagers.
  * For the cached version, most of the logic here will short circuit.
@@ -515,6 +671,15 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 	GameList candidates;
 	EnginePlugin::List plugins;
 	EnginePlugin::List::const_iterator iter;
+
+	// The cached results are only valid for the same set of detectors. This
+	// covers all engine plugins, whether they are loaded or not, so the
+	// cache is looked up before loading any.
+	DetectionCache &cache = DetectionCache::instance();
+	cache.setDetectorSignature(PluginManager::instance().getEnginePluginsSignature());
+	if (cache.lookupGames(fslist, candidates))
+		return candidates;
+
 	PluginManager::instance().loadFirstPlugin();
 	do {
 		plugins = getPlugins();
@@ -524,6 +689,8 @@ GameList EngineManager::detectGames(const Common::FSList &fslist) const {
 			candidates.push_back((**iter)->detectGames(fslist));
 		}
 	} while (PluginManager::instance().loadNextPlugin());
+
+	cache.storeGames(fslist, candidates);
 	return candidates;
 }
 
@@ -531,6 +698,52 @@ const EnginePlugin::List &EngineManager::getPlugins() const {
 	return (const EnginePlugin::List &)PluginManager::instance().getPlugins(PLUGIN_TYPE_ENGINE);
 }
 
+GameList EngineManager::getSupportedGames() const {
+	const PluginIndex *index = PluginManager::instance().getIndex();
+	if (index)
+		return index->getGames();
+
+	GameList games;
+	PluginManager::instance().loadFirstPlugin();
+	do {
+		const EnginePlugin::List &plugins = getPlugins();
+		for (EnginePlugin::List::const_iterator iter = plugins.begin(); iter != plugins.end(); ++iter)
+			games.push_back((**iter)->getSupportedGames());
+	} while (PluginManager::instance().loadNextPlugin());
+
+	return games;
+}
+
+EngineManager::EngineInfoList EngineManager::getEngineInfos() const {
+	EngineInfoList engines;
+	EngineInfo info;
+
+	const PluginIndex *index = PluginManager::instance().getIndex();
+	if (index) {
+		const Common::StringMap &indexedEngines = index->getEngines();
+		for (Common::StringMap::const_iterator i = indexedEngines.begin(); i != indexedEngines.end(); ++i) {
+			info.name = i->_key;
+			info.originalCopyright = i->_value;
+			engines.push_back(info);
+		}
+
+		Common::sort(engines.begin(), engines.end(), EngineNameLess());
+		return engines;
+	}
+
+	PluginManager::instance().loadFirstPlugin();
+	do {
+		const EnginePlugin::List &plugins = getPlugins();
+		for (EnginePlugin::List::const_iterator iter = plugins.begin(); iter != plugins.end(); ++iter) {
+			info.name = (**iter).getName();
+			info.originalCopyright = (**iter)->getOriginalCopyright();
+			engines.push_back(info);
+		}
+	} while (PluginManager::instance().loadNextPlugin());
+
+	return engines;
+}
+
 
 // Music plugins
 
@@ -297,9 +297,19 @@ protected:
 
 #define PluginMan PluginManager::instance()
 
+class PluginIndex;
+
 /**
  * Singleton class which manages all plugins, including loading them,
  * managing all Plugin class instances, and unloading them.
+ *
+ * Engine plugins are loaded on demand: the plugin index (see PluginIndex)
+ * maps the ids of the supported games to the files of the plugins, so
+ * starting a game only loads the plugin running it. It also holds the
+ * descriptions of the games and the names and copyrights of the engines,
+ * so the games and engines can be listed without loading any plugin. The
+ * index is built the first time the plugin files are seen, and rebuilt
+ * whenever one of them changes.
  */
 class PluginManager {
 protected:
@@ -308,8 +318,25 @@ protected:
 	PluginList _pluginsInMem[PLUGIN_TYPE_MAX];
 	ProviderList _providers;
 
-	bool tryLoadPlugin(Plugin *plugin);
+	/** All engine plugins, whether loaded or not. These are owned by the manager. */
+	PluginList _allEnginePlugins;
+
+	/** The index of the engine plugins, or 0, see updatePluginIndex(). */
+	PluginIndex *_index;
+
 	void addToPluginsInMemList(Plugin *plugin);
+	bool isPluginInMem(const Plugin *plugin) const;
+
+	virtual bool loadPluginByFileName(const Common::String &filename);
+
+	/**
+	 * Bring the index of the games supported by the plugin files up to
+	 * date, loading each of the plugins once if it has to be rebuilt.
+	 *
+	 * @return false if the plugins cannot be indexed, e.g. since there
+	 *         are no plugin files
+	 */
+	bool updatePluginIndex();
 
 	static PluginManager *_instance;
 	PluginManager();
@@ -322,20 +349,52 @@ public:
 
 	void addPluginProvider(PluginProvider *pp);
 
-	// Functions used by the uncached PluginManager
-	virtual void init()	{}
-	virtual void loadFirstPlugin() {}
+	/**
+	 * Collect the plugins of all providers and load the ones which are
+	 * not loaded on demand. This should only be called once by main().
+	 */
+	virtual void init();
+
+	// Functions used to look through all engine plugins
+	virtual void loadFirstPlugin() { loadAllPlugins(); }
 	virtual bool loadNextPlugin() { return false; }
-	virtual bool loadPluginFromGameId(const Common::String &gameId) { return false; }
+
+	/**
+	 * Load the plugin supporting a game, as listed in the plugin index or
+	 * the "plugin_files" config domain, in addition to the plugins already
+	 * in memory.
+	 */
+	virtual bool loadPluginFromGameId(const Common::String &gameId);
 	virtual void updateConfigWithFileName(const Common::String &gameId) {}
 
 	// Functions used only by the cached PluginManager
 	virtual void loadAllPlugins();
 	void unloadAllPlugins();
 
+	/**
+	 * Unload the plugins of a type, except for one. Engine plugins are
+	 * never deleted, since they can be loaded again.
+	 */
 	void unloadPluginsExcept(PluginType type, const Plugin *plugin, bool deletePlugin = true);
 
 	const PluginList &getPlugins(PluginType t) { return _pluginsInMem[t]; }
+
+	/**
+	 * Return the index of the engine plugins, or 0 if they are not indexed.
+	 * In that case, all of them are loaded by init().
+	 */
+	const PluginIndex *getIndex() const { return _index; }
+
+	/**
+	 * Return a string which changes whenever the set of engine plugins
+	 * does, whether they are loaded or not: it holds the version, the names
+	 * of the static plugins, and the names, sizes and modification times of
+	 * the plugin files.
+	 *
+	 * @param complete	if given, set to false if the size or modification
+	 *			time of a plugin file is unknown
+	 */
+	Common::String getEnginePluginsSignature(bool *complete = 0) const;
 };
 
 /**
@@ -345,17 +404,15 @@ public:
 class PluginManagerUncached : public PluginManager {
 protected:
 	friend class PluginManager;
-	PluginList _allEnginePlugins;
 	PluginList::iterator _currentPlugin;
 
 	PluginManagerUncached() {}
-	bool loadPluginByFileName(const Common::String &filename);
+	virtual bool loadPluginByFileName(const Common::String &filename);
 
 public:
 	virtual void init();
 	virtual void loadFirstPlugin();
 	virtual bool loadNextPlugin();
-	virtual bool loadPluginFromGameId(const Common::String &gameId);
 	virtual void updateConfigWithFileName(const Common::String &gameId);
 
 	virtual void loadAllPlugins() {} 	// we don't allow this
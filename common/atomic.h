@@ -0,0 +1,146 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_ATOMIC_H
+#define COMMON_ATOMIC_H
+
+#include "common/scummsys.h"
+
+#if defined(_MSC_VER)
+// See common/math.h on why setjmp and longjmp need special care here
+#undef setjmp
+#undef longjmp
+#include <intrin.h>
+
+#ifndef FORBIDDEN_SYMBOL_EXCEPTION_setjmp
+#undef setjmp
+#define setjmp(a)	FORBIDDEN_SYMBOL_REPLACEMENT
+#endif
+
+#ifndef FORBIDDEN_SYMBOL_EXCEPTION_longjmp
+#undef longjmp
+#define longjmp(a,b)	FORBIDDEN_SYMBOL_REPLACEMENT
+#endif
+#elif !defined(__GNUC__)
+#error No atomic operations are known for this compiler
+#endif
+
+/**
+ * @file
+ * Minimal set of atomic operations for sharing data between threads
+ * without a mutex, e.g. between the audio thread and the rest of the
+ * program.
+ *
+ * All operations imply a full memory barrier. Values used with them should
+ * be naturally aligned words (int32, uint32 or pointers) declared volatile.
+ *
+ * They are implemented with the GCC __sync builtins (also provided by
+ * clang) and the MSVC interlocked intrinsics; other compilers are not
+ * supported.
+ */
+
+namespace Common {
+
+/**
+ * Prevent the compiler and the CPU from reordering memory accesses across
+ * this call.
+ */
+inline void memoryBarrier() {
+#if defined(__GNUC__)
+	__sync_synchronize();
+#else
+	// Interlocked operations are full barriers, for the compiler and the CPU
+	volatile long barrier = 0;
+	_InterlockedOr(&barrier, 0);
+#endif
+}
+
+/**
+ * Read a value written by another thread. Memory accesses following the
+ * load are not moved before it.
+ */
+template<typename T>
+inline T atomicLoad(const volatile T *ptr) {
+	T value = *ptr;
+	memoryBarrier();
+	return value;
+}
+
+/**
+ * Publish a value to other threads. Memory accesses preceding the store,
+ * e.g. the initialization of the object a pointer points to, are not moved
+ * after it.
+ */
+template<typename T>
+inline void atomicStore(volatile T *ptr, T value) {
+	memoryBarrier();
+	*ptr = value;
+	memoryBarrier();
+}
+
+#if defined(_MSC_VER)
+/**
+ * Publish a pointer to other threads. Pointers get their own version, as
+ * they cannot be passed to the interlocked integer functions on Win64.
+ */
+template<typename T>
+inline void atomicStore(T *volatile *ptr, T *value) {
+	_InterlockedExchangePointer((void *volatile *)ptr, (void *)value);
+}
+#endif
+
+/**
+ * Replace the value at ptr with newValue, provided that it still equals
+ * oldValue. For pointers, see the overload below.
+ *
+ * @return true if the value was replaced, false otherwise
+ */
+template<typename T>
+inline bool atomicCompareAndSwap(volatile T *ptr, T oldValue, T newValue) {
+#if defined(__GNUC__)
+	return __sync_bool_compare_and_swap(ptr, oldValue, newValue);
+#else
+	if (sizeof(T) == sizeof(long))
+		return _InterlockedCompareExchange((volatile long *)ptr, (long)newValue, (long)oldValue) == (long)oldValue;
+	else
+		return _InterlockedCompareExchange64((volatile __int64 *)ptr, (__int64)newValue, (__int64)oldValue) == (__int64)oldValue;
+#endif
+}
+
+/**
+ * Replace the pointer at ptr with newValue, provided that it still equals
+ * oldValue.
+ *
+ * @return true if the pointer was replaced, false otherwise
+ */
+template<typename T>
+inline bool atomicCompareAndSwap(T *volatile *ptr, T *oldValue, T *newValue) {
+#if defined(__GNUC__)
+	return __sync_bool_compare_and_swap(ptr, oldValue, newValue);
+#else
+	return _InterlockedCompareExchangePointer((void *volatile *)ptr, (void *)newValue, (void *)oldValue) == (void *)oldValue;
+#endif
+}
+
+} // End of namespace Common
+
+#endif
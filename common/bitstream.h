@@ -26,8 +26,10 @@
 #define COMMON_BITSTREAM_H
 
 #include "common/scummsys.h"
+#include "common/endian.h"
 #include "common/textconsole.h"
 #include "common/stream.h"
+#include "common/types.h"
 
 namespace Common {
 
@@ -67,29 +69,170 @@ public:
 	/** Add a bit to the value x, making it an n+1-bit value. */
 	virtual void addBit(uint32 &x, uint32 n) = 0;
 
+	/** Are the bits handed out in the order of MSB to LSB? */
+	virtual bool isMSB2LSB() const = 0;
+
 protected:
 	BitStream() {
 	}
 };
 
 /**
- * A template implementing a bit stream for different data memory layouts.
+ * A cut-down memory stream for use with BitStreamReader.
  *
- * Such a bit stream reads valueBits-wide values from the data stream and
- * gives access to their bits, one at a time.
+ * Contrary to MemoryReadStream, none of its methods are virtual, so that
+ * a BitStreamReader using it can be fully inlined.
+ */
+class BitStreamMemoryStream {
+private:
+	const byte * const _ptrOrig;
+	const byte *_ptr;
+	const uint32 _size;
+	uint32 _pos;
+	DisposeAfterUse::Flag _disposeMemory;
+	bool _eos;
+
+public:
+	/**
+	 * Wrap a memory buffer. If disposeMemory is YES, the stream takes
+	 * ownership of the buffer and free's it when destructed.
+	 */
+	BitStreamMemoryStream(const byte *dataPtr, uint32 dataSize, DisposeAfterUse::Flag disposeMemory = DisposeAfterUse::NO) :
+		_ptrOrig(dataPtr),
+		_ptr(dataPtr),
+		_size(dataSize),
+		_pos(0),
+		_disposeMemory(disposeMemory),
+		_eos(false) {}
+
+	~BitStreamMemoryStream() {
+		if (_disposeMemory)
+			free(const_cast<byte *>(_ptrOrig));
+	}
+
+	bool eos() const { return _eos; }
+	bool err() const { return false; }
+
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		if (whence == SEEK_END)
+			offset += _size;
+		else if (whence == SEEK_CUR)
+			offset += _pos;
+
+		if (offset < 0 || (uint32)offset > _size)
+			return false;
+
+		_pos = offset;
+		_ptr = _ptrOrig + offset;
+		_eos = false;
+		return true;
+	}
+
+	byte readByte() {
+		if (_pos + 1 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		_pos++;
+		return *_ptr++;
+	}
+
+	uint16 readUint16LE() {
+		if (_pos + 2 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		uint16 val = READ_LE_UINT16(_ptr);
+		_pos += 2;
+		_ptr += 2;
+		return val;
+	}
+
+	uint16 readUint16BE() {
+		if (_pos + 2 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		uint16 val = READ_BE_UINT16(_ptr);
+		_pos += 2;
+		_ptr += 2;
+		return val;
+	}
+
+	uint32 readUint32LE() {
+		if (_pos + 4 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		uint32 val = READ_LE_UINT32(_ptr);
+		_pos += 4;
+		_ptr += 4;
+		return val;
+	}
+
+	uint32 readUint32BE() {
+		if (_pos + 4 > _size) {
+			_eos = true;
+			return 0;
+		}
+
+		uint32 val = READ_BE_UINT32(_ptr);
+		_pos += 4;
+		_ptr += 4;
+		return val;
+	}
+};
+
+/**
+ * A template implementing a bit reader for different data memory layouts.
+ *
+ * Such a reader reads valueBits-wide values from the data stream and
+ * gives access to their bits. For example, a reader with the layout
+ * parameters 32, true, false for valueBits, isLE and MSB2LSB, reads
+ * 32bit little-endian values from the data stream and hands out the bits
+ * in the order of LSB to MSB.
+ *
+ * The values are read a whole value at a time into a 64 bit reservoir,
+ * held in two 32 bit halves. Thus getBits(), peekBits() and skip() don't
+ * need to loop over single bits and peeking never seeks in the stream.
+ *
+ * None of the methods are virtual. Decoders which know the layout of
+ * their data can use a reader directly (see the BitStreamMemory*
+ * typedefs) to get all reads inlined; BitStreamImpl wraps a reader on a
+ * SeekableReadStream into the BitStream interface.
  *
- * For example, a bit stream with the layout parameters 32, true, false
- * for valueBits, isLE and isMSB2LSB, reads 32bit little-endian values
- * from the data stream and hands out the bits in the order of LSB to MSB.
+ * STREAM is the data stream class. It needs to provide pos(), size(),
+ * seek(), err(), eos() and the readByte()/readUint16*()/readUint32*()
+ * methods matching the memory layout.
  */
-template<int valueBits, bool isLE, bool isMSB2LSB>
-class BitStreamImpl : public BitStream {
+template<class STREAM, int valueBits, bool isLE, bool MSB2LSB>
+class BitStreamReader {
 private:
-	SeekableReadStream *_stream; ///< The input stream.
-	bool _disposeAfterUse;       ///< Should we delete the stream on destruction?
+	enum {
+		kValueBytes = valueBits / 8
+	};
+
+	STREAM *_stream;       ///< The input stream.
+	bool _disposeAfterUse; ///< Should we delete the stream on destruction?
 
-	uint32 _value;   ///< Current value.
-	uint8  _inValue; ///< Position within the current value.
+	/**
+	 * The bit reservoir. With MSB2LSB, the next bit is the MSB of _head,
+	 * followed by the bits of _tail. Otherwise, it's the LSB of _head,
+	 * followed by the higher bits of _head and then those of _tail.
+	 */
+	uint32 _head;
+	uint32 _tail;
+	uint8  _inValue; ///< Number of bits in the reservoir.
+
+	uint32 _dataPos;  ///< Stream position of the next data value.
+	uint32 _dataSize; ///< Stream size, rounded down to whole data values.
 
 	/** Read a data value. */
 	inline uint32 readData() {
@@ -113,64 +256,110 @@ private:
 		return 0;
 	}
 
-	/** Read the next data value. */
-	inline void readValue() {
-		if ((size() - pos()) < valueBits)
-			error("BitStreamImpl::readValue(): End of bit stream reached");
+	/** Add as many whole data values to the reservoir as fit. */
+	inline void fillReservoir() {
+		while (_inValue <= 64 - valueBits && _dataPos < _dataSize) {
+			uint32 value = readData();
+			if (_stream->err() || _stream->eos())
+				error("BitStreamReader::fillReservoir(): Read error");
+
+			_dataPos += kValueBytes;
+
+			if (MSB2LSB) {
+				if (_inValue + valueBits <= 32) {
+					_head |= value << (32 - valueBits - _inValue);
+				} else if (_inValue >= 32) {
+					_tail |= value << (64 - valueBits - _inValue);
+				} else {
+					_head |= value >> (_inValue + valueBits - 32);
+					_tail |= value << (64 - valueBits - _inValue);
+				}
+			} else {
+				if (_inValue + valueBits <= 32) {
+					_head |= value << _inValue;
+				} else if (_inValue >= 32) {
+					_tail |= value << (_inValue - 32);
+				} else {
+					_head |= value << _inValue;
+					_tail |= value >> (32 - _inValue);
+				}
+			}
+
+			_inValue += valueBits;
+		}
+	}
 
-		_value = readData();
-		if (_stream->err() || _stream->eos())
-			error("BitStreamImpl::readValue(): Read error");
+	/** Make sure the reservoir holds at least n bits. */
+	inline void need(uint8 n) {
+		if (_inValue < n) {
+			fillReservoir();
 
-		// If we're reading the bits MSB first, we need to shift the value to that position
-		if (isMSB2LSB)
-			_value <<= 32 - valueBits;
+			if (_inValue < n)
+				error("BitStreamReader::need(): End of bit stream reached");
 		}
+	}
 
-public:
-	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
-	BitStreamImpl(SeekableReadStream *stream, bool disposeAfterUse = false) :
-		_stream(stream), _disposeAfterUse(disposeAfterUse), _value(0), _inValue(0) {
+	/** Return the next n (1-32) bits in the reservoir. */
+	inline uint32 look(uint8 n) const {
+		if (MSB2LSB)
+			return _head >> (32 - n);
 
-		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
-			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+		return _head & (0xFFFFFFFF >> (32 - n));
 	}
 
-	/** Create a bit stream using this input data stream. */
-	BitStreamImpl(SeekableReadStream &stream) :
-		_stream(&stream), _disposeAfterUse(false), _value(0), _inValue(0) {
+	/** Remove n (1-32) bits from the reservoir. */
+	inline void drop(uint8 n) {
+		if (n == 32) {
+			_head = _tail;
+			_tail = 0;
+		} else if (MSB2LSB) {
+			_head = (_head << n) | (_tail >> (32 - n));
+			_tail <<= n;
+		} else {
+			_head = (_head >> n) | (_tail << (32 - n));
+			_tail >>= n;
+		}
+
+		_inValue -= n;
+	}
 
+	void init() {
 		if ((valueBits != 8) && (valueBits != 16) && (valueBits != 32))
-			error("BitStreamImpl: Invalid memory layout %d, %d, %d", valueBits, isLE, isMSB2LSB);
+			error("BitStreamReader: Invalid memory layout %d, %d, %d", valueBits, isLE, MSB2LSB);
+
+		_head = _tail = 0;
+		_inValue = 0;
+
+		_dataPos  = _stream->pos();
+		_dataSize = _stream->size() & ~((uint32) (kValueBytes - 1));
 	}
 
-	~BitStreamImpl() {
+public:
+	/** Create a bit reader using this input data stream and optionally delete it on destruction. */
+	BitStreamReader(STREAM *stream, bool disposeAfterUse = false) :
+		_stream(stream), _disposeAfterUse(disposeAfterUse) {
+
+		init();
+	}
+
+	/** Create a bit reader using this input data stream. */
+	BitStreamReader(STREAM &stream) :
+		_stream(&stream), _disposeAfterUse(false) {
+
+		init();
+	}
+
+	~BitStreamReader() {
 		if (_disposeAfterUse)
 			delete _stream;
 	}
 
 	/** Read a bit from the bit stream. */
 	uint32 getBit() {
-		// Check if we need the next value
-		if (_inValue == 0)
-			readValue();
-
-		// Get the current bit
-		int b = 0;
-		if (isMSB2LSB)
-			b = ((_value & 0x80000000) == 0) ? 0 : 1;
-		else
-			b = ((_value & 1) == 0) ? 0 : 1;
-
-		// Shift to the next bit
-		if (isMSB2LSB)
-			_value <<= 1;
-		else
-			_value >>= 1;
-
-		// Increase the position within the current value
-		_inValue = (_inValue + 1) % valueBits;
+		need(1);
 
+		uint32 b = look(1);
+		drop(1);
 		return b;
 	}
 
@@ -189,37 +378,20 @@ public:
 			return 0;
 
 		if (n > 32)
-			error("BitStreamImpl::getBits(): Too many bits requested to be read");
-
-		// Read the number of bits
-		uint32 v = 0;
+			error("BitStreamReader::getBits(): Too many bits requested to be read");
 
-		if (isMSB2LSB) {
-			while (n-- > 0)
-				v = (v << 1) | getBit();
-		} else {
-			for (uint32 i = 0; i < n; i++)
-				v = (v >> 1) | (((uint32) getBit()) << 31);
-
-			v >>= (32 - n);
-		}
+		need(n);
 
+		uint32 v = look(n);
+		drop(n);
 		return v;
 	}
 
 	/** Read a bit from the bit stream, without changing the stream's position. */
 	uint32 peekBit() {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
-
-		uint32 v = getBit();
+		need(1);
 
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
-
-		return v;
+		return look(1);
 	}
 
 	/**
@@ -228,17 +400,15 @@ public:
 	 * The bit order is the same as in getBits().
 	 */
 	uint32 peekBits(uint8 n) {
-		uint32 value   = _value;
-		uint8  inValue = _inValue;
-		uint32 curPos  = _stream->pos();
+		if (n == 0)
+			return 0;
 
-		uint32 v = getBits(n);
+		if (n > 32)
+			error("BitStreamReader::peekBits(): Too many bits requested to be read");
 
-		_stream->seek(curPos);
-		_inValue = inValue;
-		_value   = value;
+		need(n);
 
-		return v;
+		return look(n);
 	}
 
 	/**
@@ -254,9 +424,9 @@ public:
 	 */
 	void addBit(uint32 &x, uint32 n) {
 		if (n >= 32)
-			error("BitStreamImpl::addBit(): Too many bits requested to be read");
+			error("BitStreamReader::addBit(): Too many bits requested to be read");
 
-		if (isMSB2LSB)
+		if (MSB2LSB)
 			x = (x << 1) | getBit();
 		else
 			x = (x & ~(1 << n)) | (getBit() << n);
@@ -266,35 +436,97 @@ public:
 	void rewind() {
 		_stream->seek(0);
 
-		_value   = 0;
+		_head = _tail = 0;
 		_inValue = 0;
+		_dataPos = 0;
 	}
 
 	/** Skip the specified amount of bits. */
 	void skip(uint32 n) {
-		while (n-- > 0)
-			getBit();
+		if (n > _inValue) {
+			// Empty the reservoir and skip whole data values in the stream
+			n -= _inValue;
+			_head = _tail = 0;
+			_inValue = 0;
+
+			uint32 skipBytes = (n / valueBits) * kValueBytes;
+			if (skipBytes > _dataSize - _dataPos)
+				error("BitStreamReader::skip(): End of bit stream reached");
+
+			if (skipBytes > 0) {
+				_dataPos += skipBytes;
+				_stream->seek(_dataPos);
+			}
+
+			n %= valueBits;
+		}
+
+		if (n > 32) {
+			drop(32);
+			n -= 32;
+		}
+
+		if (n > 0) {
+			need(n);
+			drop(n);
+		}
+	}
+
+	/** Are the bits handed out in the order of MSB to LSB? */
+	bool isMSB2LSB() const {
+		return MSB2LSB;
 	}
 
 	/** Return the stream position in bits. */
 	uint32 pos() const {
-		if (_stream->pos() == 0)
-			return 0;
-
-		uint32 p = (_inValue == 0) ? _stream->pos() : ((_stream->pos() - 1) & ~((uint32) ((valueBits >> 3) - 1)));
-		return p * 8 + _inValue;
+		return _dataPos * 8 - _inValue;
 	}
 
 	/** Return the stream size in bits. */
 	uint32 size() const {
-		return (_stream->size() & ~((uint32) ((valueBits >> 3) - 1))) * 8;
+		return _dataSize * 8;
 	}
 
 	bool eos() const {
-		return _stream->eos() || (pos() >= size());
+		return pos() >= size();
 	}
 };
 
+/**
+ * A template implementing the BitStream interface for different data
+ * memory layouts, on top of a SeekableReadStream.
+ *
+ * See BitStreamReader for the meaning of the layout parameters.
+ */
+template<int valueBits, bool isLE, bool MSB2LSB>
+class BitStreamImpl : public BitStream {
+private:
+	BitStreamReader<SeekableReadStream, valueBits, isLE, MSB2LSB> _reader;
+
+public:
+	/** Create a bit stream using this input data stream and optionally delete it on destruction. */
+	BitStreamImpl(SeekableReadStream *stream, bool disposeAfterUse = false) :
+		_reader(stream, disposeAfterUse) {
+	}
+
+	/** Create a bit stream using this input data stream. */
+	BitStreamImpl(SeekableReadStream &stream) :
+		_reader(stream) {
+	}
+
+	uint32 getBit() { return _reader.getBit(); }
+	uint32 getBits(uint8 n) { return _reader.getBits(n); }
+	uint32 peekBit() { return _reader.peekBit(); }
+	uint32 peekBits(uint8 n) { return _reader.peekBits(n); }
+	void addBit(uint32 &x, uint32 n) { _reader.addBit(x, n); }
+	void rewind() { _reader.rewind(); }
+	void skip(uint32 n) { _reader.skip(n); }
+	uint32 pos() const { return _reader.pos(); }
+	uint32 size() const { return _reader.size(); }
+	bool eos() const { return _reader.eos(); }
+	bool isMSB2LSB() const { return MSB2LSB; }
+};
+
 // typedefs for various memory layouts.
 
 /** 8-bit data, MSB to LSB. */
@@ -320,6 +552,21 @@ typedef BitStreamImpl<32, false, true > BitStream32BEMSB;
 /** 32-bit big-endian data, LSB to MSB. */
 typedef BitStreamImpl<32, false, false> BitStream32BELSB;
 
+// typedefs for the non-virtual readers on memory buffers, in the same layouts.
+
+typedef BitStreamReader<BitStreamMemoryStream,  8, false, true > BitStreamMemory8MSB;
+typedef BitStreamReader<BitStreamMemoryStream,  8, false, false> BitStreamMemory8LSB;
+
+typedef BitStreamReader<BitStreamMemoryStream, 16, true , true > BitStreamMemory16LEMSB;
+typedef BitStreamReader<BitStreamMemoryStream, 16, true , false> BitStreamMemory16LELSB;
+typedef BitStreamReader<BitStreamMemoryStream, 16, false, true > BitStreamMemory16BEMSB;
+typedef BitStreamReader<BitStreamMemoryStream, 16, false, false> BitStreamMemory16BELSB;
+
+typedef BitStreamReader<BitStreamMemoryStream, 32, true , true > BitStreamMemory32LEMSB;
+typedef BitStreamReader<BitStreamMemoryStream, 32, true , false> BitStreamMemory32LELSB;
+typedef BitStreamReader<BitStreamMemoryStream, 32, false, true > BitStreamMemory32BEMSB;
+typedef BitStreamReader<BitStreamMemoryStream, 32, false, false> BitStreamMemory32BELSB;
+
 } // End of namespace Common
 
 #endif // COMMON_BITSTREAM_H
@@ -23,30 +23,39 @@
 // Based on eos' cosine tables
 
 #include "common/cosinetables.h"
+#include "common/atomic.h"
 #include "common/scummsys.h"
 
 namespace Common {
 
+// Indexed by the bit precision. Tables may be created by decoders on
+// several threads at once, so they are published atomically.
+static float *volatile s_cosineTables[17];
+
 CosineTable::CosineTable(int bitPrecision) {
 	assert((bitPrecision >= 4) && (bitPrecision <= 16));
 
 	_bitPrecision = bitPrecision;
 
-	int m = 1 << _bitPrecision;
-	double freq = 2 * M_PI / m;
-	_table = new float[m];
+	if (!atomicLoad(&s_cosineTables[bitPrecision])) {
+		int m = 1 << _bitPrecision;
+		double freq = 2 * M_PI / m;
+		float *table = new float[m / 2];
 
-	// Table contains cos(2*pi*x/n) for 0<=x<=n/4, 
-	// followed by its reverse
-	for (int i = 0; i <= m / 4; i++)
-		_table[i] = cos(i * freq);
+		// Table contains cos(2*pi*x/n) for 0<=x<=n/4,
+		// followed by its reverse
+		for (int i = 0; i <= m / 4; i++)
+			table[i] = cos(i * freq);
 
-	for (int i = 1; i < m / 4; i++)
-		_table[m / 2 - i] = _table[i];
-}
+		for (int i = 1; i < m / 4; i++)
+			table[m / 2 - i] = table[i];
+
+		// Keep the table of another thread which got there first
+		if (!atomicCompareAndSwap(&s_cosineTables[bitPrecision], (float *)0, table))
+			delete[] table;
+	}
 
-CosineTable::~CosineTable() {
-	delete[] _table;
+	_table = atomicLoad(&s_cosineTables[bitPrecision]);
 }
 
 } // End of namespace Common
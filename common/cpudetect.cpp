@@ -0,0 +1,70 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "common/cpudetect.h"
+
+#if defined(_MSC_VER) && defined(SCUMMVM_SSE2)
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+static uint32 detectCPUFeatures() {
+	uint32 features = 0;
+
+#if defined(SCUMMVM_SSE2) && defined(__GNUC__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		features |= kCPUFeatureSSE2;
+	if (__builtin_cpu_supports("avx2"))
+		features |= kCPUFeatureAVX2;
+#elif defined(SCUMMVM_SSE2) && defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 1);
+	if (info[3] & (1 << 26))
+		features |= kCPUFeatureSSE2;
+
+#ifdef SCUMMVM_AVX2
+	// AVX2 needs the OS to save the YMM registers (OSXSAVE + XCR0 bits 1, 2)
+	const bool osSavesYMM = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+	__cpuid(info, 0);
+	if (osSavesYMM && info[0] >= 7) {
+		__cpuidex(info, 7, 0);
+		if (info[1] & (1 << 5))
+			features |= kCPUFeatureAVX2;
+	}
+#endif
+#endif
+
+#ifdef SCUMMVM_NEON
+	features |= kCPUFeatureNEON;
+#endif
+
+	return features;
+}
+
+uint32 getCPUFeatures() {
+	static uint32 features = detectCPUFeatures();
+	return features;
+}
+
+} // End of namespace Common
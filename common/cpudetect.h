@@ -0,0 +1,88 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef COMMON_CPUDETECT_H
+#define COMMON_CPUDETECT_H
+
+#include "common/scummsys.h"
+
+/**
+ * @file
+ * Compile time and run time detection of the SIMD instruction sets which
+ * the optimized code paths (audio mixing, scalers, video decoding, ...)
+ * may use.
+ *
+ * The compile time macros only state that the compiler is able to generate
+ * code for a given instruction set. Code using them still has to check
+ * Common::hasCPUFeature() before calling into such a code path, since the
+ * binary may run on a CPU which lacks the instructions.
+ *
+ * SCUMMVM_SSE2  - SSE2 intrinsics (<emmintrin.h>) can be used. Functions
+ *                 using them must be marked with SCUMMVM_TARGET_SSE2.
+ * SCUMMVM_AVX2  - AVX2 intrinsics (<immintrin.h>) can be used. Functions
+ *                 using them must be marked with SCUMMVM_TARGET_AVX2.
+ * SCUMMVM_NEON  - NEON intrinsics (<arm_neon.h>) can be used. Since NEON
+ *                 must be enabled for the whole translation unit, this is
+ *                 only defined when the compiler targets NEON anyway.
+ */
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+	#define SCUMMVM_SSE2
+	#define SCUMMVM_AVX2
+	#define SCUMMVM_TARGET_SSE2 __attribute__((target("sse2")))
+	#define SCUMMVM_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#define SCUMMVM_SSE2
+	#if _MSC_VER >= 1800
+		#define SCUMMVM_AVX2
+	#endif
+	#define SCUMMVM_TARGET_SSE2
+	#define SCUMMVM_TARGET_AVX2
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#define SCUMMVM_NEON
+#endif
+
+namespace Common {
+
+enum CPUFeature {
+	kCPUFeatureSSE2 = 1 << 0,
+	kCPUFeatureAVX2 = 1 << 1,
+	kCPUFeatureNEON = 1 << 2
+};
+
+/**
+ * Return the set of CPUFeature flags supported by both the compiler and the
+ * CPU we are running on. The detection is only done once.
+ */
+uint32 getCPUFeatures();
+
+/**
+ * Check whether the given instruction set can be used at run time.
+ */
+inline bool hasCPUFeature(CPUFeature feature) {
+	return (getCPUFeatures() & feature) != 0;
+}
+
+} // End of namespace Common
+
+#endif
@@ -26,6 +26,15 @@
 // Copyright (c) 2002 Fabrice Bellard
 // Partly based on libdjbfft by D. J. Bernstein
 
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_NEON
+#include <arm_neon.h>
+#endif
+
 #include "common/cosinetables.h"
 #include "common/fft.h"
 #include "common/util.h"
@@ -33,26 +42,46 @@
 
 namespace Common {
 
-FFT::FFT(int bits, int inverse) : _bits(bits), _inverse(inverse) {
-	assert((_bits >= 2) && (_bits <= 16));
+bool hasFFTImpl(FFTImpl impl) {
+	switch (impl) {
+	case kFFTScalar:
+		return true;
 
-	int n = 1 << bits;
+#ifdef SCUMMVM_SSE2
+	case kFFTSSE2:
+		return hasCPUFeature(kCPUFeatureSSE2);
+#endif
 
-	_tmpBuf = new Complex[n];
-	_expTab = new Complex[n / 2];
-	_revTab = new uint16[n];
+#ifdef SCUMMVM_NEON
+	case kFFTNEON:
+		return hasCPUFeature(kCPUFeatureNEON);
+#endif
 
-	_splitRadix = 1;
+	default:
+		return false;
+	}
+}
 
-	for (int i = 0; i < n; i++)
-		_revTab[-splitRadixPermutation(i, n, _inverse) & (n - 1)] = i;
+static FFTImpl getBestFFTImpl() {
+	static const FFTImpl preferred[] = {
+		kFFTSSE2,
+		kFFTNEON
+	};
 
-	for (int i = 0; i < ARRAYSIZE(_cosTables); i++) {
-		if (i+4 <= _bits)
-			_cosTables[i] = new Common::CosineTable(i+4);
-		else
-			_cosTables[i] = 0;
+	for (int i = 0; i < ARRAYSIZE(preferred); ++i) {
+		if (hasFFTImpl(preferred[i]))
+			return preferred[i];
 	}
+
+	return kFFTScalar;
+}
+
+FFT::FFT(int bits, int inverse) : _bits(bits), _inverse(inverse) {
+	init(getBestFFTImpl());
+}
+
+FFT::FFT(int bits, int inverse, FFTImpl impl) : _bits(bits), _inverse(inverse) {
+	init(impl);
 }
 
 FFT::~FFT() {
@@ -170,6 +199,173 @@ PASS(pass)
 #define BUTTERFLIES BUTTERFLIES_BIG
 PASS(pass_big)
 
+// The vectorized passes do four elements of each quarter at a time, with
+// the operations of TRANSFORM() and BUTTERFLIES(). As they load all inputs
+// before storing, they also serve for the big transforms.
+
+#ifdef SCUMMVM_SSE2
+
+/** Split four consecutive complex numbers into their real and imaginary parts. */
+SCUMMVM_TARGET_SSE2 static inline void loadComplexSSE2(const Complex *z, __m128 &re, __m128 &im) {
+	const __m128 lo = _mm_loadu_ps(&z[0].re);
+	const __m128 hi = _mm_loadu_ps(&z[2].re);
+	re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+	im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+SCUMMVM_TARGET_SSE2 static inline void storeComplexSSE2(Complex *z, __m128 re, __m128 im) {
+	_mm_storeu_ps(&z[0].re, _mm_unpacklo_ps(re, im));
+	_mm_storeu_ps(&z[2].re, _mm_unpackhi_ps(re, im));
+}
+
+/* z[0...8n-1], w[1...2n-1], n >= 2 */
+SCUMMVM_TARGET_SSE2 static void passSSE2(Complex *z, const float *wre, unsigned int n) {
+	const int o1 = 2 * n;
+	const int o2 = 4 * n;
+	const int o3 = 6 * n;
+	const float *wim = wre + o1;
+
+	// Element 0 is not multiplied at all (TRANSFORM_ZERO), which is not the
+	// same as multiplying by 1 and 0 for signed zeros, so its inputs are
+	// blended in unchanged.
+	const __m128 first = _mm_castsi128_ps(_mm_cvtsi32_si128(-1));
+
+	for (int k = 0; k < o1; k += 4) {
+		__m128 r0, i0, r1, i1, r2, i2, r3, i3;
+		loadComplexSSE2(z + k, r0, i0);
+		loadComplexSSE2(z + o1 + k, r1, i1);
+		loadComplexSSE2(z + o2 + k, r2, i2);
+		loadComplexSSE2(z + o3 + k, r3, i3);
+
+		// wim[-k], wim[-k - 1], wim[-k - 2], wim[-k - 3]
+		const __m128 wr = _mm_loadu_ps(wre + k);
+		__m128 wi = _mm_loadu_ps(wim - k - 3);
+		wi = _mm_shuffle_ps(wi, wi, _MM_SHUFFLE(0, 1, 2, 3));
+
+		__m128 v1 = _mm_add_ps(_mm_mul_ps(r2, wr), _mm_mul_ps(i2, wi));
+		__m128 v2 = _mm_sub_ps(_mm_mul_ps(i2, wr), _mm_mul_ps(r2, wi));
+		__m128 v5 = _mm_sub_ps(_mm_mul_ps(r3, wr), _mm_mul_ps(i3, wi));
+		__m128 v6 = _mm_add_ps(_mm_mul_ps(i3, wr), _mm_mul_ps(r3, wi));
+		if (k == 0) {
+			v1 = _mm_or_ps(_mm_and_ps(first, r2), _mm_andnot_ps(first, v1));
+			v2 = _mm_or_ps(_mm_and_ps(first, i2), _mm_andnot_ps(first, v2));
+			v5 = _mm_or_ps(_mm_and_ps(first, r3), _mm_andnot_ps(first, v5));
+			v6 = _mm_or_ps(_mm_and_ps(first, i3), _mm_andnot_ps(first, v6));
+		}
+
+		const __m128 sum15 = _mm_add_ps(v5, v1), diff51 = _mm_sub_ps(v5, v1);
+		const __m128 sum26 = _mm_add_ps(v2, v6), diff26 = _mm_sub_ps(v2, v6);
+
+		storeComplexSSE2(z + k,      _mm_add_ps(r0, sum15), _mm_add_ps(i0, sum26));
+		storeComplexSSE2(z + o1 + k, _mm_add_ps(r1, diff26), _mm_add_ps(i1, diff51));
+		storeComplexSSE2(z + o2 + k, _mm_sub_ps(r0, sum15), _mm_sub_ps(i0, sum26));
+		storeComplexSSE2(z + o3 + k, _mm_sub_ps(r1, diff26), _mm_sub_ps(i1, diff51));
+	}
+}
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_NEON
+
+/* z[0...8n-1], w[1...2n-1], n >= 2 */
+static void passNEON(Complex *z, const float *wre, unsigned int n) {
+	const int o1 = 2 * n;
+	const int o2 = 4 * n;
+	const int o3 = 6 * n;
+	const float *wim = wre + o1;
+
+	// Element 0 is not multiplied at all (TRANSFORM_ZERO), which is not the
+	// same as multiplying by 1 and 0 for signed zeros, so its inputs are
+	// blended in unchanged.
+	const uint32x4_t first = vsetq_lane_u32(0xFFFFFFFF, vdupq_n_u32(0), 0);
+
+	for (int k = 0; k < o1; k += 4) {
+		// The structure loads split the real and imaginary parts
+		const float32x4x2_t a0 = vld2q_f32(&z[k].re);
+		const float32x4x2_t a1 = vld2q_f32(&z[o1 + k].re);
+		const float32x4x2_t a2 = vld2q_f32(&z[o2 + k].re);
+		const float32x4x2_t a3 = vld2q_f32(&z[o3 + k].re);
+
+		// wim[-k], wim[-k - 1], wim[-k - 2], wim[-k - 3]
+		const float32x4_t wr = vld1q_f32(wre + k);
+		float32x4_t wi = vrev64q_f32(vld1q_f32(wim - k - 3));
+		wi = vcombine_f32(vget_high_f32(wi), vget_low_f32(wi));
+
+		float32x4_t v1 = vaddq_f32(vmulq_f32(a2.val[0], wr), vmulq_f32(a2.val[1], wi));
+		float32x4_t v2 = vsubq_f32(vmulq_f32(a2.val[1], wr), vmulq_f32(a2.val[0], wi));
+		float32x4_t v5 = vsubq_f32(vmulq_f32(a3.val[0], wr), vmulq_f32(a3.val[1], wi));
+		float32x4_t v6 = vaddq_f32(vmulq_f32(a3.val[1], wr), vmulq_f32(a3.val[0], wi));
+		if (k == 0) {
+			v1 = vbslq_f32(first, a2.val[0], v1);
+			v2 = vbslq_f32(first, a2.val[1], v2);
+			v5 = vbslq_f32(first, a3.val[0], v5);
+			v6 = vbslq_f32(first, a3.val[1], v6);
+		}
+
+		const float32x4_t sum15 = vaddq_f32(v5, v1), diff51 = vsubq_f32(v5, v1);
+		const float32x4_t sum26 = vaddq_f32(v2, v6), diff26 = vsubq_f32(v2, v6);
+
+		float32x4x2_t out;
+		out.val[0] = vaddq_f32(a0.val[0], sum15);
+		out.val[1] = vaddq_f32(a0.val[1], sum26);
+		vst2q_f32(&z[k].re, out);
+		out.val[0] = vaddq_f32(a1.val[0], diff26);
+		out.val[1] = vaddq_f32(a1.val[1], diff51);
+		vst2q_f32(&z[o1 + k].re, out);
+		out.val[0] = vsubq_f32(a0.val[0], sum15);
+		out.val[1] = vsubq_f32(a0.val[1], sum26);
+		vst2q_f32(&z[o2 + k].re, out);
+		out.val[0] = vsubq_f32(a1.val[0], diff26);
+		out.val[1] = vsubq_f32(a1.val[1], diff51);
+		vst2q_f32(&z[o3 + k].re, out);
+	}
+}
+
+#endif // SCUMMVM_NEON
+
+void FFT::init(FFTImpl impl) {
+	assert((_bits >= 2) && (_bits <= 16));
+	assert(hasFFTImpl(impl));
+
+	int n = 1 << _bits;
+
+	_tmpBuf = new Complex[n];
+	_expTab = new Complex[n / 2];
+	_revTab = new uint16[n];
+
+	_splitRadix = 1;
+
+	for (int i = 0; i < n; i++)
+		_revTab[-splitRadixPermutation(i, n, _inverse) & (n - 1)] = i;
+
+	// The tables are shared and outlive the CosineTable objects
+	for (int i = 0; i < ARRAYSIZE(_cosTables); i++) {
+		if (i+4 <= _bits)
+			_cosTables[i] = Common::CosineTable(i+4).getTable();
+		else
+			_cosTables[i] = 0;
+	}
+
+	switch (impl) {
+#ifdef SCUMMVM_SSE2
+	case kFFTSSE2:
+		_pass = _passBig = &passSSE2;
+		break;
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kFFTNEON:
+		_pass = _passBig = &passNEON;
+		break;
+#endif
+
+	default:
+		_pass = &pass;
+		_passBig = &pass_big;
+		break;
+	}
+}
+
 void FFT::fft4(Complex *z) {
 	float t1, t2, t3, t4, t5, t6, t7, t8;
 
@@ -210,7 +406,7 @@ void FFT::fft16(Complex *z) {
 	fft4(z + 12);
 
 	assert(_cosTables[0]);
-	const float * const cosTable = _cosTables[0]->getTable();
+	const float * const cosTable = _cosTables[0];
 
 	TRANSFORM_ZERO(z[0], z[4], z[8], z[12]);
 	TRANSFORM(z[2], z[6], z[10], z[14], sqrthalf, sqrthalf);
@@ -235,9 +431,9 @@ void FFT::fft(int n, int logn, Complex *z) {
 		fft((n / 4), logn - 2, z + (n / 4) * 3);
 		assert(_cosTables[logn - 4]);
 		if (n > 1024)
-			pass_big(z, _cosTables[logn - 4]->getTable(), (n / 4) / 2);
+			_passBig(z, _cosTables[logn - 4], (n / 4) / 2);
 		else
-			pass(z, _cosTables[logn - 4]->getTable(), (n / 4) / 2);
+			_pass(z, _cosTables[logn - 4], (n / 4) / 2);
 	}
 }
 
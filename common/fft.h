@@ -34,7 +34,24 @@
 
 namespace Common {
 
-class CosineTable;
+/**
+ * The implementations of the radix-4 passes of the FFT. The vectorized
+ * versions do the same operations in the same order as the scalar one,
+ * but on four elements at once.
+ */
+enum FFTImpl {
+	kFFTScalar,
+	kFFTSSE2,
+	kFFTNEON,
+
+	kFFTImplCount
+};
+
+/**
+ * Return whether the given implementation is available on this build and
+ * CPU. kFFTScalar is always available.
+ */
+bool hasFFTImpl(FFTImpl impl);
 
 /**
  * (Inverse) Fast Fourier Transform.
@@ -44,7 +61,10 @@ class CosineTable;
  */
 class FFT {
 public:
+	/** Create a transform using the fastest implementation available. */
 	FFT(int bits, int inverse);
+	/** Create a transform using a specific implementation, which must be available. */
+	FFT(int bits, int inverse, FFTImpl impl);
 	~FFT();
 
 	/** Do the permutation needed BEFORE calling calc(). */
@@ -71,7 +91,13 @@ private:
 
 	static int splitRadixPermutation(int i, int n, int inverse);
 
-	CosineTable *_cosTables[13];
+	const float *_cosTables[13];
+
+	typedef void (*PassProc)(Complex *z, const float *wre, unsigned int n);
+	PassProc _pass;
+	PassProc _passBig;
+
+	void init(FFTImpl impl);
 
 	void fft4(Complex *z);
 	void fft8(Complex *z);
@@ -124,6 +124,10 @@ bool FSNode::isWritable() const {
 	return _realNode && _realNode->isWritable();
 }
 
+bool FSNode::getFileStamp(uint32 &size, uint32 &modificationTime) const {
+	return _realNode && _realNode->getFileStamp(size, modificationTime);
+}
+
 SeekableReadStream *FSNode::createReadStream() const {
 	if (_realNode == 0)
 		return 0;
@@ -205,6 +205,18 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Returns the size and the modification time of the object referred by
+	 * this node. Both may be compared with the values of a previous call to
+	 * tell whether the file has changed, without reading it.
+	 *
+	 * @param size	the size of the file in bytes
+	 * @param modificationTime	the modification time, in seconds in an arbitrary epoch
+	 * @return true if the information is available, false if the node does
+	 *         not exist or the backend cannot provide it.
+	 */
+	bool getFileStamp(uint32 &size, uint32 &modificationTime) const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
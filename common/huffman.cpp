@@ -25,7 +25,6 @@
 #include "common/huffman.h"
 #include "common/util.h"
 #include "common/textconsole.h"
-#include "common/bitstream.h"
 
 namespace Common {
 
@@ -45,6 +44,9 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 
 	assert(maxLength <= 32);
 
+	_maxLength = maxLength;
+	_tableBits = MIN<uint8>(maxLength, kMaxTableBits);
+
 	_codes.resize(maxLength);
 	_symbols.resize(codeCount);
 
@@ -58,6 +60,8 @@ Huffman::Huffman(uint8 maxLength, uint32 codeCount, const uint32 *codes, const u
 		// And put the pointer to the symbol/code struct into the symbol list.
 		_symbols[i] = &_codes[lengths[i] - 1].back();
 	}
+
+	buildTables();
 }
 
 Huffman::~Huffman() {
@@ -66,21 +70,84 @@ Huffman::~Huffman() {
 void Huffman::setSymbols(const uint32 *symbols) {
 	for (uint32 i = 0; i < _symbols.size(); i++)
 		_symbols[i]->symbol = symbols ? *symbols++ : i;
+
+	buildTables();
 }
 
-uint32 Huffman::getSymbol(BitStream &bits) const {
-	uint32 code = 0;
+/** Return the lowest n bits of value. */
+static inline uint32 lowBits(uint32 value, uint8 n) {
+	return (n >= 32) ? value : (value & ((1u << n) - 1));
+}
 
-	for (uint32 i = 0; i < _codes.size(); i++) {
-		bits.addBit(code, i);
+void Huffman::buildTables() {
+	for (int i = 0; i < 2; i++) {
+		_tables[i].clear();
+		_tables[i].resize(1 << _tableBits);
 
-		for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
-			if (code == cCode->code)
-				return cCode->symbol;
+		buildTable(_tables[i], i == kMSB2LSB, 0, _tableBits, 0, 0);
 	}
+}
 
-	error("Unknown Huffman code");
-	return 0;
+void Huffman::buildTable(PrefixTable &table, bool msb2lsb, uint32 offset, uint8 tableBits, uint32 prefix, uint8 prefixLength) {
+	const uint32 tableSize = 1 << tableBits;
+
+	// Length of the longest code continuing in each sub-table, after this table's bits
+	Array<uint8> subTableLengths;
+	subTableLengths.resize(tableSize);
+
+	for (uint32 length = prefixLength + 1; length <= _codes.size(); length++) {
+		const uint8 restLength = length - prefixLength;
+
+		for (CodeList::const_iterator cCode = _codes[length - 1].begin(); cCode != _codes[length - 1].end(); ++cCode) {
+			// Only look at the codes starting with the prefix, and take the rest of their bits
+			uint32 rest;
+			if (msb2lsb) {
+				if (prefixLength > 0 && (cCode->code >> restLength) != prefix)
+					continue;
+
+				rest = lowBits(cCode->code, restLength);
+			} else {
+				if (lowBits(cCode->code, prefixLength) != prefix)
+					continue;
+
+				rest = cCode->code >> prefixLength;
+			}
+
+			if (restLength > tableBits) {
+				const uint32 index = msb2lsb ? (rest >> (restLength - tableBits)) : lowBits(rest, tableBits);
+				subTableLengths[index] = MAX<uint8>(subTableLengths[index], restLength - tableBits);
+				continue;
+			}
+
+			// The code fills all entries whose remaining index bits differ
+			const uint32 fill = 1 << (tableBits - restLength);
+			for (uint32 i = 0; i < fill; i++) {
+				const uint32 index = msb2lsb ? ((rest << (tableBits - restLength)) | i) : (rest | (i << restLength));
+
+				PrefixEntry &entry = table[offset + index];
+				entry.value        = cCode->symbol;
+				entry.length       = restLength;
+				entry.subTableBits = 0;
+			}
+		}
+	}
+
+	for (uint32 index = 0; index < tableSize; index++) {
+		if (subTableLengths[index] == 0)
+			continue;
+
+		const uint8 subTableBits = MIN<uint8>(subTableLengths[index], kMaxTableBits);
+		const uint32 subOffset = table.size();
+		table.resize(subOffset + (1 << subTableBits));
+
+		PrefixEntry &entry = table[offset + index];
+		entry.value        = subOffset - offset;
+		entry.length       = 0;
+		entry.subTableBits = subTableBits;
+
+		const uint32 subPrefix = msb2lsb ? ((prefix << tableBits) | index) : (prefix | (index << prefixLength));
+		buildTable(table, msb2lsb, subOffset, subTableBits, subPrefix, prefixLength + tableBits);
+	}
 }
 
 } // End of namespace Common
@@ -27,15 +27,18 @@
 
 #include "common/array.h"
 #include "common/list.h"
+#include "common/textconsole.h"
 #include "common/types.h"
 
 namespace Common {
 
-class BitStream;
-
 /**
  * Huffman bitstream decoding
  *
+ * Symbols are decoded with lookup tables indexed by the next bits in the
+ * stream, so that most codes take a single lookup. Codes longer than a
+ * table's index continue in sub-tables.
+ *
  * Used in engines:
  *  - scumm
  */
@@ -55,10 +58,51 @@ public:
 	/** Modify the codes' symbols. */
 	void setSymbols(const uint32 *symbols = 0);
 
-	/** Return the next symbol in the bitstream. */
-	uint32 getSymbol(BitStream &bits) const;
+	/**
+	 * Return the next symbol in the bitstream.
+	 *
+	 * This works with any bit stream class providing the BitStream
+	 * methods, i.e. both with a BitStream and with the non-virtual
+	 * BitStreamReaders.
+	 */
+	template<class BITSTREAM>
+	uint32 getSymbol(BITSTREAM &bits) const {
+		// Near the end of the stream, the table lookups could read past it
+		if (bits.size() - bits.pos() < _maxLength)
+			return getSymbolLinear(bits);
+
+		const PrefixEntry *table = bits.isMSB2LSB() ? _tables[kMSB2LSB].begin() : _tables[kLSB2MSB].begin();
+		uint8 tableBits = _tableBits;
+
+		while (true) {
+			const PrefixEntry &entry = table[bits.peekBits(tableBits)];
+
+			if (entry.subTableBits == 0) {
+				if (entry.length == 0)
+					break;
+
+				bits.skip(entry.length);
+				return entry.value;
+			}
+
+			bits.skip(tableBits);
+			table += entry.value;
+			tableBits = entry.subTableBits;
+		}
+
+		error("Unknown Huffman code");
+		return 0;
+	}
 
 private:
+	enum {
+		kMSB2LSB = 0,
+		kLSB2MSB = 1,
+
+		/** Maximum number of index bits of a (sub-)table. */
+		kMaxTableBits = 9
+	};
+
 	struct Symbol {
 		uint32 code;
 		uint32 symbol;
@@ -70,11 +114,64 @@ private:
 	typedef Array<CodeList> CodeLists;
 	typedef Array<Symbol *> SymbolList;
 
+	/**
+	 * An entry of a lookup table. It's either a code, which means the
+	 * entry holds the symbol and the number of its bits indexing this
+	 * table, or a link to a sub-table for longer codes. Entries with
+	 * neither don't belong to any code.
+	 */
+	struct PrefixEntry {
+		uint32 value;        ///< The symbol, or the offset of the sub-table from this table.
+		uint8  length;       ///< Bits of the code indexing this table, 0 for sub-table links.
+		uint8  subTableBits; ///< Index bits of the sub-table, 0 for codes.
+	};
+
+	typedef Array<PrefixEntry> PrefixTable;
+
+	/** Maximal code length. */
+	uint8 _maxLength;
+
+	/** Index bits of the first table. */
+	uint8 _tableBits;
+
 	/** Lists of codes and their symbols, sorted by code length. */
 	CodeLists _codes;
 
 	/** Sorted list of pointers to the symbols. */
 	SymbolList _symbols;
+
+	/**
+	 * The lookup tables, with all sub-tables appended, for both bit
+	 * orders. The codes read differently in each: with MSB2LSB, the first
+	 * bit of a code is its highest one, otherwise its lowest one.
+	 */
+	PrefixTable _tables[2];
+
+	/** (Re)build the lookup tables. */
+	void buildTables();
+
+	/**
+	 * Fill the table at offset with all codes starting with prefix, which
+	 * is prefixLength bits long.
+	 */
+	void buildTable(PrefixTable &table, bool msb2lsb, uint32 offset, uint8 tableBits, uint32 prefix, uint8 prefixLength);
+
+	/** Return the next symbol, reading the code bit by bit. */
+	template<class BITSTREAM>
+	uint32 getSymbolLinear(BITSTREAM &bits) const {
+		uint32 code = 0;
+
+		for (uint32 i = 0; i < _codes.size(); i++) {
+			bits.addBit(code, i);
+
+			for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
+				if (code == cCode->code)
+					return cCode->symbol;
+		}
+
+		error("Unknown Huffman code");
+		return 0;
+	}
 };
 
 } // End of namespace Common
@@ -22,31 +22,40 @@
 
 // Based on eos' sine tables
 
+#include "common/atomic.h"
 #include "common/scummsys.h"
 #include "common/sinetables.h"
 
 namespace Common {
 
+// Indexed by the bit precision. Tables may be created by decoders on
+// several threads at once, so they are published atomically.
+static float *volatile s_sineTables[17];
+
 SineTable::SineTable(int bitPrecision) {
 	assert((bitPrecision >= 4) && (bitPrecision <= 16));
 
 	_bitPrecision = bitPrecision;
 
-	int m = 1 << _bitPrecision;
-	double freq = 2 * M_PI / m;
-	_table = new float[m];
+	if (!atomicLoad(&s_sineTables[bitPrecision])) {
+		int m = 1 << _bitPrecision;
+		double freq = 2 * M_PI / m;
+		float *table = new float[m / 2];
 
-	// Table contains sin(2*pi*x/n) for 0<=x<=n/4, 
-	// followed by its reverse
-	for (int i = 0; i <= m / 4; i++)
-		_table[i] = sin(i * freq);
+		// Table contains sin(2*pi*x/n) for 0<=x<=n/4,
+		// followed by its reverse
+		for (int i = 0; i <= m / 4; i++)
+			table[i] = sin(i * freq);
 
-	for (int i = 1; i < m / 4; i++)
-		_table[m / 2 - i] = _table[i];
-}
+		for (int i = 1; i < m / 4; i++)
+			table[m / 2 - i] = table[i];
+
+		// Keep the table of another thread which got there first
+		if (!atomicCompareAndSwap(&s_sineTables[bitPrecision], (float *)0, table))
+			delete[] table;
+	}
 
-SineTable::~SineTable() {
-	delete[] _table;
+	_table = atomicLoad(&s_sineTables[bitPrecision]);
 }
 
 } // End of namespace Common
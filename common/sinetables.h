@@ -30,23 +30,28 @@ public:
 	/**
 	 * Construct a sine table with the specified bit precision
 	 *
+	 * The values only depend on the precision, so each table is computed
+	 * once, on first use, and then shared by all SineTables of that precision.
+	 * The pointer returned by getTable() stays valid until the program
+	 * exits, even after this object is destroyed. Tables may be constructed
+	 * on several threads at once.
+	 *
 	 * @param bitPrecision Precision of the table, which must be in range [4, 16]
 	 */
 	SineTable(int bitPrecision);
-	~SineTable();
 
 	/**
 	 * Get pointer to table
 	 */
-	const float *getTable() { return _table; }
+	const float *getTable() const { return _table; }
 
 	/**
 	 * Get pointer to table
 	 */
-	int getPrecision() { return _bitPrecision; }
+	int getPrecision() const { return _bitPrecision; }
 
 private:
-	float *_table;
+	const float *_table;
 	int _bitPrecision;
 };
 
@@ -29,6 +29,7 @@
 #include "common/str.h"
 #include "common/taskbar.h"
 #include "common/updates.h"
+#include "common/workerpool.h"
 #include "common/textconsole.h"
 
 #include "backends/audiocd/default/default-audiocd.h"
@@ -42,6 +43,7 @@ OSystem::OSystem() {
 	_eventManager = 0;
 	_timerManager = 0;
 	_savefileManager = 0;
+	_workerPool = 0;
 #if defined(USE_TASKBAR)
 	_taskbarManager = 0;
 #endif
@@ -55,6 +57,12 @@ OSystem::~OSystem() {
 	delete _audiocdManager;
 	_audiocdManager = 0;
 
+	// Streams played by the audio CD emulation and the mixer queue jobs on
+	// the worker pool, so it goes after them. Backends delete their mixer
+	// before this destructor runs.
+	delete _workerPool;
+	_workerPool = 0;
+
 	delete _eventManager;
 	_eventManager = 0;
 
@@ -50,6 +50,7 @@ class UpdateManager;
 #endif
 class TimerManager;
 class SeekableReadStream;
+class WorkerPool;
 class WriteStream;
 #ifdef ENABLE_KEYMAPPER
 class HardwareInputSet;
@@ -159,6 +160,14 @@ protected:
 	 */
 	Common::SaveFileManager *_savefileManager;
 
+	/**
+	 * No default value is provided for _workerPool by OSystem. Backends
+	 * without thread support leave it unset.
+	 *
+	 * @note _workerPool is deleted by the OSystem destructor.
+	 */
+	Common::WorkerPool *_workerPool;
+
 #if defined(USE_TASKBAR)
 	/**
 	 * No default value is provided for _taskbarManager by OSystem.
@@ -936,6 +945,15 @@ public:
 		return _eventManager;
 	}
 
+	/**
+	 * Return the worker pool for running jobs in parallel, or 0 if the
+	 * backend does not provide one. For more information, refer to the
+	 * WorkerPool documentation.
+	 */
+	inline Common::WorkerPool *getWorkerPool() {
+		return _workerPool;
+	}
+
 #ifdef ENABLE_KEYMAPPER
 	/**
 	 * Register hardware inputs with keymapper
@@ -104,7 +104,11 @@ typedef struct {
 
 #include "common/fs.h"
 #include "common/unzip.h"
-#include "common/memstream.h"
+#include "common/bufferedstream.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/textconsole.h"
+#include "common/zlib.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -272,6 +276,15 @@ int unzOpenCurrentFile(unzFile file);
   If there is no error, the return value is UNZ_OK.
 */
 
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file);
+/*
+  Open a stream for reading data from the current file in the zipfile.
+  Unlike unzOpenCurrentFile, the data is decompressed on demand while
+  the stream is read, and several streams can be used at the same time.
+  The streams keep the zipfile data alive, so they may outlive the unzFile.
+  If there is an error, the return value is NULL.
+*/
+
 int unzCloseCurrentFile(unzFile file);
 /*
   Close the file in zip opened with unzOpenCurrentFile
@@ -379,6 +392,7 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _sharedStream;	/* owner of _stream, shared with the member streams */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -540,6 +554,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 
 	int err=UNZ_OK;
 
+	us->_sharedStream = Common::SharedPtr<Common::SeekableReadStream>(stream);
 	us->_stream = stream;
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
@@ -592,7 +607,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -641,7 +655,6 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
 	delete s;
 	return UNZ_OK;
 }
@@ -1122,6 +1135,109 @@ int unzOpenCurrentFile (unzFile file) {
 }
 
 
+/*
+  A SafeSeekableSubReadStream which keeps the zipfile stream alive for as
+  long as it is in use.
+*/
+class ZipMemberSubReadStream : public Common::SafeSeekableSubReadStream {
+	Common::SharedPtr<Common::SeekableReadStream> _zipStream;
+
+public:
+	ZipMemberSubReadStream(const Common::SharedPtr<Common::SeekableReadStream> &zipStream, uint32 begin, uint32 end)
+		: Common::SafeSeekableSubReadStream(zipStream.get(), begin, end), _zipStream(zipStream) {
+	}
+};
+
+#ifdef USE_ZLIB
+/*
+  Checks the CRC-32 of a member while it is being read. The data read from
+  the start of the member on is checksummed, also across seeks, as long as
+  no part of it is skipped; once the end is reached that way, a mismatch is
+  reported through err().
+*/
+class ZipMemberCrcReadStream : public Common::SeekableReadStream {
+	Common::ScopedPtr<Common::SeekableReadStream> _parentStream;
+	uLong _expectedCrc;
+	uLong _crc;
+	uint32 _crcPos;     /* number of bytes checksummed so far */
+	bool _crcMismatch;
+
+public:
+	ZipMemberCrcReadStream(Common::SeekableReadStream *parentStream, uLong expectedCrc)
+		: _parentStream(parentStream), _expectedCrc(expectedCrc), _crc(crc32(0, Z_NULL, 0)), _crcPos(0), _crcMismatch(false) {
+	}
+
+	bool err() const { return _crcMismatch || _parentStream->err(); }
+	void clearErr() { _parentStream->clearErr(); }
+	bool eos() const { return _parentStream->eos(); }
+
+	int32 pos() const { return _parentStream->pos(); }
+	int32 size() const { return _parentStream->size(); }
+	bool seek(int32 offset, int whence = SEEK_SET) { return _parentStream->seek(offset, whence); }
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		const uint32 start = _parentStream->pos();
+		const uint32 len = _parentStream->read(dataPtr, dataSize);
+
+		if (start <= _crcPos && _crcPos < start + len) {
+			const uint32 skip = _crcPos - start;
+			_crc = crc32(_crc, (const Bytef *)dataPtr + skip, len - skip);
+			_crcPos = start + len;
+
+			if (_crcPos == (uint32)_parentStream->size() && _crc != _expectedCrc) {
+				warning("CRC mismatch in zip archive member");
+				_crcMismatch = true;
+			}
+		}
+
+		return len;
+	}
+};
+#endif
+
+Common::SeekableReadStream *unzOpenCurrentFileStream(unzFile file) {
+	unz_s* s;
+	uInt iSizeVar;
+	uLong offset_local_extrafield;  /* offset of the local extra field */
+	uInt  size_local_extrafield;    /* size of the local extra field */
+
+	if (file==NULL)
+		return NULL;
+	s=(unz_s*)file;
+	if (!s->current_file_ok)
+		return NULL;
+
+	if (unzlocal_CheckCurrentFileCoherencyHeader(s,&iSizeVar,
+				&offset_local_extrafield,&size_local_extrafield)!=UNZ_OK)
+		return NULL;
+
+	const uLong pos_in_zipfile = s->cur_file_info_internal.offset_curfile +
+		SIZEZIPLOCALHEADER + iSizeVar + s->byte_before_the_zipfile;
+
+	Common::SeekableReadStream *member = new ZipMemberSubReadStream(s->_sharedStream,
+		pos_in_zipfile, pos_in_zipfile + s->cur_file_info.compressed_size);
+
+	Common::SeekableReadStream *stream = NULL;
+	if (s->cur_file_info.compression_method == 0) {
+		// Stored data can be read directly; the buffering saves us
+		// from seeking the zipfile for every small read
+		stream = Common::wrapBufferedSeekableReadStream(member, 4096, DisposeAfterUse::YES);
+	} else if (s->cur_file_info.compression_method == Z_DEFLATED) {
+		// Returns NULL (and deletes member) when built without zlib
+		stream = Common::wrapInflateReadStream(member, s->cur_file_info.uncompressed_size);
+	} else {
+		delete member;
+	}
+
+#ifdef USE_ZLIB
+	// Only verify the CRC when zlib is linked in, like unzCloseCurrentFile()
+	if (stream)
+		stream = new ZipMemberCrcReadStream(stream, s->cur_file_info.crc);
+#endif
+	return stream;
+}
+
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -1492,32 +1608,7 @@ SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) co
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
-	unz_file_info fileInfo;
-	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
-		return 0;
-
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
-		return 0;
-
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
-
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
-		return 0;
-	}
-
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
-		return 0;
-	}
-
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
-
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+	return unzOpenCurrentFileStream(_zipFile);
 }
 
 Archive *makeZipArchive(const String &name) {
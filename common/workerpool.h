@@ -0,0 +1,109 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_WORKERPOOL_H
+#define COMMON_WORKERPOOL_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+
+namespace Common {
+
+/**
+ * A pool of threads which run small, independent jobs in parallel, e.g.
+ * the slices of a video frame. Backends which support threads provide one
+ * through OSystem::getWorkerPool(); see JobGroup for how to use it.
+ *
+ * Jobs must not call error() and must not use any part of OSystem, since
+ * they may run on any thread. As an exception, jobs may use the file system
+ * through Common::FSNode: list directories, open files with
+ * FSNode::createReadStream() and read from the streams. Backends which
+ * provide a worker pool must make sure their FS nodes support this, as long
+ * as each node and stream is only used by one thread at a time. Jobs may
+ * also call OSystem::getMillis() and use the mixer, which timer callbacks
+ * do as well.
+ */
+class WorkerPool : NonCopyable {
+public:
+	typedef void (*JobProc)(void *param);
+
+	/**
+	 * Run the jobs which are still queued, then stop the threads. Jobs may
+	 * thus free data they own when done, even at shutdown.
+	 */
+	virtual ~WorkerPool() {}
+
+	/**
+	 * Return the number of threads running jobs, not counting the thread
+	 * which waits for them.
+	 */
+	virtual uint getThreadCount() const = 0;
+
+	/**
+	 * Queue a job. The pool increments *pending right away and decrements
+	 * it again once proc(param) has returned.
+	 *
+	 * This may take a lock, which the pool only holds to update its queue,
+	 * never while a job runs.
+	 */
+	virtual void addJob(JobProc proc, void *param, int32 *pending) = 0;
+
+	/**
+	 * Wait until *pending drops to zero. Queued jobs counted by *pending
+	 * are run on the calling thread while waiting; other jobs are not, so
+	 * this never runs unrelated jobs in the middle of the caller's work.
+	 * Jobs may wait for jobs of their own this way.
+	 */
+	virtual void waitForJobs(const int32 *pending) = 0;
+};
+
+/**
+ * A set of jobs which are waited for together. Without a worker pool, the
+ * jobs are run right away when they are added.
+ */
+class JobGroup : NonCopyable {
+public:
+	explicit JobGroup(WorkerPool *pool) : _pool(pool), _pending(0) {}
+	~JobGroup() { wait(); }
+
+	/** Run proc(param) on the pool, or right away if there is none. */
+	void add(WorkerPool::JobProc proc, void *param) {
+		if (_pool)
+			_pool->addJob(proc, param, &_pending);
+		else
+			proc(param);
+	}
+
+	/** Wait for all jobs added so far. */
+	void wait() {
+		if (_pool)
+			_pool->waitForJobs(&_pending);
+	}
+
+private:
+	WorkerPool *_pool;
+	int32 _pending;
+};
+
+} // End of namespace Common
+
+#endif
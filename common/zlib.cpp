@@ -24,6 +24,7 @@
 #define FORBIDDEN_SYMBOL_ALLOW_ALL
 
 #include "common/zlib.h"
+#include "common/array.h"
 #include "common/ptr.h"
 #include "common/util.h"
 #include "common/stream.h"
@@ -88,12 +89,33 @@ bool inflateZlibHeaderless(byte *dst, uint dstLen, const byte *src, uint srcLen,
 /**
  * A simple wrapper class which can be used to wrap around an arbitrary
  * other SeekableReadStream and will then provide on-the-fly decompression support.
- * Assumes the compressed data to be in gzip format.
+ * Assumes the compressed data to be in gzip or zlib format, or to be raw
+ * deflate data (as used in ZIP archives) if a known size is passed.
+ *
+ * While decompressing, a copy of the inflate state is recorded every
+ * CHECKPOINT_INTERVAL bytes of output. Seeking then only has to restart
+ * decompression from the nearest checkpoint before the target position,
+ * instead of from the start of the stream. At most MAX_CHECKPOINTS are kept:
+ * once they are all used, every other one is dropped and the interval
+ * doubles, so the memory used stays bounded however long the stream is.
  */
 class GZipReadStream : public SeekableReadStream {
 protected:
 	enum {
-		BUFSIZE = 16384		// 1 << MAX_WBITS
+		BUFSIZE = 16384,		// 1 << MAX_WBITS
+		CHECKPOINT_INTERVAL = 256 * 1024,
+		MAX_CHECKPOINTS = 16	// about 40 KB each
+	};
+
+	/**
+	 * A point from which decompression can be resumed. Each checkpoint
+	 * holds a complete copy of the inflate state, including its 32 KB
+	 * window, so they should not be made too frequently.
+	 */
+	struct Checkpoint {
+		uint32 pos;			///< position in the decompressed data
+		int32 wrappedPos;	///< position of the next input byte in the wrapped stream
+		z_stream stream;
 	};
 
 	byte	_buf[BUFSIZE];
@@ -104,36 +126,114 @@ protected:
 	uint32 _pos;
 	uint32 _origSize;
 	bool _eos;
+	bool _rawDeflate;
+
+	/**
+	 * The checkpoints recorded so far, sorted by position. The n-th
+	 * checkpoint is at position (n + 1) * _checkpointInterval. They are
+	 * allocated separately because a z_stream must not be moved in memory.
+	 */
+	Array<Checkpoint *> _checkpoints;
+
+	/** Distance between checkpoints, CHECKPOINT_INTERVAL times a power of two. */
+	uint32 _checkpointInterval;
+
+	/** Cleared when a checkpoint cannot be recorded, e.g. for lack of memory. */
+	bool _checkpointing;
+
+	void addCheckpoint() {
+		Checkpoint *cp = new Checkpoint();
+		if (inflateCopy(&cp->stream, &_stream) != Z_OK) {
+			// Otherwise read() would stop at this position again and again
+			_checkpointing = false;
+			delete cp;
+			return;
+		}
+		cp->pos = _pos;
+		cp->wrappedPos = _wrapped->pos() - _stream.avail_in;
+		_checkpoints.push_back(cp);
+
+		if (_checkpoints.size() == MAX_CHECKPOINTS)
+			thinCheckpoints();
+	}
+
+	/**
+	 * Drop every other checkpoint and double the interval, keeping the ones
+	 * at the even multiples of the old interval.
+	 */
+	void thinCheckpoints() {
+		uint kept = 0;
+		for (uint i = 0; i < _checkpoints.size(); ++i) {
+			if (i % 2 == 1) {
+				_checkpoints[kept++] = _checkpoints[i];
+			} else {
+				inflateEnd(&_checkpoints[i]->stream);
+				delete _checkpoints[i];
+			}
+		}
+		_checkpoints.resize(kept);
+		_checkpointInterval *= 2;
+	}
+
+	bool restoreCheckpoint(Checkpoint *cp) {
+		inflateEnd(&_stream);
+		_zlibErr = inflateCopy(&_stream, &cp->stream);
+		if (_zlibErr != Z_OK)
+			return false;
+
+		_pos = cp->pos;
+		_wrapped->seek(cp->wrappedPos, SEEK_SET);
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+		return true;
+	}
+
+	uint32 nextCheckpointPos() const {
+		if (!_checkpointing)
+			return 0xFFFFFFFF;
+		return (_checkpoints.size() + 1) * _checkpointInterval;
+	}
 
 public:
 
-	GZipReadStream(SeekableReadStream *w) : _wrapped(w), _stream() {
+	GZipReadStream(SeekableReadStream *w, uint32 knownSize = 0, bool rawDeflate = false) : _wrapped(w), _stream(), _rawDeflate(rawDeflate), _checkpointInterval(CHECKPOINT_INTERVAL), _checkpointing(true) {
 		assert(w != 0);
 
-		// Verify file header is correct
-		w->seek(0, SEEK_SET);
-		uint16 header = w->readUint16BE();
-		assert(header == 0x1F8B ||
-		       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
-
-		if (header == 0x1F8B) {
-			// Retrieve the original file size
-			w->seek(-4, SEEK_END);
-			_origSize = w->readUint32LE();
+		if (_rawDeflate) {
+			// Raw deflate data has no header at all, so the size has to
+			// be known up front
+			_origSize = knownSize;
 		} else {
-			// Original size not available in zlib format
-			_origSize = 0;
+			// Verify file header is correct
+			w->seek(0, SEEK_SET);
+			uint16 header = w->readUint16BE();
+			assert(header == 0x1F8B ||
+			       ((header & 0x0F00) == 0x0800 && header % 31 == 0));
+
+			if (header == 0x1F8B) {
+				// Retrieve the original file size
+				w->seek(-4, SEEK_END);
+				_origSize = w->readUint32LE();
+			} else {
+				// Original size not available in zlib format
+				_origSize = knownSize;
+			}
 		}
 		_pos = 0;
 		w->seek(0, SEEK_SET);
 		_eos = false;
 
-		// Adding 32 to windowBits indicates to zlib that it is supposed to
-		// automatically detect whether gzip or zlib headers are used for
-		// the compressed file. This feature was added in zlib 1.2.0.4,
-		// released 10 August 2003.
-		// Note: This is *crucial* for savegame compatibility, do *not* remove!
-		_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		if (_rawDeflate) {
+			// Negative MAX_WBITS tells zlib there's no header
+			_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+		} else {
+			// Adding 32 to windowBits indicates to zlib that it is supposed to
+			// automatically detect whether gzip or zlib headers are used for
+			// the compressed file. This feature was added in zlib 1.2.0.4,
+			// released 10 August 2003.
+			// Note: This is *crucial* for savegame compatibility, do *not* remove!
+			_zlibErr = inflateInit2(&_stream, MAX_WBITS + 32);
+		}
 		if (_zlibErr != Z_OK)
 			return;
 
@@ -144,6 +244,11 @@ public:
 
 	~GZipReadStream() {
 		inflateEnd(&_stream);
+
+		for (uint i = 0; i < _checkpoints.size(); ++i) {
+			inflateEnd(&_checkpoints[i]->stream);
+			delete _checkpoints[i];
+		}
 	}
 
 	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
@@ -153,26 +258,45 @@ public:
 	}
 
 	uint32 read(void *dataPtr, uint32 dataSize) {
-		_stream.next_out = (byte *)dataPtr;
-		_stream.avail_out = dataSize;
-
-		// Keep going while we get no error
-		while (_zlibErr == Z_OK && _stream.avail_out) {
-			if (_stream.avail_in == 0 && !_wrapped->eos()) {
-				// If we are out of input data: Read more data, if available.
-				_stream.next_in = _buf;
-				_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
-			}
-			_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+		if (_rawDeflate && dataSize > _origSize - _pos) {
+			// Raw deflate streams do not necessarily signal their end, so
+			// do not try to read past the known size
+			dataSize = _origSize - _pos;
+			_eos = true;
 		}
 
-		// Update the position counter
-		_pos += dataSize - _stream.avail_out;
+		byte *dst = (byte *)dataPtr;
+		uint32 total = 0;
+
+		while (_zlibErr == Z_OK && total < dataSize) {
+			// Stop at the next checkpoint position, so it can be recorded
+			const uint32 chunk = MIN(dataSize - total, nextCheckpointPos() - _pos);
 
-		if (_zlibErr == Z_STREAM_END && _stream.avail_out > 0)
+			_stream.next_out = dst + total;
+			_stream.avail_out = chunk;
+
+			// Keep going while we get no error
+			while (_zlibErr == Z_OK && _stream.avail_out) {
+				if (_stream.avail_in == 0 && !_wrapped->eos()) {
+					// If we are out of input data: Read more data, if available.
+					_stream.next_in = _buf;
+					_stream.avail_in = _wrapped->read(_buf, BUFSIZE);
+				}
+				_zlibErr = inflate(&_stream, Z_NO_FLUSH);
+			}
+
+			// Update the position counter
+			_pos += chunk - _stream.avail_out;
+			total += chunk - _stream.avail_out;
+
+			if (_zlibErr == Z_OK && _pos == nextCheckpointPos())
+				addCheckpoint();
+		}
+
+		if (_zlibErr == Z_STREAM_END && total < dataSize)
 			_eos = true;
 
-		return dataSize - _stream.avail_out;
+		return total;
 	}
 
 	bool eos() const {
@@ -197,10 +321,18 @@ public:
 
 		assert(newPos >= 0);
 
-		if ((uint32)newPos < _pos) {
-			// To search backward, we have to restart the whole decompression
-			// from the start of the file. A rather wasteful operation, best
-			// to avoid it. :/
+		// Resume from the last checkpoint before the new position, if that
+		// is closer than the current position
+		Checkpoint *cp = 0;
+		for (uint i = 0; i < _checkpoints.size() && _checkpoints[i]->pos <= (uint32)newPos; ++i)
+			cp = _checkpoints[i];
+
+		if (cp && (cp->pos > _pos || (uint32)newPos < _pos)) {
+			if (!restoreCheckpoint(cp))
+				return false;	// FIXME: STREAM REWRITE
+		} else if ((uint32)newPos < _pos) {
+			// To search backward without a checkpoint, we have to restart
+			// the whole decompression from the start of the file.
 #if DEBUG
 			warning("Backward seeking in GZipReadStream detected");
 #endif
@@ -220,7 +352,11 @@ public:
 		// bytes, so this should be fine.
 		byte tmpBuf[1024];
 		while (!err() && offset > 0) {
-			offset -= read(tmpBuf, MIN((int32)sizeof(tmpBuf), offset));
+			// Raw deflate streams stop at their known size without an error
+			const uint32 skipped = read(tmpBuf, MIN((int32)sizeof(tmpBuf), offset));
+			if (skipped == 0)
+				break;
+			offset -= skipped;
 		}
 
 		_eos = false;
@@ -336,7 +472,7 @@ public:
 
 #endif	// USE_ZLIB
 
-SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped) {
+SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped) {
 		uint16 header = toBeWrapped->readUint16BE();
@@ -345,12 +481,22 @@ SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped) {
 				      header % 31 == 0));
 		toBeWrapped->seek(-2, SEEK_CUR);
 		if (isCompressed)
-			return new GZipReadStream(toBeWrapped);
+			return new GZipReadStream(toBeWrapped, knownSize);
 	}
 #endif
 	return toBeWrapped;
 }
 
+SeekableReadStream *wrapInflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize) {
+#if defined(USE_ZLIB)
+	if (toBeWrapped)
+		return new GZipReadStream(toBeWrapped, knownSize, true);
+#else
+	delete toBeWrapped;
+#endif
+	return 0;
+}
+
 WriteStream *wrapCompressedWriteStream(WriteStream *toBeWrapped) {
 #if defined(USE_ZLIB)
 	if (toBeWrapped)
@@ -88,8 +88,31 @@ bool inflateZlibHeaderless(byte *dst, uint dstLen, const byte *src, uint srcLen,
  *
  * It is safe to call this with a NULL parameter (in this case, NULL is
  * returned).
+ *
+ * @param toBeWrapped   the stream to be wrapped (if it is in gzip-format)
+ * @param knownSize     a supplied length of the uncompressed data (if known),
+ *                      used by size() for zlib-format data, which does not
+ *                      store it
+ */
+SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize = 0);
+
+/**
+ * Take an arbitrary SeekableReadStream holding raw deflate data, i.e. data
+ * compressed with deflate but *without* any zlib or gzip header (like the
+ * members of ZIP archives), and wrap it in a custom stream which provides
+ * transparent on-the-fly decompression.
+ *
+ * The wrapped stream is deleted together with the returned stream. If ZLIB
+ * support has been disabled, the wrapped stream is deleted and NULL is
+ * returned.
+ *
+ * It is safe to call this with a NULL parameter (in this case, NULL is
+ * returned).
+ *
+ * @param toBeWrapped   the stream holding the compressed data
+ * @param knownSize     the length of the uncompressed data
  */
-SeekableReadStream *wrapCompressedReadStream(SeekableReadStream *toBeWrapped);
+SeekableReadStream *wrapInflateReadStream(SeekableReadStream *toBeWrapped, uint32 knownSize);
 
 /**
  * Take an arbitrary WriteStream and wrap it in a custom stream which provides
@@ -0,0 +1,156 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Benchmark for Video::BinkDecoder.
+ *
+ * Decodes all frames of a Bink video as fast as possible, once without a
+ * worker pool and once for each given number of worker threads, and prints
+ * the frame rate and a checksum of the frames of each run. The checksums
+ * must match, since the pool may not change the output.
+ *
+ * Build with "make devtools/bench-bink" and run it as
+ * "bench-bink FILE [THREADS...]". Without thread counts, it uses one thread
+ * less than the number of CPUs, as the backends do.
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "audio/mixer_intern.h"
+#include "backends/workerpool/posix/posix-workerpool.h"
+#include "common/memstream.h"
+#include "graphics/surface.h"
+#include "video/bink_decoder.h"
+
+#include "test/testsystem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+/**
+ * OSystem providing a worker pool and a mixer, which is never mixed: the
+ * audio of the video is decoded, but only piles up in its queue.
+ */
+class BenchSystem : public TestSystem {
+public:
+	BenchSystem() {
+		// Common::Mutex goes through g_system, so set it before the mixer
+		g_system = this;
+		_mixer = new Audio::MixerImpl(this, 44100);
+		_mixer->setReady(true);
+	}
+
+	virtual ~BenchSystem() { delete _mixer; }
+
+	void setWorkerPool(Common::WorkerPool *pool) {
+		delete _workerPool;
+		_workerPool = pool;
+	}
+
+	virtual Audio::Mixer *getMixer() { return _mixer; }
+
+private:
+	Audio::MixerImpl *_mixer;
+};
+
+static double getSeconds() {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static bool run(const char *name, byte *data, uint32 size) {
+	// The decoder takes over the stream, so give it a copy of the file
+	byte *copy = (byte *)malloc(size);
+	memcpy(copy, data, size);
+
+	Video::BinkDecoder decoder;
+	if (!decoder.loadStream(new Common::MemoryReadStream(copy, size, DisposeAfterUse::YES), Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0)))
+		return false;
+
+	uint32 frames = 0;
+	uint32 checksum = 0;
+	const double start = getSeconds();
+	while (!decoder.endOfVideo()) {
+		const Graphics::Surface *surface = decoder.decodeNextFrame();
+		if (!surface)
+			break;
+
+		for (int y = 0; y < surface->h; y++) {
+			const byte *line = (const byte *)surface->getBasePtr(0, y);
+			for (int x = 0; x < surface->w * surface->format.bytesPerPixel; x++)
+				checksum = checksum * 31 + line[x];
+		}
+		frames++;
+	}
+	const double seconds = getSeconds() - start;
+
+	printf("  %-12s %5u frames in %7.3f s  %8.2f fps  (checksum %08x)\n", name, frames, seconds, frames / seconds, checksum);
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s FILE [THREADS...]\n", argv[0]);
+		return 1;
+	}
+
+	FILE *file = fopen(argv[1], "rb");
+	if (!file) {
+		fprintf(stderr, "Could not open %s\n", argv[1]);
+		return 1;
+	}
+	fseek(file, 0, SEEK_END);
+	const uint32 size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	byte *data = (byte *)malloc(size);
+	const bool read = fread(data, 1, size, file) == size;
+	fclose(file);
+	if (!read) {
+		fprintf(stderr, "Could not read %s\n", argv[1]);
+		free(data);
+		return 1;
+	}
+
+	BenchSystem system;
+
+	printf("%s:\n", argv[1]);
+	int status = 0;
+	if (!run("no pool", data, size)) {
+		fprintf(stderr, "Not a Bink video: %s\n", argv[1]);
+		status = 1;
+	} else {
+		const int runs = argc > 2 ? argc - 2 : 1;
+		for (int i = 0; i < runs; i++) {
+			const uint threads = argc > 2 ? atoi(argv[2 + i]) : PosixWorkerPool::getDefaultThreadCount();
+			system.setWorkerPool(new PosixWorkerPool(threads));
+
+			char name[32];
+			snprintf(name, sizeof(name), "%u threads", threads);
+			run(name, data, size);
+		}
+	}
+
+	free(data);
+	return status;
+}
@@ -0,0 +1,178 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Micro-benchmark for Common::Huffman.
+ *
+ * Decodes random data, which is a valid stream for any complete prefix
+ * code, with the table-driven decoder and with the former decoder, which
+ * read the codes bit by bit and searched them in a list per code length.
+ *
+ * Build with "make devtools/bench-huffman" and run it without arguments.
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/bitstream.h"
+#include "common/huffman.h"
+#include "common/list.h"
+#include "common/memstream.h"
+
+#include <stdio.h>
+#include <sys/time.h>
+
+/** The former Common::Huffman decoding. */
+class LinearHuffman {
+public:
+	LinearHuffman(uint32 codeCount, const uint32 *codes, const uint8 *lengths) {
+		uint8 maxLength = 0;
+		for (uint32 i = 0; i < codeCount; i++)
+			maxLength = MAX(maxLength, lengths[i]);
+
+		_codes.resize(maxLength);
+		for (uint32 i = 0; i < codeCount; i++)
+			_codes[lengths[i] - 1].push_back(Symbol(codes[i], i));
+	}
+
+	uint32 getSymbol(Common::BitStream &bits) const {
+		uint32 code = 0;
+
+		for (uint32 i = 0; i < _codes.size(); i++) {
+			bits.addBit(code, i);
+
+			for (CodeList::const_iterator cCode = _codes[i].begin(); cCode != _codes[i].end(); ++cCode)
+				if (code == cCode->code)
+					return cCode->symbol;
+		}
+
+		error("Unknown Huffman code");
+		return 0;
+	}
+
+private:
+	struct Symbol {
+		uint32 code;
+		uint32 symbol;
+
+		Symbol(uint32 c, uint32 s) : code(c), symbol(s) {}
+	};
+
+	typedef Common::List<Symbol> CodeList;
+	Common::Array<CodeList> _codes;
+};
+
+static uint32 s_seed = 1;
+
+static uint32 getRandom() {
+	s_seed = s_seed * 1103515245 + 12345;
+	return s_seed >> 16;
+}
+
+static double getSeconds() {
+	struct timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * Create a complete prefix code, read lowest bit first, by splitting
+ * random leaves of the code tree.
+ */
+static void createCode(uint32 codeCount, uint8 maxLength, Common::Array<uint32> &codes, Common::Array<uint8> &lengths) {
+	codes.push_back(0);
+	lengths.push_back(0);
+
+	while (codes.size() < codeCount) {
+		uint32 i = getRandom() % codes.size();
+		if (lengths[i] >= maxLength)
+			continue;
+
+		codes.push_back(codes[i] | (1 << lengths[i]));
+		lengths.push_back(lengths[i] + 1);
+		lengths[i]++;
+	}
+}
+
+template<class HUFFMAN, class BITSTREAM>
+static void run(const char *name, const HUFFMAN &huffman, BITSTREAM &bits, uint32 symbolCount) {
+	uint32 checksum = 0;
+
+	const double start = getSeconds();
+	for (uint32 i = 0; i < symbolCount; i++)
+		checksum = checksum * 31 + huffman.getSymbol(bits);
+	const double seconds = getSeconds() - start;
+
+	printf("  %-28s %8.2f Msymbols/s  (checksum %08x)\n", name, symbolCount / seconds / 1000000.0, checksum);
+}
+
+static void benchmark(uint32 codeCount, uint8 maxLength) {
+	Common::Array<uint32> codes;
+	Common::Array<uint8> lengths;
+	createCode(codeCount, maxLength, codes, lengths);
+
+	uint8 longest = 0;
+	for (uint32 i = 0; i < codeCount; i++)
+		longest = MAX(longest, lengths[i]);
+
+	const uint32 dataSize = 4 * 1024 * 1024;
+	byte *data = (byte *)malloc(dataSize);
+	for (uint32 i = 0; i < dataSize; i++)
+		data[i] = getRandom();
+
+	// Leave enough bits for the longest code at the end
+	const uint32 symbolCount = (dataSize * 8 - 32) / longest;
+
+	printf("%u codes, up to %u bits long, %u symbols:\n", codeCount, longest, symbolCount);
+
+	LinearHuffman linear(codeCount, codes.begin(), lengths.begin());
+	Common::Huffman table(0, codeCount, codes.begin(), lengths.begin());
+
+	{
+		Common::MemoryReadStream stream(data, dataSize);
+		Common::BitStream32LELSB bits(stream);
+		run("linear, BitStream", linear, bits, symbolCount);
+	}
+
+	{
+		Common::MemoryReadStream stream(data, dataSize);
+		Common::BitStream32LELSB bits(stream);
+		run("table, BitStream", table, bits, symbolCount);
+	}
+
+	{
+		Common::BitStreamMemory32LELSB bits(new Common::BitStreamMemoryStream(data, dataSize), true);
+		run("table, BitStreamMemory", table, bits, symbolCount);
+	}
+
+	free(data);
+}
+
+int main(int argc, char *argv[]) {
+	// Bink style: 16 symbols
+	benchmark(16, 8);
+	// Smacker/JPEG style: a byte per symbol
+	benchmark(256, 16);
+	// Many long codes
+	benchmark(1024, 24);
+
+	return 0;
+}
@@ -26,7 +26,7 @@ clean: clean-devtools
 devtools: $(DEVTOOLS)
 
 clean-devtools:
-	-$(RM) $(DEVTOOLS)
+	-$(RM) $(DEVTOOLS) devtools/bench-huffman$(EXEEXT) devtools/bench-bink$(EXEEXT)
 
 #
 # Build rules for the devtools
@@ -44,6 +44,15 @@ devtools/make-scumm-fontdata$(EXEEXT): $(srcdir)/devtools/make-scumm-fontdata.c
 	$(QUIET)$(MKDIR) devtools/$(DEPDIR)
 	$(QUIET_LINK)$(LD) $(CFLAGS) -Wall -o $@ $<
 
+# Not part of DEVTOOLS, since it needs the common code built for the host
+devtools/bench-huffman$(EXEEXT): $(srcdir)/devtools/bench-huffman.cpp common/libcommon.a
+	$(QUIET)$(MKDIR) devtools/$(DEPDIR)
+	$(QUIET_LINK)$(CXX) $(CXXFLAGS) $(CPPFLAGS) -o $@ $+ $(LIBS)
+
+devtools/bench-bink$(EXEEXT): $(srcdir)/devtools/bench-bink.cpp video/libvideo.a audio/libaudio.a graphics/libgraphics.a backends/libbackends.a common/libcommon.a
+	$(QUIET)$(MKDIR) devtools/$(DEPDIR)
+	$(QUIET_LINK)$(CXX) $(CXXFLAGS) $(CPPFLAGS) -o $@ $+ $(LIBS)
+
 #
 # Rules to explicitly rebuild the credits / MD5 tables.
 # The rules for the files in the "web" resp. "docs" modules
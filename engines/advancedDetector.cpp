@@ -23,15 +23,18 @@
 #include "common/debug.h"
 #include "common/util.h"
 #include "common/hash-str.h"
-#include "common/file.h"
 #include "common/macresman.h"
 #include "common/md5.h"
+#include "common/stream.h"
 #include "common/config-manager.h"
 #include "common/system.h"
 #include "common/textconsole.h"
 #include "common/translation.h"
 
+#include "common/workerpool.h"
+
 #include "engines/advancedDetector.h"
+#include "engines/detectioncache.h"
 #include "engines/obsolete.h"
 
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
@@ -315,6 +318,31 @@ struct SizeMD5 {
 
 typedef Common::HashMap<Common::String, SizeMD5, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> SizeMD5Map;
 
+/** A file whose size and MD5 aren't in the detection cache yet. */
+struct SizeMD5Job {
+	Common::String fname;
+	Common::FSNode node;
+	uint32 md5Bytes;
+	SizeMD5 result;
+};
+
+/**
+ * Compute the size and the MD5 of a file. This may run on a worker thread,
+ * so it must neither print debug messages nor use the OSystem.
+ */
+static void computeSizeMD5(void *param) {
+	SizeMD5Job *job = (SizeMD5Job *)param;
+
+	Common::SeekableReadStream *stream = job->node.createReadStream();
+	if (stream) {
+		job->result.size = (int32)stream->size();
+		job->result.md5 = Common::computeStreamMD5AsString(*stream, job->md5Bytes);
+		delete stream;
+	} else {
+		job->result.size = -1;
+	}
+}
+
 static void reportUnknown(const Common::FSNode &path, const SizeMD5Map &filesSizeMD5) {
 	// TODO: This message should be cleaned up / made more specific.
 	// For example, we should specify at least which engine triggered this.
@@ -382,6 +410,9 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 	const ADGameDescription *g;
 	const byte *descPtr;
 
+	// The files which need to be read, in the order they were found
+	Common::Array<SizeMD5Job> jobs;
+
 	debug(3, "Starting detection in dir '%s'", parent.getPath().c_str());
 
 	// Check which files are included in some ADGameDescription *and* are present.
@@ -412,22 +443,47 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 				if (allFiles.contains(fname)) {
 					debug(3, "+ %s", fname.c_str());
 
-					Common::File testFile;
+					const Common::FSNode &node = allFiles[fname];
 
-					if (testFile.open(allFiles[fname])) {
-						tmp.size = (int32)testFile.size();
-						tmp.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
-					} else {
+					if (node.isDirectory()) {
 						tmp.size = -1;
+						filesSizeMD5[fname] = tmp;
+					} else if (DetectionCache::instance().lookupMD5(node, _md5Bytes, tmp.size, tmp.md5)) {
+						debug(3, "> '%s': '%s' (cached)", fname.c_str(), tmp.md5.c_str());
+						filesSizeMD5[fname] = tmp;
+					} else {
+						// Mark the file as seen; the size and MD5 are filled in below
+						filesSizeMD5[fname] = tmp;
+
+						SizeMD5Job job;
+						job.fname = fname;
+						job.node = node;
+						job.md5Bytes = _md5Bytes;
+						jobs.push_back(job);
 					}
-
-					debug(3, "> '%s': '%s'", fname.c_str(), tmp.md5.c_str());
-					filesSizeMD5[fname] = tmp;
 				}
 			}
 		}
 	}
 
+	// The remaining files are independent of each other, so read them in
+	// parallel; on slow (e.g. network) storage, this hides the latencies.
+	if (!jobs.empty()) {
+		Common::JobGroup group(g_system->getWorkerPool());
+		for (uint j = 0; j < jobs.size(); j++)
+			group.add(computeSizeMD5, &jobs[j]);
+		group.wait();
+
+		for (uint j = 0; j < jobs.size(); j++) {
+			const SizeMD5Job &job = jobs[j];
+			debug(3, "> '%s': '%s'", job.fname.c_str(), job.result.md5.c_str());
+			filesSizeMD5[job.fname] = job.result;
+
+			if (job.result.size != -1)
+				DetectionCache::instance().storeMD5(job.node, job.md5Bytes, job.result.size, job.result.md5);
+		}
+	}
+
 	ADGameDescList matched;
 	int maxFilesMatched = 0;
 	bool gotAnyMatchesWithAllFiles = false;
@@ -0,0 +1,388 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/detectioncache.h"
+
+#include "common/algorithm.h"
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/endian.h"
+#include "common/fs.h"
+#include "common/md5.h"
+#include "common/memstream.h"
+#include "common/savefile.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+
+namespace Common {
+DECLARE_SINGLETON(DetectionCache);
+}
+
+enum {
+	kCacheVersion = 2,
+
+	/**
+	 * The most MD5 checksums kept. Beyond that, the ones used least recently
+	 * are dropped, e.g. those of files which were deleted or moved.
+	 */
+	kMaxMD5Entries = 10000,
+
+	/**
+	 * How deep the fingerprint of a directory looks into subdirectories.
+	 * This is the deepest _maxScanDepth of the advanced detectors.
+	 */
+	kFingerprintDepth = 3,
+
+	/** Upper limit for strings read from the cache file, to reject broken files */
+	kMaxStringLength = 65536
+};
+
+static const uint32 kCacheTag = MKTAG('D', 'C', 'C', 'H');
+
+DetectionCache::DetectionCache() : _loaded(false), _enabled(false), _dirty(false), _useCount(0) {
+}
+
+bool DetectionCache::getFileStamp(const Common::FSNode &node, uint32 &size, uint32 &modificationTime) {
+	if (node.getFileStamp(size, modificationTime))
+		return true;
+
+	// A file which exists but has no stamp means the backend cannot stamp
+	// files at all. Nothing could be cached then, so drop the cache rather
+	// than keep writing it.
+	if (node.exists() && _enabled) {
+		debug(2, "Files cannot be stamped, disabling the detection cache");
+		_enabled = false;
+		_dirty = false;
+		_md5s.clear();
+		_games.clear();
+	}
+	return false;
+}
+
+bool DetectionCache::load() {
+	if (_loaded)
+		return _enabled;
+
+	_loaded = true;
+	_enabled = !ConfMan.get("detection_cache").empty() && g_system->getSavefileManager();
+	if (!_enabled)
+		return false;
+
+	Common::InSaveFile *file = g_system->getSavefileManager()->openForLoading(ConfMan.get("detection_cache"));
+	if (file) {
+		readCache(*file);
+		delete file;
+	}
+
+	return true;
+}
+
+void DetectionCache::flush() {
+	if (!_enabled || !_dirty)
+		return;
+
+	pruneMD5s();
+
+	Common::OutSaveFile *file = g_system->getSavefileManager()->openForSaving(ConfMan.get("detection_cache"));
+	if (!file) {
+		warning("Could not write the detection cache '%s'", ConfMan.get("detection_cache").c_str());
+		return;
+	}
+
+	writeCache(*file);
+	file->finalize();
+	if (file->err())
+		warning("Could not write the detection cache '%s'", ConfMan.get("detection_cache").c_str());
+	delete file;
+
+	_dirty = false;
+}
+
+Common::String DetectionCache::getMD5Key(const Common::FSNode &node, uint32 md5Bytes) {
+	return Common::String::format("%u:", md5Bytes) + node.getPath();
+}
+
+bool DetectionCache::lookupMD5(const Common::FSNode &node, uint32 md5Bytes, int32 &size, Common::String &md5) {
+	if (!load())
+		return false;
+
+	MD5Map::iterator i = _md5s.find(getMD5Key(node, md5Bytes));
+	if (i == _md5s.end())
+		return false;
+
+	uint32 stampSize, stampTime;
+	if (!getFileStamp(node, stampSize, stampTime) || stampSize != i->_value.stampSize || stampTime != i->_value.stampTime) {
+		if (!_enabled)
+			return false;
+
+		// The file changed, so the checksum is of no use anymore
+		_md5s.erase(i);
+		_dirty = true;
+		return false;
+	}
+
+	i->_value.lastUsed = ++_useCount;
+	size = i->_value.size;
+	md5 = i->_value.md5;
+	return true;
+}
+
+void DetectionCache::storeMD5(const Common::FSNode &node, uint32 md5Bytes, int32 size, const Common::String &md5) {
+	if (!load())
+		return;
+
+	MD5Entry entry;
+	if (!getFileStamp(node, entry.stampSize, entry.stampTime))
+		return;
+
+	entry.size = size;
+	entry.md5 = md5;
+	entry.lastUsed = ++_useCount;
+	_md5s[getMD5Key(node, md5Bytes)] = entry;
+	_dirty = true;
+}
+
+bool DetectionCache::addFingerprint(Common::String &fingerprint, const Common::FSList &fslist, int depth) {
+	// The order of the listing is up to the backend
+	Common::FSList sorted(fslist);
+	Common::sort(sorted.begin(), sorted.end());
+
+	for (Common::FSList::const_iterator file = sorted.begin(); file != sorted.end(); ++file) {
+		uint32 stampSize, stampTime;
+		if (!getFileStamp(*file, stampSize, stampTime))
+			return false;
+
+		// Note that the modification time of a directory only changes when
+		// files are added, removed or renamed. Changed files are caught by
+		// looking into the directory.
+		fingerprint += Common::String::format("%s\t%c\t%u\t%u\n", file->getName().c_str(),
+		                                      file->isDirectory() ? 'd' : 'f', stampSize, stampTime);
+
+		if (file->isDirectory() && depth > 1) {
+			Common::FSList files;
+			if (file->getChildren(files, Common::FSNode::kListAll)) {
+				fingerprint += "{\n";
+				if (!addFingerprint(fingerprint, files, depth - 1))
+					return false;
+				fingerprint += "}\n";
+			}
+		}
+	}
+
+	return true;
+}
+
+bool DetectionCache::computeFingerprint(const Common::FSList &fslist, Common::String &fingerprint) {
+	Common::String listing;
+	if (!addFingerprint(listing, fslist, kFingerprintDepth))
+		return false;
+
+	Common::MemoryReadStream stream((const byte *)listing.c_str(), listing.size());
+	fingerprint = Common::computeStreamMD5AsString(stream);
+	return true;
+}
+
+Common::String DetectionCache::getGamesKey(const Common::FSList &fslist) {
+	return fslist.begin()->getParent().getPath();
+}
+
+bool DetectionCache::lookupGames(const Common::FSList &fslist, GameList &games) {
+	if (fslist.empty() || !load())
+		return false;
+
+	GamesMap::const_iterator i = _games.find(getGamesKey(fslist));
+	if (i == _games.end())
+		return false;
+
+	Common::String fingerprint;
+	if (!computeFingerprint(fslist, fingerprint) || fingerprint != i->_value.fingerprint)
+		return false;
+
+	games = i->_value.games;
+	return true;
+}
+
+void DetectionCache::storeGames(const Common::FSList &fslist, const GameList &games) {
+	if (fslist.empty() || !load())
+		return;
+
+	GamesEntry entry;
+	if (!computeFingerprint(fslist, entry.fingerprint))
+		return;
+
+	entry.games = games;
+	_games[getGamesKey(fslist)] = entry;
+	_dirty = true;
+}
+
+void DetectionCache::setDetectorSignature(const Common::String &signature) {
+	if (!load() || signature == _signature)
+		return;
+
+	debug(2, "Detectors changed, dropping the cached detection results");
+	_signature = signature;
+	_games.clear();
+	_dirty = true;
+}
+
+void DetectionCache::pruneMD5s() {
+	if (_md5s.size() <= kMaxMD5Entries)
+		return;
+
+	Common::Array<uint32> uses;
+	uses.reserve(_md5s.size());
+	for (MD5Map::const_iterator i = _md5s.begin(); i != _md5s.end(); ++i)
+		uses.push_back(i->_value.lastUsed);
+	Common::sort(uses.begin(), uses.end());
+
+	// Keep the entries used at or after this
+	const uint32 oldestUse = uses[uses.size() - kMaxMD5Entries];
+
+	Common::Array<Common::String> dropped;
+	for (MD5Map::const_iterator i = _md5s.begin(); i != _md5s.end(); ++i) {
+		if (i->_value.lastUsed < oldestUse)
+			dropped.push_back(i->_key);
+	}
+
+	for (uint i = 0; i < dropped.size(); i++)
+		_md5s.erase(dropped[i]);
+
+	debug(2, "Dropped %u unused MD5 checksums from the detection cache", dropped.size());
+}
+
+static void writeString(Common::WriteStream &stream, const Common::String &str) {
+	stream.writeUint32LE(str.size());
+	stream.write(str.c_str(), str.size());
+}
+
+static bool readString(Common::ReadStream &stream, Common::String &str) {
+	const uint32 size = stream.readUint32LE();
+	if (stream.eos() || stream.err() || size > kMaxStringLength)
+		return false;
+
+	char buffer[256];
+	str.clear();
+	for (uint32 left = size; left > 0; ) {
+		const uint32 chunk = MIN<uint32>(left, sizeof(buffer));
+		if (stream.read(buffer, chunk) != chunk)
+			return false;
+		str += Common::String(buffer, chunk);
+		left -= chunk;
+	}
+
+	return true;
+}
+
+void DetectionCache::writeCache(Common::WriteStream &stream) const {
+	stream.writeUint32BE(kCacheTag);
+	stream.writeUint32LE(kCacheVersion);
+	writeString(stream, _signature);
+	stream.writeUint32LE(_useCount);
+
+	stream.writeUint32LE(_md5s.size());
+	for (MD5Map::const_iterator i = _md5s.begin(); i != _md5s.end(); ++i) {
+		writeString(stream, i->_key);
+		stream.writeUint32LE(i->_value.stampSize);
+		stream.writeUint32LE(i->_value.stampTime);
+		stream.writeSint32LE(i->_value.size);
+		stream.writeUint32LE(i->_value.lastUsed);
+		writeString(stream, i->_value.md5);
+	}
+
+	stream.writeUint32LE(_games.size());
+	for (GamesMap::const_iterator i = _games.begin(); i != _games.end(); ++i) {
+		writeString(stream, i->_key);
+		writeString(stream, i->_value.fingerprint);
+
+		const GameList &games = i->_value.games;
+		stream.writeUint32LE(games.size());
+		for (GameList::const_iterator game = games.begin(); game != games.end(); ++game) {
+			stream.writeUint32LE(game->size());
+			for (GameDescriptor::const_iterator value = game->begin(); value != game->end(); ++value) {
+				writeString(stream, value->_key);
+				writeString(stream, value->_value);
+			}
+		}
+	}
+}
+
+void DetectionCache::readCache(Common::ReadStream &stream) {
+	if (stream.readUint32BE() != kCacheTag || stream.readUint32LE() != kCacheVersion)
+		return;
+
+	MD5Map md5s;
+	GamesMap games;
+	Common::String signature;
+
+	if (!readString(stream, signature))
+		return;
+	const uint32 useCount = stream.readUint32LE();
+
+	for (uint32 count = stream.readUint32LE(); count > 0; count--) {
+		Common::String key;
+		MD5Entry entry;
+
+		if (!readString(stream, key))
+			return;
+		entry.stampSize = stream.readUint32LE();
+		entry.stampTime = stream.readUint32LE();
+		entry.size = stream.readSint32LE();
+		entry.lastUsed = stream.readUint32LE();
+		if (!readString(stream, entry.md5))
+			return;
+
+		md5s[key] = entry;
+	}
+
+	for (uint32 count = stream.readUint32LE(); count > 0; count--) {
+		Common::String key;
+		GamesEntry entry;
+
+		if (!readString(stream, key) || !readString(stream, entry.fingerprint))
+			return;
+
+		for (uint32 gameCount = stream.readUint32LE(); gameCount > 0; gameCount--) {
+			if (stream.eos() || stream.err())
+				return;
+
+			GameDescriptor game;
+			for (uint32 valueCount = stream.readUint32LE(); valueCount > 0; valueCount--) {
+				Common::String name, value;
+				if (!readString(stream, name) || !readString(stream, value))
+					return;
+				game[name] = value;
+			}
+			entry.games.push_back(game);
+		}
+
+		games[key] = entry;
+	}
+
+	if (stream.eos() || stream.err())
+		return;
+
+	// Only use the cache if it could be read in full
+	_signature = signature;
+	_useCount = useCount;
+	_md5s = md5s;
+	_games = games;
+}
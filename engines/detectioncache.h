@@ -0,0 +1,150 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_DETECTIONCACHE_H
+#define ENGINES_DETECTIONCACHE_H
+
+#include "common/hashmap.h"
+#include "common/hash-str.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+#include "engines/game.h"
+
+namespace Common {
+class FSList;
+class FSNode;
+class ReadStream;
+class WriteStream;
+}
+
+/**
+ * A persistent cache of the work done while detecting games, shared by all
+ * engines. It remembers
+ *  - the MD5 checksums of the files looked at by the detectors, keyed by
+ *    their path, size and modification time; only the ones used most
+ *    recently are kept, and
+ *  - the games detected in a directory, keyed by a fingerprint of the
+ *    names, sizes and modification times of the files in it.
+ *
+ * The cache is stored with the savefile manager, in the file named by the
+ * "detection_cache" config key. Setting that key to an empty string disables
+ * the cache. So do backends which cannot tell the size and the modification
+ * time of files (see Common::FSNode::getFileStamp), since without those, no
+ * cached result could be checked.
+ */
+class DetectionCache : public Common::Singleton<DetectionCache> {
+public:
+	/**
+	 * Look up the MD5 checksum of the first md5Bytes bytes of a file.
+	 *
+	 * @param node		the file
+	 * @param md5Bytes	the number of bytes the checksum was computed over
+	 * @param size		set to the size of the file, as the detectors see it
+	 * @param md5		set to the checksum
+	 * @return true if the cache holds a checksum for the current contents of the file
+	 */
+	bool lookupMD5(const Common::FSNode &node, uint32 md5Bytes, int32 &size, Common::String &md5);
+
+	/** Remember the MD5 checksum of a file, as computed by a detector. */
+	void storeMD5(const Common::FSNode &node, uint32 md5Bytes, int32 size, const Common::String &md5);
+
+	/**
+	 * Look up the games detected in a directory, given the listing passed
+	 * to the detectors.
+	 *
+	 * @return true if the cache holds the games detected in the current
+	 *         contents of the directory
+	 */
+	bool lookupGames(const Common::FSList &fslist, GameList &games);
+
+	/** Remember the games detected in a directory. */
+	void storeGames(const Common::FSList &fslist, const GameList &games);
+
+	/**
+	 * Set the string identifying the detectors which produce the cached
+	 * games, e.g. the version and the list of the engine plugins. The cached
+	 * games are dropped when it changes.
+	 */
+	void setDetectorSignature(const Common::String &signature);
+
+	/** Write the cache back to the disk, if anything changed. */
+	void flush();
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	DetectionCache();
+
+	struct MD5Entry {
+		uint32 stampSize;
+		uint32 stampTime;
+		int32 size;
+		uint32 lastUsed;	///< Value of _useCount when the entry was last used
+		Common::String md5;
+	};
+
+	struct GamesEntry {
+		Common::String fingerprint;
+		GameList games;
+	};
+
+	typedef Common::HashMap<Common::String, MD5Entry> MD5Map;
+	typedef Common::HashMap<Common::String, GamesEntry> GamesMap;
+
+	/** Load the cache from the disk, the first time it is used. */
+	bool load();
+
+	/**
+	 * Get the stamp of a file, see Common::FSNode::getFileStamp. Disables
+	 * the cache if the backend cannot stamp files.
+	 */
+	bool getFileStamp(const Common::FSNode &node, uint32 &size, uint32 &modificationTime);
+
+	/**
+	 * Compute the fingerprint of a directory listing, descending into
+	 * subdirectories up to the given depth.
+	 */
+	bool addFingerprint(Common::String &fingerprint, const Common::FSList &fslist, int depth);
+	bool computeFingerprint(const Common::FSList &fslist, Common::String &fingerprint);
+
+	/** Drop the least recently used MD5 checksums, if there are too many. */
+	void pruneMD5s();
+
+	static Common::String getMD5Key(const Common::FSNode &node, uint32 md5Bytes);
+	static Common::String getGamesKey(const Common::FSList &fslist);
+
+	void readCache(Common::ReadStream &stream);
+	void writeCache(Common::WriteStream &stream) const;
+
+	bool _loaded;
+	bool _enabled;
+	bool _dirty;
+
+	/** Counts the uses of MD5 checksums, to tell which were used last */
+	uint32 _useCount;
+
+	Common::String _signature;
+	MD5Map _md5s;
+	GamesMap _games;
+};
+
+#endif
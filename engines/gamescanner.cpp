@@ -0,0 +1,103 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/gamescanner.h"
+
+#include "common/util.h"
+#include "common/workerpool.h"
+
+GameScanner::GameScanner(const Common::FSNode &root, bool recursive, Common::WorkerPool *pool)
+	: _pool(pool), _recursive(recursive),
+	  _scannedCount(0), _foundCount(1), _listedCount(0) {
+
+	// Keep all threads busy, even while the results of some listings
+	// wait for the detection of the directories before them.
+	_maxListings = _pool ? MAX<uint>(_pool->getThreadCount() * 2, 1) : 1;
+
+	_pendingDirs.push(root);
+	startListings();
+}
+
+GameScanner::~GameScanner() {
+	for (Common::List<Listing *>::iterator i = _listings.begin(); i != _listings.end(); ++i) {
+		if (_pool)
+			_pool->waitForJobs(&(*i)->pending);
+		delete *i;
+	}
+}
+
+void GameScanner::listDirectory(void *param) {
+	Listing *listing = (Listing *)param;
+
+	// Only this job touches the listing until it is done
+	listing->success = listing->dir.getChildren(listing->files, Common::FSNode::kListAll);
+}
+
+void GameScanner::startListings() {
+	while (!_pendingDirs.empty() && _listings.size() < _maxListings) {
+		Listing *listing = new Listing();
+		listing->dir = _pendingDirs.pop();
+		listing->success = false;
+		listing->pending = 0;
+		_listings.push_back(listing);
+
+		if (_pool)
+			_pool->addJob(listDirectory, listing, &listing->pending);
+		else
+			listDirectory(listing);
+	}
+}
+
+bool GameScanner::listNextDirectory(Common::FSNode &dir, Common::FSList &files) {
+	assert(!isFinished());
+
+	Listing *listing = _listings.front();
+	_listings.pop_front();
+	if (_pool)
+		_pool->waitForJobs(&listing->pending);
+
+	dir = listing->dir;
+	files.clear();
+
+	const bool success = listing->success;
+	if (success) {
+		_listedCount += listing->files.size();
+
+		if (_recursive) {
+			for (Common::FSList::const_iterator file = listing->files.begin(); file != listing->files.end(); ++file) {
+				if (file->isDirectory()) {
+					_pendingDirs.push(*file);
+					_foundCount++;
+				}
+			}
+		}
+
+		files = listing->files;
+	}
+
+	_scannedCount++;
+	delete listing;
+
+	// List the next directories while this one is being looked at
+	startListings();
+	return success;
+}
@@ -0,0 +1,137 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_GAMESCANNER_H
+#define ENGINES_GAMESCANNER_H
+
+#include "common/fs.h"
+#include "common/list.h"
+#include "common/noncopyable.h"
+#include "common/queue.h"
+
+#include "engines/game.h"
+#include "engines/metaengine.h"
+
+namespace Common {
+class WorkerPool;
+}
+
+/**
+ * Walks a directory tree and detects the games in each directory, for the
+ * mass add dialog and the --add command line option.
+ *
+ * The directories are scanned breadth-first. While the games in one
+ * directory are being detected, the next few directories are listed on the
+ * worker pool, so the latency of slow (e.g. network) storage is hidden. The
+ * detection itself runs on the calling thread: the detectors are not
+ * re-entrant (e.g. the fallback detectors fill static descriptions) and may
+ * use any part of the system. It hashes the files on the worker pool, though.
+ */
+class GameScanner : Common::NonCopyable {
+public:
+	/**
+	 * @param root		the directory to start at
+	 * @param recursive	whether to descend into subdirectories
+	 * @param pool		the worker pool to list the directories on, or 0 to
+	 *			list them on the calling thread
+	 */
+	GameScanner(const Common::FSNode &root, bool recursive, Common::WorkerPool *pool);
+	~GameScanner();
+
+	/** Return whether all directories have been scanned. */
+	bool isFinished() const { return _pendingDirs.empty() && _listings.empty(); }
+
+	/**
+	 * Take the listing of the next directory. The directories after it are
+	 * listed on the pool in the meantime. Must not be called once
+	 * isFinished() returns true.
+	 *
+	 * @param dir	set to the directory
+	 * @param files	set to the files and subdirectories in it
+	 * @return false if the directory could not be listed
+	 */
+	bool listNextDirectory(Common::FSNode &dir, Common::FSList &files);
+
+	/**
+	 * Detect the games in the next directory. Must not be called once
+	 * isFinished() returns true.
+	 *
+	 * @param dir	set to the directory
+	 * @param games	set to the games detected in it
+	 * @return false if the directory could not be listed
+	 */
+	bool scanNextDirectory(Common::FSNode &dir, GameList &games) {
+		Common::FSList files;
+		games.clear();
+		if (!listNextDirectory(dir, files))
+			return false;
+
+		games = EngineMan.detectGames(files);
+		return true;
+	}
+
+	/** Return the number of directories scanned so far. */
+	uint getScannedCount() const { return _scannedCount; }
+
+	/** Return the number of directories found so far, scanned or not. */
+	uint getFoundCount() const { return _foundCount; }
+
+	/** Return the number of files and directories listed so far. */
+	uint getListedCount() const { return _listedCount; }
+
+	/** Return the number of directories being listed ahead right now. */
+	uint getListingCount() const { return _listings.size(); }
+
+	/** Return the most directories listed ahead at once. */
+	uint getMaxListingCount() const { return _maxListings; }
+
+private:
+	/** A directory which is being listed, possibly on a worker thread. */
+	struct Listing {
+		Common::FSNode dir;
+		Common::FSList files;
+		bool success;
+		int32 pending;
+	};
+
+	static void listDirectory(void *param);
+
+	/** Start listing directories, up to the limit of listings ahead. */
+	void startListings();
+
+	Common::WorkerPool *_pool;
+	bool _recursive;
+
+	/** The most directories being listed ahead at once. */
+	uint _maxListings;
+
+	/** Directories which were found but are not being listed yet. */
+	Common::Queue<Common::FSNode> _pendingDirs;
+	/** Directories which are being listed, in the order they were found. */
+	Common::List<Listing *> _listings;
+
+	uint _scannedCount;
+	uint _foundCount;
+	uint _listedCount;
+};
+
+#endif
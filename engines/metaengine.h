@@ -256,10 +256,29 @@ typedef PluginSubclass<MetaEngine> EnginePlugin;
  */
 class EngineManager : public Common::Singleton<EngineManager> {
 public:
+	/** The name of an engine and the copyright of the games it runs. */
+	struct EngineInfo {
+		Common::String name;
+		Common::String originalCopyright;
+	};
+	typedef Common::Array<EngineInfo> EngineInfoList;
+
 	GameDescriptor findGameInLoadedPlugins(const Common::String &gameName, const EnginePlugin **plugin = NULL) const;
 	GameDescriptor findGame(const Common::String &gameName, const EnginePlugin **plugin = NULL) const;
 	GameList detectGames(const Common::FSList &fslist) const;
 	const EnginePlugin::List &getPlugins() const;
+
+	/**
+	 * Return the games supported by all engine plugins. If the plugins are
+	 * indexed, the games are taken from the index and no plugin is loaded.
+	 */
+	GameList getSupportedGames() const;
+
+	/**
+	 * Return the names and copyrights of all engines. If the plugins are
+	 * indexed, they are taken from the index and no plugin is loaded.
+	 */
+	EngineInfoList getEngineInfos() const;
 };
 
 /** Convenience shortcut for accessing the engine manager. */
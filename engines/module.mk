@@ -2,9 +2,11 @@ MODULE := engines
 
 MODULE_OBJS := \
 	advancedDetector.o \
+	detectioncache.o \
 	dialogs.o \
 	engine.o \
 	game.o \
+	gamescanner.o \
 	obsolete.o \
 	savestate.o
 
@@ -108,6 +108,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	DCmd_Register("resource_id",		WRAP_METHOD(Console, cmdResourceId));
 	DCmd_Register("resource_info",		WRAP_METHOD(Console, cmdResourceInfo));
 	DCmd_Register("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
+	DCmd_Register("resource_cache",		WRAP_METHOD(Console, cmdResourceCache));
 	DCmd_Register("list",				WRAP_METHOD(Console, cmdList));
 	DCmd_Register("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	DCmd_Register("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
@@ -344,6 +345,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	DebugPrintf(" resource_id - Identifies a resource number by splitting it up in resource type and resource number\n");
 	DebugPrintf(" resource_info - Shows info about a resource\n");
 	DebugPrintf(" resource_types - Shows the valid resource types\n");
+	DebugPrintf(" resource_cache - Shows the resource cache statistics, or sets the cache size\n");
 	DebugPrintf(" list - Lists all the resources of a given type\n");
 	DebugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	DebugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
@@ -785,6 +787,37 @@ bool Console::cmdResourceTypes(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceCache(int argc, const char **argv) {
+	if (argc > 2) {
+		DebugPrintf("Shows the statistics of the cache of unlocked resources, or sets its size\n");
+		DebugPrintf("Usage: %s [<size in KB>]\n", argv[0]);
+		return true;
+	}
+
+	ResourceManager *resMan = _engine->getResMan();
+
+	if (argc == 2) {
+		char *endptr;
+		const long size = strtol(argv[1], &endptr, 10);
+		if (*argv[1] == '\0' || *endptr != '\0' || size <= 0 || size > 0x7FFFFFFF / 1024) {
+			DebugPrintf("Invalid cache size: %s\n", argv[1]);
+			return true;
+		}
+
+		resMan->setCacheSize(size * 1024);
+	}
+
+	const ResourceCacheStats &stats = resMan->getCacheStats();
+	const uint32 requests = stats.hits + stats.misses;
+
+	DebugPrintf("Cache size: %d KB\n", resMan->getCacheSize() / 1024);
+	DebugPrintf("Hits: %d, misses: %d (%d%% hit rate)\n", stats.hits, stats.misses,
+	            requests ? stats.hits * 100 / requests : 0);
+	DebugPrintf("Evictions: %d (%d KB)\n", stats.evictions, stats.evictedBytes / 1024);
+
+	return true;
+}
+
 bool Console::cmdHexgrep(int argc, const char **argv) {
 	if (argc < 4) {
 		DebugPrintf("Searches some resources for a particular sequence of bytes, represented as decimal or hexadecimal numbers.\n");
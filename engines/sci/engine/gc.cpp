@@ -160,9 +160,65 @@ AddrSet *findAllActiveReferences(EngineState *s) {
 	return normalizeAddresses(s->_segMan, wm._map);
 }
 
+enum {
+	/** Number of table entries checked by one incremental gc step */
+	GC_STEP_ADDRESSES = 512,
+
+	/**
+	 * Most allocations during an incremental gc cycle. Beyond that, the
+	 * distances between the allocation stamps could wrap around, so the
+	 * cycle starts over.
+	 */
+	GC_MAX_CYCLE_ALLOCATIONS = 0x40000000
+};
+
+/**
+ * Checks whether an entry was allocated after markStamp, and is thus
+ * unknown to the active references gathered then. The stamps are compared
+ * by their distance to markStamp, which stays right when
+ * g_sciAllocationStamp wraps around. An entry older than about 2^32
+ * allocations may pass for a new one; it is then merely kept until the
+ * next cycle.
+ */
+static bool isYoungerThan(uint32 allocStamp, uint32 markStamp) {
+	return allocStamp - markStamp < g_sciAllocationStamp - markStamp;
+}
+
+/**
+ * Frees a deallocatable address if it is not referenced. Addresses allocated
+ * after markStamp are kept, as activeRefs does not know about them.
+ */
+static void sweepAddress(SegManager *segMan, SegmentObj *mobj, reg_t addr, const AddrSet &activeRefs, uint32 markStamp, int &freed) {
+	if (mobj->hasAllocationStamps() && isYoungerThan(mobj->getAllocationStamp(addr), markStamp))
+		return;
+
+	if (!activeRefs.contains(addr)) {
+		// Not found -> we can free it
+		mobj->freeAtAddress(segMan, addr);
+		debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+		freed++;
+	}
+}
+
+/**
+ * Frees all deallocatable addresses of a segment which are not referenced.
+ */
+static void sweepSegment(SegManager *segMan, SegmentId seg, const AddrSet &activeRefs, uint32 markStamp, int &freed) {
+	SegmentObj *mobj = segMan->getSegmentObj(seg);
+
+	// Get a list of all deallocatable objects in this segment,
+	// then free any which are not referenced from somewhere.
+	const Common::Array<reg_t> tmp = mobj->listAllDeallocatable(seg);
+	for (Common::Array<reg_t>::const_iterator it = tmp.begin(); it != tmp.end(); ++it)
+		sweepAddress(segMan, mobj, *it, activeRefs, markStamp, freed);
+}
+
 void run_gc(EngineState *s) {
 	SegManager *segMan = s->_segMan;
 
+	// A full collection supersedes any unfinished incremental one
+	abort_gc(s);
+
 	// Some debug stuff
 	debugC(kDebugLevelGC, "[GC] Running...");
 #ifdef GC_DEBUG_CODE
@@ -174,6 +230,7 @@ void run_gc(EngineState *s) {
 
 	// Compute the set of all segments references currently in use.
 	AddrSet *activeRefs = findAllActiveReferences(s);
+	const uint32 markStamp = g_sciAllocationStamp;
 
 	// Iterate over all segments, and check for each whether it
 	// contains stuff that can be collected.
@@ -182,26 +239,15 @@ void run_gc(EngineState *s) {
 		SegmentObj *mobj = heap[seg];
 
 		if (mobj != NULL) {
+			int freed = 0;
 #ifdef GC_DEBUG_CODE
 			const SegmentType type = mobj->getType();
 			segnames[type] = segmentTypeNames[type];
 #endif
-
-			// Get a list of all deallocatable objects in this segment,
-			// then free any which are not referenced from somewhere.
-			const Common::Array<reg_t> tmp = mobj->listAllDeallocatable(seg);
-			for (Common::Array<reg_t>::const_iterator it = tmp.begin(); it != tmp.end(); ++it) {
-				const reg_t addr = *it;
-				if (!activeRefs->contains(addr)) {
-					// Not found -> we can free it
-					mobj->freeAtAddress(segMan, addr);
-					debugC(kDebugLevelGC, "[GC] Deallocating %04x:%04x", PRINT_REG(addr));
+			sweepSegment(segMan, seg, *activeRefs, markStamp, freed);
 #ifdef GC_DEBUG_CODE
-					segcount[type]++;
+			segcount[type] += freed;
 #endif
-				}
-			}
-
 		}
 	}
 
@@ -216,4 +262,77 @@ void run_gc(EngineState *s) {
 #endif
 }
 
+bool run_gc_step(EngineState *s) {
+	SegManager *segMan = s->_segMan;
+	const Common::Array<SegmentObj *> &heap = segMan->getSegments();
+	int freed = 0;
+
+	if (!s->_gcCycle) {
+		debugC(kDebugLevelGC, "[GC] Starting incremental cycle");
+
+		GCCycle *cycle = new GCCycle();
+		cycle->activeRefs = findAllActiveReferences(s);
+		cycle->markStamp = g_sciAllocationStamp;
+		cycle->nextSegment = 1;
+		cycle->nextEntry = 0;
+		s->_gcCycle = cycle;
+
+		// Scripts and dynamic memory have no allocation stamps, and scripts
+		// may become referenced again through the class table without
+		// anything being allocated. Sweep them while the active references
+		// are still accurate; the table segments follow in the next steps.
+		for (uint seg = 1; seg < heap.size(); seg++) {
+			if (heap[seg] && !heap[seg]->hasAllocationStamps())
+				sweepSegment(segMan, seg, *cycle->activeRefs, cycle->markStamp, freed);
+		}
+
+		return true;
+	}
+
+	GCCycle *cycle = s->_gcCycle;
+
+	if (g_sciAllocationStamp - cycle->markStamp > GC_MAX_CYCLE_ALLOCATIONS) {
+		debugC(kDebugLevelGC, "[GC] Too many allocations, restarting incremental cycle");
+		abort_gc(s);
+		return true;
+	}
+
+	// Table entries which were unreferenced when the cycle started stay
+	// unreferenced: they can only be reached again through a reference,
+	// and there was none left to copy it from. New entries are skipped by
+	// their allocation stamp, so the sweep can be spread over many steps.
+	// Each step checks a fixed number of entries, so large tables are split
+	// over several steps as well.
+	uint budget = GC_STEP_ADDRESSES;
+	while (cycle->nextSegment < heap.size() && budget > 0) {
+		SegmentObj *mobj = heap[cycle->nextSegment];
+		const uint entryCount = (mobj && mobj->hasAllocationStamps()) ? mobj->getEntryCount() : 0;
+
+		for (; cycle->nextEntry < entryCount && budget > 0; cycle->nextEntry++, budget--) {
+			if (mobj->isValidOffset(cycle->nextEntry))
+				sweepAddress(segMan, mobj, make_reg(cycle->nextSegment, cycle->nextEntry), *cycle->activeRefs, cycle->markStamp, freed);
+		}
+
+		if (cycle->nextEntry >= entryCount) {
+			cycle->nextSegment++;
+			cycle->nextEntry = 0;
+		}
+	}
+
+	if (cycle->nextSegment < heap.size())
+		return true;
+
+	debugC(kDebugLevelGC, "[GC] Finished incremental cycle");
+	abort_gc(s);
+	return false;
+}
+
+void abort_gc(EngineState *s) {
+	if (s->_gcCycle) {
+		delete s->_gcCycle->activeRefs;
+		delete s->_gcCycle;
+		s->_gcCycle = 0;
+	}
+}
+
 } // End of namespace Sci
@@ -55,6 +55,42 @@ AddrSet *findAllActiveReferences(EngineState *s);
  */
 void run_gc(EngineState *s);
 
+/**
+ * State of an incremental garbage collection which has gathered the active
+ * references, but not yet swept all segments.
+ */
+struct GCCycle {
+	AddrSet *activeRefs;	///< References which were active when the cycle started
+	uint32 markStamp;	///< g_sciAllocationStamp when the cycle started
+	uint nextSegment;	///< Segment being swept
+	uint nextEntry;	///< Next entry of that segment to sweep
+};
+
+/**
+ * Runs one step of an incremental garbage collection on the current system
+ * state. The first step of a cycle gathers all active references and frees
+ * unreferenced scripts and dynamic memory; every following step checks a
+ * limited number of entries of the table segments (clones, lists, nodes,
+ * hunks, arrays and strings) and frees the unreferenced ones, resuming where
+ * the previous step stopped, even within a segment. Entries which were
+ * allocated after the cycle started are left for the next cycle.
+ *
+ * Only the sweep is spread over several steps. The first step still gathers
+ * the active references in one go, since marking incrementally would need a
+ * write barrier on every store of the VM. Neither is there a separate nursery
+ * for young entries; the allocation stamps merely keep a cycle from freeing
+ * entries allocated after it started.
+ * @param s The state in which we should gc
+ * @return true if the cycle needs more steps, false if it is finished
+ */
+bool run_gc_step(EngineState *s);
+
+/**
+ * Drops the unfinished incremental garbage collection, if any
+ * @param s The state in which we should gc
+ */
+void abort_gc(EngineState *s);
+
 struct WorklistManager {
 	Common::Array<reg_t> _worklist;
 	AddrSet _map;	// used for 2 contains() calls, inside push() and run_gc()
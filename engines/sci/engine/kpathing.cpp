@@ -28,6 +28,7 @@
 #include "sci/graphics/palette.h"
 #include "sci/graphics/screen.h"
 
+#include "common/algorithm.h"
 #include "common/debug-channels.h"
 #include "common/list.h"
 #include "common/system.h"
@@ -94,10 +95,14 @@ struct Vertex {
 	// Previous vertex in shortest path
 	Vertex *path_prev;
 
+	// Position in the vertex index
+	int index;
+
 public:
 	Vertex(const Common::Point &p) : v(p) {
 		costG = HUGE_DISTANCE;
 		path_prev = NULL;
+		index = -1;
 	}
 };
 
@@ -214,6 +219,82 @@ public:
 
 typedef Common::List<Polygon *> PolygonList;
 
+/**
+ * Buckets the edges of a polygon set in a uniform grid, so that the edges
+ * which may touch a line segment can be found without testing all of them.
+ */
+class EdgeIndex {
+public:
+	EdgeIndex() : _left(0), _top(0), _cellWidth(1), _cellHeight(1), _columns(0), _rows(0), _queryCount(0) {}
+
+	/**
+	 * Builds the index for the edges starting at the given vertices. Single
+	 * vertices are indexed as well, as degenerate edges.
+	 */
+	void build(const Common::Array<Vertex *> &vertices);
+
+	/**
+	 * Finds the edges with a bounding box which may overlap the bounding
+	 * box of the line segment (a, b).
+	 * @param result	receives the indices of the edges, in no particular order
+	 */
+	void query(const Common::Point &a, const Common::Point &b, Common::Array<uint16> &result);
+
+private:
+	enum {
+		kMaxGridSize = 16
+	};
+
+	int _left, _top;
+	int _cellWidth, _cellHeight;
+	int _columns, _rows;
+	Common::Array<Common::Array<uint16> > _cells;
+
+	// Used to report edges spanning several cells only once per query
+	Common::Array<uint32> _lastQuery;
+	uint32 _queryCount;
+};
+
+/**
+ * Visibility graph of a polygon set which kAvoidPath was called with.
+ * Games call kAvoidPath over and over with the same polygons, only the start
+ * and end points differ. These are merged into the polygon set as
+ * single-vertex polygons in front of all other vertices, which leaves the
+ * visibility between the other vertices unchanged.
+ */
+struct VisibilityGraph {
+	// Types, sizes and points of the polygons the graph was built for
+	Common::Array<int16> key;
+
+	EdgeIndex edges;
+
+	// The vertices visible from each vertex, in ascending order. Only valid
+	// for the vertices with computed set.
+	Common::Array<Common::Array<uint16> > visible;
+	Common::Array<bool> computed;
+};
+
+/**
+ * Visibility graphs of the polygon sets kAvoidPath was recently called with,
+ * most recently used first.
+ */
+struct AvoidPathCache {
+	enum {
+		kMaxGraphs = 4
+	};
+
+	Common::List<VisibilityGraph *> graphs;
+
+	~AvoidPathCache() {
+		for (Common::List<VisibilityGraph *>::iterator it = graphs.begin(); it != graphs.end(); ++it)
+			delete *it;
+	}
+};
+
+void freeAvoidPathCache(AvoidPathCache *cache) {
+	delete cache;
+}
+
 // Pathfinding state
 struct PathfindingState {
 	// List of all polygons
@@ -235,6 +316,19 @@ struct PathfindingState {
 	// Screen size
 	int _width, _height;
 
+	// Cached visibility graph of the polygon set without the start and end
+	// points, or NULL if the polygon set does not match its layout
+	VisibilityGraph *_graph;
+
+	// The vertices of the polygon set in the order of the graph
+	Common::Array<Vertex *> _graphVertices;
+
+	// Number of vertices in front of the graph vertices in the vertex index
+	int _graphOffset;
+
+	// Scratch buffer for edge index queries
+	Common::Array<uint16> _edgeCandidates;
+
 	PathfindingState(int width, int height) : _width(width), _height(height) {
 		vertex_start = NULL;
 		vertex_end = NULL;
@@ -242,6 +336,8 @@ struct PathfindingState {
 		_prependPoint = NULL;
 		_appendPoint = NULL;
 		vertices = 0;
+		_graph = NULL;
+		_graphOffset = 0;
 	}
 
 	~PathfindingState() {
@@ -637,6 +733,141 @@ static int inside(const Common::Point &p, Vertex *vertex) {
 	return 0;
 }
 
+void EdgeIndex::build(const Common::Array<Vertex *> &vertices) {
+	_cells.clear();
+	_columns = _rows = 0;
+
+	if (vertices.empty())
+		return;
+
+	int left = vertices[0]->v.x, right = left;
+	int top = vertices[0]->v.y, bottom = top;
+
+	for (uint i = 1; i < vertices.size(); i++) {
+		left = MIN<int>(left, vertices[i]->v.x);
+		right = MAX<int>(right, vertices[i]->v.x);
+		top = MIN<int>(top, vertices[i]->v.y);
+		bottom = MAX<int>(bottom, vertices[i]->v.y);
+	}
+
+	// Aim for a handful of edges per cell
+	const int size = CLIP<int>((int)sqrt((float)vertices.size()), 1, kMaxGridSize);
+
+	_left = left;
+	_top = top;
+	_columns = _rows = size;
+	_cellWidth = (right - left) / size + 1;
+	_cellHeight = (bottom - top) / size + 1;
+	_cells.resize(_columns * _rows);
+
+	for (uint i = 0; i < vertices.size(); i++) {
+		const Common::Point &p = vertices[i]->v;
+		const Common::Point &q = CLIST_NEXT(vertices[i])->v;
+
+		const int x1 = (MIN(p.x, q.x) - _left) / _cellWidth;
+		const int x2 = (MAX(p.x, q.x) - _left) / _cellWidth;
+		const int y1 = (MIN(p.y, q.y) - _top) / _cellHeight;
+		const int y2 = (MAX(p.y, q.y) - _top) / _cellHeight;
+
+		for (int y = y1; y <= y2; y++)
+			for (int x = x1; x <= x2; x++)
+				_cells[y * _columns + x].push_back(i);
+	}
+
+	_lastQuery.clear();
+	_lastQuery.resize(vertices.size());
+	_queryCount = 0;
+}
+
+void EdgeIndex::query(const Common::Point &a, const Common::Point &b, Common::Array<uint16> &result) {
+	result.clear();
+
+	if (_cells.empty())
+		return;
+
+	// Clip the bounding box of the segment to the grid
+	const int right = _left + _columns * _cellWidth - 1;
+	const int bottom = _top + _rows * _cellHeight - 1;
+	const int left = MAX<int>(MIN(a.x, b.x), _left);
+	const int top = MAX<int>(MIN(a.y, b.y), _top);
+	const int x2 = MIN<int>(MAX(a.x, b.x), right);
+	const int y2 = MIN<int>(MAX(a.y, b.y), bottom);
+
+	if (left > x2 || top > y2)
+		return;
+
+	if (++_queryCount == 0) {
+		for (uint i = 0; i < _lastQuery.size(); i++)
+			_lastQuery[i] = 0;
+		_queryCount = 1;
+	}
+
+	for (int y = (top - _top) / _cellHeight; y <= (y2 - _top) / _cellHeight; y++) {
+		for (int x = (left - _left) / _cellWidth; x <= (x2 - _left) / _cellWidth; x++) {
+			const Common::Array<uint16> &cell = _cells[y * _columns + x];
+
+			for (uint i = 0; i < cell.size(); i++) {
+				if (_lastQuery[cell[i]] != _queryCount) {
+					_lastQuery[cell[i]] = _queryCount;
+					result.push_back(cell[i]);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Checks whether an edge blocks the line between two vertices
+ * @param vertex_cur	the first vertex
+ * @param vertex		the second vertex
+ * @param edge			the first vertex of the edge
+ * @return true if the edge blocks the line, false otherwise
+ */
+static bool edge_blocks(Vertex *vertex_cur, Vertex *vertex, Vertex *edge) {
+	if (!VERTEX_HAS_EDGES(edge))
+		return false;
+
+	if (between(vertex_cur->v, vertex->v, edge->v)) {
+		// If we hit a vertex, make sure we can pass through it without intersecting its polygon
+		// Otherwise, this edge won't properly intersect
+		return inside(vertex_cur->v, edge) || inside(vertex->v, edge);
+	}
+
+	return intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v);
+}
+
+/**
+ * Checks whether a vertex is visible from another vertex
+ * @param s				the pathfinding state
+ * @param vertex_cur	the vertex to look from
+ * @param vertex		the vertex to check
+ * @return true if vertex is visible from vertex_cur, false otherwise
+ */
+static bool vertex_visible(PathfindingState *s, Vertex *vertex_cur, Vertex *vertex) {
+	// Make sure we don't intersect a polygon locally at the vertices
+	if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
+		return false;
+
+	// Check for intersecting edges
+	if (s->_graph) {
+		// The start and end points never have edges, so the edges of the
+		// graph vertices are all there is to check
+		s->_graph->edges.query(vertex_cur->v, vertex->v, s->_edgeCandidates);
+
+		for (uint i = 0; i < s->_edgeCandidates.size(); i++) {
+			if (edge_blocks(vertex_cur, vertex, s->_graphVertices[s->_edgeCandidates[i]]))
+				return false;
+		}
+	} else {
+		for (int i = 0; i < s->vertices; i++) {
+			if (edge_blocks(vertex_cur, vertex, s->vertex_index[i]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
 /**
  * Returns a list of all vertices that are visible from a particular vertex.
  * @param s				the pathfinding state
@@ -646,33 +877,37 @@ static int inside(const Common::Point &p, Vertex *vertex) {
 static VertexList *visible_vertices(PathfindingState *s, Vertex *vertex_cur) {
 	VertexList *visVerts = new VertexList();
 
-	for (int i = 0; i < s->vertices; i++) {
-		Vertex *vertex = s->vertex_index[i];
-
-		// Make sure we don't intersect a polygon locally at the vertices
-		if ((vertex == vertex_cur) || (inside(vertex->v, vertex_cur)) || (inside(vertex_cur->v, vertex)))
-			continue;
+	if (s->_graph && vertex_cur->index >= s->_graphOffset) {
+		// Visibility between the graph vertices is cached; only the start
+		// and end points in front of them need to be checked. The list is
+		// built in the same order as below.
+		VisibilityGraph *graph = s->_graph;
+		const int cur = vertex_cur->index - s->_graphOffset;
+
+		if (!graph->computed[cur]) {
+			for (uint i = 0; i < s->_graphVertices.size(); i++) {
+				if (vertex_visible(s, vertex_cur, s->_graphVertices[i]))
+					graph->visible[cur].push_back(i);
+			}
+			graph->computed[cur] = true;
+		}
 
-		// Check for intersecting edges
-		int j;
-		for (j = 0; j < s->vertices; j++) {
-			Vertex *edge = s->vertex_index[j];
-			if (VERTEX_HAS_EDGES(edge)) {
-				if (between(vertex_cur->v, vertex->v, edge->v)) {
-					// If we hit a vertex, make sure we can pass through it without intersecting its polygon
-					if ((inside(vertex_cur->v, edge)) || (inside(vertex->v, edge)))
-						break;
-
-					// This edge won't properly intersect, so we continue
-					continue;
-				}
+		const Common::Array<uint16> &visible = graph->visible[cur];
+		for (uint i = 0; i < visible.size(); i++)
+			visVerts->push_front(s->_graphVertices[visible[i]]);
 
-				if (intersect_proper(vertex_cur->v, vertex->v, edge->v, CLIST_NEXT(edge)->v))
-					break;
-			}
+		for (int i = s->_graphOffset - 1; i >= 0; i--) {
+			if (vertex_visible(s, vertex_cur, s->vertex_index[i]))
+				visVerts->push_back(s->vertex_index[i]);
 		}
 
-		if (j == s->vertices)
+		return visVerts;
+	}
+
+	for (int i = 0; i < s->vertices; i++) {
+		Vertex *vertex = s->vertex_index[i];
+
+		if (vertex_visible(s, vertex_cur, vertex))
 			visVerts->push_front(vertex);
 	}
 
@@ -836,52 +1071,67 @@ static int intersection(const Common::Point &a, const Common::Point &b, Vertex *
  *             (Common::Point) *ret: On success, the closest intersection point
  */
 static int nearest_intersection(PathfindingState *s, const Common::Point &p, const Common::Point &q, Common::Point *ret) {
-	Polygon *polygon = 0;
 	FloatPoint isec;
-	Polygon *ipolygon = 0;
+	Vertex *ivertex = 0;
 	uint32 dist = HUGE_DISTANCE;
 
-	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end(); ++it) {
-		polygon = *it;
-		Vertex *vertex;
+	// Only the edges near the line segment can intersect it. They are
+	// checked in vertex index order, so that the first one of several
+	// intersections at the same distance is picked like before.
+	Common::Array<uint16> &candidates = s->_edgeCandidates;
+	s->_graph->edges.query(p, q, candidates);
+	Common::sort(candidates.begin(), candidates.end());
 
-		CLIST_FOREACH(vertex, &polygon->vertices) {
-			uint32 new_dist;
-			FloatPoint new_isec;
-
-			// Check for intersection with vertex
-			if (between(p, q, vertex->v)) {
-				// Skip this vertex if we hit it from the
-				// inside of the polygon
-				if (inside(q, vertex)) {
-					new_isec.x = vertex->v.x;
-					new_isec.y = vertex->v.y;
-				} else
-					continue;
-			} else {
-				// Check for intersection with edges
+	for (uint i = 0; i < candidates.size(); i++) {
+		Vertex *vertex = s->_graphVertices[candidates[i]];
+		uint32 new_dist;
+		FloatPoint new_isec;
+
+		// Check for intersection with vertex
+		if (between(p, q, vertex->v)) {
+			// Skip this vertex if we hit it from the
+			// inside of the polygon
+			if (inside(q, vertex)) {
+				new_isec.x = vertex->v.x;
+				new_isec.y = vertex->v.y;
+			} else
+				continue;
+		} else {
+			// Check for intersection with edges
 
-				// Skip this edge if we hit it from the
-				// inside of the polygon
-				if (!left(vertex->v, CLIST_NEXT(vertex)->v, q))
-					continue;
+			// Skip this edge if we hit it from the
+			// inside of the polygon
+			if (!left(vertex->v, CLIST_NEXT(vertex)->v, q))
+				continue;
 
-				if (intersection(p, q, vertex, &new_isec) != PF_OK)
-					continue;
-			}
+			if (intersection(p, q, vertex, &new_isec) != PF_OK)
+				continue;
+		}
 
-			new_dist = p.sqrDist(new_isec.toPoint());
-			if (new_dist < dist) {
-				ipolygon = polygon;
-				isec = new_isec;
-				dist = new_dist;
-			}
+		new_dist = p.sqrDist(new_isec.toPoint());
+		if (new_dist < dist) {
+			ivertex = vertex;
+			isec = new_isec;
+			dist = new_dist;
 		}
 	}
 
 	if (dist == HUGE_DISTANCE)
 		return PF_ERROR;
 
+	// Find the polygon of the intersecting edge
+	Polygon *ipolygon = 0;
+	for (PolygonList::iterator it = s->polygons.begin(); it != s->polygons.end() && !ipolygon; ++it) {
+		Vertex *vertex;
+
+		CLIST_FOREACH(vertex, &(*it)->vertices) {
+			if (vertex == ivertex) {
+				ipolygon = *it;
+				break;
+			}
+		}
+	}
+
 	// Find point not contained in polygon
 	return find_free_point(isec, ipolygon, ret);
 }
@@ -1163,6 +1413,61 @@ static void change_polygons_opt_0(PathfindingState *s) {
 	}
 }
 
+/**
+ * Finds the visibility graph of the polygon set of a pathfinding state in the
+ * cache, or adds a new one
+ * Parameters: (EngineState *) s: The game state
+ *             (PathfindingState *) pf_s: The pathfinding state, with the
+ *                                        start and end points not merged yet
+ * Returns   : (VisibilityGraph *) The visibility graph
+ */
+static VisibilityGraph *lookupVisibilityGraph(EngineState *s, PathfindingState *pf_s) {
+	Common::Array<int16> key;
+
+	for (PolygonList::iterator it = pf_s->polygons.begin(); it != pf_s->polygons.end(); ++it) {
+		Vertex *vertex;
+
+		key.push_back((*it)->type);
+		key.push_back((*it)->vertices.size());
+		CLIST_FOREACH(vertex, &(*it)->vertices) {
+			key.push_back(vertex->v.x);
+			key.push_back(vertex->v.y);
+		}
+	}
+
+	if (!s->_avoidPathCache)
+		s->_avoidPathCache = new AvoidPathCache();
+
+	Common::List<VisibilityGraph *> &graphs = s->_avoidPathCache->graphs;
+
+	for (Common::List<VisibilityGraph *>::iterator it = graphs.begin(); it != graphs.end(); ++it) {
+		if ((*it)->key == key) {
+			VisibilityGraph *graph = *it;
+			graphs.erase(it);
+			graphs.push_front(graph);
+			return graph;
+		}
+	}
+
+	debugC(kDebugLevelAvoidPath, "AvoidPath: Building visibility graph for %u vertices", pf_s->_graphVertices.size());
+
+	VisibilityGraph *graph = new VisibilityGraph();
+	graph->key = key;
+	graph->edges.build(pf_s->_graphVertices);
+	graph->visible.resize(pf_s->_graphVertices.size());
+	graph->computed.resize(pf_s->_graphVertices.size());
+	for (uint i = 0; i < graph->computed.size(); i++)
+		graph->computed[i] = false;
+
+	graphs.push_front(graph);
+	if (graphs.size() > (uint)AvoidPathCache::kMaxGraphs) {
+		delete graphs.back();
+		graphs.pop_back();
+	}
+
+	return graph;
+}
+
 /**
  * Converts the SCI input data for pathfinding
  * Parameters: (EngineState *) s: The game state
@@ -1218,6 +1523,16 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 		return NULL;
 	}
 
+	for (PolygonList::iterator it = pf_s->polygons.begin(); it != pf_s->polygons.end(); ++it) {
+		Vertex *vertex;
+
+		CLIST_FOREACH(vertex, &(*it)->vertices) {
+			pf_s->_graphVertices.push_back(vertex);
+		}
+	}
+
+	pf_s->_graph = lookupVisibilityGraph(s, pf_s);
+
 	if (opt == 0) {
 		// Keyboard support. Only the first edge of the path we compute
 		// here matches the path returned by SSCI. This is assumed to be
@@ -1271,12 +1586,26 @@ static PathfindingState *convert_polygon_set(EngineState *s, reg_t poly_list, Co
 		Vertex *vertex;
 
 		CLIST_FOREACH(vertex, &polygon->vertices) {
+			vertex->index = count;
 			pf_s->vertex_index[count++] = vertex;
 		}
 	}
 
 	pf_s->vertices = count;
 
+	// The cached visibility graph can only be used if the start and end
+	// points became single-vertex polygons (or coincide with existing
+	// vertices). A point which split an edge changes the polygon set.
+	pf_s->_graphOffset = count - pf_s->_graphVertices.size();
+	for (int i = 0; i < count && pf_s->_graph; i++) {
+		if (i < pf_s->_graphOffset) {
+			if (VERTEX_HAS_EDGES(pf_s->vertex_index[i]))
+				pf_s->_graph = NULL;
+		} else if (pf_s->vertex_index[i] != pf_s->_graphVertices[i - pf_s->_graphOffset]) {
+			pf_s->_graph = NULL;
+		}
+	}
+
 	return pf_s;
 }
 
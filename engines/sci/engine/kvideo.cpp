@@ -27,6 +27,7 @@
 #include "sci/graphics/cursor.h"
 #include "sci/graphics/palette.h"
 #include "sci/graphics/screen.h"
+#include "common/config-manager.h"
 #include "common/events.h"
 #include "common/keyboard.h"
 #include "common/str.h"
@@ -36,6 +37,7 @@
 #include "graphics/surface.h"
 #include "video/video_decoder.h"
 #include "video/avi_decoder.h"
+#include "video/prefetching_decoder.h"
 #include "video/qt_decoder.h"
 #include "sci/video/seq_decoder.h"
 #ifdef ENABLE_SCI32
@@ -49,6 +51,10 @@ void playVideo(Video::VideoDecoder *videoDecoder, VideoState videoState) {
 	if (!videoDecoder)
 		return;
 
+	// Optionally decode the frames ahead, off the main loop
+	if (ConfMan.getBool("video_prefetch"))
+		videoDecoder = new Video::PrefetchingVideoDecoder(videoDecoder, DisposeAfterUse::YES, g_system->getWorkerPool());
+
 	byte *scaleBuffer = 0;
 	byte bytesPerPixel = videoDecoder->getPixelFormat().bytesPerPixel;
 	uint16 width = videoDecoder->getWidth();
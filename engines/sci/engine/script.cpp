@@ -61,6 +61,50 @@ void Script::freeScript() {
 	_bufSize = 0;
 
 	_objects.clear();
+	clearInstructionCache();
+}
+
+void Script::clearInstructionCache() {
+	_instructionIndex.clear();
+	_instructions.clear();
+}
+
+const ScriptInstruction &Script::getInstruction(uint16 offset) {
+	if (_instructionIndex.empty())
+		_instructionIndex.resize(_scriptSize);
+
+	const uint16 index = offset < _instructionIndex.size() ? _instructionIndex[offset] : 0;
+	if (index)
+		return _instructions[index - 1];
+
+	ScriptInstruction instruction;
+	instruction.size = readPMachineInstruction(_buf + offset, instruction.extOpcode, instruction.opparams);
+
+	// Resolve the relative operand of branches and local calls once, so
+	// that the VM does not have to add it up each time
+	switch (instruction.extOpcode >> 1) {
+	case op_bt:
+	case op_bnt:
+	case op_jmp:
+	case op_call:
+		instruction.target = offset + instruction.size + instruction.opparams[0];
+		break;
+	default:
+		instruction.target = 0;
+		break;
+	}
+
+	// Only code in the script itself is cached, and the index is limited to
+	// 16 bits. In the unlikely case of a script with more instructions, or
+	// of code running in the heap, the rest is decoded each time.
+	if (offset >= _instructionIndex.size() || _instructions.size() >= 0xFFFF) {
+		_uncachedInstruction = instruction;
+		return _uncachedInstruction;
+	}
+
+	_instructions.push_back(instruction);
+	_instructionIndex[offset] = _instructions.size();
+	return _instructions.back();
 }
 
 void Script::init(int script_nr, ResourceManager *resMan) {
@@ -139,6 +183,7 @@ void Script::load(ResourceManager *resMan) {
 
 	_buf = (byte *)malloc(_bufSize);
 	assert(_buf);
+	clearInstructionCache();
 
 	assert(_bufSize >= script->size);
 	memcpy(_buf, script->data, script->size);
@@ -313,6 +358,8 @@ bool Script::relocateLocal(SegmentId segment, int location) {
 }
 
 void Script::relocateSci0Sci21(reg_t block) {
+	clearInstructionCache();
+
 	const byte *heap = _buf;
 	uint16 heapSize = (uint16)_bufSize;
 	uint16 heapOffset = 0;
@@ -362,6 +409,8 @@ void Script::relocateSci0Sci21(reg_t block) {
 }
 
 void Script::relocateSci3(reg_t block) {
+	clearInstructionCache();
+
 	const byte *relocStart = _buf + READ_SCI11ENDIAN_UINT32(_buf + 8);
 	//int count = _bufSize - READ_SCI11ENDIAN_UINT32(_buf + 8);
 
@@ -48,6 +48,14 @@ enum ScriptObjectTypes {
 
 typedef Common::HashMap<uint16, Object> ObjMap;
 
+/** A decoded instruction, as returned by readPMachineInstruction() */
+struct ScriptInstruction {
+	int16 opparams[4];	/**< The operands */
+	uint16 size;		/**< Size of the instruction in bytes */
+	uint16 target;		/**< Absolute offset jumped to by branches and local calls */
+	byte extOpcode;		/**< The "extended" opcode, with the operand size in the lowest bit */
+};
+
 class Script : public SegmentObj {
 private:
 	int _nr; /**< Script number */
@@ -74,6 +82,19 @@ private:
 
 	ObjMap _objects;	/**< Table for objects, contains property variables */
 
+	/**
+	 * Cache of the instructions decoded so far. For each offset in the
+	 * script (without the heap), _instructionIndex holds the index of the
+	 * instruction starting there in _instructions plus one, or 0 if it has
+	 * not been decoded yet. This costs two bytes per byte of script, plus
+	 * one ScriptInstruction per instruction executed.
+	 */
+	Common::Array<uint16> _instructionIndex;
+	Common::Array<ScriptInstruction> _instructions;
+	ScriptInstruction _uncachedInstruction;
+
+	void clearInstructionCache();
+
 public:
 	int getLocalsOffset() const { return _localsOffset; }
 	uint16 getLocalsCount() const { return _localsCount; }
@@ -83,6 +104,13 @@ public:
 	uint32 getBufSize() const { return _bufSize; }
 	const byte *getBuf(uint offset = 0) const { return _buf + offset; }
 
+	/**
+	 * Returns the instruction at the given offset of the script buffer.
+	 * Instructions are decoded only once, when they are executed the first
+	 * time. The returned reference is only valid until the next call.
+	 */
+	const ScriptInstruction &getInstruction(uint16 offset);
+
 	int getScriptNumber() const { return _nr; }
 	SegmentId getLocalsSegment() const { return _localsSegment; }
 	reg_t *getLocalsBegin() { return _localsBlock ? _localsBlock->_locals.begin() : NULL; }
@@ -36,6 +36,8 @@ namespace Sci {
 //#define GC_DEBUG // Debug garbage collection
 //#define GC_DEBUG_VERBOSE // Debug garbage verbosely
 
+uint32 g_sciAllocationStamp = 0;
+
 SegmentObj *SegmentObj::createSegmentObj(SegmentType type) {
 	SegmentObj *mem = 0;
 	switch (type) {
@@ -128,6 +128,29 @@ public:
 		return Common::Array<reg_t>();
 	}
 
+	/**
+	 * Checks whether the deallocatable addresses of this segment carry
+	 * allocation stamps, so that they can be swept by an incremental
+	 * garbage collection.
+	 * Used by the garbage collector.
+	 */
+	virtual bool hasAllocationStamps() const { return false; }
+
+	/**
+	 * Returns the allocation stamp of the entry at the given address,
+	 * see g_sciAllocationStamp.
+	 * Used by the garbage collector.
+	 */
+	virtual uint32 getAllocationStamp(reg_t sub_addr) const { return 0; }
+
+	/**
+	 * Returns the number of entries of a segment with allocation stamps,
+	 * valid or not. The valid ones are those with a valid offset, so an
+	 * incremental garbage collection can sweep them a few at a time.
+	 * Used by the garbage collector.
+	 */
+	virtual uint getEntryCount() const { return 0; }
+
 	/**
 	 * Iterates over all references reachable from the specified object.
 	 * Used by the garbage collector.
@@ -207,11 +230,23 @@ struct Hunk {
 	const char *type;
 };
 
+/**
+ * Counter which is incremented for every table entry allocation. Each entry
+ * remembers the value at the time of its allocation, which tells the
+ * incremental garbage collector whether an entry is younger than the set of
+ * active references it is sweeping with. The counter may wrap around, so
+ * stamps are only compared by their distance, see run_gc_step().
+ */
+extern uint32 g_sciAllocationStamp;
+
 template<typename T>
 struct SegmentObjTable : public SegmentObj {
 	typedef T value_type;
 	struct Entry : public T {
 		int next_free; /* Only used for free entries */
+		uint32 allocStamp; /* Value of g_sciAllocationStamp at allocation */
+
+		Entry() : next_free(0), allocStamp(0) {}
 	};
 	enum { HEAPENTRY_INVALID = -1 };
 
@@ -239,11 +274,13 @@ public:
 			first_free = _table[oldff].next_free;
 
 			_table[oldff].next_free = oldff;
+			_table[oldff].allocStamp = g_sciAllocationStamp++;
 			return oldff;
 		} else {
 			uint newIdx = _table.size();
 			_table.push_back(Entry());
 			_table[newIdx].next_free = newIdx;	// Tag as 'valid'
+			_table[newIdx].allocStamp = g_sciAllocationStamp++;
 			return newIdx;
 		}
 	}
@@ -272,6 +309,14 @@ public:
 				tmp.push_back(make_reg(segId, i));
 		return tmp;
 	}
+
+	virtual bool hasAllocationStamps() const { return true; }
+
+	virtual uint32 getAllocationStamp(reg_t sub_addr) const {
+		return isValidEntry(sub_addr.offset) ? _table[sub_addr.offset].allocStamp : 0;
+	}
+
+	virtual uint getEntryCount() const { return _table.size(); }
 };
 
 
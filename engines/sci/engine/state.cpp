@@ -26,6 +26,7 @@
 #include "sci/debug.h"	// for g_debug_sleeptime_factor
 #include "sci/event.h"
 
+#include "sci/engine/gc.h"
 #include "sci/engine/kernel.h"
 #include "sci/engine/state.h"
 #include "sci/engine/selector.h"
@@ -68,12 +69,14 @@ static const uint16 s_halfWidthSJISMap[256] = {
 };
 
 EngineState::EngineState(SegManager *segMan)
-: _segMan(segMan), _dirseeker() {
+: _segMan(segMan), _dirseeker(), _gcCycle(0), _avoidPathCache(0) {
 
 	reset(false);
 }
 
 EngineState::~EngineState() {
+	abort_gc(this);
+	freeAvoidPathCache(_avoidPathCache);
 	delete _msgState;
 }
 
@@ -98,6 +101,7 @@ void EngineState::reset(bool isRestoring) {
 	lastWaitTime = 0;
 
 	gcCountDown = 0;
+	abort_gc(this);
 
 	_throttleCounter = 0;
 	_throttleLastTime = 0;
@@ -42,10 +42,15 @@ class WriteStream;
 
 namespace Sci {
 
+struct AvoidPathCache;
 class EventManager;
+struct GCCycle;
 class MessageState;
 class SoundCommandParser;
 
+/** Frees the visibility graphs cached by kAvoidPath */
+void freeAvoidPathCache(AvoidPathCache *cache);
+
 enum AbortGameState {
 	kAbortNone = 0,
 	kAbortLoadGame = 1,
@@ -216,6 +221,9 @@ public:
 	void shrinkStackToBase();
 
 	int gcCountDown; /**< Number of kernel calls until next gc */
+	GCCycle *_gcCycle; /**< Unfinished incremental gc, or NULL */
+
+	AvoidPathCache *_avoidPathCache; /**< Visibility graphs of recent kAvoidPath calls */
 
 	MessageState *_msgState;
 
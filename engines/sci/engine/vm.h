@@ -136,7 +136,8 @@ enum {
 
 /** Number of kernel calls in between gcs; should be < 50000 */
 enum {
-	GC_INTERVAL = 0x8000
+	GC_INTERVAL = 0x8000,
+	GC_STEP_INTERVAL = 0x40 ///< Kernel calls in between the steps of an incremental gc
 };
 
 enum sci_opcodes {
@@ -240,6 +240,8 @@ protected:
 	int32 _fileOffset; /**< Offset in file */
 	ResourceStatus _status;
 	uint16 _lockers; /**< Number of places where this resource was locked */
+	Resource *_lruPrev; /**< Next more recently used resource in the LRU list */
+	Resource *_lruNext; /**< Next less recently used resource in the LRU list */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
 
@@ -254,6 +256,14 @@ protected:
 
 typedef Common::HashMap<ResourceId, Resource *, ResourceIdHash> ResourceMap;
 
+/** Statistics of the cache of unlocked resources, see ResourceManager */
+struct ResourceCacheStats {
+	uint32 hits;		///< Requests for resources which were still loaded
+	uint32 misses;		///< Requests for resources which had to be loaded
+	uint32 evictions;	///< Resources freed to stay within the cache size
+	uint32 evictedBytes;	///< Number of bytes freed by evictions
+};
+
 class ResourceManager {
 	// FIXME: These 'friend' declarations are meant to be a temporary hack to
 	// ease transition to the ResourceSource class system.
@@ -302,6 +312,23 @@ public:
 	 */
 	void unlockResource(Resource *res);
 
+	/**
+	 * Returns the statistics of the cache of unlocked resources.
+	 */
+	const ResourceCacheStats &getCacheStats() const { return _cacheStats; }
+
+	/**
+	 * Returns the maximum number of bytes kept in the cache of unlocked
+	 * resources.
+	 */
+	int getCacheSize() const { return _maxMemoryLRU; }
+
+	/**
+	 * Changes the maximum number of bytes kept in the cache of unlocked
+	 * resources, freeing resources if necessary.
+	 */
+	void setCacheSize(int size);
+
 	/**
 	 * Tests whether a resource exists.
 	 *
@@ -379,19 +406,23 @@ public:
 	ResourceType convertResType(byte type);
 
 protected:
-	// Maximum number of bytes to allow being allocated for resources
-	// Note: maxMemory will not be interpreted as a hard limit, only as a restriction
-	// for resources which are not explicitly locked. However, a warning will be
-	// issued whenever this limit is exceeded.
+	// Default number of bytes to allow being allocated for resources, unless
+	// overridden with the resource_cache_size config key (in KB).
+	// Note: this will not be interpreted as a hard limit, only as a restriction
+	// for resources which are not explicitly locked.
 	enum {
-		MAX_MEMORY = 256 * 1024	// 256KB
+		MAX_MEMORY = 256 * 1024,		// 256KB
+		MAX_MEMORY_SCI32 = 4 * 1024 * 1024	// 4MB, SCI32 views and pics are a lot larger
 	};
 
 	ViewType _viewType; // Used to determine if the game has EGA or VGA graphics
 	Common::List<ResourceSource *> _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
-	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	int _maxMemoryLRU;	///< Amount of resource bytes to keep under LRU control
+	Resource *_lruFirst;	///< Most recently used resource under LRU control
+	Resource *_lruLast;	///< Least recently used resource under LRU control
+	ResourceCacheStats _cacheStats;
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
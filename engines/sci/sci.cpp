@@ -195,6 +195,7 @@ Common::Error SciEngine::run() {
 	ConfMan.registerDefault("native_fb01", "false");
 	ConfMan.registerDefault("windows_cursors", "false");	// Windows cursors for KQ6 Windows
 	ConfMan.registerDefault("silver_cursors", "false");	// Silver cursors for SQ4 CD
+	ConfMan.registerDefault("video_prefetch", "false");	// Decode videos ahead on the worker pool
 
 	_resMan = new ResourceManager();
 	assert(_resMan);
@@ -574,17 +574,39 @@ void JPEGDecoder::idct1D8x8(int32 src[8], int32 dest[64], int32 ps, int32 half)
 	dest[7 * 8] = (src[0] - src[1]) >> ps;
 }
 
+// A 1D IDCT of a row without AC coefficients, which most rows are after
+// quantization. idct1D8x8() gives ((src[0] << 9) + half) >> ps for every
+// element of such a row, as all other terms are zero.
+static inline bool idctRowIsDC(const int32 src[8]) {
+	return !(src[1] | src[2] | src[3] | src[4] | src[5] | src[6] | src[7]);
+}
+
+static inline void idctDC1D8x8(const int32 src[8], int32 dest[64], int32 ps, int32 half) {
+	const int32 dc = ((src[0] << 9) + half) >> ps;
+	for (int i = 0; i < 8; i++)
+		dest[i * 8] = dc;
+}
+
 void JPEGDecoder::idct2D8x8(int32 block[64]) {
 	int32 tmp[64];
 
 	// Apply 1D IDCT to rows
-	for (int i = 0; i < 8; i++)
-		idct1D8x8(&block[i * 8], &tmp[i], 9, 1 << 8);
+	for (int i = 0; i < 8; i++) {
+		if (idctRowIsDC(&block[i * 8]))
+			idctDC1D8x8(&block[i * 8], &tmp[i], 9, 1 << 8);
+		else
+			idct1D8x8(&block[i * 8], &tmp[i], 9, 1 << 8);
+	}
 
-	// Apply 1D IDCT to columns
-	for (int i = 0; i < 8; i++)
-		idct1D8x8(&tmp[i * 8], &block[i], 12, 1 << 11);
- }
+	// Apply 1D IDCT to columns. If the rows only had DC coefficients, so do
+	// all of these.
+	for (int i = 0; i < 8; i++) {
+		if (idctRowIsDC(&tmp[i * 8]))
+			idctDC1D8x8(&tmp[i * 8], &block[i], 12, 1 << 11);
+		else
+			idct1D8x8(&tmp[i * 8], &block[i], 12, 1 << 11);
+	}
+}
 
 bool JPEGDecoder::readDataUnit(uint16 x, uint16 y) {
 	// Prepare an empty data array
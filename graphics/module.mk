@@ -53,6 +53,9 @@ ifdef USE_NASM
 MODULE_OBJS += \
 	scaler/hq2x_i386.o \
 	scaler/hq3x_i386.o
+else
+MODULE_OBJS += \
+	scaler/hqx_pattern.o
 endif
 
 endif
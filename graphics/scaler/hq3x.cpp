@@ -21,6 +21,7 @@
  */
 
 #include "graphics/scaler/intern.h"
+#include "graphics/scaler/hqx_pattern.h"
 
 #ifdef USE_NASM
 // Assembly version of HQ3x
@@ -126,7 +127,16 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 	//	 | w7 | w8 | w9 |
 	//	 +----+----+----+
 
+	// The neighbourhood patterns of each row are computed ahead, up to
+	// kHQPatternChunkWidth pixels at a time, by vectorized code where
+	// possible
+	const HQPatternProc patternProc = getHQPatternProc();
+	uint8 patterns[kHQPatternChunkWidth];
+
 	while (height--) {
+		const uint8 *pat = patterns;
+		const uint8 *patEnd = patterns;
+
 		w1 = *(p - 1 - nextlineSrc);
 		w4 = *(p - 1);
 		w7 = *(p - 1 + nextlineSrc);
@@ -136,23 +146,22 @@ static void HQ3x_implementation(const uint8 *srcPtr, uint32 srcPitch, uint8 *dst
 		w8 = *(p + nextlineSrc);
 
 		int tmpWidth = width;
-		while (tmpWidth--) {
+		while (tmpWidth) {
+			if (pat == patEnd) {
+				const int count = tmpWidth < kHQPatternChunkWidth ? tmpWidth : (int)kHQPatternChunkWidth;
+				patternProc(p, srcPitch, count, patterns);
+				pat = patterns;
+				patEnd = patterns + count;
+			}
+			tmpWidth--;
+
 			p++;
 
 			w3 = *(p - nextlineSrc);
 			w6 = *(p);
 			w9 = *(p + nextlineSrc);
 
-			int pattern = 0;
-			const int yuv5 = YUV(5);
-			if (w5 != w1 && diffYUV(yuv5, YUV(1))) pattern |= 0x0001;
-			if (w5 != w2 && diffYUV(yuv5, YUV(2))) pattern |= 0x0002;
-			if (w5 != w3 && diffYUV(yuv5, YUV(3))) pattern |= 0x0004;
-			if (w5 != w4 && diffYUV(yuv5, YUV(4))) pattern |= 0x0008;
-			if (w5 != w6 && diffYUV(yuv5, YUV(6))) pattern |= 0x0010;
-			if (w5 != w7 && diffYUV(yuv5, YUV(7))) pattern |= 0x0020;
-			if (w5 != w8 && diffYUV(yuv5, YUV(8))) pattern |= 0x0040;
-			if (w5 != w9 && diffYUV(yuv5, YUV(9))) pattern |= 0x0080;
+			const int pattern = *pat++;
 
 			switch (pattern) {
 			case 0:
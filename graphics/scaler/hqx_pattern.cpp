@@ -0,0 +1,247 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_AVX2
+#include <immintrin.h>
+#endif
+
+#include "graphics/scaler/hqx_pattern.h"
+#include "graphics/scaler/intern.h"
+#include "common/endian.h"
+#include "common/util.h"
+
+extern "C" uint32 *RGBtoYUV;
+
+/*
+ * The vectorized versions compute the same patterns as diffYUV() does:
+ * the Y, U and V components are stored in separate bytes of the RGBtoYUV
+ * entries (the top byte is always zero), so the absolute difference of
+ * each component can be formed with saturating byte subtractions and
+ * compared against the per component thresholds the same way.
+ */
+
+static inline int computePatternScalar(const uint16 *p, uint32 nextlineSrc) {
+	const int w1 = *(p - 1 - nextlineSrc);
+	const int w2 = *(p - nextlineSrc);
+	const int w3 = *(p + 1 - nextlineSrc);
+	const int w4 = *(p - 1);
+	const int w5 = *(p);
+	const int w6 = *(p + 1);
+	const int w7 = *(p - 1 + nextlineSrc);
+	const int w8 = *(p + nextlineSrc);
+	const int w9 = *(p + 1 + nextlineSrc);
+
+	int pattern = 0;
+	const int yuv5 = RGBtoYUV[w5];
+	if (w5 != w1 && diffYUV(yuv5, RGBtoYUV[w1])) pattern |= 0x0001;
+	if (w5 != w2 && diffYUV(yuv5, RGBtoYUV[w2])) pattern |= 0x0002;
+	if (w5 != w3 && diffYUV(yuv5, RGBtoYUV[w3])) pattern |= 0x0004;
+	if (w5 != w4 && diffYUV(yuv5, RGBtoYUV[w4])) pattern |= 0x0008;
+	if (w5 != w6 && diffYUV(yuv5, RGBtoYUV[w6])) pattern |= 0x0010;
+	if (w5 != w7 && diffYUV(yuv5, RGBtoYUV[w7])) pattern |= 0x0020;
+	if (w5 != w8 && diffYUV(yuv5, RGBtoYUV[w8])) pattern |= 0x0040;
+	if (w5 != w9 && diffYUV(yuv5, RGBtoYUV[w9])) pattern |= 0x0080;
+	return pattern;
+}
+
+static void computePatternsScalar(const uint16 *src, uint32 srcPitch, int width, uint8 *patterns) {
+	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
+
+	for (int x = 0; x < width; ++x)
+		patterns[x] = computePatternScalar(src + x, nextlineSrc);
+}
+
+#ifdef SCUMMVM_SSE2
+
+/** Bytes 0-2 of each lane hold the V, U and Y thresholds used by diffYUV() */
+#define HQ_YUV_THRESHOLDS 0x00300706
+
+/**
+ * Return a mask with all bits of a 32 bit lane set if the pixels differ
+ * and their YUV values differ noticeably.
+ */
+SCUMMVM_TARGET_SSE2 static inline __m128i diffMaskSSE2(__m128i w5, __m128i yuv5, __m128i w, __m128i yuv) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i absDiff = _mm_or_si128(_mm_subs_epu8(yuv5, yuv), _mm_subs_epu8(yuv, yuv5));
+	const __m128i over = _mm_subs_epu8(absDiff, _mm_set1_epi32(HQ_YUV_THRESHOLDS));
+	const __m128i similar = _mm_or_si128(_mm_cmpeq_epi32(over, zero), _mm_cmpeq_epi32(w5, w));
+	return _mm_andnot_si128(similar, _mm_set1_epi32(-1));
+}
+
+SCUMMVM_TARGET_SSE2 static inline __m128i loadPixelsSSE2(const uint16 *p) {
+	return _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+}
+
+SCUMMVM_TARGET_SSE2 static void computePatternsSSE2(const uint16 *src, uint32 srcPitch, int width, uint8 *patterns) {
+	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
+	const uint32 *yuvTable = RGBtoYUV;
+
+	// The YUV values of the three rows, for columns x - 1 to x + 4
+	uint32 yuv[3][6];
+	int x = 0;
+
+	if (width >= 4) {
+		for (int row = 0; row < 3; ++row) {
+			const uint16 *p = src + (row - 1) * (int)nextlineSrc;
+			yuv[row][4] = yuvTable[p[-1]];
+			yuv[row][5] = yuvTable[p[0]];
+		}
+	}
+
+	for (; x + 4 <= width; x += 4) {
+		__m128i w[9], y[9];
+
+		for (int row = 0; row < 3; ++row) {
+			const uint16 *p = src + x + (row - 1) * (int)nextlineSrc;
+			uint32 *r = yuv[row];
+
+			r[0] = r[4];
+			r[1] = r[5];
+			r[2] = yuvTable[p[1]];
+			r[3] = yuvTable[p[2]];
+			r[4] = yuvTable[p[3]];
+			r[5] = yuvTable[p[4]];
+
+			w[row * 3 + 0] = loadPixelsSSE2(p - 1);
+			w[row * 3 + 1] = loadPixelsSSE2(p);
+			w[row * 3 + 2] = loadPixelsSSE2(p + 1);
+			y[row * 3 + 0] = _mm_loadu_si128((const __m128i *)(r + 0));
+			y[row * 3 + 1] = _mm_loadu_si128((const __m128i *)(r + 1));
+			y[row * 3 + 2] = _mm_loadu_si128((const __m128i *)(r + 2));
+		}
+
+		__m128i pattern;
+		pattern = _mm_and_si128(diffMaskSSE2(w[4], y[4], w[0], y[0]), _mm_set1_epi32(0x01));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffMaskSSE2(w[4], y[4], w[1], y[1]), _mm_set1_epi32(0x02)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffMaskSSE2(w[4], y[4], w[2], y[2]), _mm_set1_epi32(0x04)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffMaskSSE2(w[4], y[4], w[3], y[3]), _mm_set1_epi32(0x08)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffMaskSSE2(w[4], y[4], w[5], y[5]), _mm_set1_epi32(0x10)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffMaskSSE2(w[4], y[4], w[6], y[6]), _mm_set1_epi32(0x20)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffMaskSSE2(w[4], y[4], w[7], y[7]), _mm_set1_epi32(0x40)));
+		pattern = _mm_or_si128(pattern, _mm_and_si128(diffMaskSSE2(w[4], y[4], w[8], y[8]), _mm_set1_epi32(0x80)));
+
+		pattern = _mm_packs_epi32(pattern, pattern);
+		pattern = _mm_packus_epi16(pattern, pattern);
+		WRITE_UINT32(patterns + x, (uint32)_mm_cvtsi128_si32(pattern));
+	}
+
+	for (; x < width; ++x)
+		patterns[x] = computePatternScalar(src + x, nextlineSrc);
+}
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_AVX2
+
+SCUMMVM_TARGET_AVX2 static inline __m256i diffMaskAVX2(__m256i w5, __m256i yuv5, __m256i w, __m256i yuv) {
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i absDiff = _mm256_or_si256(_mm256_subs_epu8(yuv5, yuv), _mm256_subs_epu8(yuv, yuv5));
+	const __m256i over = _mm256_subs_epu8(absDiff, _mm256_set1_epi32(HQ_YUV_THRESHOLDS));
+	const __m256i similar = _mm256_or_si256(_mm256_cmpeq_epi32(over, zero), _mm256_cmpeq_epi32(w5, w));
+	return _mm256_andnot_si256(similar, _mm256_set1_epi32(-1));
+}
+
+SCUMMVM_TARGET_AVX2 static void computePatternsAVX2(const uint16 *src, uint32 srcPitch, int width, uint8 *patterns) {
+	const uint32 nextlineSrc = srcPitch / sizeof(uint16);
+	const int *yuvTable = (const int *)RGBtoYUV;
+	int x = 0;
+
+	for (; x + 8 <= width; x += 8) {
+		__m256i w[9], y[9];
+
+		for (int row = 0; row < 3; ++row) {
+			const uint16 *p = src + x + (row - 1) * (int)nextlineSrc;
+
+			for (int col = 0; col < 3; ++col) {
+				const int i = row * 3 + col;
+				w[i] = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p + col - 1)));
+				y[i] = _mm256_i32gather_epi32(yuvTable, w[i], 4);
+			}
+		}
+
+		__m256i pattern;
+		pattern = _mm256_and_si256(diffMaskAVX2(w[4], y[4], w[0], y[0]), _mm256_set1_epi32(0x01));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffMaskAVX2(w[4], y[4], w[1], y[1]), _mm256_set1_epi32(0x02)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffMaskAVX2(w[4], y[4], w[2], y[2]), _mm256_set1_epi32(0x04)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffMaskAVX2(w[4], y[4], w[3], y[3]), _mm256_set1_epi32(0x08)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffMaskAVX2(w[4], y[4], w[5], y[5]), _mm256_set1_epi32(0x10)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffMaskAVX2(w[4], y[4], w[6], y[6]), _mm256_set1_epi32(0x20)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffMaskAVX2(w[4], y[4], w[7], y[7]), _mm256_set1_epi32(0x40)));
+		pattern = _mm256_or_si256(pattern, _mm256_and_si256(diffMaskAVX2(w[4], y[4], w[8], y[8]), _mm256_set1_epi32(0x80)));
+
+		// Narrow the eight 32 bit lanes down to bytes
+		__m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(pattern), _mm256_extracti128_si256(pattern, 1));
+		packed = _mm_packus_epi16(packed, packed);
+		_mm_storel_epi64((__m128i *)(patterns + x), packed);
+	}
+
+	for (; x < width; ++x)
+		patterns[x] = computePatternScalar(src + x, nextlineSrc);
+}
+
+#endif // SCUMMVM_AVX2
+
+HQPatternProc getHQPatternProc(HQPatternImpl impl) {
+	switch (impl) {
+	case kHQPatternScalar:
+		return &computePatternsScalar;
+
+#ifdef SCUMMVM_SSE2
+	case kHQPatternSSE2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+			return &computePatternsSSE2;
+		break;
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kHQPatternAVX2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+			return &computePatternsAVX2;
+		break;
+#endif
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+HQPatternProc getHQPatternProc() {
+	static const HQPatternImpl preferred[] = {
+		kHQPatternAVX2,
+		kHQPatternSSE2
+	};
+
+	for (int i = 0; i < ARRAYSIZE(preferred); ++i) {
+		HQPatternProc proc = getHQPatternProc(preferred[i]);
+		if (proc)
+			return proc;
+	}
+
+	return &computePatternsScalar;
+}
@@ -0,0 +1,70 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_SCALER_HQX_PATTERN_H
+#define GRAPHICS_SCALER_HQX_PATTERN_H
+
+#include "common/scummsys.h"
+
+/**
+ * Compute the HQx neighbourhood patterns for one row of 16 bit pixels.
+ *
+ * For each of the width pixels starting at src, bit n of the pattern is
+ * set if the pixel differs noticeably (as decided by diffYUV) from its
+ * n-th neighbour, counting row by row from the top left neighbour and
+ * skipping the pixel itself. The pixels around the row, i.e. the row
+ * above and below and one column left and right, are read as well.
+ *
+ * The YUV values are taken from the RGBtoYUV table, so InitLUT() must have
+ * been called before.
+ */
+typedef void (*HQPatternProc)(const uint16 *src, uint32 srcPitch, int width, uint8 *patterns);
+
+enum {
+	/**
+	 * Number of pixels the scalers compute the patterns of at a time, into
+	 * a buffer on the stack. Rows which are wider are done in several parts.
+	 */
+	kHQPatternChunkWidth = 256
+};
+
+enum HQPatternImpl {
+	kHQPatternScalar,
+	kHQPatternSSE2,
+	kHQPatternAVX2,
+
+	kHQPatternImplCount
+};
+
+/**
+ * Return the pattern routine using a specific implementation, or 0 if it
+ * is not available on this build or CPU. kHQPatternScalar is always
+ * available; it is the reference the vectorized versions have to match.
+ */
+HQPatternProc getHQPatternProc(HQPatternImpl impl);
+
+/**
+ * Return the fastest pattern routine available.
+ */
+HQPatternProc getHQPatternProc();
+
+#endif
@@ -83,10 +83,25 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/cpudetect.h"
+
+#ifdef SCUMMVM_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef SCUMMVM_AVX2
+#include <immintrin.h>
+#endif
+#ifdef SCUMMVM_NEON
+#include <arm_neon.h>
+#endif
+
 #include "common/scummsys.h"
+#include "common/endian.h"
 #include "common/singleton.h"
+#include "common/util.h"
 
 #include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
 
 namespace Graphics {
 
@@ -229,21 +244,6 @@ void convertYUV444ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 	}
 }
 
-void convertYUV444ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
-	// Sanity checks
-	assert(dst && dst->pixels);
-	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
-	assert(ySrc && uSrc && vSrc);
-
-	const YUVToRGBLookup *lookup = YUVToRGBMan.getLookup(dst->format);
-
-	// Use a templated function to avoid an if check on every pixel
-	if (dst->format.bytesPerPixel == 2)
-		convertYUV444ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
-	else
-		convertYUV444ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
-}
-
 template<typename PixelInt>
 void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	int halfHeight = yHeight >> 1;
@@ -276,29 +276,13 @@ void convertYUV420ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 			dstPtr += sizeof(PixelInt);
 		}
 
-		dstPtr += dstPitch;
+		dstPtr += (dstPitch << 1) - yWidth * sizeof(PixelInt);
 		ySrc += (yPitch << 1) - yWidth;
 		uSrc += uvPitch - halfWidth;
 		vSrc += uvPitch - halfWidth;
 	}
 }
 
-void convertYUV420ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
-	// Sanity checks
-	assert(dst && dst->pixels);
-	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
-	assert(ySrc && uSrc && vSrc);
-	assert((yWidth & 1) == 0);
-	assert((yHeight & 1) == 0);
-
-	const YUVToRGBLookup *lookup = YUVToRGBMan.getLookup(dst->format);
-
-	// Use a templated function to avoid an if check on every pixel
-	if (dst->format.bytesPerPixel == 2)
-		convertYUV420ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
-	else
-		convertYUV420ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
-}
 
 #define READ_QUAD(ptr, prefix) \
 	byte prefix##A = ptr[index]; \
@@ -368,16 +352,644 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 #undef DO_INTERPOLATION
 #undef DO_YUV410_PIXEL
 
+/*
+ * The vectorized converters. The lookup tables store trunc(coef * c) for
+ * each chroma value c = u - 128 resp. v - 128. With a = |c| <= 128 this is
+ * exactly a * intPart + ((a * frac) >> 16) with the sign of c restored, for
+ * the 16 bit fractions below; they were found by checking all 256 values.
+ * Together with clamping the channel sums to 0..255 and packing them with
+ * the PixelFormat's shifts, this gives bit-identical pixels without any
+ * per-pixel table lookups.
+ */
+
+enum {
+	kCrRFrac = 26277, // 0.419 / 0.299 = 1 + 26277 / 65536
+	kCrGFrac = 46773, // 0.299 / 0.419 (negated)
+	kCbGFrac = 22567, // 0.114 / 0.331 (negated)
+	kCbBFrac = 50684  // 0.587 / 0.331 = 1 + 50684 / 65536
+};
+
+/**
+ * The format of the destination pixels, split into the parts the
+ * vectorized converters need. The lookup is used for the pixels at the
+ * end of a row which do not fill a whole vector.
+ */
+struct YUVToRGBRowFormat {
+	YUVToRGBRowFormat(const Graphics::PixelFormat &format, const YUVToRGBLookup *lookup_) :
+		lookup(lookup_),
+		rLoss(format.rLoss), gLoss(format.gLoss), bLoss(format.bLoss),
+		rShift(format.rShift), gShift(format.gShift), bShift(format.bShift),
+		alpha(format.RGBToColor(0, 0, 0)) {
+	}
+
+	const YUVToRGBLookup *lookup;
+	int rLoss, gLoss, bLoss;
+	int rShift, gShift, bShift;
+	uint32 alpha;
+};
+
+/**
+ * Convert width pixels of one row. With halfChroma, two rows are converted
+ * which share their chroma, and each chroma sample also covers two
+ * horizontally adjacent pixels, like in 420.
+ */
+typedef void (*YUVToRGBRowProc)(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowFormat &format);
+
+template<typename PixelInt, bool halfChroma>
+static void convertRowScalar(byte *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int x, int width, const YUVToRGBLookup *lookup) {
+	const int16 *Cr_r_tab = lookup->_colorTab;
+	const int16 *Cr_g_tab = Cr_r_tab + 256;
+	const int16 *Cb_g_tab = Cr_g_tab + 256;
+	const int16 *Cb_b_tab = Cb_g_tab + 256;
+	const uint32 *rgbToPix = lookup->_rgbToPix;
+
+	for (; x < width; x++) {
+		const uint32 *L;
+		const int c = halfChroma ? (x >> 1) : x;
+
+		int16 cr_r  = Cr_r_tab[vSrc[c]];
+		int16 crb_g = Cr_g_tab[vSrc[c]] + Cb_g_tab[uSrc[c]];
+		int16 cb_b  = Cb_b_tab[uSrc[c]];
+
+		PUT_PIXEL(ySrc[x], dst + x * sizeof(PixelInt));
+	}
+}
+
+template<typename PixelInt, bool halfChroma>
+static void convertRowsScalar(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int x, int width, const YUVToRGBLookup *lookup) {
+	convertRowScalar<PixelInt, halfChroma>(dst, ySrc, uSrc, vSrc, x, width, lookup);
+	if (halfChroma)
+		convertRowScalar<PixelInt, halfChroma>(dst + dstPitch, ySrc + yPitch, uSrc, vSrc, x, width, lookup);
+}
+
+#ifdef SCUMMVM_SSE2
+
+struct YUVToRGBPackingSSE2 {
+	__m128i rLoss, rShift, gLoss, gShift, bLoss, bShift, alpha;
+};
+
+SCUMMVM_TARGET_SSE2 static inline __m128i scaleChromaSSE2(__m128i c, int frac, bool intPart) {
+	const __m128i sign = _mm_srai_epi16(c, 15);
+	const __m128i a = _mm_sub_epi16(_mm_xor_si128(c, sign), sign);
+	__m128i t = _mm_mulhi_epu16(a, _mm_set1_epi16((int16)frac));
+	if (intPart)
+		t = _mm_add_epi16(t, a);
+	return _mm_sub_epi16(_mm_xor_si128(t, sign), sign);
+}
+
+/**
+ * Compute the chroma terms of the red, green and blue channels from eight
+ * u and v values, which are zero extended to 16 bits.
+ */
+SCUMMVM_TARGET_SSE2 static inline void computeChromaSSE2(__m128i u, __m128i v, __m128i &crR, __m128i &crbG, __m128i &cbB) {
+	u = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	v = _mm_sub_epi16(v, _mm_set1_epi16(128));
+	crR = scaleChromaSSE2(v, kCrRFrac, true);
+	crbG = _mm_sub_epi16(_mm_setzero_si128(), _mm_add_epi16(scaleChromaSSE2(v, kCrGFrac, false), scaleChromaSSE2(u, kCbGFrac, false)));
+	cbB = scaleChromaSSE2(u, kCbBFrac, true);
+}
+
+SCUMMVM_TARGET_SSE2 static inline __m128i clampChannelSSE2(__m128i x) {
+	return _mm_min_epi16(_mm_max_epi16(x, _mm_setzero_si128()), _mm_set1_epi16(255));
+}
+
+/** Store eight pixels, from the luma in ySrc and the given chroma terms. */
+template<typename PixelInt>
+SCUMMVM_TARGET_SSE2 static inline void putPixelsSSE2(byte *dst, const byte *ySrc, __m128i crR, __m128i crbG, __m128i cbB, const YUVToRGBPackingSSE2 &packing) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)ySrc), zero);
+	const __m128i r = clampChannelSSE2(_mm_add_epi16(y, crR));
+	const __m128i g = clampChannelSSE2(_mm_add_epi16(y, crbG));
+	const __m128i b = clampChannelSSE2(_mm_add_epi16(y, cbB));
+
+	if (sizeof(PixelInt) == 2) {
+		__m128i pixels = packing.alpha;
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(r, packing.rLoss), packing.rShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(g, packing.gLoss), packing.gShift));
+		pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(b, packing.bLoss), packing.bShift));
+		_mm_storeu_si128((__m128i *)dst, pixels);
+	} else {
+		__m128i lo = packing.alpha, hi = packing.alpha;
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(r, zero), packing.rLoss), packing.rShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(r, zero), packing.rLoss), packing.rShift));
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(g, zero), packing.gLoss), packing.gShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(g, zero), packing.gLoss), packing.gShift));
+		lo = _mm_or_si128(lo, _mm_sll_epi32(_mm_srl_epi32(_mm_unpacklo_epi16(b, zero), packing.bLoss), packing.bShift));
+		hi = _mm_or_si128(hi, _mm_sll_epi32(_mm_srl_epi32(_mm_unpackhi_epi16(b, zero), packing.bLoss), packing.bShift));
+		_mm_storeu_si128((__m128i *)dst, lo);
+		_mm_storeu_si128((__m128i *)(dst + 16), hi);
+	}
+}
+
+template<typename PixelInt, bool halfChroma>
+SCUMMVM_TARGET_SSE2 static void convertRowSSE2(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowFormat &format) {
+	const __m128i zero = _mm_setzero_si128();
+
+	YUVToRGBPackingSSE2 packing;
+	packing.rLoss = _mm_cvtsi32_si128(format.rLoss);
+	packing.rShift = _mm_cvtsi32_si128(format.rShift);
+	packing.gLoss = _mm_cvtsi32_si128(format.gLoss);
+	packing.gShift = _mm_cvtsi32_si128(format.gShift);
+	packing.bLoss = _mm_cvtsi32_si128(format.bLoss);
+	packing.bShift = _mm_cvtsi32_si128(format.bShift);
+	packing.alpha = (sizeof(PixelInt) == 2) ? _mm_set1_epi16((int16)format.alpha) : _mm_set1_epi32(format.alpha);
+
+	int x = 0;
+	if (halfChroma) {
+		// Eight chroma samples cover 16 pixels in each of the two rows
+		for (; x + 16 <= width; x += 16) {
+			const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uSrc + (x >> 1))), zero);
+			const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vSrc + (x >> 1))), zero);
+			__m128i crR, crbG, cbB;
+			computeChromaSSE2(u, v, crR, crbG, cbB);
+
+			const __m128i crR0 = _mm_unpacklo_epi16(crR, crR), crR1 = _mm_unpackhi_epi16(crR, crR);
+			const __m128i crbG0 = _mm_unpacklo_epi16(crbG, crbG), crbG1 = _mm_unpackhi_epi16(crbG, crbG);
+			const __m128i cbB0 = _mm_unpacklo_epi16(cbB, cbB), cbB1 = _mm_unpackhi_epi16(cbB, cbB);
+
+			byte *dst0 = dst + x * sizeof(PixelInt);
+			const byte *y0 = ySrc + x;
+			putPixelsSSE2<PixelInt>(dst0, y0, crR0, crbG0, cbB0, packing);
+			putPixelsSSE2<PixelInt>(dst0 + 8 * sizeof(PixelInt), y0 + 8, crR1, crbG1, cbB1, packing);
+			putPixelsSSE2<PixelInt>(dst0 + dstPitch, y0 + yPitch, crR0, crbG0, cbB0, packing);
+			putPixelsSSE2<PixelInt>(dst0 + dstPitch + 8 * sizeof(PixelInt), y0 + yPitch + 8, crR1, crbG1, cbB1, packing);
+		}
+	} else {
+		for (; x + 8 <= width; x += 8) {
+			const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(uSrc + x)), zero);
+			const __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(vSrc + x)), zero);
+			__m128i crR, crbG, cbB;
+			computeChromaSSE2(u, v, crR, crbG, cbB);
+			putPixelsSSE2<PixelInt>(dst + x * sizeof(PixelInt), ySrc + x, crR, crbG, cbB, packing);
+		}
+	}
+
+	convertRowsScalar<PixelInt, halfChroma>(dst, dstPitch, ySrc, yPitch, uSrc, vSrc, x, width, format.lookup);
+}
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_AVX2
+
+struct YUVToRGBPackingAVX2 {
+	__m128i rLoss, rShift, gLoss, gShift, bLoss, bShift;
+	__m256i alpha;
+};
+
+SCUMMVM_TARGET_AVX2 static inline __m256i scaleChromaAVX2(__m256i c, int frac, bool intPart) {
+	const __m256i a = _mm256_abs_epi16(c);
+	__m256i t = _mm256_mulhi_epu16(a, _mm256_set1_epi16((int16)frac));
+	if (intPart)
+		t = _mm256_add_epi16(t, a);
+	// t is 0 wherever c is, so the sign can be applied directly
+	return _mm256_sign_epi16(t, c);
+}
+
+SCUMMVM_TARGET_AVX2 static inline void computeChromaAVX2(__m256i u, __m256i v, __m256i &crR, __m256i &crbG, __m256i &cbB) {
+	u = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+	v = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+	crR = scaleChromaAVX2(v, kCrRFrac, true);
+	crbG = _mm256_sub_epi16(_mm256_setzero_si256(), _mm256_add_epi16(scaleChromaAVX2(v, kCrGFrac, false), scaleChromaAVX2(u, kCbGFrac, false)));
+	cbB = scaleChromaAVX2(u, kCbBFrac, true);
+}
+
+SCUMMVM_TARGET_AVX2 static inline __m256i clampChannelAVX2(__m256i x) {
+	return _mm256_min_epi16(_mm256_max_epi16(x, _mm256_setzero_si256()), _mm256_set1_epi16(255));
+}
+
+SCUMMVM_TARGET_AVX2 static inline __m256i packChannelAVX2(__m128i c, __m128i loss, __m128i shift) {
+	return _mm256_sll_epi32(_mm256_srl_epi32(_mm256_cvtepu16_epi32(c), loss), shift);
+}
+
+/** Store 16 pixels, from the luma in ySrc and the given chroma terms. */
+template<typename PixelInt>
+SCUMMVM_TARGET_AVX2 static inline void putPixelsAVX2(byte *dst, const byte *ySrc, __m256i crR, __m256i crbG, __m256i cbB, const YUVToRGBPackingAVX2 &packing) {
+	const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)ySrc));
+	const __m256i r = clampChannelAVX2(_mm256_add_epi16(y, crR));
+	const __m256i g = clampChannelAVX2(_mm256_add_epi16(y, crbG));
+	const __m256i b = clampChannelAVX2(_mm256_add_epi16(y, cbB));
+
+	if (sizeof(PixelInt) == 2) {
+		__m256i pixels = packing.alpha;
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(_mm256_srl_epi16(r, packing.rLoss), packing.rShift));
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(_mm256_srl_epi16(g, packing.gLoss), packing.gShift));
+		pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(_mm256_srl_epi16(b, packing.bLoss), packing.bShift));
+		_mm256_storeu_si256((__m256i *)dst, pixels);
+	} else {
+		// Widening keeps the pixel order, unlike the per lane unpacks
+		__m256i lo = packing.alpha, hi = packing.alpha;
+		lo = _mm256_or_si256(lo, packChannelAVX2(_mm256_castsi256_si128(r), packing.rLoss, packing.rShift));
+		hi = _mm256_or_si256(hi, packChannelAVX2(_mm256_extracti128_si256(r, 1), packing.rLoss, packing.rShift));
+		lo = _mm256_or_si256(lo, packChannelAVX2(_mm256_castsi256_si128(g), packing.gLoss, packing.gShift));
+		hi = _mm256_or_si256(hi, packChannelAVX2(_mm256_extracti128_si256(g, 1), packing.gLoss, packing.gShift));
+		lo = _mm256_or_si256(lo, packChannelAVX2(_mm256_castsi256_si128(b), packing.bLoss, packing.bShift));
+		hi = _mm256_or_si256(hi, packChannelAVX2(_mm256_extracti128_si256(b, 1), packing.bLoss, packing.bShift));
+		_mm256_storeu_si256((__m256i *)dst, lo);
+		_mm256_storeu_si256((__m256i *)(dst + 32), hi);
+	}
+}
+
+template<typename PixelInt, bool halfChroma>
+SCUMMVM_TARGET_AVX2 static void convertRowAVX2(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowFormat &format) {
+	YUVToRGBPackingAVX2 packing;
+	packing.rLoss = _mm_cvtsi32_si128(format.rLoss);
+	packing.rShift = _mm_cvtsi32_si128(format.rShift);
+	packing.gLoss = _mm_cvtsi32_si128(format.gLoss);
+	packing.gShift = _mm_cvtsi32_si128(format.gShift);
+	packing.bLoss = _mm_cvtsi32_si128(format.bLoss);
+	packing.bShift = _mm_cvtsi32_si128(format.bShift);
+	packing.alpha = (sizeof(PixelInt) == 2) ? _mm256_set1_epi16((int16)format.alpha) : _mm256_set1_epi32(format.alpha);
+
+	int x = 0;
+	if (halfChroma) {
+		// 16 chroma samples cover 32 pixels in each of the two rows
+		for (; x + 32 <= width; x += 32) {
+			const __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(uSrc + (x >> 1))));
+			const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(vSrc + (x >> 1))));
+			__m256i crR, crbG, cbB;
+			computeChromaAVX2(u, v, crR, crbG, cbB);
+
+			// Order the 64 bit blocks as 0, 2, 1, 3, so that the per lane
+			// unpacks yield the chroma of pixels 0-15 resp. 16-31
+			crR = _mm256_permute4x64_epi64(crR, 0xD8);
+			crbG = _mm256_permute4x64_epi64(crbG, 0xD8);
+			cbB = _mm256_permute4x64_epi64(cbB, 0xD8);
+			const __m256i crR0 = _mm256_unpacklo_epi16(crR, crR), crR1 = _mm256_unpackhi_epi16(crR, crR);
+			const __m256i crbG0 = _mm256_unpacklo_epi16(crbG, crbG), crbG1 = _mm256_unpackhi_epi16(crbG, crbG);
+			const __m256i cbB0 = _mm256_unpacklo_epi16(cbB, cbB), cbB1 = _mm256_unpackhi_epi16(cbB, cbB);
+
+			byte *dst0 = dst + x * sizeof(PixelInt);
+			const byte *y0 = ySrc + x;
+			putPixelsAVX2<PixelInt>(dst0, y0, crR0, crbG0, cbB0, packing);
+			putPixelsAVX2<PixelInt>(dst0 + 16 * sizeof(PixelInt), y0 + 16, crR1, crbG1, cbB1, packing);
+			putPixelsAVX2<PixelInt>(dst0 + dstPitch, y0 + yPitch, crR0, crbG0, cbB0, packing);
+			putPixelsAVX2<PixelInt>(dst0 + dstPitch + 16 * sizeof(PixelInt), y0 + yPitch + 16, crR1, crbG1, cbB1, packing);
+		}
+	} else {
+		for (; x + 16 <= width; x += 16) {
+			const __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(uSrc + x)));
+			const __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(vSrc + x)));
+			__m256i crR, crbG, cbB;
+			computeChromaAVX2(u, v, crR, crbG, cbB);
+			putPixelsAVX2<PixelInt>(dst + x * sizeof(PixelInt), ySrc + x, crR, crbG, cbB, packing);
+		}
+	}
+
+	convertRowsScalar<PixelInt, halfChroma>(dst, dstPitch, ySrc, yPitch, uSrc, vSrc, x, width, format.lookup);
+}
+
+#endif // SCUMMVM_AVX2
+
+#ifdef SCUMMVM_NEON
+
+static inline int16x8_t scaleChromaNEON(int16x8_t c, int frac, bool intPart) {
+	const uint16x4_t f = vdup_n_u16(frac);
+	const uint16x8_t a = vreinterpretq_u16_s16(vabsq_s16(c));
+	uint16x8_t t = vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(a), f), 16),
+	                            vshrn_n_u32(vmull_u16(vget_high_u16(a), f), 16));
+	if (intPart)
+		t = vaddq_u16(t, a);
+	const int16x8_t sign = vshrq_n_s16(c, 15);
+	return vsubq_s16(veorq_s16(vreinterpretq_s16_u16(t), sign), sign);
+}
+
+static inline void computeChromaNEON(uint8x8_t u8, uint8x8_t v8, int16x8_t &crR, int16x8_t &crbG, int16x8_t &cbB) {
+	const int16x8_t bias = vdupq_n_s16(128);
+	const int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u8)), bias);
+	const int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v8)), bias);
+	crR = scaleChromaNEON(v, kCrRFrac, true);
+	crbG = vnegq_s16(vaddq_s16(scaleChromaNEON(v, kCrGFrac, false), scaleChromaNEON(u, kCbGFrac, false)));
+	cbB = scaleChromaNEON(u, kCbBFrac, true);
+}
+
+static inline uint32x4_t packChannelNEON(uint16x4_t c, int loss, int shift) {
+	// Shifting left by a negative amount shifts right
+	return vshlq_u32(vshlq_u32(vmovl_u16(c), vdupq_n_s32(-loss)), vdupq_n_s32(shift));
+}
+
+/** Store eight pixels, from the luma in ySrc and the given chroma terms. */
+template<typename PixelInt>
+static inline void putPixelsNEON(byte *dst, const byte *ySrc, int16x8_t crR, int16x8_t crbG, int16x8_t cbB, const YUVToRGBRowFormat &format) {
+	const int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(ySrc)));
+	// The saturating narrowing clamps to 0..255
+	const uint16x8_t r = vmovl_u8(vqmovun_s16(vaddq_s16(y, crR)));
+	const uint16x8_t g = vmovl_u8(vqmovun_s16(vaddq_s16(y, crbG)));
+	const uint16x8_t b = vmovl_u8(vqmovun_s16(vaddq_s16(y, cbB)));
+
+	if (sizeof(PixelInt) == 2) {
+		uint16x8_t pixels = vdupq_n_u16(format.alpha);
+		pixels = vorrq_u16(pixels, vshlq_u16(vshlq_u16(r, vdupq_n_s16(-format.rLoss)), vdupq_n_s16(format.rShift)));
+		pixels = vorrq_u16(pixels, vshlq_u16(vshlq_u16(g, vdupq_n_s16(-format.gLoss)), vdupq_n_s16(format.gShift)));
+		pixels = vorrq_u16(pixels, vshlq_u16(vshlq_u16(b, vdupq_n_s16(-format.bLoss)), vdupq_n_s16(format.bShift)));
+		vst1q_u16((uint16 *)dst, pixels);
+	} else {
+		uint32x4_t lo = vdupq_n_u32(format.alpha), hi = lo;
+		lo = vorrq_u32(lo, packChannelNEON(vget_low_u16(r), format.rLoss, format.rShift));
+		hi = vorrq_u32(hi, packChannelNEON(vget_high_u16(r), format.rLoss, format.rShift));
+		lo = vorrq_u32(lo, packChannelNEON(vget_low_u16(g), format.gLoss, format.gShift));
+		hi = vorrq_u32(hi, packChannelNEON(vget_high_u16(g), format.gLoss, format.gShift));
+		lo = vorrq_u32(lo, packChannelNEON(vget_low_u16(b), format.bLoss, format.bShift));
+		hi = vorrq_u32(hi, packChannelNEON(vget_high_u16(b), format.bLoss, format.bShift));
+		vst1q_u32((uint32 *)dst, lo);
+		vst1q_u32((uint32 *)(dst + 16), hi);
+	}
+}
+
+template<typename PixelInt, bool halfChroma>
+static void convertRowNEON(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, const YUVToRGBRowFormat &format) {
+	int x = 0;
+	if (halfChroma) {
+		// Eight chroma samples cover 16 pixels in each of the two rows
+		for (; x + 16 <= width; x += 16) {
+			int16x8_t crR, crbG, cbB;
+			computeChromaNEON(vld1_u8(uSrc + (x >> 1)), vld1_u8(vSrc + (x >> 1)), crR, crbG, cbB);
+
+			const int16x8x2_t crRDup = vzipq_s16(crR, crR);
+			const int16x8x2_t crbGDup = vzipq_s16(crbG, crbG);
+			const int16x8x2_t cbBDup = vzipq_s16(cbB, cbB);
+
+			byte *dst0 = dst + x * sizeof(PixelInt);
+			const byte *y0 = ySrc + x;
+			putPixelsNEON<PixelInt>(dst0, y0, crRDup.val[0], crbGDup.val[0], cbBDup.val[0], format);
+			putPixelsNEON<PixelInt>(dst0 + 8 * sizeof(PixelInt), y0 + 8, crRDup.val[1], crbGDup.val[1], cbBDup.val[1], format);
+			putPixelsNEON<PixelInt>(dst0 + dstPitch, y0 + yPitch, crRDup.val[0], crbGDup.val[0], cbBDup.val[0], format);
+			putPixelsNEON<PixelInt>(dst0 + dstPitch + 8 * sizeof(PixelInt), y0 + yPitch + 8, crRDup.val[1], crbGDup.val[1], cbBDup.val[1], format);
+		}
+	} else {
+		for (; x + 8 <= width; x += 8) {
+			int16x8_t crR, crbG, cbB;
+			computeChromaNEON(vld1_u8(uSrc + x), vld1_u8(vSrc + x), crR, crbG, cbB);
+			putPixelsNEON<PixelInt>(dst + x * sizeof(PixelInt), ySrc + x, crR, crbG, cbB, format);
+		}
+	}
+
+	convertRowsScalar<PixelInt, halfChroma>(dst, dstPitch, ySrc, yPitch, uSrc, vSrc, x, width, format.lookup);
+}
+
+#endif // SCUMMVM_NEON
+
+#define YUV_TO_RGB_ROW_PROC(impl, bytesPerPixel, halfChroma) \
+	(bytesPerPixel == 2 ? (halfChroma ? &impl<uint16, true> : &impl<uint16, false>) \
+	                    : (halfChroma ? &impl<uint32, true> : &impl<uint32, false>))
+
+/**
+ * Return the row converter of a vectorized implementation, or 0 if it is
+ * not available on this build and CPU.
+ */
+static YUVToRGBRowProc getYUVToRGBRowProc(YUVToRGBImpl impl, int bytesPerPixel, bool halfChroma) {
+	switch (impl) {
+#ifdef SCUMMVM_SSE2
+	case kYUVToRGBSSE2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+			return YUV_TO_RGB_ROW_PROC(convertRowSSE2, bytesPerPixel, halfChroma);
+		break;
+#endif
+
+#ifdef SCUMMVM_AVX2
+	case kYUVToRGBAVX2:
+		if (Common::hasCPUFeature(Common::kCPUFeatureAVX2))
+			return YUV_TO_RGB_ROW_PROC(convertRowAVX2, bytesPerPixel, halfChroma);
+		break;
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kYUVToRGBNEON:
+		if (Common::hasCPUFeature(Common::kCPUFeatureNEON))
+			return YUV_TO_RGB_ROW_PROC(convertRowNEON, bytesPerPixel, halfChroma);
+		break;
+#endif
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+#undef YUV_TO_RGB_ROW_PROC
+
+bool hasYUVToRGBImpl(YUVToRGBImpl impl) {
+	return impl == kYUVToRGBScalar || getYUVToRGBRowProc(impl, 2, false) != 0;
+}
+
+static YUVToRGBImpl getBestYUVToRGBImpl() {
+	static const YUVToRGBImpl preferred[] = {
+		kYUVToRGBAVX2,
+		kYUVToRGBSSE2,
+		kYUVToRGBNEON
+	};
+
+	for (int i = 0; i < ARRAYSIZE(preferred); ++i) {
+		if (hasYUVToRGBImpl(preferred[i]))
+			return preferred[i];
+	}
+
+	return kYUVToRGBScalar;
+}
+
+void convertYUV444ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	convertYUV444ToRGB(dst, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch, getBestYUVToRGBImpl());
+}
+
+void convertYUV444ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch, YUVToRGBImpl impl) {
+	// Sanity checks
+	assert(dst && dst->pixels);
+	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
+	assert(ySrc && uSrc && vSrc);
+	assert(hasYUVToRGBImpl(impl));
+
+	const YUVToRGBLookup *lookup = YUVToRGBMan.getLookup(dst->format);
+
+	if (impl != kYUVToRGBScalar) {
+		const YUVToRGBRowFormat format(dst->format, lookup);
+		const YUVToRGBRowProc convertRow = getYUVToRGBRowProc(impl, dst->format.bytesPerPixel, false);
+
+		for (int h = 0; h < yHeight; h++)
+			convertRow((byte *)dst->getBasePtr(0, h), dst->pitch, ySrc + h * yPitch, yPitch, uSrc + h * uvPitch, vSrc + h * uvPitch, yWidth, format);
+		return;
+	}
+
+	// Use a templated function to avoid an if check on every pixel
+	if (dst->format.bytesPerPixel == 2)
+		convertYUV444ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	else
+		convertYUV444ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+}
+
+void convertYUV420ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	convertYUV420ToRGB(dst, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch, getBestYUVToRGBImpl());
+}
+
+void convertYUV420ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch, YUVToRGBImpl impl) {
+	// Sanity checks
+	assert(dst && dst->pixels);
+	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
+	assert(ySrc && uSrc && vSrc);
+	assert((yWidth & 1) == 0);
+	assert((yHeight & 1) == 0);
+	assert(hasYUVToRGBImpl(impl));
+
+	const YUVToRGBLookup *lookup = YUVToRGBMan.getLookup(dst->format);
+
+	if (impl != kYUVToRGBScalar) {
+		const YUVToRGBRowFormat format(dst->format, lookup);
+		const YUVToRGBRowProc convertRow = getYUVToRGBRowProc(impl, dst->format.bytesPerPixel, true);
+
+		for (int h = 0; h < yHeight; h += 2)
+			convertRow((byte *)dst->getBasePtr(0, h), dst->pitch, ySrc + h * yPitch, yPitch, uSrc + (h >> 1) * uvPitch, vSrc + (h >> 1) * uvPitch, yWidth, format);
+		return;
+	}
+
+	// Use a templated function to avoid an if check on every pixel
+	if (dst->format.bytesPerPixel == 2)
+		convertYUV420ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+	else
+		convertYUV420ToRGB<uint32>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
+}
+
+/**
+ * Upsample chroma samples x to quarterWidth - 1 of one row of a 410 chroma
+ * plane to the full width. This is the bilinear interpolation of
+ * convertYUV410ToRGB<>() above, split into a vertical pass and a horizontal
+ * one; the weights factor exactly, so the results are the same.
+ */
+static void interpolateYUV410Row(byte *dst, const byte *src, int x, int quarterWidth, int uvPitch, int yDiff) {
+	for (; x < quarterWidth; x++) {
+		const int a = src[x] * (4 - yDiff) + src[x + uvPitch] * yDiff;
+		const int b = src[x + 1] * (4 - yDiff) + src[x + uvPitch + 1] * yDiff;
+		dst[x * 4 + 0] = (a * 4) >> 4;
+		dst[x * 4 + 1] = (a * 3 + b) >> 4;
+		dst[x * 4 + 2] = (a * 2 + b * 2) >> 4;
+		dst[x * 4 + 3] = (a + b * 3) >> 4;
+	}
+}
+
+#ifdef SCUMMVM_SSE2
+
+SCUMMVM_TARGET_SSE2 static void interpolateYUV410RowSSE2(byte *dst, const byte *src, int quarterWidth, int uvPitch, int yDiff) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i top = _mm_set1_epi16(4 - yDiff), bottom = _mm_set1_epi16(yDiff);
+
+	// Eight chroma samples expand to 32 pixels. The last sample read is
+	// src[x + 8] <= src[quarterWidth], which the scalar code reads as well.
+	int x = 0;
+	for (; x + 8 <= quarterWidth; x += 8) {
+		const __m128i a = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + x)), zero), top),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + x + uvPitch)), zero), bottom));
+		const __m128i b = _mm_add_epi16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + x + 1)), zero), top),
+			_mm_mullo_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(src + x + uvPitch + 1)), zero), bottom));
+
+		// a * (4 - xDiff) + b * xDiff = 4 * a + (b - a) * xDiff
+		const __m128i d = _mm_sub_epi16(b, a);
+		const __m128i o0 = _mm_slli_epi16(a, 2);
+		const __m128i o1 = _mm_add_epi16(o0, d);
+		const __m128i o2 = _mm_add_epi16(o1, d);
+		const __m128i o3 = _mm_add_epi16(o2, d);
+
+		const __m128i lo01 = _mm_unpacklo_epi16(_mm_srli_epi16(o0, 4), _mm_srli_epi16(o1, 4));
+		const __m128i hi01 = _mm_unpackhi_epi16(_mm_srli_epi16(o0, 4), _mm_srli_epi16(o1, 4));
+		const __m128i lo23 = _mm_unpacklo_epi16(_mm_srli_epi16(o2, 4), _mm_srli_epi16(o3, 4));
+		const __m128i hi23 = _mm_unpackhi_epi16(_mm_srli_epi16(o2, 4), _mm_srli_epi16(o3, 4));
+
+		_mm_storeu_si128((__m128i *)(dst + x * 4), _mm_packus_epi16(_mm_unpacklo_epi32(lo01, lo23), _mm_unpackhi_epi32(lo01, lo23)));
+		_mm_storeu_si128((__m128i *)(dst + x * 4 + 16), _mm_packus_epi16(_mm_unpacklo_epi32(hi01, hi23), _mm_unpackhi_epi32(hi01, hi23)));
+	}
+
+	interpolateYUV410Row(dst, src, x, quarterWidth, uvPitch, yDiff);
+}
+
+#endif // SCUMMVM_SSE2
+
+#ifdef SCUMMVM_NEON
+
+static void interpolateYUV410RowNEON(byte *dst, const byte *src, int quarterWidth, int uvPitch, int yDiff) {
+	const uint16x8_t top = vdupq_n_u16(4 - yDiff), bottom = vdupq_n_u16(yDiff);
+
+	// Eight chroma samples expand to 32 pixels. The last sample read is
+	// src[x + 8] <= src[quarterWidth], which the scalar code reads as well.
+	int x = 0;
+	for (; x + 8 <= quarterWidth; x += 8) {
+		const int16x8_t a = vreinterpretq_s16_u16(vmlaq_u16(vmulq_u16(vmovl_u8(vld1_u8(src + x)), top), vmovl_u8(vld1_u8(src + x + uvPitch)), bottom));
+		const int16x8_t b = vreinterpretq_s16_u16(vmlaq_u16(vmulq_u16(vmovl_u8(vld1_u8(src + x + 1)), top), vmovl_u8(vld1_u8(src + x + uvPitch + 1)), bottom));
+
+		// a * (4 - xDiff) + b * xDiff = 4 * a + (b - a) * xDiff
+		const int16x8_t d = vsubq_s16(b, a);
+		const int16x8_t o0 = vshlq_n_s16(a, 2);
+		const int16x8_t o1 = vaddq_s16(o0, d);
+		const int16x8_t o2 = vaddq_s16(o1, d);
+		const int16x8_t o3 = vaddq_s16(o2, d);
+
+		uint8x8x4_t out;
+		out.val[0] = vqshrun_n_s16(o0, 4);
+		out.val[1] = vqshrun_n_s16(o1, 4);
+		out.val[2] = vqshrun_n_s16(o2, 4);
+		out.val[3] = vqshrun_n_s16(o3, 4);
+		vst4_u8(dst + x * 4, out);
+	}
+
+	interpolateYUV410Row(dst, src, x, quarterWidth, uvPitch, yDiff);
+}
+
+#endif // SCUMMVM_NEON
+
+static void interpolateYUV410Row(YUVToRGBImpl impl, byte *dst, const byte *src, int quarterWidth, int uvPitch, int yDiff) {
+	switch (impl) {
+#ifdef SCUMMVM_SSE2
+	case kYUVToRGBSSE2:
+	case kYUVToRGBAVX2:
+		interpolateYUV410RowSSE2(dst, src, quarterWidth, uvPitch, yDiff);
+		break;
+#endif
+
+#ifdef SCUMMVM_NEON
+	case kYUVToRGBNEON:
+		interpolateYUV410RowNEON(dst, src, quarterWidth, uvPitch, yDiff);
+		break;
+#endif
+
+	default:
+		interpolateYUV410Row(dst, src, 0, quarterWidth, uvPitch, yDiff);
+		break;
+	}
+}
+
 void convertYUV410ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
+	convertYUV410ToRGB(dst, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch, getBestYUVToRGBImpl());
+}
+
+void convertYUV410ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch, YUVToRGBImpl impl) {
 	// Sanity checks
 	assert(dst && dst->pixels);
 	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
 	assert(ySrc && uSrc && vSrc);
 	assert((yWidth & 3) == 0);
 	assert((yHeight & 3) == 0);
+	assert(hasYUVToRGBImpl(impl));
 
 	const YUVToRGBLookup *lookup = YUVToRGBMan.getLookup(dst->format);
 
+	if (impl != kYUVToRGBScalar) {
+		const YUVToRGBRowFormat format(dst->format, lookup);
+		const YUVToRGBRowProc convertRow = getYUVToRGBRowProc(impl, dst->format.bytesPerPixel, false);
+		const int quarterWidth = yWidth >> 2;
+
+		// The chroma is upsampled a row at a time, then converted like 444
+		byte *uRow = new byte[yWidth];
+		byte *vRow = new byte[yWidth];
+
+		for (int h = 0; h < yHeight; h++) {
+			interpolateYUV410Row(impl, uRow, uSrc + (h >> 2) * uvPitch, quarterWidth, uvPitch, h & 3);
+			interpolateYUV410Row(impl, vRow, vSrc + (h >> 2) * uvPitch, quarterWidth, uvPitch, h & 3);
+			convertRow((byte *)dst->getBasePtr(0, h), dst->pitch, ySrc + h * yPitch, yPitch, uRow, vRow, yWidth, format);
+		}
+
+		delete[] uRow;
+		delete[] vRow;
+		return;
+	}
+
 	// Use a templated function to avoid an if check on every pixel
 	if (dst->format.bytesPerPixel == 2)
 		convertYUV410ToRGB<uint16>((byte *)dst->pixels, dst->pitch, lookup, ySrc, uSrc, vSrc, yWidth, yHeight, yPitch, uvPitch);
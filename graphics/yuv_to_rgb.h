@@ -36,6 +36,28 @@
 
 namespace Graphics {
 
+/**
+ * The implementations of the conversions below. They all produce exactly
+ * the same pixels; the vectorized versions compute the chroma terms in
+ * fixed point instead of looking them up, and are used automatically when
+ * the CPU supports them.
+ */
+enum YUVToRGBImpl {
+	kYUVToRGBScalar,
+	kYUVToRGBSSE2,
+	kYUVToRGBAVX2,
+	kYUVToRGBNEON,
+
+	kYUVToRGBImplCount
+};
+
+/**
+ * Return whether the given implementation is available on this build and
+ * CPU. kYUVToRGBScalar is always available; it is the reference the
+ * vectorized versions have to match.
+ */
+bool hasYUVToRGBImpl(YUVToRGBImpl impl);
+
 /**
  * Convert a YUV444 image to an RGB surface
  *
@@ -50,6 +72,14 @@ namespace Graphics {
  */
 void convertYUV444ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+/**
+ * Convert a YUV444 image to an RGB surface using a specific implementation,
+ * which must be available.
+ *
+ * @see hasYUVToRGBImpl
+ */
+void convertYUV444ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch, YUVToRGBImpl impl);
+
 /**
  * Convert a YUV420 image to an RGB surface
  *
@@ -64,6 +94,14 @@ void convertYUV444ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uS
  */
 void convertYUV420ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+/**
+ * Convert a YUV420 image to an RGB surface using a specific implementation,
+ * which must be available.
+ *
+ * @see hasYUVToRGBImpl
+ */
+void convertYUV420ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch, YUVToRGBImpl impl);
+
 /**
  * Convert a YUV410 image to an RGB surface
  *
@@ -83,6 +121,14 @@ void convertYUV420ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uS
  */
 void convertYUV410ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch);
 
+/**
+ * Convert a YUV410 image to an RGB surface using a specific implementation,
+ * which must be available.
+ *
+ * @see hasYUVToRGBImpl
+ */
+void convertYUV410ToRGB(Graphics::Surface *dst, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch, YUVToRGBImpl impl);
+
 } // End of namespace Graphics
 
 #endif
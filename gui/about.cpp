@@ -107,16 +107,16 @@ AboutDialog::AboutDialog()
 	engines += _("Available engines:");
 	addLine(engines.c_str());
 
-	const EnginePlugin::List &plugins = EngineMan.getPlugins();
-	EnginePlugin::List::const_iterator iter = plugins.begin();
-	for (; iter != plugins.end(); ++iter) {
+	const EngineManager::EngineInfoList engineInfos = EngineMan.getEngineInfos();
+	EngineManager::EngineInfoList::const_iterator iter = engineInfos.begin();
+	for (; iter != engineInfos.end(); ++iter) {
 	  Common::String str;
 	  str = "C0";
-	  str += (**iter).getName();
+	  str += iter->name;
 	  addLine(str.c_str());
 
 	  str = "C2";
-	  str += (**iter)->getOriginalCopyright();
+	  str += iter->originalCopyright;
 	  addLine(str.c_str());
 
 	  //addLine("");
@@ -20,6 +20,7 @@
  */
 
 #include "base/version.h"
+#include "engines/detectioncache.h"
 
 #include "common/config-manager.h"
 #include "common/events.h"
@@ -843,6 +844,7 @@ void LauncherDialog::addGame() {
 			// ...so let's determine a list of candidates, games that
 			// could be contained in the specified directory.
 			GameList candidates(EngineMan.detectGames(files));
+			DetectionCache::instance().flush();
 
 			int idx;
 			if (candidates.empty()) {
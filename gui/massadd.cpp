@@ -19,6 +19,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 
+#include "engines/detectioncache.h"
 #include "engines/metaengine.h"
 #include "common/algorithm.h"
 #include "common/config-manager.h"
@@ -59,18 +60,14 @@ enum {
 
 MassAddDialog::MassAddDialog(const Common::FSNode &startDir)
 	: Dialog("MassAdd"),
-	_dirsScanned(0),
+	_scanner(startDir, true, g_system->getWorkerPool()),
 	_oldGamesCount(0),
-	_dirTotal(0),
 	_okButton(0),
 	_dirProgressText(0),
 	_gameProgressText(0) {
 
 	StringArray l;
 
-	// The dir we start our scan at
-	_scanStack.push(startDir);
-
 	// Removed for now... Why would you put a title on mass add dialog called "Mass Add Dialog"?
 	// new StaticTextWidget(this, "massadddialog_caption", "Mass Add Dialog");
 
@@ -162,7 +159,9 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 
 		close();
 	} else if (cmd == kCancelCmd) {
-		// User cancelled, so we don't do anything and just leave.
+		// User cancelled, so we don't do anything and just leave. The
+		// detection results so far are still worth keeping, though.
+		DetectionCache::instance().flush();
 		_games.clear();
 		close();
 	} else {
@@ -171,22 +170,20 @@ void MassAddDialog::handleCommand(CommandSender *sender, uint32 cmd, uint32 data
 }
 
 void MassAddDialog::handleTickle() {
-	if (_scanStack.empty())
+	if (_scanner.isFinished())
 		return;	// We have finished scanning
 
 	uint32 t = g_system->getMillis();
 
-	// Perform a breadth-first scan of the filesystem.
-	while (!_scanStack.empty() && (g_system->getMillis() - t) < kMaxScanTime) {
-		Common::FSNode dir = _scanStack.pop();
-
-		Common::FSList files;
-		if (!dir.getChildren(files, Common::FSNode::kListAll)) {
-			continue;
-		}
+	// Perform a breadth-first scan of the filesystem. The scanner lists the
+	// next directories in the background while we look at the current one.
+	while (!_scanner.isFinished() && (g_system->getMillis() - t) < kMaxScanTime) {
+		Common::FSNode dir;
+		GameList candidates;
 
 		// Run the detector on the dir
-		GameList candidates(EngineMan.detectGames(files));
+		if (!_scanner.scanNextDirectory(dir, candidates))
+			continue;
 
 		// Just add all detected games / game variants. If we get more than one,
 		// that either means the directory contains multiple games, or the detector
@@ -229,20 +226,8 @@ void MassAddDialog::handleTickle() {
 			_list->append(result.description());
 		}
 
-
-		// Recurse into all subdirs
-		for (Common::FSList::const_iterator file = files.begin(); file != files.end(); ++file) {
-			if (file->isDirectory()) {
-				_scanStack.push(*file);
-
-				_dirTotal++;
-			}
-		}
-
-		_dirsScanned++;
-
 #if defined(USE_TASKBAR)
-		g_system->getTaskbarManager()->setProgressValue(_dirsScanned, _dirTotal);
+		g_system->getTaskbarManager()->setProgressValue(_scanner.getScannedCount(), _scanner.getFoundCount());
 		g_system->getTaskbarManager()->setCount(_games.size());
 #endif
 	}
@@ -251,7 +236,10 @@ void MassAddDialog::handleTickle() {
 	// Update the dialog
 	Common::String buf;
 
-	if (_scanStack.empty()) {
+	if (_scanner.isFinished()) {
+		// Write the detection results of all scanned directories at once
+		DetectionCache::instance().flush();
+
 		// Enable the OK button
 		_okButton->setEnabled(true);
 
@@ -262,7 +250,7 @@ void MassAddDialog::handleTickle() {
 		_gameProgressText->setLabel(buf);
 
 	} else {
-		buf = Common::String::format(_("Scanned %d directories ..."), _dirsScanned);
+		buf = Common::String::format(_("Scanned %d directories ..."), _scanner.getScannedCount());
 		_dirProgressText->setLabel(buf);
 
 		buf = Common::String::format(_("Discovered %d new games, ignored %d previously added games ..."), _games.size(), _oldGamesCount);
@@ -23,9 +23,9 @@
 #define MASSADD_DIALOG_H
 
 #include "gui/dialog.h"
+#include "engines/gamescanner.h"
 #include "common/fs.h"
 #include "common/hashmap.h"
-#include "common/stack.h"
 #include "common/str.h"
 
 namespace GUI {
@@ -48,7 +48,7 @@ public:
 	}
 
 private:
-	Common::Stack<Common::FSNode>  _scanStack;
+	GameScanner _scanner;
 	GameList _games;
 
 	/**
@@ -58,9 +58,7 @@ private:
 	 */
 	Common::HashMap<Common::String, StringArray>	_pathToTargets;
 
-	int _dirsScanned;
 	int _oldGamesCount;
-	int _dirTotal;
 
 	Widget *_okButton;
 	StaticTextWidget *_dirProgressText;
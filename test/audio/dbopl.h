@@ -0,0 +1,199 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifndef DISABLE_DOSBOX_OPL
+#include "audio/softsynth/opl/dbopl.h"
+#include "audio/softsynth/opl/dbopl_block.h"
+#endif
+
+class DBOPLTestSuite : public CxxTest::TestSuite
+{
+#ifndef DISABLE_DOSBOX_OPL
+private:
+	typedef OPL::DOSBox::DBOPL::BlockOps BlockOps;
+	typedef OPL::DOSBox::DBOPL::Chip Chip;
+
+	enum {
+		kMaxLen = 37,
+		kWaveSize = 1024
+	};
+
+	uint32 _seed;
+
+	uint32 next() {
+		_seed = _seed * 1103515245 + 12345;
+		return (_seed >> 16) | (_seed << 16);
+	}
+
+	void checkImpl(const BlockOps *ref, const BlockOps *ops) {
+		// One extra entry, see BlockOps::wave
+		int16 waveTable[kWaveSize + 1];
+		for (int i = 0; i <= kWaveSize; ++i)
+			waveTable[i] = (int16)(next() % 8192) - 4096;
+
+		int32 mod[kMaxLen], mul[kMaxLen], in[kMaxLen], out[kMaxLen * 2];
+		int32 expected[kMaxLen * 2], actual[kMaxLen * 2];
+		uint32 expectedIndex[kMaxLen], actualIndex[kMaxLen];
+
+		for (uint32 len = 0; len <= kMaxLen; ++len) {
+			for (uint32 i = 0; i < kMaxLen; ++i) {
+				// Modulation of both signs beyond the table size
+				mod[i] = (int32)(next() % 8192) - 4096;
+				// Silent samples are 0, the largest volume is below 1.0
+				mul[i] = (next() & 3) ? next() % 65536 : 0;
+				in[i] = (int32)next() >> 12;
+			}
+			for (uint32 i = 0; i < kMaxLen * 2; ++i)
+				out[i] = (int32)next() >> 12;
+
+			// Counters close to wrapping around
+			const uint32 waveIndex = next() | 0xF0000000;
+			const uint32 waveAdd = next() % (1 << 24);
+			const uint32 waveMask = (next() & 1) ? 1023 : 511;
+			const uint32 waveShift = 22;
+
+			uint32 expectedCounter = waveIndex, actualCounter = waveIndex;
+			ref->phase(expectedIndex, &expectedCounter, waveAdd, waveShift, len);
+			ops->phase(actualIndex, &actualCounter, waveAdd, waveShift, len);
+			TS_ASSERT_EQUALS(expectedCounter, actualCounter);
+			TS_ASSERT_EQUALS(memcmp(expectedIndex, actualIndex, len * sizeof(uint32)), 0);
+
+			for (int modulated = 0; modulated < 2; ++modulated) {
+				expectedCounter = actualCounter = waveIndex;
+				ref->wave(expected, modulated ? mod : 0, mul, &expectedCounter, waveAdd, waveShift, waveTable, waveMask, len);
+				ops->wave(actual, modulated ? mod : 0, mul, &actualCounter, waveAdd, waveShift, waveTable, waveMask, len);
+				TS_ASSERT_EQUALS(expectedCounter, actualCounter);
+				TS_ASSERT_EQUALS(memcmp(expected, actual, len * sizeof(int32)), 0);
+			}
+
+			// In place modulation
+			memcpy(actual, mod, sizeof(mod));
+			actualCounter = waveIndex;
+			ops->wave(actual, actual, mul, &actualCounter, waveAdd, waveShift, waveTable, waveMask, len);
+			expectedCounter = waveIndex;
+			ref->wave(expected, mod, mul, &expectedCounter, waveAdd, waveShift, waveTable, waveMask, len);
+			TS_ASSERT_EQUALS(memcmp(expected, actual, len * sizeof(int32)), 0);
+
+			memcpy(expected, out, sizeof(out));
+			memcpy(actual, out, sizeof(out));
+			ref->mix(expected, in, len);
+			ops->mix(actual, in, len);
+			TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(out)), 0);
+
+			for (int pan = 0; pan < 4; ++pan) {
+				const int32 maskLeft = (pan & 1) ? -1 : 0;
+				const int32 maskRight = (pan & 2) ? -1 : 0;
+				memcpy(expected, out, sizeof(out));
+				memcpy(actual, out, sizeof(out));
+				ref->mixStereo(expected, in, maskLeft, maskRight, len);
+				ops->mixStereo(actual, in, maskLeft, maskRight, len);
+				TS_ASSERT_EQUALS(memcmp(expected, actual, sizeof(out)), 0);
+			}
+		}
+	}
+
+	// Set up all channels with a mix of the synthesis modes and waveforms
+	void setupChip(Chip &chip, bool opl3) {
+		static const int opOffsets[9] = { 0, 1, 2, 8, 9, 10, 16, 17, 18 };
+
+		chip.Setup(44100);
+		if (opl3) {
+			chip.WriteReg(0x105, 1);
+			// Four operator mode for the first channels of both halves
+			chip.WriteReg(0x104, 0x09);
+		}
+		// Deep vibrato and tremolo
+		chip.WriteReg(0xbd, 0xc0);
+
+		for (int ch = 0; ch < (opl3 ? 18 : 9); ++ch) {
+			const int base = (ch >= 9) ? 0x100 : 0;
+			for (int op = 0; op < 2; ++op) {
+				const int reg = base + opOffsets[ch % 9] + op * 3;
+				chip.WriteReg(0x20 + reg, 0xc1 + (ch & 0x23) + op);
+				chip.WriteReg(0x40 + reg, op ? (ch & 7) : 0x10 + ch);
+				chip.WriteReg(0x60 + reg, 0xf1 + (ch & 7) * 0x10);
+				chip.WriteReg(0x80 + reg, 0x13 + (ch & 3) * 0x20);
+				chip.WriteReg(0xe0 + reg, (ch + op) & 7);
+			}
+			chip.WriteReg(base + 0xc0 + ch % 9, 0x30 | (ch % 7) << 1 | (ch & 1));
+			chip.WriteReg(base + 0xa0 + ch % 9, 0x41 + ch * 13);
+			chip.WriteReg(base + 0xb0 + ch % 9, 0x21 + (ch & 7) * 4);
+		}
+	}
+
+	void renderChip(const BlockOps *ops, bool opl3, int32 *output, int len) {
+		Chip chip;
+		chip.blockOps = ops;
+		setupChip(chip, opl3);
+
+		// Render in uneven pieces, and let some notes go into their release
+		int pos = 0;
+		for (int piece = 0; pos < len; ++piece) {
+			const int samples = MIN(len - pos, 300 + piece * 77);
+			if (opl3)
+				chip.GenerateBlock3(samples, output + pos * 2);
+			else
+				chip.GenerateBlock2(samples, output + pos);
+			pos += samples;
+
+			chip.WriteReg(0xb0 + piece % 9, 0x01 + piece * 4 % 32);
+		}
+	}
+
+#endif
+
+public:
+	void setUp() {
+#ifndef DISABLE_DOSBOX_OPL
+		_seed = 1;
+#endif
+	}
+
+	void test_block_ops() {
+#ifndef DISABLE_DOSBOX_OPL
+		using namespace OPL::DOSBox::DBOPL;
+		const BlockOps *ref = getBlockOps(kBlockOpsScalar);
+		TS_ASSERT(ref);
+		TS_ASSERT(getBlockOps());
+
+		for (int impl = 0; impl < kBlockOpsImplCount; ++impl) {
+			const BlockOps *ops = getBlockOps((BlockOpsImpl)impl);
+			if (ops)
+				checkImpl(ref, ops);
+		}
+#endif
+	}
+
+	void test_chip_block_ops() {
+#ifndef DISABLE_DOSBOX_OPL
+		using namespace OPL::DOSBox::DBOPL;
+		InitTables();
+
+		const int len = 4000;
+		int32 *expected = new int32[len * 2];
+		int32 *actual = new int32[len * 2];
+
+		for (int opl3 = 0; opl3 < 2; ++opl3) {
+			renderChip(getBlockOps(kBlockOpsScalar), opl3, expected, len);
+
+			// Make sure there is something to compare
+			int nonZero = 0;
+			for (int i = 0; i < len; ++i)
+				nonZero += (expected[i] != 0);
+			TS_ASSERT_LESS_THAN(len / 2, nonZero);
+
+			for (int impl = 0; impl < kBlockOpsImplCount; ++impl) {
+				const BlockOps *ops = getBlockOps((BlockOpsImpl)impl);
+				if (!ops)
+					continue;
+				renderChip(ops, opl3, actual, len);
+				TS_ASSERT_EQUALS(memcmp(expected, actual, len * (opl3 ? 2 : 1) * sizeof(int32)), 0);
+			}
+		}
+
+		delete[] expected;
+		delete[] actual;
+#endif
+	}
+};
@@ -0,0 +1,151 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/softsynth/midiring.h"
+
+class MidiEventRingTestSuite : public CxxTest::TestSuite
+{
+private:
+	MidiEventRing *_ring;
+
+	static void fillData(byte *data, uint32 length, byte seed) {
+		for (uint32 i = 0; i < length; i++)
+			data[i] = (byte)(seed + i * 7);
+	}
+
+	static bool checkData(const byte *data, uint32 length, byte seed) {
+		for (uint32 i = 0; i < length; i++) {
+			if (data[i] != (byte)(seed + i * 7))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	void setUp() {
+		// Too large for the stack
+		_ring = new MidiEventRing();
+	}
+
+	void tearDown() {
+		delete _ring;
+	}
+
+	void test_order() {
+		MidiEventRing::Event event;
+		TS_ASSERT(!_ring->peek(event));
+
+		for (uint32 i = 0; i < 10; i++)
+			TS_ASSERT(_ring->push(0x90 + i, 100 * i));
+
+		for (uint32 i = 0; i < 10; i++) {
+			TS_ASSERT(_ring->peek(event));
+			TS_ASSERT_EQUALS(event.msg, 0x90 + i);
+			TS_ASSERT_EQUALS(event.timestamp, 100 * i);
+			TS_ASSERT(!event.data);
+			TS_ASSERT_EQUALS(event.length, 0u);
+
+			// Peeking does not remove the event
+			TS_ASSERT(_ring->peek(event));
+			TS_ASSERT_EQUALS(event.msg, 0x90 + i);
+			_ring->pop();
+		}
+
+		TS_ASSERT(!_ring->peek(event));
+	}
+
+	void test_sysex() {
+		byte data[300];
+		MidiEventRing::Event event;
+
+		// Go around the data ring several times, with lengths which do not
+		// divide its size, so the data has to start over at the beginning
+		for (uint32 i = 0; i < 1000; i++) {
+			const uint32 length = 1 + (i * 37) % 300;
+			fillData(data, length, i);
+			TS_ASSERT(_ring->push(0xF0, i, data, length));
+			TS_ASSERT(_ring->push(0x80, i));
+
+			TS_ASSERT(_ring->peek(event));
+			TS_ASSERT_EQUALS(event.timestamp, i);
+			TS_ASSERT_EQUALS(event.length, length);
+			TS_ASSERT(event.data && checkData(event.data, length, i));
+			_ring->pop();
+
+			TS_ASSERT(_ring->peek(event));
+			TS_ASSERT_EQUALS(event.msg, 0x80u);
+			TS_ASSERT(!event.data);
+			_ring->pop();
+		}
+	}
+
+	void test_event_overflow() {
+		for (uint32 i = 0; i < MidiEventRing::kEventCount; i++)
+			TS_ASSERT(_ring->push(i, i));
+
+		// Full: the new event is dropped, the queued ones are kept
+		TS_ASSERT(!_ring->push(0xFFFF, 0));
+
+		MidiEventRing::Event event;
+		TS_ASSERT(_ring->peek(event));
+		TS_ASSERT_EQUALS(event.msg, 0u);
+		_ring->pop();
+
+		// There is room for one event again
+		TS_ASSERT(_ring->push(0x1234, 0));
+		TS_ASSERT(!_ring->push(0x1235, 0));
+
+		for (uint32 i = 1; i < MidiEventRing::kEventCount; i++) {
+			TS_ASSERT(_ring->peek(event));
+			TS_ASSERT_EQUALS(event.msg, i);
+			_ring->pop();
+		}
+		TS_ASSERT(_ring->peek(event));
+		TS_ASSERT_EQUALS(event.msg, 0x1234u);
+		_ring->pop();
+		TS_ASSERT(!_ring->peek(event));
+	}
+
+	void test_sysex_overflow() {
+		const uint32 length = MidiEventRing::kSysExBufferSize / 4;
+		byte *data = new byte[MidiEventRing::kSysExBufferSize + 1];
+		fillData(data, MidiEventRing::kSysExBufferSize + 1, 1);
+
+		for (uint32 i = 0; i < 4; i++)
+			TS_ASSERT(_ring->push(0xF0, i, data, length));
+
+		// The data ring is full, while the event ring is not
+		TS_ASSERT(!_ring->push(0xF0, 4, data, 1));
+		TS_ASSERT(_ring->push(0x80, 4));
+
+		// Data larger than the whole ring never fits
+		_ring->clear();
+		TS_ASSERT(!_ring->push(0xF0, 0, data, MidiEventRing::kSysExBufferSize + 1));
+
+		// Nor does data which would have to start over at the beginning of
+		// the ring, while that part is still in use
+		TS_ASSERT(_ring->push(0xF0, 0, data, 1));
+		TS_ASSERT(_ring->push(0xF0, 1, data, MidiEventRing::kSysExBufferSize - 2));
+		MidiEventRing::Event event;
+		TS_ASSERT(_ring->peek(event));
+		_ring->pop();
+		TS_ASSERT(!_ring->push(0xF0, 2, data, 2));
+		TS_ASSERT(_ring->peek(event));
+		TS_ASSERT_EQUALS(event.length, (uint32)MidiEventRing::kSysExBufferSize - 2);
+		_ring->pop();
+		TS_ASSERT(_ring->push(0xF0, 2, data, 2));
+		TS_ASSERT(_ring->peek(event));
+		TS_ASSERT(checkData(event.data, 2, 1));
+
+		delete[] data;
+	}
+
+	void test_clear() {
+		byte data[4] = { 1, 2, 3, 4 };
+		TS_ASSERT(_ring->push(0x90, 0));
+		TS_ASSERT(_ring->push(0xF0, 1, data, sizeof(data)));
+		_ring->clear();
+
+		MidiEventRing::Event event;
+		TS_ASSERT(!_ring->peek(event));
+	}
+};
@@ -0,0 +1,190 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/mixer_intern.h"
+
+#include "test/testsystem.h"
+
+class MixerTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kRate = 22050,
+		kSamples = 256
+	};
+
+	/**
+	 * Stream of a constant sample value, which calls back into the mixer
+	 * from readBuffer() like MIDI drivers and engine streams do, and clears
+	 * a flag when it is deleted.
+	 */
+	class CallbackStream : public Audio::AudioStream {
+	public:
+		enum Action {
+			kNone,
+			kStopSelf,
+			kStopOther,
+			kSetVolume,
+			kPlay
+		};
+
+		CallbackStream(Audio::Mixer *mixer, bool *alive, Action action = kNone)
+		    : _mixer(mixer), _alive(alive), _action(action), _reads(0) {
+			*_alive = true;
+		}
+
+		~CallbackStream() { *_alive = false; }
+
+		int readBuffer(int16 *buffer, const int numSamples) {
+			_reads++;
+
+			switch (_action) {
+			case kNone:
+				break;
+			case kStopSelf:
+				_mixer->stopHandle(handle);
+				break;
+			case kStopOther:
+				_mixer->stopHandle(other);
+				break;
+			case kSetVolume:
+				TS_ASSERT(_mixer->isSoundHandleActive(handle));
+				_mixer->setChannelVolume(handle, 0);
+				break;
+			case kPlay:
+				_mixer->playStream(Audio::Mixer::kPlainSoundType, &other, Audio::makeQueuingAudioStream(kRate, false));
+				break;
+			}
+			_action = kNone;
+
+			// The channel is only deleted once we return
+			for (int i = 0; i < numSamples; i++)
+				buffer[i] = 1000;
+			return numSamples;
+		}
+
+		bool isStereo() const { return false; }
+		int getRate() const { return kRate; }
+		bool endOfData() const { return false; }
+
+		uint getReadCount() const { return _reads; }
+
+		Audio::SoundHandle handle;
+		Audio::SoundHandle other;
+
+	private:
+		Audio::Mixer *_mixer;
+		bool *_alive;
+		Action _action;
+		uint _reads;
+	};
+
+	TestSystem *_system;
+	OSystem *_oldSystem;
+	Audio::MixerImpl *_mixer;
+	int16 _buffer[kSamples * 2];
+
+	// The mixer deletes the streams left at the end of a test in tearDown()
+	bool _alive, _otherAlive;
+
+	CallbackStream *play(bool *alive, CallbackStream::Action action = CallbackStream::kNone) {
+		CallbackStream *stream = new CallbackStream(_mixer, alive, action);
+		static_cast<Audio::Mixer *>(_mixer)->playStream(Audio::Mixer::kPlainSoundType, &stream->handle, stream);
+		return stream;
+	}
+
+	int mix() {
+		_mixer->mixCallback((byte *)_buffer, sizeof(_buffer));
+
+		int peak = 0;
+		for (int i = 0; i < kSamples * 2; i++)
+			peak = MAX<int>(peak, ABS(_buffer[i]));
+		return peak;
+	}
+
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		_system = new TestSystem();
+		g_system = _system;
+
+		_mixer = new Audio::MixerImpl(_system, kRate);
+		_mixer->setReady(true);
+	}
+
+	void tearDown() {
+		delete _mixer;
+		g_system = _oldSystem;
+		delete _system;
+	}
+
+	void test_stop() {
+		CallbackStream *stream = play(&_alive);
+		TS_ASSERT_LESS_THAN(0, mix());
+
+		// Outside of the mixer callback, the channel is deleted right away
+		_mixer->stopHandle(stream->handle);
+		TS_ASSERT(!_alive);
+		TS_ASSERT_EQUALS(mix(), 0);
+	}
+
+	void test_stop_self() {
+		// The channel is deleted after the stream returns
+		CallbackStream *stream = play(&_alive, CallbackStream::kStopSelf);
+		const Audio::SoundHandle handle = stream->handle;
+		mix();
+		TS_ASSERT(!_alive);
+		TS_ASSERT(!_mixer->isSoundHandleActive(handle));
+		TS_ASSERT_EQUALS(mix(), 0);
+	}
+
+	void test_stop_other() {
+		CallbackStream *stream = play(&_alive, CallbackStream::kStopOther);
+		CallbackStream *other = play(&_otherAlive);
+		stream->other = other->handle;
+
+		mix();
+		TS_ASSERT(_alive);
+		TS_ASSERT(!_otherAlive);
+		TS_ASSERT(_mixer->isSoundHandleActive(stream->handle));
+	}
+
+	void test_calls_from_stream() {
+		// The volume change applies from the next mix pass on
+		CallbackStream *stream = play(&_alive, CallbackStream::kSetVolume);
+		TS_ASSERT_LESS_THAN(0, mix());
+		TS_ASSERT_EQUALS(_mixer->getChannelVolume(stream->handle), 0);
+		TS_ASSERT_EQUALS(mix(), 0);
+		TS_ASSERT_EQUALS(stream->getReadCount(), 2u);
+	}
+
+	void test_play_from_stream() {
+		CallbackStream *stream = play(&_alive, CallbackStream::kPlay);
+		mix();
+		TS_ASSERT(_mixer->isSoundHandleActive(stream->other));
+	}
+
+	void test_settings() {
+		CallbackStream *stream = play(&_alive);
+		const int peak = mix();
+		TS_ASSERT_LESS_THAN(0, peak);
+
+		// Only the latest settings matter, however many changes are made
+		// between two mix passes
+		for (int i = 0; i < 1000; i++)
+			_mixer->setChannelVolume(stream->handle, i & 0xFF);
+		_mixer->setChannelVolume(stream->handle, 0);
+		TS_ASSERT_EQUALS(mix(), 0);
+
+		_mixer->setChannelVolume(stream->handle, Audio::Mixer::kMaxChannelVolume);
+		_mixer->pauseHandle(stream->handle, true);
+		TS_ASSERT_EQUALS(mix(), 0);
+		_mixer->pauseHandle(stream->handle, false);
+		TS_ASSERT_EQUALS(mix(), peak);
+
+		_mixer->setVolumeForSoundType(Audio::Mixer::kPlainSoundType, 0);
+		TS_ASSERT_EQUALS(mix(), 0);
+		_mixer->setVolumeForSoundType(Audio::Mixer::kPlainSoundType, Audio::Mixer::kMaxMixerVolume);
+		TS_ASSERT_EQUALS(mix(), peak);
+	}
+};
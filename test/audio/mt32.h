@@ -0,0 +1,211 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifdef USE_MT32EMU
+#include "audio/softsynth/mt32/SampleOps.h"
+#include "audio/softsynth/mt32/freeverb.h"
+#endif
+
+class MT32TestSuite : public CxxTest::TestSuite
+{
+#ifdef USE_MT32EMU
+private:
+	enum {
+		kMaxLen = 45
+	};
+
+	uint32 _seed;
+
+	float nextFloat() {
+		_seed = _seed * 1103515245 + 12345;
+		switch ((_seed >> 8) & 15) {
+		case 0:
+			return 0.0f;
+		case 1:
+			return -0.0f;
+		case 2:
+			// Exact integers after scaling, and halfway values
+			return (float)((int)(_seed >> 16) % 9 - 4) / 8.0f;
+		case 3:
+			// Denormals
+			return (float)((int)(_seed >> 16) - 32768) * 1e-42f;
+		case 4:
+			// Way beyond the 16-bit range after scaling
+			return (float)((int)(_seed >> 16) - 32768) * 1000.0f;
+		default:
+			return (float)((int)(_seed >> 12) - (1 << 19)) / (float)(1 << 18);
+		}
+	}
+
+	int16 nextSample() {
+		_seed = _seed * 1103515245 + 12345;
+		return (int16)(_seed >> 16);
+	}
+
+	void fill(float *buf, int len) {
+		for (int i = 0; i < len; ++i)
+			buf[i] = nextFloat();
+	}
+
+	void fill(int16 *buf, int len) {
+		for (int i = 0; i < len; ++i)
+			buf[i] = nextSample();
+	}
+
+	template<typename T>
+	void assertEqual(const T *expected, const T *actual, int len) {
+		// Compare the bits, so that signed zeros have to match as well
+		TS_ASSERT_EQUALS(memcmp(expected, actual, len * sizeof(T)), 0);
+	}
+
+	void checkImpl(const MT32Emu::SampleOps *ref, const MT32Emu::SampleOps *ops) {
+		float src[kMaxLen], src2[kMaxLen], in[kMaxLen], expected[kMaxLen], actual[kMaxLen];
+		float buf1[kMaxLen], buf2[kMaxLen];
+		int16 s[6][kMaxLen], expected16[kMaxLen * 2], actual16[kMaxLen * 2];
+
+		for (int len = 0; len <= kMaxLen; ++len) {
+			fill(src, kMaxLen);
+			fill(src2, kMaxLen);
+			fill(in, kMaxLen);
+			const float factor = nextFloat();
+
+			memcpy(expected, in, sizeof(in));
+			memcpy(actual, in, sizeof(in));
+			ref->mix(expected, src, len);
+			ops->mix(actual, src, len);
+			assertEqual(expected, actual, kMaxLen);
+
+			memcpy(expected, in, sizeof(in));
+			memcpy(actual, in, sizeof(in));
+			ref->subtract(expected, src, len);
+			ops->subtract(actual, src, len);
+			assertEqual(expected, actual, kMaxLen);
+
+			memcpy(expected, in, sizeof(in));
+			memcpy(actual, in, sizeof(in));
+			ref->scale(expected, src, factor, len);
+			ops->scale(actual, src, factor, len);
+			assertEqual(expected, actual, kMaxLen);
+
+			memcpy(expected, in, sizeof(in));
+			memcpy(actual, in, sizeof(in));
+			ref->multiply(expected, src, len);
+			ops->multiply(actual, src, len);
+			assertEqual(expected, actual, kMaxLen);
+
+			memcpy(expected, in, sizeof(in));
+			memcpy(actual, in, sizeof(in));
+			ref->ringModulate(expected, src, len);
+			ops->ringModulate(actual, src, len);
+			assertEqual(expected, actual, kMaxLen);
+
+			static const float gains[] = { 16384.0f, 8192.0f, 8192.0f * 0.68f, 1.0f };
+			for (int g = 0; g < ARRAYSIZE(gains); ++g) {
+				memset(expected16, 0, sizeof(expected16));
+				memset(actual16, 0, sizeof(actual16));
+				ref->truncateToBit16s(expected16, src, gains[g], len);
+				ops->truncateToBit16s(actual16, src, gains[g], len);
+				assertEqual(expected16, actual16, kMaxLen);
+
+				ref->floorToBit16s(expected16, src, gains[g], len);
+				ops->floorToBit16s(actual16, src, gains[g], len);
+				assertEqual(expected16, actual16, kMaxLen);
+			}
+
+			for (int i = 0; i < 6; ++i)
+				fill(s[i], kMaxLen);
+			memset(expected16, 0, sizeof(expected16));
+			memset(actual16, 0, sizeof(actual16));
+			ref->mixOutput(expected16, s[0], s[1], s[2], s[3], s[4], s[5], len);
+			ops->mixOutput(actual16, s[0], s[1], s[2], s[3], s[4], s[5], len);
+			assertEqual(expected16, actual16, kMaxLen * 2);
+
+			memcpy(buf1, src2, sizeof(src2));
+			memcpy(buf2, src2, sizeof(src2));
+			memcpy(expected, in, sizeof(in));
+			memcpy(actual, in, sizeof(in));
+			ref->allpass(buf1, expected, 0.5f, len);
+			ops->allpass(buf2, actual, 0.5f, len);
+			assertEqual(expected, actual, kMaxLen);
+			assertEqual(buf1, buf2, kMaxLen);
+
+			memcpy(buf1, src2, sizeof(src2));
+			memcpy(buf2, src2, sizeof(src2));
+			ref->combFeed(buf1, in, src, factor, len);
+			ops->combFeed(buf2, in, src, factor, len);
+			assertEqual(buf1, buf2, kMaxLen);
+		}
+	}
+#endif
+
+public:
+	void test_sample_ops() {
+#ifdef USE_MT32EMU
+		const MT32Emu::SampleOps *ref = MT32Emu::getSampleOps(MT32Emu::SampleOpsImpl_SCALAR);
+		TS_ASSERT(ref != NULL);
+		TS_ASSERT(MT32Emu::getSampleOps() != NULL);
+
+		for (int impl = MT32Emu::SampleOpsImpl_SCALAR + 1; impl < MT32Emu::SampleOpsImpl_COUNT; ++impl) {
+			const MT32Emu::SampleOps *ops = MT32Emu::getSampleOps((MT32Emu::SampleOpsImpl)impl);
+			if (!ops)
+				continue;
+
+			_seed = impl;
+			checkImpl(ref, ops);
+		}
+#endif
+	}
+
+	void test_freeverb_block_size() {
+#ifdef USE_MT32EMU
+		// Processing one sample at a time does exactly what the reverb did
+		// before it worked on blocks; any block size has to give the same
+		const int len = 3000;
+		float *inL = new float[len];
+		float *inR = new float[len];
+		float *expectedL = new float[len];
+		float *expectedR = new float[len];
+		float *actualL = new float[len];
+		float *actualR = new float[len];
+
+		_seed = 42;
+		for (int i = 0; i < len; ++i) {
+			// Some silence in between, so the filters decay into denormals
+			const bool silent = (i / 500) & 1;
+			inL[i] = silent ? 0.0f : (float)((int)nextSample()) / 32768.0f;
+			inR[i] = silent ? 0.0f : (float)((int)nextSample()) / 32768.0f;
+		}
+
+		revmodel *reference = new revmodel(0.4f);
+		revmodel *blocks = new revmodel(0.4f);
+		revmodel *models[2] = { reference, blocks };
+		for (int m = 0; m < 2; ++m) {
+			models[m]->setfiltval(0.939522749f);
+			models[m]->setdamp(0.05f);
+			models[m]->setwet(0.38f);
+			models[m]->setroomsize(0.77f);
+		}
+
+		for (int i = 0; i < len; ++i)
+			reference->process(inL + i, inR + i, expectedL + i, expectedR + i, 1);
+
+		for (int pos = 0, step = 1; pos < len; pos += step, step = step * 3 % 401 + 1) {
+			const int n = MIN(step, len - pos);
+			blocks->process(inL + pos, inR + pos, actualL + pos, actualR + pos, n);
+		}
+
+		assertEqual(expectedL, actualL, len);
+		assertEqual(expectedR, actualR, len);
+
+		delete reference;
+		delete blocks;
+		delete[] inL;
+		delete[] inR;
+		delete[] expectedL;
+		delete[] expectedR;
+		delete[] actualL;
+		delete[] actualR;
+#endif
+	}
+};
@@ -0,0 +1,184 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/audiostream.h"
+#include "audio/prefetch.h"
+#include "audio/decoders/raw.h"
+
+#include "helper.h"
+
+#include "test/deferringworkerpool.h"
+
+class PrefetchingAudioStreamTestSuite : public CxxTest::TestSuite
+{
+private:
+	/**
+	 * Stream which returns at most 64 samples per readBuffer() call, like a
+	 * slow decoder.
+	 */
+	class TrickleStream : public Audio::AudioStream {
+	public:
+		TrickleStream(int samples) : _left(samples) {}
+
+		int readBuffer(int16 *buffer, const int numSamples) {
+			const int samples = MIN(MIN(numSamples, 64), _left);
+			memset(buffer, 0, samples * sizeof(int16));
+			_left -= samples;
+			return samples;
+		}
+
+		bool isStereo() const { return false; }
+		int getRate() const { return 11025; }
+		bool endOfData() const { return _left == 0; }
+
+	private:
+		int _left;
+	};
+
+	/** Stream which clears a flag when it is deleted. */
+	class TrackedStream : public TrickleStream {
+	public:
+		TrackedStream(int samples, bool *alive) : TrickleStream(samples), _alive(alive) { *_alive = true; }
+		~TrackedStream() { *_alive = false; }
+
+	private:
+		bool *_alive;
+	};
+
+	void readTestTemplate(const bool isStereo) {
+		const int rate = 11025;
+		const int time = 2;
+		const int samples = rate * time * (isStereo ? 2 : 1);
+
+		int16 *sine;
+		Audio::SeekableAudioStream *s = createSineStream<int16>(rate, time, &sine, false, isStereo);
+
+		// Use a small lookahead, so the buffer wraps around many times. The
+		// reads are never larger than the lookahead, though.
+		Audio::PrefetchingAudioStream *p = Audio::makePrefetchingAudioStream(s, DisposeAfterUse::YES, 0, 50);
+		TS_ASSERT_EQUALS(p->isStereo(), isStereo);
+		TS_ASSERT_EQUALS(p->getRate(), rate);
+
+		int16 *buffer = new int16[samples + 4];
+		int pos = 0;
+		for (int chunk = 2; pos < samples; chunk = (chunk * 3) % 1000 + 2) {
+			const int len = MIN(chunk, samples - pos);
+			TS_ASSERT_EQUALS(p->readBuffer(buffer + pos, len), len);
+			pos += len;
+		}
+
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, samples * sizeof(int16)), 0);
+
+		// Reading past the end is no underrun
+		TS_ASSERT_EQUALS(p->readBuffer(buffer, 4), 0);
+		TS_ASSERT(p->endOfData());
+		TS_ASSERT(p->endOfStream());
+		TS_ASSERT_EQUALS(p->getUnderrunCount(), 0u);
+
+		delete[] buffer;
+		delete[] sine;
+		delete p;
+	}
+
+public:
+	void test_read_mono() {
+		readTestTemplate(false);
+	}
+
+	void test_read_stereo() {
+		readTestTemplate(true);
+	}
+
+	void test_underrun() {
+		Audio::PrefetchingAudioStream *p = Audio::makePrefetchingAudioStream(new TrickleStream(1000), DisposeAfterUse::YES, 0);
+
+		// Only two pieces of the requested samples are decoded in time
+		int16 buffer[200];
+		TS_ASSERT_EQUALS(p->readBuffer(buffer, 200), 128);
+		TS_ASSERT_EQUALS(p->getUnderrunCount(), 1u);
+		TS_ASSERT(!p->endOfData());
+
+		int total = 128;
+		while (!p->endOfData())
+			total += p->readBuffer(buffer, 200);
+
+		TS_ASSERT_EQUALS(total, 1000);
+		TS_ASSERT(p->endOfStream());
+
+		delete p;
+	}
+
+	void test_pool_fill() {
+		const int rate = 11025;
+		const int samples = rate * 2;
+
+		int16 *sine;
+		Audio::SeekableAudioStream *s = createSineStream<int16>(rate, 2, &sine, false, false);
+
+		// 50 ms of lookahead make for a buffer of 1024 samples
+		DeferringWorkerPool pool;
+		Audio::PrefetchingAudioStream *p = Audio::makePrefetchingAudioStream(s, DisposeAfterUse::YES, &pool, 50);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 0u);
+
+		int16 *buffer = new int16[samples];
+		TS_ASSERT_EQUALS(p->readBuffer(buffer, 600), 600);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 1u);
+
+		// Nothing is decoded until the job runs, and only one job is queued
+		TS_ASSERT_EQUALS(p->readBuffer(buffer + 600, 600), 424);
+		TS_ASSERT_EQUALS(p->getUnderrunCount(), 1u);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 1u);
+
+		int pos = 1024;
+		while (!p->endOfData()) {
+			pool.runJobs();
+			pos += p->readBuffer(buffer + pos, MIN(700, samples - pos));
+		}
+
+		TS_ASSERT_EQUALS(pos, samples);
+		TS_ASSERT_EQUALS(memcmp(buffer, sine, samples * sizeof(int16)), 0);
+		TS_ASSERT_EQUALS(p->getUnderrunCount(), 1u);
+		TS_ASSERT(p->endOfStream());
+
+		// The source has ended, so no more jobs are queued
+		pool.runJobs();
+		TS_ASSERT_EQUALS(p->readBuffer(buffer, 4), 0);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 0u);
+
+		delete[] buffer;
+		delete[] sine;
+		delete p;
+	}
+
+	void test_pool_delete_while_queued() {
+		bool alive;
+		DeferringWorkerPool pool;
+		Audio::PrefetchingAudioStream *p = Audio::makePrefetchingAudioStream(new TrackedStream(100000, &alive), DisposeAfterUse::YES, &pool, 50);
+
+		// The source only decodes 64 samples at a time
+		int16 buffer[50];
+		TS_ASSERT_EQUALS(p->readBuffer(buffer, 50), 50);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 1u);
+
+		// The queued job owns the buffer and the source now
+		delete p;
+		TS_ASSERT(alive);
+
+		pool.runJobs();
+		TS_ASSERT(!alive);
+	}
+
+	void test_pool_delete_while_idle() {
+		bool alive;
+		DeferringWorkerPool pool;
+		Audio::PrefetchingAudioStream *p = Audio::makePrefetchingAudioStream(new TrackedStream(100000, &alive), DisposeAfterUse::YES, &pool, 50);
+
+		// The source only decodes 64 samples at a time
+		int16 buffer[50];
+		TS_ASSERT_EQUALS(p->readBuffer(buffer, 50), 50);
+		pool.runJobs();
+
+		delete p;
+		TS_ASSERT(!alive);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 0u);
+	}
+};
@@ -0,0 +1,196 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mixer.h"
+#include "audio/rate.h"
+#include "audio/rate_mix.h"
+
+#include "common/frac.h"
+
+#include "helper.h"
+
+class RateConverterTestSuite : public CxxTest::TestSuite
+{
+private:
+	uint32 _seed;
+
+	int16 nextSample() {
+		_seed = _seed * 1103515245 + 12345;
+		// Make full scale samples common, so saturation gets exercised
+		switch ((_seed >> 8) & 7) {
+		case 0:
+			return 32767;
+		case 1:
+			return -32768;
+		default:
+			return (int16)(_seed >> 16);
+		}
+	}
+
+	void mixBufferTestTemplate(const bool stereo, const bool reverseStereo) {
+		static const Audio::st_volume_t volumes[] = { 0, 1, 77, 128, 255, 256 };
+		const int maxFrames = 67;
+
+		Audio::MixBufferProc reference = Audio::getMixBufferProc(stereo, reverseStereo, Audio::kMixBufferScalar);
+		TS_ASSERT(reference != 0);
+
+		int16 input[maxFrames * 2];
+		int16 output[maxFrames * 2];
+		int16 expected[maxFrames * 2];
+
+		for (int impl = Audio::kMixBufferScalar + 1; impl < Audio::kMixBufferImplCount; ++impl) {
+			Audio::MixBufferProc proc = Audio::getMixBufferProc(stereo, reverseStereo, (Audio::MixBufferImpl)impl);
+			if (!proc)
+				continue;
+
+			_seed = impl;
+			for (int frames = 0; frames <= maxFrames; ++frames) {
+				for (int l = 0; l < ARRAYSIZE(volumes); ++l) {
+					const Audio::st_volume_t vol_l = volumes[l];
+					const Audio::st_volume_t vol_r = volumes[ARRAYSIZE(volumes) - 1 - l];
+
+					for (int i = 0; i < maxFrames * 2; ++i) {
+						input[i] = nextSample();
+						output[i] = expected[i] = nextSample();
+					}
+
+					reference(expected, input, frames, vol_l, vol_r);
+					proc(output, input, frames, vol_l, vol_r);
+					TS_ASSERT_EQUALS(memcmp(expected, output, sizeof(output)), 0);
+				}
+			}
+		}
+	}
+
+	void flowTestTemplate(const int inRate, const int outRate, const bool isStereo) {
+		const int time = 1;
+		int16 *sine;
+		Audio::SeekableAudioStream *s = createSineStream<int16>(inRate, time, &sine, false, isStereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, isStereo);
+
+		const int outFrames = outRate * time;
+		int16 *buffer = new int16[outFrames * 2 + 2];
+		memset(buffer, 0, sizeof(int16) * (outFrames * 2 + 2));
+
+		// Request more than available, to check the end of stream handling
+		TS_ASSERT_EQUALS(converter->flow(*s, buffer, outFrames + 1, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), outFrames);
+
+		// The simple converter outputs the last input frame of each step
+		const int step = inRate / outRate;
+		for (int i = 0; i < outFrames; ++i) {
+			const int frame = i * step + step - 1;
+			if (isStereo) {
+				TS_ASSERT_EQUALS(buffer[i * 2 + 0], sine[frame * 2 + 0]);
+				TS_ASSERT_EQUALS(buffer[i * 2 + 1], sine[frame * 2 + 1]);
+			} else {
+				TS_ASSERT_EQUALS(buffer[i * 2 + 0], sine[frame]);
+				TS_ASSERT_EQUALS(buffer[i * 2 + 1], sine[frame]);
+			}
+		}
+		TS_ASSERT_EQUALS(buffer[outFrames * 2 + 0], 0);
+		TS_ASSERT_EQUALS(buffer[outFrames * 2 + 1], 0);
+
+		delete converter;
+		delete[] buffer;
+		delete[] sine;
+		delete s;
+	}
+
+	void linearFlowTestTemplate(const int inRate, const int outRate, const bool isStereo) {
+		const int time = 1;
+		const int channels = isStereo ? 2 : 1;
+		int16 *sine;
+		Audio::SeekableAudioStream *s = createSineStream<int16>(inRate, time, &sine, false, isStereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, isStereo);
+
+		// Interpolate the expected output the way the converter does, until
+		// it runs out of input
+		const int inFrames = inRate * time;
+		const int maxFrames = (int)((int64)inFrames * outRate / inRate) + 2;
+		int16 *expected = new int16[maxFrames * 2];
+		const frac_t inc = ((uint32)inRate << FRAC_BITS) / outRate;
+		frac_t opos = FRAC_ONE;
+		int16 last[2] = { 0, 0 }, cur[2] = { 0, 0 };
+		int inPos = 0, expectedFrames = 0;
+
+		while (expectedFrames < maxFrames) {
+			while ((frac_t)FRAC_ONE <= opos && inPos < inFrames) {
+				for (int c = 0; c < channels; ++c) {
+					last[c] = cur[c];
+					cur[c] = sine[inPos * channels + c];
+				}
+				inPos++;
+				opos -= FRAC_ONE;
+			}
+			if ((frac_t)FRAC_ONE <= opos)
+				break;
+
+			for (int c = 0; c < 2; ++c) {
+				const int i = isStereo ? c : 0;
+				expected[expectedFrames * 2 + c] = (int16)(last[i] + (((cur[i] - last[i]) * opos + FRAC_HALF) >> FRAC_BITS));
+			}
+			expectedFrames++;
+			opos += inc;
+		}
+		TS_ASSERT_LESS_THAN(expectedFrames, maxFrames);
+
+		int16 *buffer = new int16[maxFrames * 2];
+		memset(buffer, 0, sizeof(int16) * maxFrames * 2);
+
+		// Request more than available, to check the end of stream handling
+		TS_ASSERT_EQUALS(converter->flow(*s, buffer, maxFrames, Audio::Mixer::kMaxMixerVolume, Audio::Mixer::kMaxMixerVolume), expectedFrames);
+		TS_ASSERT_EQUALS(memcmp(buffer, expected, sizeof(int16) * expectedFrames * 2), 0);
+		TS_ASSERT_EQUALS(buffer[expectedFrames * 2 + 0], 0);
+		TS_ASSERT_EQUALS(buffer[expectedFrames * 2 + 1], 0);
+
+		delete converter;
+		delete[] buffer;
+		delete[] expected;
+		delete[] sine;
+		delete s;
+	}
+
+public:
+	void test_mix_buffer_mono() {
+		mixBufferTestTemplate(false, false);
+	}
+
+	void test_mix_buffer_stereo() {
+		mixBufferTestTemplate(true, false);
+	}
+
+	void test_mix_buffer_stereo_reverse() {
+		mixBufferTestTemplate(true, true);
+	}
+
+	void test_flow_copy_mono() {
+		flowTestTemplate(22050, 22050, false);
+	}
+
+	void test_flow_copy_stereo() {
+		flowTestTemplate(22050, 22050, true);
+	}
+
+	void test_flow_simple_mono() {
+		flowTestTemplate(44100, 22050, false);
+	}
+
+	void test_flow_simple_stereo() {
+		flowTestTemplate(44100, 22050, true);
+	}
+
+	void test_flow_linear_up_mono() {
+		linearFlowTestTemplate(11025, 44100, false);
+	}
+
+	void test_flow_linear_up_stereo() {
+		linearFlowTestTemplate(22050, 48000, true);
+	}
+
+	void test_flow_linear_down_mono() {
+		linearFlowTestTemplate(48000, 44100, false);
+	}
+
+	void test_flow_linear_down_stereo() {
+		linearFlowTestTemplate(44100, 32000, true);
+	}
+};
@@ -0,0 +1,210 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/workerpool.h"
+
+#if defined(POSIX)
+#include "backends/workerpool/posix/posix-workerpool.h"
+#endif
+#if defined(SDL_BACKEND)
+#include "backends/workerpool/sdl/sdl-workerpool.h"
+#endif
+
+class WorkerPoolTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kJobCount = 64,
+		kInnerJobCount = 4
+	};
+
+	/** A job which marks its slot as done. */
+	struct Job {
+		int value;
+		volatile bool done;
+	};
+
+	static void runJob(void *param) {
+		Job *job = (Job *)param;
+		job->value *= 2;
+		job->done = true;
+	}
+
+	/** A job which runs a group of its own on the same pool. */
+	struct OuterJob {
+		Common::WorkerPool *pool;
+		Job inner[kInnerJobCount];
+		volatile bool done;
+	};
+
+	static void runOuterJob(void *param) {
+		OuterJob *job = (OuterJob *)param;
+
+		Common::JobGroup group(job->pool);
+		for (int i = 0; i < kInnerJobCount; i++)
+			group.add(runJob, &job->inner[i]);
+		group.wait();
+
+		for (int i = 0; i < kInnerJobCount; i++) {
+			if (!job->inner[i].done)
+				return;
+		}
+		job->done = true;
+	}
+
+	/** Create each kind of pool this build has, with the given thread count. */
+	static Common::Array<Common::WorkerPool *> createPools(uint threadCount) {
+		Common::Array<Common::WorkerPool *> pools;
+#if defined(POSIX)
+		pools.push_back(new PosixWorkerPool(threadCount));
+#endif
+#if defined(SDL_BACKEND)
+		pools.push_back(new SdlWorkerPool(threadCount));
+#endif
+		return pools;
+	}
+
+	static void deletePools(Common::Array<Common::WorkerPool *> &pools) {
+		for (uint i = 0; i < pools.size(); i++)
+			delete pools[i];
+		pools.clear();
+	}
+
+	static void initJobs(Job *jobs, int count) {
+		for (int i = 0; i < count; i++) {
+			jobs[i].value = i;
+			jobs[i].done = false;
+		}
+	}
+
+	static bool checkJobs(const Job *jobs, int count) {
+		for (int i = 0; i < count; i++) {
+			if (!jobs[i].done || jobs[i].value != i * 2)
+				return false;
+		}
+		return true;
+	}
+
+	void checkGroup(Common::WorkerPool *pool) {
+		Job jobs[kJobCount];
+		initJobs(jobs, kJobCount);
+
+		Common::JobGroup group(pool);
+		for (int i = 0; i < kJobCount; i++)
+			group.add(runJob, &jobs[i]);
+		group.wait();
+
+		TS_ASSERT(checkJobs(jobs, kJobCount));
+	}
+
+public:
+	void test_group_without_pool() {
+		// The jobs run right away
+		Job job = { 21, false };
+		Common::JobGroup group(0);
+		group.add(runJob, &job);
+		TS_ASSERT(job.done);
+		TS_ASSERT_EQUALS(job.value, 42);
+		group.wait();
+	}
+
+	void test_completion() {
+		// Also without threads, where the waiting thread runs all jobs
+		for (uint threads = 0; threads <= 3; threads++) {
+			Common::Array<Common::WorkerPool *> pools = createPools(threads);
+			for (uint i = 0; i < pools.size(); i++) {
+				TS_ASSERT_EQUALS(pools[i]->getThreadCount(), threads);
+				checkGroup(pools[i]);
+				// The pool is still usable after a group is done
+				checkGroup(pools[i]);
+			}
+			deletePools(pools);
+		}
+	}
+
+	void test_group_destructor_waits() {
+		Common::Array<Common::WorkerPool *> pools = createPools(2);
+		for (uint i = 0; i < pools.size(); i++) {
+			Job jobs[kJobCount];
+			initJobs(jobs, kJobCount);
+			{
+				Common::JobGroup group(pools[i]);
+				for (int j = 0; j < kJobCount; j++)
+					group.add(runJob, &jobs[j]);
+			}
+			TS_ASSERT(checkJobs(jobs, kJobCount));
+		}
+		deletePools(pools);
+	}
+
+	void test_nested_groups() {
+		// More outer jobs than threads: the outer jobs block every thread
+		// and can only get through by running their own inner jobs
+		for (uint threads = 0; threads <= 2; threads++) {
+			Common::Array<Common::WorkerPool *> pools = createPools(threads);
+			for (uint i = 0; i < pools.size(); i++) {
+				OuterJob jobs[8];
+				Common::JobGroup group(pools[i]);
+				for (int j = 0; j < (int)ARRAYSIZE(jobs); j++) {
+					jobs[j].pool = pools[i];
+					jobs[j].done = false;
+					initJobs(jobs[j].inner, kInnerJobCount);
+					group.add(runOuterJob, &jobs[j]);
+				}
+				group.wait();
+
+				for (int j = 0; j < (int)ARRAYSIZE(jobs); j++)
+					TS_ASSERT(jobs[j].done);
+			}
+			deletePools(pools);
+		}
+	}
+
+	void test_wait_runs_own_jobs_only() {
+		// Without threads, nothing runs the other group's job
+		Common::Array<Common::WorkerPool *> pools = createPools(0);
+		for (uint i = 0; i < pools.size(); i++) {
+			Job mine = { 1, false };
+			Job other = { 2, false };
+			int32 myPending = 0;
+			int32 otherPending = 0;
+
+			pools[i]->addJob(runJob, &other, &otherPending);
+			pools[i]->addJob(runJob, &mine, &myPending);
+			TS_ASSERT_EQUALS(myPending, 1);
+			TS_ASSERT_EQUALS(otherPending, 1);
+
+			pools[i]->waitForJobs(&myPending);
+			TS_ASSERT(mine.done);
+			TS_ASSERT_EQUALS(myPending, 0);
+			TS_ASSERT(!other.done);
+			TS_ASSERT_EQUALS(otherPending, 1);
+
+			pools[i]->waitForJobs(&otherPending);
+			TS_ASSERT(other.done);
+			TS_ASSERT_EQUALS(otherPending, 0);
+		}
+		deletePools(pools);
+	}
+
+	void test_shutdown_drains_queue() {
+		// Jobs which are never waited for still run before the pool is gone
+		for (uint threads = 0; threads <= 2; threads++) {
+			Common::Array<Common::WorkerPool *> pools = createPools(threads);
+			for (uint i = 0; i < pools.size(); i++) {
+				Job jobs[kJobCount];
+				initJobs(jobs, kJobCount);
+				int32 pending = 0;
+
+				for (int j = 0; j < kJobCount; j++)
+					pools[i]->addJob(runJob, &jobs[j], &pending);
+				delete pools[i];
+				pools[i] = 0;
+
+				TS_ASSERT(checkJobs(jobs, kJobCount));
+				TS_ASSERT_EQUALS(pending, 0);
+			}
+			deletePools(pools);
+		}
+	}
+};
@@ -0,0 +1,107 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+
+#include "base/pluginindex.h"
+
+class PluginIndexTestSuite : public CxxTest::TestSuite
+{
+private:
+	static void fillIndex(PluginIndex &index) {
+		index.clear("stamp");
+		index.addEngine("SCUMM", "LucasArts");
+		index.addGame("tentacle", "Day of the Tentacle", "plugins/libscumm.so");
+		index.addGame("monkey", "The Secret of Monkey Island", "plugins/libscumm.so");
+		index.addEngine("Sky", "Revolution");
+		index.addGame("sky", "Beneath a Steel Sky", "");
+	}
+
+public:
+	void test_lookup() {
+		PluginIndex index;
+		fillIndex(index);
+
+		TS_ASSERT_EQUALS(index.getStamp(), "stamp");
+		TS_ASSERT_EQUALS(index.getFileName("monkey"), "plugins/libscumm.so");
+		// Static plugins have no file, and unknown games none either
+		TS_ASSERT_EQUALS(index.getFileName("sky"), "");
+		TS_ASSERT_EQUALS(index.getFileName("queen"), "");
+
+		GameList games = index.getGames();
+		TS_ASSERT_EQUALS(games.size(), 3u);
+		TS_ASSERT_EQUALS(games[0].gameid(), "monkey");
+		TS_ASSERT_EQUALS(games[0].description(), "The Secret of Monkey Island");
+		TS_ASSERT_EQUALS(games[1].gameid(), "sky");
+		TS_ASSERT_EQUALS(games[2].gameid(), "tentacle");
+
+		TS_ASSERT_EQUALS(index.getEngines().size(), 2u);
+		TS_ASSERT_EQUALS(index.getEngines()["Sky"], "Revolution");
+	}
+
+	void test_first_plugin_wins() {
+		PluginIndex index;
+		fillIndex(index);
+
+		index.addEngine("SCUMM", "Somebody else");
+		index.addGame("monkey", "Another Monkey Island", "plugins/libother.so");
+		TS_ASSERT_EQUALS(index.getEngines()["SCUMM"], "LucasArts");
+		TS_ASSERT_EQUALS(index.getFileName("monkey"), "plugins/libscumm.so");
+		TS_ASSERT_EQUALS(index.getGames().size(), 3u);
+	}
+
+	void test_clear() {
+		PluginIndex index;
+		fillIndex(index);
+
+		index.clear("other");
+		TS_ASSERT_EQUALS(index.getStamp(), "other");
+		TS_ASSERT(index.getGames().empty());
+		TS_ASSERT(index.getEngines().empty());
+	}
+
+	void test_round_trip() {
+		PluginIndex index;
+		fillIndex(index);
+
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+		index.save(out);
+
+		PluginIndex loaded;
+		Common::MemoryReadStream in(out.getData(), out.size());
+		TS_ASSERT(loaded.load(in));
+		TS_ASSERT_EQUALS(loaded.getStamp(), "stamp");
+		TS_ASSERT_EQUALS(loaded.getFileName("tentacle"), "plugins/libscumm.so");
+		TS_ASSERT_EQUALS(loaded.getFileName("sky"), "");
+		TS_ASSERT_EQUALS(loaded.getEngines()["SCUMM"], "LucasArts");
+
+		GameList games = loaded.getGames();
+		TS_ASSERT_EQUALS(games.size(), 3u);
+		TS_ASSERT_EQUALS(games[2].description(), "Day of the Tentacle");
+	}
+
+	void test_broken_data() {
+		PluginIndex index;
+		fillIndex(index);
+
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+		index.save(out);
+
+		// Truncated data is rejected, and leaves the index alone
+		PluginIndex loaded;
+		loaded.clear("old");
+		loaded.addGame("queen", "Flight of the Amazon Queen", "plugins/libqueen.so");
+		Common::MemoryReadStream truncated(out.getData(), out.size() - 1);
+		TS_ASSERT(!loaded.load(truncated));
+		TS_ASSERT_EQUALS(loaded.getStamp(), "old");
+		TS_ASSERT_EQUALS(loaded.getFileName("queen"), "plugins/libqueen.so");
+		TS_ASSERT_EQUALS(loaded.getGames().size(), 1u);
+
+		// So is anything which is not an index
+		byte *garbage = (byte *)malloc(out.size());
+		memcpy(garbage, out.getData(), out.size());
+		garbage[0] ^= 0xFF;
+		Common::MemoryReadStream wrongTag(garbage, out.size(), DisposeAfterUse::YES);
+		TS_ASSERT(!loaded.load(wrongTag));
+		TS_ASSERT_EQUALS(loaded.getStamp(), "old");
+	}
+};
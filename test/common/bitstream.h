@@ -0,0 +1,145 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bitstream.h"
+#include "common/memstream.h"
+
+class BitStreamTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kDataSize = 255
+	};
+
+	byte _data[kDataSize];
+
+	/** Reference implementation: return bit i of the data in the given layout. */
+	template<int valueBits, bool isLE, bool isMSB2LSB>
+	uint32 refBit(uint32 i) {
+		const uint32 bytes = valueBits / 8;
+		const byte *p = _data + (i / valueBits) * bytes;
+
+		uint32 value = 0;
+		for (uint32 j = 0; j < bytes; j++)
+			value |= p[j] << (8 * (isLE ? j : (bytes - 1 - j)));
+
+		const uint32 k = i % valueBits;
+		return (value >> (isMSB2LSB ? (valueBits - 1 - k) : k)) & 1;
+	}
+
+	template<int valueBits, bool isLE, bool isMSB2LSB>
+	uint32 refBits(uint32 i, uint8 n) {
+		uint32 v = 0;
+		for (uint32 j = 0; j < n; j++) {
+			if (isMSB2LSB)
+				v = (v << 1) | refBit<valueBits, isLE, isMSB2LSB>(i + j);
+			else
+				v |= refBit<valueBits, isLE, isMSB2LSB>(i + j) << j;
+		}
+		return v;
+	}
+
+	/** Run a fixed pseudo-random mix of reads on bits and compare against the reference. */
+	template<int valueBits, bool isLE, bool isMSB2LSB, class BITSTREAM>
+	void checkReads(BITSTREAM &bits) {
+		const uint32 size = (kDataSize & ~(valueBits / 8 - 1)) * 8;
+		TS_ASSERT_EQUALS(bits.size(), size);
+		TS_ASSERT_EQUALS(bits.pos(), 0u);
+
+		uint32 seed = 1;
+		uint32 pos = 0;
+		while (pos + 100 < size) {
+			seed = seed * 1103515245 + 12345;
+			const uint8 n = (seed >> 16) % 33;
+
+			switch ((seed >> 24) % 5) {
+			case 0:
+				TS_ASSERT_EQUALS(bits.getBits(n), (refBits<valueBits, isLE, isMSB2LSB>(pos, n)));
+				pos += n;
+				break;
+			case 1:
+				TS_ASSERT_EQUALS(bits.peekBits(n), (refBits<valueBits, isLE, isMSB2LSB>(pos, n)));
+				break;
+			case 2:
+				bits.skip(n * 2);
+				pos += n * 2;
+				break;
+			case 3:
+				TS_ASSERT_EQUALS(bits.getBit(), (refBit<valueBits, isLE, isMSB2LSB>(pos)));
+				pos++;
+				break;
+			default: {
+				uint32 x = 0;
+				for (uint32 i = 0; i < (n & 15); i++)
+					bits.addBit(x, i);
+				TS_ASSERT_EQUALS(x, (refBits<valueBits, isLE, isMSB2LSB>(pos, n & 15)));
+				pos += n & 15;
+				break;
+			}
+			}
+
+			TS_ASSERT_EQUALS(bits.pos(), pos);
+		}
+
+		// Read up to the very end
+		while (pos < size) {
+			const uint8 n = MIN<uint32>(size - pos, 32);
+			TS_ASSERT_EQUALS(bits.getBits(n), (refBits<valueBits, isLE, isMSB2LSB>(pos, n)));
+			pos += n;
+		}
+		TS_ASSERT(bits.eos());
+
+		bits.rewind();
+		TS_ASSERT_EQUALS(bits.pos(), 0u);
+		TS_ASSERT(!bits.eos());
+		TS_ASSERT_EQUALS(bits.getBits(32), (refBits<valueBits, isLE, isMSB2LSB>(0, 32)));
+	}
+
+	template<int valueBits, bool isLE, bool isMSB2LSB>
+	void checkLayout() {
+		Common::MemoryReadStream stream(_data, kDataSize);
+		Common::BitStreamImpl<valueBits, isLE, isMSB2LSB> bitStream(stream);
+		checkReads<valueBits, isLE, isMSB2LSB>(bitStream);
+
+		Common::BitStreamReader<Common::BitStreamMemoryStream, valueBits, isLE, isMSB2LSB>
+			reader(new Common::BitStreamMemoryStream(_data, kDataSize), true);
+		checkReads<valueBits, isLE, isMSB2LSB>(reader);
+	}
+
+public:
+	void setUp() {
+		uint32 seed = 0x1234;
+		for (int i = 0; i < kDataSize; i++) {
+			seed = seed * 1103515245 + 12345;
+			_data[i] = seed >> 16;
+		}
+	}
+
+	void test_8bit() {
+		checkLayout<8, false, true >();
+		checkLayout<8, false, false>();
+	}
+
+	void test_16bit() {
+		checkLayout<16, true , true >();
+		checkLayout<16, true , false>();
+		checkLayout<16, false, true >();
+		checkLayout<16, false, false>();
+	}
+
+	void test_32bit() {
+		checkLayout<32, true , true >();
+		checkLayout<32, true , false>();
+		checkLayout<32, false, true >();
+		checkLayout<32, false, false>();
+	}
+
+	void test_stream_offset() {
+		// A bit stream starts at the current position of its stream
+		Common::MemoryReadStream stream(_data, kDataSize);
+		stream.seek(4);
+
+		Common::BitStream8MSB bits(stream);
+		TS_ASSERT_EQUALS(bits.pos(), 32u);
+		TS_ASSERT_EQUALS(bits.getBits(8), (uint32)_data[4]);
+		TS_ASSERT_EQUALS(bits.pos(), 40u);
+	}
+};
@@ -0,0 +1,128 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/cosinetables.h"
+#include "common/dct.h"
+#include "common/fft.h"
+#include "common/sinetables.h"
+
+class FFTTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kMaxBits = 12
+	};
+
+	Common::Complex _input[1 << kMaxBits];
+
+	void fillInput(int n) {
+		uint32 seed = 1;
+		for (int i = 0; i < n; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_input[i].re = ((seed >> 16) & 0xFFFF) / 32768.0f - 1.0f;
+			seed = seed * 1103515245 + 12345;
+			_input[i].im = ((seed >> 16) & 0xFFFF) / 32768.0f - 1.0f;
+		}
+	}
+
+	void calcFFT(int bits, int inverse, Common::FFTImpl impl, Common::Complex *z) {
+		memcpy(z, _input, sizeof(Common::Complex) << bits);
+		Common::FFT fft(bits, inverse, impl);
+		fft.permute(z);
+		fft.calc(z);
+	}
+
+public:
+	void test_fft_matches_dft() {
+		const int bits = 7, n = 1 << bits;
+		fillInput(n);
+
+		Common::Complex z[n];
+		for (int impl = Common::kFFTScalar; impl < Common::kFFTImplCount; ++impl) {
+			if (!Common::hasFFTImpl((Common::FFTImpl)impl))
+				continue;
+
+			for (int inverse = 0; inverse < 2; ++inverse) {
+				calcFFT(bits, inverse, (Common::FFTImpl)impl, z);
+
+				const double sign = inverse ? 1.0 : -1.0;
+				for (int k = 0; k < n; ++k) {
+					double re = 0.0, im = 0.0;
+					for (int j = 0; j < n; ++j) {
+						const double angle = sign * 2 * M_PI * ((j * k) % n) / n;
+						re += _input[j].re * cos(angle) - _input[j].im * sin(angle);
+						im += _input[j].re * sin(angle) + _input[j].im * cos(angle);
+					}
+
+					TS_ASSERT_DELTA(z[k].re, re, 1e-3);
+					TS_ASSERT_DELTA(z[k].im, im, 1e-3);
+				}
+			}
+		}
+	}
+
+	void test_fft_impls_agree() {
+		fillInput(1 << kMaxBits);
+
+		Common::Complex *expected = new Common::Complex[1 << kMaxBits];
+		Common::Complex *actual = new Common::Complex[1 << kMaxBits];
+
+		for (int bits = 2; bits <= kMaxBits; ++bits) {
+			calcFFT(bits, 0, Common::kFFTScalar, expected);
+
+			for (int impl = Common::kFFTScalar + 1; impl < Common::kFFTImplCount; ++impl) {
+				if (!Common::hasFFTImpl((Common::FFTImpl)impl))
+					continue;
+
+				// The same operations are done in the same order, but the
+				// scalar code may keep intermediate results at a higher
+				// precision on some targets.
+				calcFFT(bits, 0, (Common::FFTImpl)impl, actual);
+				for (int k = 0; k < (1 << bits); ++k) {
+					TS_ASSERT_DELTA(actual[k].re, expected[k].re, 1e-4);
+					TS_ASSERT_DELTA(actual[k].im, expected[k].im, 1e-4);
+				}
+			}
+		}
+
+		delete[] expected;
+		delete[] actual;
+	}
+
+	void test_dct_iii() {
+		const int bits = 6, n = 1 << bits;
+		fillInput(n);
+
+		float data[n + 1];
+		for (int i = 0; i < n; ++i)
+			data[i] = _input[i].re;
+
+		Common::DCT dct(bits, Common::DCT::DCT_III);
+		dct.calc(data);
+
+		for (int k = 0; k < n; ++k) {
+			double sum = _input[0].re * 0.5;
+			for (int j = 1; j < n; ++j)
+				sum += _input[j].re * cos(M_PI / n * (k + 0.5) * j);
+
+			TS_ASSERT_DELTA(data[k], sum * 2 / n, 1e-5);
+		}
+	}
+
+	void test_shared_tables() {
+		const float *cosTable;
+		{
+			Common::CosineTable table(10);
+			cosTable = table.getTable();
+		}
+
+		// The table outlives the object and is shared with new ones
+		Common::CosineTable table(10);
+		TS_ASSERT_EQUALS(table.getTable(), cosTable);
+		TS_ASSERT_DIFFERS(Common::CosineTable(11).getTable(), cosTable);
+
+		Common::SineTable sineTable(10);
+		for (int i = 0; i < 512; ++i) {
+			TS_ASSERT_DELTA(cosTable[i], cos(2 * M_PI * (i <= 256 ? i : 512 - i) / 1024), 1e-6);
+			TS_ASSERT_DELTA(sineTable.getTable()[i], sin(2 * M_PI * (i <= 256 ? i : 512 - i) / 1024), 1e-6);
+		}
+	}
+};
@@ -0,0 +1,115 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "common/zlib.h"
+
+class GZipReadStreamTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		// Large enough for a couple of seek checkpoints
+		kPayloadSize = 1200 * 1024
+	};
+
+	byte *_payload;
+	byte *_gzipData;
+	uint32 _gzipSize;
+
+	void checkContents(Common::SeekableReadStream *s, uint32 offset, uint32 len) {
+		byte *buf = new byte[len];
+		TS_ASSERT(s->seek(offset, SEEK_SET));
+		TS_ASSERT_EQUALS((uint32)s->pos(), offset);
+		TS_ASSERT_EQUALS(s->read(buf, len), len);
+		TS_ASSERT_EQUALS(memcmp(buf, _payload + offset, len), 0);
+		TS_ASSERT_EQUALS((uint32)s->pos(), offset + len);
+		delete[] buf;
+	}
+
+public:
+	void setUp() {
+		_payload = new byte[kPayloadSize];
+		uint32 seed = 1;
+		for (int i = 0; i < kPayloadSize; ++i) {
+			seed = seed * 1103515245 + 12345;
+			_payload[i] = (i & 0x100) ? (byte)(seed >> 16) & 0x0F : (byte)(i >> 3);
+		}
+
+		Common::MemoryWriteStreamDynamic *gzipData = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(gzipData);
+		gzip->write(_payload, kPayloadSize);
+		gzip->finalize();
+		_gzipData = gzipData->getData();
+		_gzipSize = gzipData->size();
+		delete gzip;
+	}
+
+	void tearDown() {
+		free(_gzipData);
+		delete[] _payload;
+	}
+
+#if defined(USE_ZLIB)
+	void test_read_all() {
+		Common::SeekableReadStream *s = Common::wrapCompressedReadStream(new Common::MemoryReadStream(_gzipData, _gzipSize));
+		TS_ASSERT(s);
+		TS_ASSERT_EQUALS(s->size(), kPayloadSize);
+		checkContents(s, 0, kPayloadSize);
+
+		byte tmp[16];
+		TS_ASSERT_EQUALS(s->read(tmp, sizeof(tmp)), 0u);
+		TS_ASSERT(s->eos());
+		delete s;
+	}
+
+	void test_seek() {
+		Common::SeekableReadStream *s = Common::wrapCompressedReadStream(new Common::MemoryReadStream(_gzipData, _gzipSize));
+		TS_ASSERT(s);
+
+		// Forward seek past several checkpoint positions, then jump around
+		checkContents(s, 1000000, 1000);
+		checkContents(s, 300000, 70000);
+		checkContents(s, 5, 10);
+		checkContents(s, 700000, 200000);
+		checkContents(s, 262144, 1);
+		checkContents(s, 262143, 2);
+		checkContents(s, kPayloadSize - 100, 100);
+		checkContents(s, 1100000, 100);
+
+		TS_ASSERT(s->seek(-100, SEEK_CUR));
+		TS_ASSERT_EQUALS(s->pos(), 1100000);
+		TS_ASSERT_EQUALS(s->readByte(), _payload[1100000]);
+		delete s;
+	}
+
+	void test_seek_long_stream() {
+		// Long enough for the checkpoints to be thinned out twice
+		const uint32 size = 12 * 1024 * 1024;
+		byte *payload = new byte[size];
+		for (uint32 i = 0; i < size; ++i)
+			payload[i] = (byte)((i >> 4) ^ (i >> 13) ^ (i * 7));
+
+		Common::MemoryWriteStreamDynamic *gzipData = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(gzipData);
+		gzip->write(payload, size);
+		gzip->finalize();
+
+		Common::SeekableReadStream *s = Common::wrapCompressedReadStream(new Common::MemoryReadStream(gzipData->getData(), gzipData->size()));
+		TS_ASSERT(s);
+
+		// Jump around the positions of dropped and kept checkpoints
+		const uint32 offsets[] = {
+			size - 10, 256 * 1024, 512 * 1024 - 1, 3 * 1024 * 1024 + 5,
+			8 * 1024 * 1024, 4 * 1024 * 1024 - 2, 11 * 1024 * 1024, 1
+		};
+		byte buf[16];
+		for (uint i = 0; i < ARRAYSIZE(offsets); ++i) {
+			TS_ASSERT(s->seek(offsets[i], SEEK_SET));
+			TS_ASSERT_EQUALS(s->read(buf, 10), 10u);
+			TS_ASSERT_EQUALS(memcmp(buf, payload + offsets[i], 10), 0);
+		}
+
+		delete s;
+		delete gzip;
+		delete[] payload;
+	}
+#endif
+};
@@ -0,0 +1,139 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/bitstream.h"
+#include "common/huffman.h"
+#include "common/memstream.h"
+
+class HuffmanTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kSymbolCount = 2000
+	};
+
+	uint32 _seed;
+
+	uint32 getRandom() {
+		_seed = _seed * 1103515245 + 12345;
+		return _seed >> 16;
+	}
+
+	/**
+	 * Create a complete prefix code with codeCount codes by splitting
+	 * random leaves of the code tree. The codes are stored with the first
+	 * bit as the highest one.
+	 */
+	void createCode(uint32 codeCount, uint8 maxLength, Common::Array<uint32> &codes, Common::Array<uint8> &lengths) {
+		codes.clear();
+		lengths.clear();
+		codes.push_back(0);
+		lengths.push_back(0);
+
+		while (codes.size() < codeCount) {
+			// Prefer the last leaves, to also get some long codes
+			uint32 i = codes.size() - 1 - getRandom() % MIN<uint32>(codes.size(), 3);
+			if (lengths[i] >= maxLength)
+				i = getRandom() % codes.size();
+			if (lengths[i] >= maxLength)
+				continue;
+
+			codes.push_back((codes[i] << 1) | 1);
+			lengths.push_back(lengths[i] + 1);
+			codes[i] <<= 1;
+			lengths[i]++;
+		}
+	}
+
+	/** Reverse the lowest n bits of value. */
+	static uint32 reverseBits(uint32 value, uint8 n) {
+		uint32 r = 0;
+		for (uint8 i = 0; i < n; i++)
+			r |= ((value >> i) & 1) << (n - 1 - i);
+		return r;
+	}
+
+	/** Encode symbols into bytes, with the bits in the order of MSB to LSB, or the other way round. */
+	static byte *encode(const Common::Array<uint32> &symbols, const Common::Array<uint32> &codes,
+	                    const Common::Array<uint8> &lengths, bool msb2lsb, uint32 &size) {
+		uint32 bitCount = 0;
+		for (uint32 i = 0; i < symbols.size(); i++)
+			bitCount += lengths[symbols[i]];
+
+		size = (bitCount + 7) / 8;
+		byte *data = (byte *)calloc(size, 1);
+
+		uint32 pos = 0;
+		for (uint32 i = 0; i < symbols.size(); i++) {
+			for (int j = lengths[symbols[i]] - 1; j >= 0; j--, pos++) {
+				if ((codes[symbols[i]] >> j) & 1)
+					data[pos / 8] |= msb2lsb ? (0x80 >> (pos % 8)) : (1 << (pos % 8));
+			}
+		}
+
+		return data;
+	}
+
+	void checkCode(uint32 codeCount, uint8 maxLength) {
+		Common::Array<uint32> codes;
+		Common::Array<uint8> lengths;
+		createCode(codeCount, maxLength, codes, lengths);
+
+		Common::Array<uint32> symbols;
+		for (uint32 i = 0; i < kSymbolCount; i++)
+			symbols.push_back(getRandom() % codeCount);
+
+		// Decode with their own symbols, which aren't the code indices
+		Common::Array<uint32> values;
+		for (uint32 i = 0; i < codeCount; i++)
+			values.push_back(i * 7 + 3);
+
+		// With MSB2LSB, the codes are read highest bit first
+		{
+			Common::Huffman huffman(0, codeCount, codes.begin(), lengths.begin(), values.begin());
+
+			uint32 size;
+			byte *data = encode(symbols, codes, lengths, true, size);
+
+			Common::MemoryReadStream stream(data, size);
+			Common::BitStream8MSB bits(stream);
+			for (uint32 i = 0; i < symbols.size(); i++)
+				TS_ASSERT_EQUALS(huffman.getSymbol(bits), values[symbols[i]]);
+
+			free(data);
+		}
+
+		// With LSB2MSB, the codes are read lowest bit first
+		{
+			Common::Array<uint32> lsbCodes;
+			for (uint32 i = 0; i < codeCount; i++)
+				lsbCodes.push_back(reverseBits(codes[i], lengths[i]));
+
+			Common::Huffman huffman(0, codeCount, lsbCodes.begin(), lengths.begin());
+			huffman.setSymbols(values.begin());
+
+			uint32 size;
+			byte *data = encode(symbols, codes, lengths, false, size);
+
+			Common::BitStreamMemory8LSB bits(new Common::BitStreamMemoryStream(data, size, DisposeAfterUse::YES), true);
+			for (uint32 i = 0; i < symbols.size(); i++)
+				TS_ASSERT_EQUALS(huffman.getSymbol(bits), values[symbols[i]]);
+		}
+	}
+
+public:
+	void setUp() {
+		_seed = 1;
+	}
+
+	void test_short_codes() {
+		checkCode(2, 1);
+		checkCode(16, 8);
+		checkCode(40, 9);
+	}
+
+	void test_long_codes() {
+		// Longer than one table, up to a third level
+		checkCode(64, 12);
+		checkCode(300, 20);
+		checkCode(500, 32);
+	}
+};
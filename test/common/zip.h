@@ -0,0 +1,238 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+class ZipArchiveTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kPayloadSize = 100000
+	};
+
+	byte *_payload;
+	byte *_zipData;
+	uint32 _zipSize;
+
+	struct Member {
+		const char *name;
+		uint16 method;
+		const byte *data;
+		uint32 compressedSize;
+		uint32 crc;
+		uint32 offset;
+	};
+
+	static void writeHeader(Common::WriteStream &out, uint32 signature, const Member &m, uint32 crc, uint32 size) {
+		out.writeUint32LE(signature);
+		if (signature == 0x02014b50)
+			out.writeUint16LE(20);	// version made by
+		out.writeUint16LE(20);		// version needed to extract
+		out.writeUint16LE(0);		// flags
+		out.writeUint16LE(m.method);
+		out.writeUint32LE(0);		// time and date
+		out.writeUint32LE(crc);
+		out.writeUint32LE(m.compressedSize);
+		out.writeUint32LE(size);
+		out.writeUint16LE(strlen(m.name));
+		out.writeUint16LE(0);		// extra field length
+		if (signature == 0x02014b50) {
+			out.writeUint16LE(0);	// comment length
+			out.writeUint16LE(0);	// disk number
+			out.writeUint16LE(0);	// internal attributes
+			out.writeUint32LE(0);	// external attributes
+			out.writeUint32LE(m.offset);
+		}
+		out.write(m.name, strlen(m.name));
+	}
+
+	Common::Archive *openArchive() {
+		return Common::makeZipArchive(new Common::MemoryReadStream(_zipData, _zipSize));
+	}
+
+	void checkContents(Common::SeekableReadStream *s, uint32 offset, uint32 len) {
+		byte *buf = new byte[len];
+		TS_ASSERT(s->seek(offset, SEEK_SET));
+		TS_ASSERT_EQUALS(s->read(buf, len), len);
+		TS_ASSERT_EQUALS(memcmp(buf, _payload + offset, len), 0);
+		delete[] buf;
+	}
+
+public:
+	void setUp() {
+		_payload = new byte[kPayloadSize];
+		uint32 seed = 1;
+		for (int i = 0; i < kPayloadSize; ++i) {
+			seed = seed * 1103515245 + 12345;
+			// Compressible, but not trivially so
+			_payload[i] = (i & 0x100) ? (byte)(seed >> 16) & 0x0F : (byte)(i >> 3);
+		}
+
+		// Let the gzip writer do the deflating; the raw deflate data is
+		// what lies between its 10 byte header and 8 byte trailer.
+		Common::MemoryWriteStreamDynamic *gzipData = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::NO);
+		Common::WriteStream *gzip = Common::wrapCompressedWriteStream(gzipData);
+		gzip->write(_payload, kPayloadSize);
+		gzip->finalize();
+		byte *gzipBuf = gzipData->getData();
+		const uint32 gzipSize = gzipData->size();
+		delete gzip;
+
+#if defined(USE_ZLIB)
+		const uint32 crc = READ_LE_UINT32(gzipBuf + gzipSize - 8);
+		Member members[4] = {
+			{ "stored.bin",   0, _payload,        kPayloadSize,   crc,     0 },
+			{ "deflated.bin", 8, gzipBuf + 10, gzipSize - 18,  crc,     0 },
+			{ "badcrc.bin",   0, _payload,        kPayloadSize,   crc ^ 1, 0 },
+			{ "badcrc.z",     8, gzipBuf + 10, gzipSize - 18,  crc ^ 1, 0 }
+		};
+#else
+		const uint32 crc = 0;
+		Member members[1] = {
+			{ "stored.bin",   0, _payload,        kPayloadSize,   crc,     0 }
+		};
+#endif
+
+		Common::MemoryWriteStreamDynamic zip(DisposeAfterUse::NO);
+		for (int i = 0; i < ARRAYSIZE(members); ++i) {
+			members[i].offset = zip.pos();
+			writeHeader(zip, 0x04034b50, members[i], members[i].crc, kPayloadSize);
+			zip.write(members[i].data, members[i].compressedSize);
+		}
+
+		const uint32 centralDirOffset = zip.pos();
+		for (int i = 0; i < ARRAYSIZE(members); ++i)
+			writeHeader(zip, 0x02014b50, members[i], members[i].crc, kPayloadSize);
+		const uint32 centralDirSize = zip.pos() - centralDirOffset;
+
+		zip.writeUint32LE(0x06054b50);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(0);
+		zip.writeUint16LE(ARRAYSIZE(members));
+		zip.writeUint16LE(ARRAYSIZE(members));
+		zip.writeUint32LE(centralDirSize);
+		zip.writeUint32LE(centralDirOffset);
+		zip.writeUint16LE(0);
+
+		_zipData = zip.getData();
+		_zipSize = zip.size();
+		free(gzipBuf);
+	}
+
+	void tearDown() {
+		free(_zipData);
+		delete[] _payload;
+	}
+
+	void test_stored_member() {
+		Common::Archive *archive = openArchive();
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *s = archive->createReadStreamForMember("stored.bin");
+		TS_ASSERT(s);
+		TS_ASSERT_EQUALS(s->size(), kPayloadSize);
+		checkContents(s, 0, kPayloadSize);
+		checkContents(s, 1234, 5678);
+
+		delete s;
+		delete archive;
+	}
+
+#if defined(USE_ZLIB)
+	void test_deflated_member() {
+		Common::Archive *archive = openArchive();
+		TS_ASSERT(archive);
+
+		Common::SeekableReadStream *s = archive->createReadStreamForMember("deflated.bin");
+		TS_ASSERT(s);
+		TS_ASSERT_EQUALS(s->size(), kPayloadSize);
+		checkContents(s, 0, kPayloadSize);
+
+		// Reading past the end must stop at the known size
+		byte tmp[16];
+		TS_ASSERT_EQUALS(s->read(tmp, sizeof(tmp)), 0u);
+		TS_ASSERT(s->eos());
+
+		// Backward seeks
+		checkContents(s, 50000, 100);
+		checkContents(s, 10, 100);
+		checkContents(s, kPayloadSize - 1, 1);
+
+		// Seeking past the end must stop at the known size, too
+		s->seek(kPayloadSize + 1000, SEEK_SET);
+		TS_ASSERT_EQUALS(s->pos(), kPayloadSize);
+
+		delete s;
+		delete archive;
+	}
+
+	void test_crc() {
+		Common::Archive *archive = openArchive();
+		const char *const good[] = { "stored.bin", "deflated.bin" };
+		const char *const bad[] = { "badcrc.bin", "badcrc.z" };
+
+		for (int i = 0; i < ARRAYSIZE(good); ++i) {
+			Common::SeekableReadStream *s = archive->createReadStreamForMember(good[i]);
+			TS_ASSERT(s);
+			checkContents(s, 0, kPayloadSize);
+			TS_ASSERT(!s->err());
+			delete s;
+		}
+
+		for (int i = 0; i < ARRAYSIZE(bad); ++i) {
+			// The data is read as usual, but the error shows at the end,
+			// even when parts were read twice or out of order
+			Common::SeekableReadStream *s = archive->createReadStreamForMember(bad[i]);
+			TS_ASSERT(s);
+			checkContents(s, 0, 1000);
+			checkContents(s, 50000, 1000);
+			checkContents(s, 500, 20000);
+			TS_ASSERT(!s->err());
+			checkContents(s, 20500, kPayloadSize - 20500);
+			TS_ASSERT(s->err());
+			delete s;
+		}
+
+		delete archive;
+	}
+
+	void test_independent_readers() {
+		Common::Archive *archive = openArchive();
+
+		Common::SeekableReadStream *s1 = archive->createReadStreamForMember("deflated.bin");
+		Common::SeekableReadStream *s2 = archive->createReadStreamForMember("deflated.bin");
+		Common::SeekableReadStream *s3 = archive->createReadStreamForMember("stored.bin");
+		TS_ASSERT(s1 && s2 && s3);
+
+		s2->seek(40000, SEEK_SET);
+		s3->seek(70000, SEEK_SET);
+		for (int i = 0; i < 20000; ++i) {
+			TS_ASSERT_EQUALS(s1->readByte(), _payload[i]);
+			TS_ASSERT_EQUALS(s2->readByte(), _payload[40000 + i]);
+			TS_ASSERT_EQUALS(s3->readByte(), _payload[70000 + i]);
+		}
+
+		delete s1;
+		delete s2;
+		delete s3;
+		delete archive;
+	}
+#endif
+
+	void test_member_outlives_archive() {
+		Common::Archive *archive = openArchive();
+		Common::SeekableReadStream *s = archive->createReadStreamForMember("stored.bin");
+		delete archive;
+
+		TS_ASSERT(s);
+		checkContents(s, 0, kPayloadSize);
+		delete s;
+	}
+
+	void test_missing_member() {
+		Common::Archive *archive = openArchive();
+		TS_ASSERT(!archive->createReadStreamForMember("missing.bin"));
+		delete archive;
+	}
+};
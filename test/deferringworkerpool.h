@@ -0,0 +1,70 @@
+#ifndef TEST_DEFERRINGWORKERPOOL_H
+#define TEST_DEFERRINGWORKERPOOL_H
+
+#include "common/util.h"
+#include "common/workerpool.h"
+
+// Quoted, this would find the test suite in test/common/list.h
+#include <common/list.h>
+
+/**
+ * Worker pool without threads, which keeps the jobs queued until they are
+ * waited for or runJobs() is called. This way, tests decide when the jobs
+ * run and can see how many are in flight.
+ */
+class DeferringWorkerPool : public Common::WorkerPool {
+public:
+	/** @param threadCount	the thread count to report, which users size their work by */
+	DeferringWorkerPool(uint threadCount = 1) : _threadCount(threadCount), _maxQueued(0) {}
+
+	virtual uint getThreadCount() const { return _threadCount; }
+
+	virtual void addJob(JobProc proc, void *param, int32 *pending) {
+		Job job = { proc, param, pending };
+		(*pending)++;
+		_jobs.push_back(job);
+		_maxQueued = MAX<uint>(_maxQueued, _jobs.size());
+	}
+
+	/** Run the queued jobs counted by *pending, like the real pools. */
+	virtual void waitForJobs(const int32 *pending) {
+		while (*pending > 0) {
+			JobList::iterator i = _jobs.begin();
+			while (i != _jobs.end() && i->pending != pending)
+				++i;
+			assert(i != _jobs.end());
+			runJob(i);
+		}
+	}
+
+	/** Run all queued jobs, including the ones they queue. */
+	void runJobs() {
+		while (!_jobs.empty())
+			runJob(_jobs.begin());
+	}
+
+	uint getQueuedCount() const { return _jobs.size(); }
+	uint getMaxQueuedCount() const { return _maxQueued; }
+
+private:
+	struct Job {
+		JobProc proc;
+		void *param;
+		int32 *pending;
+	};
+
+	typedef Common::List<Job> JobList;
+
+	void runJob(JobList::iterator i) {
+		const Job job = *i;
+		_jobs.erase(i);
+		job.proc(job.param);
+		(*job.pending)--;
+	}
+
+	const uint _threadCount;
+	JobList _jobs;
+	uint _maxQueued;
+};
+
+#endif
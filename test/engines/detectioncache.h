@@ -0,0 +1,370 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/config-manager.h"
+#include "common/fs.h"
+#include "common/memstream.h"
+#include "common/savefile.h"
+
+#include "backends/fs/abstract-fs.h"
+#include "backends/fs/fs-factory.h"
+
+#include "engines/detectioncache.h"
+
+#include "test/testsystem.h"
+
+class DetectionCacheTestSuite : public CxxTest::TestSuite
+{
+private:
+	/** The most MD5 checksums the cache keeps */
+	enum {
+		kMaxMD5Entries = 10000
+	};
+
+	struct Stamp {
+		uint32 size;
+		uint32 time;
+		bool directory;
+	};
+
+	typedef Common::HashMap<Common::String, Stamp> StampMap;
+
+	/**
+	 * A file system which only consists of the stamps of its files, keyed
+	 * by their paths. Stamps can be switched off, as on backends which
+	 * cannot provide them.
+	 */
+	struct TestFS {
+		StampMap files;
+		bool hasStamps;
+
+		TestFS() : hasStamps(true) {}
+
+		void add(const Common::String &path, uint32 size, uint32 time, bool directory = false) {
+			Stamp &stamp = files[path];
+			stamp.size = size;
+			stamp.time = time;
+			stamp.directory = directory;
+		}
+	};
+
+	class TestFSNode : public AbstractFSNode {
+	public:
+		TestFSNode(TestFS *fs, const Common::String &path) : _fs(fs), _path(path) {}
+
+		virtual AbstractFSNode *getChild(const Common::String &name) const {
+			return new TestFSNode(_fs, _path + "/" + name);
+		}
+
+		virtual AbstractFSNode *getParent() const {
+			const char *slash = strrchr(_path.c_str(), '/');
+			if (!slash || slash == _path.c_str())
+				return 0;
+			return new TestFSNode(_fs, Common::String(_path.c_str(), slash));
+		}
+
+		virtual bool exists() const { return _fs->files.contains(_path); }
+
+		virtual bool getChildren(AbstractFSList &list, ListMode mode, bool hidden) const {
+			for (StampMap::const_iterator i = _fs->files.begin(); i != _fs->files.end(); ++i) {
+				TestFSNode *child = new TestFSNode(_fs, i->_key);
+				AbstractFSNode *parent = child->getParent();
+				if (parent && parent->getPath() == _path)
+					list.push_back(child);
+				else
+					delete child;
+				delete parent;
+			}
+			return true;
+		}
+
+		virtual bool getFileStamp(uint32 &size, uint32 &modificationTime) const {
+			StampMap::const_iterator i = _fs->files.find(_path);
+			if (!_fs->hasStamps || i == _fs->files.end())
+				return false;
+			size = i->_value.size;
+			modificationTime = i->_value.time;
+			return true;
+		}
+
+		virtual Common::String getName() const { return lastPathComponent(_path, '/'); }
+		virtual Common::String getPath() const { return _path; }
+		virtual bool isDirectory() const { return exists() && _fs->files[_path].directory; }
+		virtual bool isReadable() const { return true; }
+		virtual bool isWritable() const { return false; }
+		virtual Common::SeekableReadStream *createReadStream() { return 0; }
+		virtual Common::WriteStream *createWriteStream() { return 0; }
+
+	private:
+		TestFS *_fs;
+		Common::String _path;
+	};
+
+	class TestFSFactory : public FilesystemFactory {
+	public:
+		TestFSFactory(TestFS *fs) : _fs(fs) {}
+
+		virtual AbstractFSNode *makeCurrentDirectoryFileNode() const { return makeRootFileNode(); }
+		virtual AbstractFSNode *makeRootFileNode() const { return new TestFSNode(_fs, "/"); }
+		virtual AbstractFSNode *makeFileNodePath(const Common::String &path) const { return new TestFSNode(_fs, path); }
+
+	private:
+		TestFS *_fs;
+	};
+
+	/** Keeps the save files in memory. */
+	class TestSaveFileManager : public Common::SaveFileManager {
+	public:
+		typedef Common::HashMap<Common::String, Common::Array<byte> > FileMap;
+
+		FileMap files;
+
+		virtual Common::OutSaveFile *openForSaving(const Common::String &name) {
+			return new SaveFile(files[name]);
+		}
+
+		virtual Common::InSaveFile *openForLoading(const Common::String &name) {
+			if (!files.contains(name))
+				return 0;
+			const Common::Array<byte> &data = files[name];
+			byte *copy = (byte *)malloc(MAX<uint>(data.size(), 1));
+			for (uint i = 0; i < data.size(); i++)
+				copy[i] = data[i];
+			return new Common::MemoryReadStream(copy, data.size(), DisposeAfterUse::YES);
+		}
+
+		virtual bool removeSavefile(const Common::String &name) {
+			files.erase(name);
+			return true;
+		}
+		virtual Common::StringArray listSavefiles(const Common::String &pattern) { return Common::StringArray(); }
+
+	private:
+		/** Stores its data in the file when deleted. */
+		class SaveFile : public Common::MemoryWriteStreamDynamic {
+		public:
+			SaveFile(Common::Array<byte> &file) : Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES), _file(file) {}
+
+			~SaveFile() {
+				_file.resize(size());
+				for (uint i = 0; i < size(); i++)
+					_file[i] = getData()[i];
+			}
+
+		private:
+			Common::Array<byte> &_file;
+		};
+	};
+
+	class CacheSystem : public TestSystem {
+	public:
+		CacheSystem(TestFS *fs, TestSaveFileManager *saves) : TestSystem(new TestFSFactory(fs)) { _savefileManager = saves; }
+	};
+
+	TestFS *_fs;
+	TestSaveFileManager *_saves;
+	CacheSystem *_system;
+	OSystem *_oldSystem;
+
+	/** Write the cache, and start over with a cache reading it back. */
+	static void reload() {
+		DetectionCache::instance().flush();
+		DetectionCache::destroy();
+	}
+
+	static Common::FSList listGame() {
+		Common::FSList files;
+		Common::FSNode("/game").getChildren(files, Common::FSNode::kListAll);
+		return files;
+	}
+
+	static GameList makeGames() {
+		GameList games;
+		games.push_back(GameDescriptor("monkey", "The Secret of Monkey Island"));
+		return games;
+	}
+
+	bool lookupGames() {
+		GameList games;
+		if (!DetectionCache::instance().lookupGames(listGame(), games))
+			return false;
+		TS_ASSERT_EQUALS(games.size(), 1u);
+		TS_ASSERT_EQUALS(games[0].gameid(), "monkey");
+		TS_ASSERT_EQUALS(games[0].description(), "The Secret of Monkey Island");
+		return true;
+	}
+
+	static bool lookupMD5(const char *path, int32 &size, Common::String &md5) {
+		return DetectionCache::instance().lookupMD5(Common::FSNode(path), 5000, size, md5);
+	}
+
+	static bool hasMD5(const char *path) {
+		int32 size;
+		Common::String md5;
+		return lookupMD5(path, size, md5);
+	}
+
+public:
+	void setUp() {
+		_fs = new TestFS();
+		_fs->add("/game", 0, 100, true);
+		_fs->add("/game/monkey.000", 8357, 200);
+		_fs->add("/game/monkey.001", 123409, 200);
+		_fs->add("/game/sub", 0, 100, true);
+		_fs->add("/game/sub/track1.wav", 5000, 300);
+
+		_saves = new TestSaveFileManager();
+		_oldSystem = g_system;
+		_system = new CacheSystem(_fs, _saves);
+		g_system = _system;
+
+		ConfMan.set("detection_cache", "detection.cache", Common::ConfigManager::kTransientDomain);
+		DetectionCache::destroy();
+	}
+
+	void tearDown() {
+		DetectionCache::destroy();
+		ConfMan.removeKey("detection_cache", Common::ConfigManager::kTransientDomain);
+
+		g_system = _oldSystem;
+		delete _system;
+		delete _fs;
+	}
+
+	void test_md5_round_trip() {
+		DetectionCache::instance().storeMD5(Common::FSNode("/game/monkey.000"), 5000, 8357, "0123456789abcdef0123456789abcdef");
+		reload();
+		TS_ASSERT(_saves->files.contains("detection.cache"));
+
+		int32 size = 0;
+		Common::String md5;
+		TS_ASSERT(lookupMD5("/game/monkey.000", size, md5));
+		TS_ASSERT_EQUALS(size, 8357);
+		TS_ASSERT_EQUALS(md5, "0123456789abcdef0123456789abcdef");
+
+		// Checksums over a different number of bytes are different entries
+		TS_ASSERT(!DetectionCache::instance().lookupMD5(Common::FSNode("/game/monkey.000"), 1024, size, md5));
+		TS_ASSERT(!hasMD5("/game/monkey.001"));
+	}
+
+	void test_md5_changed_file() {
+		DetectionCache::instance().storeMD5(Common::FSNode("/game/monkey.000"), 5000, 8357, "0123456789abcdef0123456789abcdef");
+		reload();
+
+		_fs->add("/game/monkey.000", 8357, 201);
+		TS_ASSERT(!hasMD5("/game/monkey.000"));
+
+		// The outdated checksum is dropped, even if the file changes back
+		reload();
+		_fs->add("/game/monkey.000", 8357, 200);
+		TS_ASSERT(!hasMD5("/game/monkey.000"));
+	}
+
+	void test_md5_pruning() {
+		const int count = kMaxMD5Entries + 10;
+		for (int i = 0; i < count; i++) {
+			const Common::String path = Common::String::format("/game/file%d", i);
+			_fs->add(path, i, 400);
+			DetectionCache::instance().storeMD5(Common::FSNode(path), 5000, i, "0123456789abcdef0123456789abcdef");
+		}
+
+		// Using the first few checksums again keeps them
+		for (int i = 0; i < 5; i++)
+			TS_ASSERT(hasMD5(Common::String::format("/game/file%d", i).c_str()));
+
+		reload();
+		for (int i = 0; i < 5; i++)
+			TS_ASSERT(hasMD5(Common::String::format("/game/file%d", i).c_str()));
+		// The ten used least recently are gone
+		for (int i = 5; i < 15; i++)
+			TS_ASSERT(!hasMD5(Common::String::format("/game/file%d", i).c_str()));
+		TS_ASSERT(hasMD5("/game/file15"));
+		TS_ASSERT(hasMD5(Common::String::format("/game/file%d", count - 1).c_str()));
+	}
+
+	void test_games_round_trip() {
+		DetectionCache::instance().storeGames(listGame(), makeGames());
+		TS_ASSERT(lookupGames());
+
+		reload();
+		TS_ASSERT(lookupGames());
+
+		// Another directory with the same files is not the same game
+		Common::FSList other;
+		Common::FSNode("/game/sub").getChildren(other, Common::FSNode::kListAll);
+		GameList games;
+		TS_ASSERT(!DetectionCache::instance().lookupGames(other, games));
+	}
+
+	void test_fingerprint_invalidation() {
+		DetectionCache::instance().storeGames(listGame(), makeGames());
+		reload();
+
+		// A changed size or time of a file, also within a subdirectory,
+		// and added files all change the fingerprint
+		_fs->add("/game/monkey.001", 123410, 200);
+		TS_ASSERT(!lookupGames());
+		_fs->add("/game/monkey.001", 123409, 200);
+		TS_ASSERT(lookupGames());
+
+		_fs->add("/game/sub/track1.wav", 5000, 301);
+		TS_ASSERT(!lookupGames());
+		_fs->add("/game/sub/track1.wav", 5000, 300);
+		TS_ASSERT(lookupGames());
+
+		_fs->add("/game/monkey.002", 12, 500);
+		TS_ASSERT(!lookupGames());
+	}
+
+	void test_detector_signature() {
+		DetectionCache::instance().setDetectorSignature("engines 1");
+		DetectionCache::instance().storeGames(listGame(), makeGames());
+		DetectionCache::instance().storeMD5(Common::FSNode("/game/monkey.000"), 5000, 8357, "0123456789abcdef0123456789abcdef");
+		reload();
+
+		DetectionCache::instance().setDetectorSignature("engines 1");
+		TS_ASSERT(lookupGames());
+
+		// Other detectors may detect other games, but the checksums still hold
+		DetectionCache::instance().setDetectorSignature("engines 2");
+		TS_ASSERT(!lookupGames());
+		TS_ASSERT(hasMD5("/game/monkey.000"));
+	}
+
+	void test_broken_file() {
+		Common::Array<byte> &file = _saves->files["detection.cache"];
+		for (int i = 0; i < 64; i++)
+			file.push_back(i);
+
+		TS_ASSERT(!lookupGames());
+		TS_ASSERT(!hasMD5("/game/monkey.000"));
+
+		// The broken file is replaced
+		DetectionCache::instance().storeGames(listGame(), makeGames());
+		reload();
+		TS_ASSERT(lookupGames());
+	}
+
+	void test_without_stamps() {
+		_fs->hasStamps = false;
+
+		DetectionCache::instance().storeMD5(Common::FSNode("/game/monkey.000"), 5000, 8357, "0123456789abcdef0123456789abcdef");
+		DetectionCache::instance().storeGames(listGame(), makeGames());
+		DetectionCache::instance().setDetectorSignature("engines 1");
+		TS_ASSERT(!lookupGames());
+		TS_ASSERT(!hasMD5("/game/monkey.000"));
+
+		// The cache is disabled, so it does not even write a file
+		reload();
+		TS_ASSERT(!_saves->files.contains("detection.cache"));
+	}
+
+	void test_disabled() {
+		ConfMan.set("detection_cache", "", Common::ConfigManager::kTransientDomain);
+
+		DetectionCache::instance().storeGames(listGame(), makeGames());
+		TS_ASSERT(!lookupGames());
+		reload();
+		TS_ASSERT(_saves->files.empty());
+	}
+};
@@ -0,0 +1,221 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+#include "common/fs.h"
+
+#include "backends/fs/abstract-fs.h"
+#include "backends/fs/fs-factory.h"
+
+#include "engines/gamescanner.h"
+
+#include "test/deferringworkerpool.h"
+#include "test/testsystem.h"
+
+class GameScannerTestSuite : public CxxTest::TestSuite
+{
+private:
+	/**
+	 * A file or directory of a temporary tree, which is kept in memory:
+	 * this way, directories can be made to fail listing, and the tests need
+	 * no write access to the disk.
+	 */
+	struct Entry {
+		Common::String name;
+		Entry *parent;
+		bool directory;
+		bool failing;
+		Common::Array<Entry *> children;
+
+		Entry(const char *n, Entry *p, bool dir) : name(n), parent(p), directory(dir), failing(false) {
+			if (parent)
+				parent->children.push_back(this);
+		}
+
+		~Entry() {
+			for (uint i = 0; i < children.size(); i++)
+				delete children[i];
+		}
+
+		Common::String getPath() const {
+			if (!parent)
+				return "/";
+			if (!parent->parent)
+				return "/" + name;
+			return parent->getPath() + "/" + name;
+		}
+	};
+
+	class TestFSNode : public AbstractFSNode {
+	public:
+		TestFSNode(Entry *entry) : _entry(entry) {}
+
+		virtual AbstractFSNode *getChild(const Common::String &name) const {
+			for (uint i = 0; i < _entry->children.size(); i++) {
+				if (_entry->children[i]->name == name)
+					return new TestFSNode(_entry->children[i]);
+			}
+			return 0;
+		}
+
+		virtual AbstractFSNode *getParent() const {
+			return _entry->parent ? new TestFSNode(_entry->parent) : 0;
+		}
+
+		virtual bool exists() const { return true; }
+
+		virtual bool getChildren(AbstractFSList &list, ListMode mode, bool hidden) const {
+			if (_entry->failing)
+				return false;
+
+			for (uint i = 0; i < _entry->children.size(); i++) {
+				Entry *child = _entry->children[i];
+				if ((mode == Common::FSNode::kListFilesOnly && child->directory) ||
+				    (mode == Common::FSNode::kListDirectoriesOnly && !child->directory))
+					continue;
+				list.push_back(new TestFSNode(child));
+			}
+			return true;
+		}
+
+		virtual Common::String getName() const { return _entry->name; }
+		virtual Common::String getPath() const { return _entry->getPath(); }
+		virtual bool isDirectory() const { return _entry->directory; }
+		virtual bool isReadable() const { return true; }
+		virtual bool isWritable() const { return false; }
+		virtual Common::SeekableReadStream *createReadStream() { return 0; }
+		virtual Common::WriteStream *createWriteStream() { return 0; }
+
+	private:
+		Entry *_entry;
+	};
+
+	class TestFSFactory : public FilesystemFactory {
+	public:
+		TestFSFactory(Entry *root) : _root(root) {}
+
+		virtual AbstractFSNode *makeCurrentDirectoryFileNode() const { return makeRootFileNode(); }
+		virtual AbstractFSNode *makeRootFileNode() const { return new TestFSNode(_root); }
+
+		virtual AbstractFSNode *makeFileNodePath(const Common::String &path) const {
+			return findEntry(_root, path);
+		}
+
+	private:
+		static AbstractFSNode *findEntry(Entry *entry, const Common::String &path) {
+			if (entry->getPath() == path)
+				return new TestFSNode(entry);
+
+			for (uint i = 0; i < entry->children.size(); i++) {
+				AbstractFSNode *node = findEntry(entry->children[i], path);
+				if (node)
+					return node;
+			}
+			return 0;
+		}
+
+		Entry *_root;
+	};
+
+	Entry *_root;
+	Entry *_failing;
+	TestSystem *_system;
+	OSystem *_oldSystem;
+
+	/** Scan the whole tree and return the paths in the order scanned. */
+	Common::Array<Common::String> scan(bool recursive, Common::WorkerPool *pool, DeferringWorkerPool *deferring) {
+		Common::Array<Common::String> paths;
+		GameScanner scanner(Common::FSNode("/"), recursive, pool);
+
+		while (!scanner.isFinished()) {
+			TS_ASSERT_LESS_THAN_EQUALS(scanner.getListingCount(), scanner.getMaxListingCount());
+			if (deferring)
+				TS_ASSERT_LESS_THAN_EQUALS(deferring->getQueuedCount(), scanner.getMaxListingCount());
+
+			Common::FSNode dir;
+			Common::FSList files;
+			const bool success = scanner.listNextDirectory(dir, files);
+			TS_ASSERT_EQUALS(success, dir.getPath() != _failing->getPath());
+			if (!success)
+				TS_ASSERT(files.empty());
+
+			paths.push_back(dir.getPath());
+		}
+
+		TS_ASSERT_EQUALS(scanner.getScannedCount(), paths.size());
+		TS_ASSERT_EQUALS(scanner.getFoundCount(), paths.size());
+		return paths;
+	}
+
+public:
+	void setUp() {
+		_root = new Entry("", 0, true);
+		Entry *a = new Entry("a", _root, true);
+		Entry *a1 = new Entry("a1", a, true);
+		new Entry("deep", a1, true);
+		_failing = new Entry("a2", a, true);
+		_failing->failing = true;
+		new Entry("hidden", _failing, true);
+		new Entry("file", a, false);
+		Entry *b = new Entry("b", _root, true);
+		new Entry("b1", b, true);
+		new Entry("c", _root, true);
+		new Entry("d", _root, true);
+		new Entry("e", _root, true);
+		new Entry("game.dat", _root, false);
+
+		_oldSystem = g_system;
+		_system = new TestSystem(new TestFSFactory(_root));
+		g_system = _system;
+	}
+
+	void tearDown() {
+		g_system = _oldSystem;
+		delete _system;
+		delete _root;
+	}
+
+	void test_breadth_first() {
+		const char *expected[] = {
+			"/", "/a", "/b", "/c", "/d", "/e",
+			"/a/a1", "/a/a2", "/b/b1", "/a/a1/deep"
+		};
+
+		DeferringWorkerPool pool(2);
+		Common::Array<Common::String> paths = scan(true, &pool, &pool);
+		TS_ASSERT_EQUALS(paths.size(), (uint)ARRAYSIZE(expected));
+		for (uint i = 0; i < MIN<uint>(paths.size(), ARRAYSIZE(expected)); i++)
+			TS_ASSERT_EQUALS(paths[i], expected[i]);
+
+		// Two threads keep up to four listings in flight, and the root
+		// has enough subdirectories to reach that
+		TS_ASSERT_EQUALS(pool.getMaxQueuedCount(), 4u);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 0u);
+	}
+
+	void test_without_pool() {
+		Common::Array<Common::String> paths = scan(true, 0, 0);
+		TS_ASSERT_EQUALS(paths.size(), 10u);
+		TS_ASSERT_EQUALS(paths.back(), "/a/a1/deep");
+	}
+
+	void test_not_recursive() {
+		DeferringWorkerPool pool(2);
+		Common::Array<Common::String> paths = scan(false, &pool, &pool);
+		TS_ASSERT_EQUALS(paths.size(), 1u);
+		TS_ASSERT_EQUALS(pool.getMaxQueuedCount(), 1u);
+	}
+
+	void test_abandoned_scan() {
+		// Stop early: the listings still in flight are waited for
+		DeferringWorkerPool pool(2);
+		{
+			GameScanner scanner(Common::FSNode("/"), true, &pool);
+			Common::FSNode dir;
+			Common::FSList files;
+			TS_ASSERT(scanner.listNextDirectory(dir, files));
+			TS_ASSERT_EQUALS(files.size(), 6u);
+			TS_ASSERT_EQUALS(scanner.getListingCount(), 4u);
+		}
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 0u);
+	}
+};
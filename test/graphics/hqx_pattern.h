@@ -0,0 +1,144 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/scaler.h"
+
+#if defined(USE_HQ_SCALERS) && !defined(USE_NASM)
+
+#include "graphics/scaler/hqx_pattern.h"
+
+class HQPatternTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kWidth = 77,
+		kHeight = 9,
+		kPitch = kWidth + 2
+	};
+
+	uint32 _seed;
+	uint16 _pixels[kPitch * kHeight];
+
+	uint16 nextPixel(const uint16 *palette, int paletteSize) {
+		_seed = _seed * 1103515245 + 12345;
+		return palette[(_seed >> 16) % paletteSize];
+	}
+
+	void fillPixels(const uint16 *palette, int paletteSize) {
+		for (int i = 0; i < kPitch * kHeight; ++i)
+			_pixels[i] = nextPixel(palette, paletteSize);
+	}
+
+	void comparePatterns() {
+		HQPatternProc reference = getHQPatternProc(kHQPatternScalar);
+		TS_ASSERT(reference != 0);
+
+		uint8 expected[kWidth], patterns[kWidth];
+
+		for (int impl = kHQPatternScalar + 1; impl < kHQPatternImplCount; ++impl) {
+			HQPatternProc proc = getHQPatternProc((HQPatternImpl)impl);
+			if (!proc)
+				continue;
+
+			for (int y = 1; y < kHeight - 1; ++y) {
+				const uint16 *row = _pixels + y * kPitch + 1;
+				for (int width = 0; width <= kWidth; ++width) {
+					memset(expected, 0xAA, sizeof(expected));
+					memset(patterns, 0xAA, sizeof(patterns));
+					reference(row, kPitch * 2, width, expected);
+					proc(row, kPitch * 2, width, patterns);
+					TS_ASSERT_EQUALS(memcmp(expected, patterns, sizeof(patterns)), 0);
+				}
+			}
+		}
+	}
+
+public:
+	void setUp() {
+		InitScalers(565);
+		_seed = 1;
+	}
+
+	void tearDown() {
+		DestroyScalers();
+	}
+
+	void test_random_pixels() {
+		// Colors spread over the whole 16 bit range
+		uint16 palette[256];
+		for (int i = 0; i < 256; ++i)
+			palette[i] = (uint16)(i * 257 + 3);
+		fillPixels(palette, 256);
+		comparePatterns();
+	}
+
+	void test_similar_pixels() {
+		// Colors close to each other, so the YUV thresholds matter
+		static const uint16 palette[] = {
+			0x0000, 0x0020, 0x0001, 0x0800, 0x0821, 0x1082, 0x18E3, 0x2104,
+			0xF800, 0xF820, 0xF000, 0x07E0, 0x0FE0, 0x001F, 0x081F, 0xFFFF
+		};
+		fillPixels(palette, ARRAYSIZE(palette));
+		comparePatterns();
+	}
+
+	void test_scalar_pattern() {
+		// A single pixel standing out from a flat area
+		for (int i = 0; i < kPitch * kHeight; ++i)
+			_pixels[i] = 0x0000;
+		_pixels[4 * kPitch + 5] = 0xFFFF;
+
+		uint8 patterns[kWidth];
+		getHQPatternProc(kHQPatternScalar)(_pixels + 4 * kPitch + 1, kPitch * 2, kWidth, patterns);
+		TS_ASSERT_EQUALS(patterns[3], 0x10);
+		TS_ASSERT_EQUALS(patterns[4], 0xFF);
+		TS_ASSERT_EQUALS(patterns[5], 0x08);
+		TS_ASSERT_EQUALS(patterns[6], 0x00);
+
+		getHQPatternProc(kHQPatternScalar)(_pixels + 3 * kPitch + 1, kPitch * 2, kWidth, patterns);
+		TS_ASSERT_EQUALS(patterns[3], 0x80);
+		TS_ASSERT_EQUALS(patterns[4], 0x40);
+		TS_ASSERT_EQUALS(patterns[5], 0x20);
+	}
+
+	void test_wide_rows() {
+		// Rows wider than kHQPatternChunkWidth have their patterns computed
+		// in several parts, which must scale them the same as narrow rects
+		enum {
+			kWideWidth = kHQPatternChunkWidth * 2 + 37,
+			kWidePitch = kWideWidth + 2,
+			kWideHeight = 4,
+			kSlice = 60
+		};
+
+		static const uint16 palette[] = {
+			0x0000, 0x0821, 0x18E3, 0xF800, 0x07E0, 0x001F, 0xFFFF
+		};
+		uint16 *src = new uint16[kWidePitch * (kWideHeight + 2)];
+		for (int i = 0; i < kWidePitch * (kWideHeight + 2); ++i)
+			src[i] = nextPixel(palette, ARRAYSIZE(palette));
+		const uint8 *srcPtr = (const uint8 *)(src + kWidePitch + 1);
+
+		const int dstPitch = kWideWidth * 3 * 2;
+		uint16 *whole = new uint16[kWideWidth * 3 * kWideHeight * 3];
+		uint16 *sliced = new uint16[kWideWidth * 3 * kWideHeight * 3];
+
+		for (int factor = 2; factor <= 3; ++factor) {
+			ScalerProc *scaler = factor == 2 ? HQ2x : HQ3x;
+			memset(whole, 0, dstPitch * kWideHeight * 3);
+			memset(sliced, 0, dstPitch * kWideHeight * 3);
+
+			scaler(srcPtr, kWidePitch * 2, (uint8 *)whole, dstPitch, kWideWidth, kWideHeight);
+			for (int x = 0; x < kWideWidth; x += kSlice) {
+				const int width = MIN<int>(kSlice, kWideWidth - x);
+				scaler(srcPtr + x * 2, kWidePitch * 2, (uint8 *)(sliced + x * factor), dstPitch, width, kWideHeight);
+			}
+
+			TS_ASSERT_EQUALS(memcmp(whole, sliced, dstPitch * kWideHeight * factor), 0);
+		}
+
+		delete[] src;
+		delete[] whole;
+		delete[] sliced;
+	}
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite {
+private:
+	enum {
+		kSize = 256,
+		// Extra destination columns, which must not be touched
+		kGuard = 3
+	};
+
+	uint32 _seed;
+	byte *_y, *_u, *_v;
+
+	byte nextByte() {
+		_seed = _seed * 1103515245 + 12345;
+		return (byte)(_seed >> 16);
+	}
+
+	static Graphics::PixelFormat getFormat(int i) {
+		switch (i) {
+		case 0:
+			return Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);
+		case 1:
+			return Graphics::PixelFormat(2, 5, 5, 5, 0, 10, 5, 0, 0);
+		case 2:
+			return Graphics::PixelFormat(2, 4, 4, 4, 4, 12, 8, 4, 0);
+		case 3:
+			return Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0);
+		case 4:
+			return Graphics::PixelFormat(4, 8, 8, 8, 8, 16, 8, 0, 24);
+		default:
+			return Graphics::PixelFormat(4, 8, 8, 8, 0, 8, 16, 24, 0);
+		}
+	}
+
+	enum {
+		kFormatCount = 6
+	};
+
+	enum Subsampling {
+		k444,
+		k420,
+		k410
+	};
+
+	static void convert(Subsampling subsampling, Graphics::Surface *dst, const byte *y, const byte *u, const byte *v, int width, int height, Graphics::YUVToRGBImpl impl) {
+		switch (subsampling) {
+		case k444:
+			Graphics::convertYUV444ToRGB(dst, y, u, v, width, height, kSize, kSize, impl);
+			break;
+		case k420:
+			Graphics::convertYUV420ToRGB(dst, y, u, v, width, height, kSize, kSize, impl);
+			break;
+		case k410:
+			Graphics::convertYUV410ToRGB(dst, y, u, v, width, height, kSize, kSize, impl);
+			break;
+		}
+	}
+
+	void compareImpls(Subsampling subsampling, int width, int height) {
+		for (int f = 0; f < kFormatCount; ++f) {
+			const Graphics::PixelFormat format = getFormat(f);
+
+			Graphics::Surface expected, actual;
+			expected.create(width + kGuard, height, format);
+			actual.create(width + kGuard, height, format);
+			const uint32 size = expected.pitch * height;
+
+			memset(expected.pixels, 0xAA, size);
+			convert(subsampling, &expected, _y, _u, _v, width, height, Graphics::kYUVToRGBScalar);
+
+			for (int impl = Graphics::kYUVToRGBScalar + 1; impl < Graphics::kYUVToRGBImplCount; ++impl) {
+				if (!Graphics::hasYUVToRGBImpl((Graphics::YUVToRGBImpl)impl))
+					continue;
+
+				memset(actual.pixels, 0xAA, size);
+				convert(subsampling, &actual, _y, _u, _v, width, height, (Graphics::YUVToRGBImpl)impl);
+				TS_ASSERT_EQUALS(memcmp(expected.pixels, actual.pixels, size), 0);
+			}
+
+			expected.free();
+			actual.free();
+		}
+	}
+
+	void fillRandom() {
+		for (int i = 0; i < kSize * (kSize + 1); ++i) {
+			_y[i] = nextByte();
+			_u[i] = nextByte();
+			_v[i] = nextByte();
+		}
+	}
+
+public:
+	void setUp() {
+		_seed = 1;
+		// One extra chroma row, as required by convertYUV410ToRGB()
+		_y = new byte[kSize * (kSize + 1)];
+		_u = new byte[kSize * (kSize + 1)];
+		_v = new byte[kSize * (kSize + 1)];
+	}
+
+	void tearDown() {
+		delete[] _y;
+		delete[] _u;
+		delete[] _v;
+	}
+
+	void test_scalar_available() {
+		TS_ASSERT(Graphics::hasYUVToRGBImpl(Graphics::kYUVToRGBScalar));
+	}
+
+	void test_444_all_chroma() {
+		// Every (u, v) pair, each with several luma values
+		for (int pass = 0; pass < 4; ++pass) {
+			for (int y = 0; y < kSize; ++y) {
+				for (int x = 0; x < kSize; ++x) {
+					_y[y * kSize + x] = (pass < 2) ? (byte)(pass ? 255 : 0) : nextByte();
+					_u[y * kSize + x] = x;
+					_v[y * kSize + x] = y;
+				}
+			}
+
+			compareImpls(k444, kSize, kSize);
+		}
+	}
+
+	void test_444_widths() {
+		fillRandom();
+		for (int width = 1; width <= 40; ++width)
+			compareImpls(k444, width, 3);
+		compareImpls(k444, 253, 7);
+	}
+
+	void test_420() {
+		fillRandom();
+		for (int width = 2; width <= 40; width += 2)
+			compareImpls(k420, width, 4);
+		compareImpls(k420, 250, 64);
+	}
+
+	void test_410() {
+		fillRandom();
+		for (int width = 4; width <= 40; width += 4)
+			compareImpls(k410, width, 4);
+		compareImpls(k410, 252, 64);
+	}
+};
@@ -5,8 +5,12 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/backends/*.h $(srcdir)/test/base/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h $(srcdir)/test/engines/*.h $(srcdir)/test/video/*.h
+TEST_LIBS    := base/libbase.a backends/libbackends.a engines/libengines.a video/libvideo.a audio/libaudio.a graphics/libgraphics.a common/libcommon.a
+
+ifdef USE_MT32EMU
+TEST_LIBS    := audio/softsynth/mt32/libmt32.a $(TEST_LIBS)
+endif
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
@@ -0,0 +1,233 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/surface.h"
+
+#include "video/prefetching_decoder.h"
+
+#include "test/deferringworkerpool.h"
+#include "test/testsystem.h"
+
+class PrefetchingVideoDecoderTestSuite : public CxxTest::TestSuite
+{
+private:
+	enum {
+		kFrameCount = 10,
+		kFrameTime = 40
+	};
+
+	/**
+	 * Decoder of a 4x4 video at 25 fps, whose frames are filled with their
+	 * number.
+	 */
+	class CountingDecoder : public Video::VideoDecoder {
+	public:
+		CountingDecoder() : _loaded(true), _decodedCount(0), _helpingPool(0), _decoding(false), _reentered(false) {
+			_surface.create(4, 4, Graphics::PixelFormat::createFormatCLUT8());
+		}
+
+		~CountingDecoder() { _surface.free(); }
+
+		bool loadStream(Common::SeekableReadStream *stream) { return false; }
+		void close() { reset(); _loaded = false; }
+		bool isVideoLoaded() const { return _loaded; }
+
+		uint16 getWidth() const { return _surface.w; }
+		uint16 getHeight() const { return _surface.h; }
+		Graphics::PixelFormat getPixelFormat() const { return _surface.format; }
+		uint32 getFrameCount() const { return kFrameCount; }
+
+		uint32 getTimeToNextFrame() const {
+			if (endOfVideo() || _curFrame < 0)
+				return 0;
+
+			const int32 due = _startTime + (_curFrame + 1) * kFrameTime - (int32)g_system->getMillis();
+			return due > 0 ? due : 0;
+		}
+
+		const Graphics::Surface *decodeNextFrame() {
+			if (_decoding)
+				_reentered = true;
+			_decoding = true;
+
+			// Like a decoder splitting its work into jobs, on a pool which
+			// runs any queued job while waiting
+			if (_helpingPool)
+				_helpingPool->runJobs();
+
+			if (++_curFrame == 0)
+				_startTime = g_system->getMillis();
+
+			memset(_surface.pixels, _curFrame, _surface.h * _surface.pitch);
+			_decodedCount++;
+			_decoding = false;
+			return &_surface;
+		}
+
+		uint getDecodedCount() const { return _decodedCount; }
+
+		/** Run all jobs queued on the pool while decoding a frame. */
+		void setHelpingPool(DeferringWorkerPool *pool) { _helpingPool = pool; }
+
+		/** Whether decodeNextFrame() was called while it was running. */
+		bool wasReentered() const { return _reentered; }
+
+	private:
+		Graphics::Surface _surface;
+		bool _loaded;
+		uint _decodedCount;
+		DeferringWorkerPool *_helpingPool;
+		bool _decoding;
+		bool _reentered;
+	};
+
+	TestSystem *_system;
+	OSystem *_oldSystem;
+
+	static bool isFrame(const Graphics::Surface *surface, int number) {
+		if (!surface)
+			return false;
+
+		const byte *pixels = (const byte *)surface->pixels;
+		for (int i = 0; i < surface->h * surface->pitch; i++) {
+			if (pixels[i] != number)
+				return false;
+		}
+		return true;
+	}
+
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		_system = new TestSystem();
+		_system->setMillis(1000);
+		g_system = _system;
+	}
+
+	void tearDown() {
+		g_system = _oldSystem;
+		delete _system;
+	}
+
+	void test_pool_prefetch() {
+		DeferringWorkerPool pool;
+		CountingDecoder *decoder = new CountingDecoder();
+		Video::PrefetchingVideoDecoder video(decoder, DisposeAfterUse::YES, &pool, 3);
+
+		// Nothing is decoded until the job runs, which fills the queue
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 1u);
+		TS_ASSERT_EQUALS(decoder->getDecodedCount(), 0u);
+		pool.runJobs();
+		TS_ASSERT_EQUALS(video.getQueueDepth(), 3u);
+		TS_ASSERT_EQUALS(decoder->getDecodedCount(), 3u);
+
+		for (int frame = 0; frame < kFrameCount; frame++) {
+			TS_ASSERT(!video.endOfVideo());
+			TS_ASSERT(isFrame(video.decodeNextFrame(), frame));
+			TS_ASSERT_EQUALS(video.getCurFrame(), frame);
+
+			// Taking a frame queues the job again, unless the video has
+			// been decoded completely
+			TS_ASSERT_EQUALS(pool.getQueuedCount(), frame + 3 < kFrameCount ? 1u : 0u);
+			pool.runJobs();
+			TS_ASSERT_EQUALS(video.getQueueDepth(), (uint)MIN(3, kFrameCount - 1 - frame));
+		}
+
+		TS_ASSERT(video.endOfVideo());
+		TS_ASSERT_EQUALS(video.getUnderrunCount(), 0u);
+		TS_ASSERT_EQUALS(decoder->getDecodedCount(), (uint)kFrameCount);
+	}
+
+	void test_pool_timing() {
+		DeferringWorkerPool pool;
+		Video::PrefetchingVideoDecoder video(new CountingDecoder(), DisposeAfterUse::YES, &pool, 3);
+		pool.runJobs();
+
+		// The frames decoded ahead keep the timing of the wrapped decoder
+		TS_ASSERT_EQUALS(video.getTimeToNextFrame(), 0u);
+		TS_ASSERT(isFrame(video.decodeNextFrame(), 0));
+		TS_ASSERT_EQUALS(video.getTimeToNextFrame(), (uint32)kFrameTime);
+
+		_system->setMillis(1000 + kFrameTime + 10);
+		TS_ASSERT_EQUALS(video.getTimeToNextFrame(), 0u);
+		TS_ASSERT(isFrame(video.decodeNextFrame(), 1));
+		TS_ASSERT_EQUALS(video.getTimeToNextFrame(), (uint32)kFrameTime - 10);
+	}
+
+	void test_pool_underrun() {
+		DeferringWorkerPool pool;
+		Video::PrefetchingVideoDecoder video(new CountingDecoder(), DisposeAfterUse::YES, &pool, 3);
+
+		// The job has not run yet, so the frame is decoded right away
+		TS_ASSERT(isFrame(video.decodeNextFrame(), 0));
+		TS_ASSERT_EQUALS(video.getUnderrunCount(), 1u);
+
+		pool.runJobs();
+		TS_ASSERT(isFrame(video.decodeNextFrame(), 1));
+		TS_ASSERT_EQUALS(video.getUnderrunCount(), 1u);
+	}
+
+	void test_pool_paused() {
+		DeferringWorkerPool pool;
+		Video::PrefetchingVideoDecoder video(new CountingDecoder(), DisposeAfterUse::YES, &pool, 3);
+
+		// No frames are decoded during a pause, since their due times would
+		// be off. The job is queued again at the end of the pause.
+		video.pauseVideo(true);
+		pool.runJobs();
+		TS_ASSERT_EQUALS(video.getQueueDepth(), 0u);
+
+		video.pauseVideo(false);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 1u);
+		pool.runJobs();
+		TS_ASSERT_EQUALS(video.getQueueDepth(), 3u);
+	}
+
+	void test_pool_delete_while_queued() {
+		DeferringWorkerPool pool;
+		Video::PrefetchingVideoDecoder *video = new Video::PrefetchingVideoDecoder(new CountingDecoder(), DisposeAfterUse::YES, &pool, 3);
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 1u);
+
+		// The destructor waits for the job
+		delete video;
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 0u);
+	}
+
+	void test_pool_job_while_decoding() {
+		DeferringWorkerPool pool;
+		CountingDecoder *decoder = new CountingDecoder();
+		decoder->setHelpingPool(&pool);
+		Video::PrefetchingVideoDecoder video(decoder, DisposeAfterUse::YES, &pool, 3);
+
+		// The job runs while the frame is decoded synchronously, but must
+		// not decode a frame in the middle of that
+		TS_ASSERT(isFrame(video.decodeNextFrame(), 0));
+		TS_ASSERT(!decoder->wasReentered());
+		TS_ASSERT_EQUALS(decoder->getDecodedCount(), 1u);
+
+		// It is queued again afterwards
+		TS_ASSERT_EQUALS(pool.getQueuedCount(), 1u);
+		pool.runJobs();
+		TS_ASSERT(!decoder->wasReentered());
+		TS_ASSERT_EQUALS(video.getQueueDepth(), 3u);
+
+		for (int frame = 1; frame < kFrameCount; frame++) {
+			TS_ASSERT(isFrame(video.decodeNextFrame(), frame));
+			pool.runJobs();
+		}
+		TS_ASSERT(video.endOfVideo());
+		TS_ASSERT(!decoder->wasReentered());
+	}
+
+	void test_without_pool() {
+		CountingDecoder *decoder = new CountingDecoder();
+		Video::PrefetchingVideoDecoder video(decoder, DisposeAfterUse::YES, 0, 3);
+
+		for (int frame = 0; frame < kFrameCount; frame++) {
+			TS_ASSERT(isFrame(video.decodeNextFrame(), frame));
+			TS_ASSERT_EQUALS(decoder->getDecodedCount(), (uint)frame + 1);
+		}
+
+		TS_ASSERT(video.endOfVideo());
+		TS_ASSERT_EQUALS(video.getUnderrunCount(), 0u);
+	}
+};
@@ -30,7 +30,6 @@
 #include "common/textconsole.h"
 #include "common/math.h"
 #include "common/stream.h"
-#include "common/substream.h"
 #include "common/file.h"
 #include "common/str.h"
 #include "common/bitstream.h"
@@ -38,6 +37,7 @@
 #include "common/rdft.h"
 #include "common/dct.h"
 #include "common/system.h"
+#include "common/workerpool.h"
 
 #include "graphics/yuv_to_rgb.h"
 #include "graphics/surface.h"
@@ -110,8 +110,12 @@ BinkDecoder::BinkDecoder() {
 	for (int i = 0; i < 4; i++) {
 		_curPlanes[i] = 0;
 		_oldPlanes[i] = 0;
+		_pitches[i]   = 0;
+		_blocks[i]    = 0;
 	}
 
+	_slicesPerPlane = 0;
+
 	_audioStream = 0;
 }
 
@@ -144,8 +148,13 @@ void BinkDecoder::close() {
 	for (int i = 0; i < 4; i++) {
 		delete[] _curPlanes[i]; _curPlanes[i] = 0;
 		delete[] _oldPlanes[i]; _oldPlanes[i] = 0;
+		delete[] _blocks[i];    _blocks[i]    = 0;
 	}
 
+	_planeSlices.clear();
+	_convertSlices.clear();
+	_slicesPerPlane = 0;
+
 	deinitBundles();
 
 	for (int i = 0; i < 16; i++) {
@@ -219,9 +228,12 @@ const Graphics::Surface *BinkDecoder::decodeNextFrame() {
 				//                  Number of samples in bytes
 				audio.sampleCount = _bink->readUint32LE() / (2 * audio.channels);
 
-				audio.bits =
-					new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-					    audioPacketStart + 4, audioPacketEnd), true);
+				uint32 audioDataSize = audioPacketEnd - audioPacketStart - 4;
+				byte *audioData = (byte *)malloc(audioDataSize);
+				_bink->read(audioData, audioDataSize);
+
+				audio.bits = new Common::BitStreamMemory32LELSB(
+					new Common::BitStreamMemoryStream(audioData, audioDataSize, DisposeAfterUse::YES), true);
 
 				audioPacket(audio);
 
@@ -235,12 +247,12 @@ const Graphics::Surface *BinkDecoder::decodeNextFrame() {
 		}
 	}
 
-	uint32 videoPacketStart = _bink->pos();
-	uint32 videoPacketEnd   = _bink->pos() + frameSize;
+	// Read the whole packet, so that the bit reader works on plain memory
+	byte *videoData = (byte *)malloc(frameSize);
+	_bink->read(videoData, frameSize);
 
-	frame.bits =
-		new Common::BitStream32LELSB(new Common::SeekableSubReadStream(_bink,
-		    videoPacketStart, videoPacketEnd), true);
+	frame.bits = new Common::BitStreamMemory32LELSB(
+		new Common::BitStreamMemoryStream(videoData, frameSize, DisposeAfterUse::YES), true);
 
 	videoPacket(frame);
 
@@ -283,11 +295,16 @@ void BinkDecoder::audioPacket(AudioTrack &audio) {
 void BinkDecoder::videoPacket(VideoFrame &video) {
 	assert(video.bits);
 
+	// The bitstream has to be read in order, but drawing a slice of blocks
+	// only needs the blocks themselves and the last frame. So the slices are
+	// drawn in parallel, while the main thread goes on reading the next ones.
+	Common::JobGroup jobs(g_system->getWorkerPool());
+
 	if (_hasAlpha) {
 		if (_id == kBIKiID)
 			video.bits->skip(32);
 
-		decodePlane(video, 3, false);
+		decodePlane(video, 3, false, jobs);
 	}
 
 	if (_id == kBIKiID)
@@ -296,48 +313,53 @@ void BinkDecoder::videoPacket(VideoFrame &video) {
 	for (int i = 0; i < 3; i++) {
 		int planeIdx = ((i == 0) || !_swapPlanes) ? i : (i ^ 3);
 
-		decodePlane(video, planeIdx, i != 0);
+		decodePlane(video, planeIdx, i != 0, jobs);
 
 		if (video.bits->pos() >= video.bits->size())
 			break;
 	}
 
+	jobs.wait();
+
 	// Convert the YUV data we have to our format
 	// We're ignoring alpha for now
 	assert(_curPlanes[0] && _curPlanes[1] && _curPlanes[2]);
-	Graphics::convertYUV420ToRGB(&_surface, _curPlanes[0], _curPlanes[1], _curPlanes[2],
-			_surface.w, _surface.h, _surface.w, _surface.w >> 1);
+	for (uint32 i = 0; i < _convertSlices.size(); i++) {
+		ConvertSlice &slice = _convertSlices[i];
+
+		slice.y = _curPlanes[0] + i * kConvertSliceRows * _pitches[0];
+		slice.u = _curPlanes[1] + i * (kConvertSliceRows >> 1) * _pitches[1];
+		slice.v = _curPlanes[2] + i * (kConvertSliceRows >> 1) * _pitches[2];
+
+		// The first band sets up the RGB lookup table, which must not happen
+		// on several threads at once
+		if (i == 0)
+			convertSlice(&slice);
+		else
+			jobs.add(convertSlice, &slice);
+	}
+
+	jobs.wait();
 
 	// And swap the planes with the reference planes
 	for (int i = 0; i < 4; i++)
 		SWAP(_curPlanes[i], _oldPlanes[i]);
 }
 
-void BinkDecoder::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
+void BinkDecoder::decodePlane(VideoFrame &video, int planeIdx, bool isChroma, Common::JobGroup &jobs) {
 
 	uint32 blockWidth  = isChroma ? ((_surface.w  + 15) >> 4) : ((_surface.w  + 7) >> 3);
 	uint32 blockHeight = isChroma ? ((_surface.h + 15) >> 4) : ((_surface.h + 7) >> 3);
-	uint32 width       = isChroma ?  (_surface.w        >> 1) :   _surface.w;
 	uint32 height      = isChroma ?  (_surface.h       >> 1) :   _surface.h;
 
 	DecodeContext ctx;
 
-	ctx.video     = &video;
-	ctx.planeIdx  = planeIdx;
-	ctx.destStart = _curPlanes[planeIdx];
-	ctx.destEnd   = _curPlanes[planeIdx] + width * height;
-	ctx.prevStart = _oldPlanes[planeIdx];
-	ctx.prevEnd   = _oldPlanes[planeIdx] + width * height;
-	ctx.pitch     = width;
-
-	for (int i = 0; i < 64; i++) {
-		ctx.coordMap[i] = (i & 7) + (i >> 3) * ctx.pitch;
-
-		ctx.coordScaledMap1[i] = ((i & 7) * 2 + 0) + (((i >> 3) * 2 + 0) * ctx.pitch);
-		ctx.coordScaledMap2[i] = ((i & 7) * 2 + 1) + (((i >> 3) * 2 + 0) * ctx.pitch);
-		ctx.coordScaledMap3[i] = ((i & 7) * 2 + 0) + (((i >> 3) * 2 + 1) * ctx.pitch);
-		ctx.coordScaledMap4[i] = ((i & 7) * 2 + 1) + (((i >> 3) * 2 + 1) * ctx.pitch);
-	}
+	ctx.video      = &video;
+	ctx.planeIdx   = planeIdx;
+	ctx.blockWidth = blockWidth;
+	ctx.prevStart  = _oldPlanes[planeIdx];
+	ctx.prevEnd    = _oldPlanes[planeIdx] + _pitches[planeIdx] * height;
+	ctx.pitch      = _pitches[planeIdx];
 
 	for (int i = 0; i < kSourceMAX; i++) {
 		_bundles[i].countLength = _bundles[i].countLengths[isChroma ? 1 : 0];
@@ -345,6 +367,9 @@ void BinkDecoder::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
 		readBundle(video, (Source) i);
 	}
 
+	PlaneSlice *slice = &_planeSlices[planeIdx * _slicesPerPlane];
+	uint32 sliceStart = 0;
+
 	for (ctx.blockY = 0; ctx.blockY < blockHeight; ctx.blockY++) {
 		readBlockTypes  (video, _bundles[kSourceBlockTypes]);
 		readBlockTypes  (video, _bundles[kSourceSubBlockTypes]);
@@ -356,16 +381,20 @@ void BinkDecoder::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
 		readDCS         (video, _bundles[kSourceInterDC], kDCStartBits, true);
 		readRuns        (video, _bundles[kSourceRun]);
 
-		ctx.dest = ctx.destStart + 8 * ctx.blockY * ctx.pitch;
-		ctx.prev = ctx.prevStart + 8 * ctx.blockY * ctx.pitch;
+		ctx.block = _blocks[planeIdx] + ctx.blockY * blockWidth;
+		ctx.prev  = ctx.prevStart + 8 * ctx.blockY * ctx.pitch;
 
-		for (ctx.blockX = 0; ctx.blockX < blockWidth; ctx.blockX++, ctx.dest += 8, ctx.prev += 8) {
+		for (ctx.blockX = 0; ctx.blockX < blockWidth; ctx.blockX++, ctx.block++, ctx.prev += 8) {
 			BlockType blockType = (BlockType) getBundleValue(kSourceBlockTypes);
 
 			// 16x16 block type on odd line means part of the already decoded block, so skip it
 			if ((ctx.blockY & 1) && (blockType == kBlockScaled)) {
+				ctx.block->op = kOpNone;
+				if (ctx.blockX + 1 < blockWidth)
+					ctx.block[1].op = kOpNone;
+
 				ctx.blockX += 1;
-				ctx.dest   += 8;
+				ctx.block  += 1;
 				ctx.prev   += 8;
 				continue;
 			}
@@ -417,6 +446,21 @@ void BinkDecoder::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
 
 		}
 
+		// Hand the slice over for drawing once it is complete
+		if (((ctx.blockY + 1 - sliceStart) == kSliceBlockRows) || ((ctx.blockY + 1) == blockHeight)) {
+			slice->blocks     = _blocks[planeIdx] + sliceStart * blockWidth;
+			slice->blockWidth = blockWidth;
+			slice->blockRows  = ctx.blockY + 1 - sliceStart;
+			slice->dest       = _curPlanes[planeIdx] + 8 * sliceStart * ctx.pitch;
+			slice->prev       = _oldPlanes[planeIdx] + 8 * sliceStart * ctx.pitch;
+			slice->pitch      = ctx.pitch;
+
+			jobs.add(drawSlice, slice);
+
+			slice++;
+			sliceStart = ctx.blockY + 1;
+		}
+
 	}
 
 	if (video.bits->pos() & 0x1F) // next plane data starts at 32-bit boundary
@@ -601,28 +645,47 @@ bool BinkDecoder::loadStream(Common::SeekableReadStream *stream, const Graphics:
 
 	_surface.create(width, height, format);
 
-	// Give the planes a bit extra space
-	width  = _surface.w  + 32;
-	height = _surface.h + 32;
-
-	_curPlanes[0] = new byte[ width       *  height      ]; // Y
-	_curPlanes[1] = new byte[(width >> 1) * (height >> 1)]; // U, 1/4 resolution
-	_curPlanes[2] = new byte[(width >> 1) * (height >> 1)]; // V, 1/4 resolution
-	_curPlanes[3] = new byte[ width       *  height      ]; // A
-	_oldPlanes[0] = new byte[ width       *  height      ]; // Y
-	_oldPlanes[1] = new byte[(width >> 1) * (height >> 1)]; // U, 1/4 resolution
-	_oldPlanes[2] = new byte[(width >> 1) * (height >> 1)]; // V, 1/4 resolution
-	_oldPlanes[3] = new byte[ width       *  height      ]; // A
-
-	// Initialize the video with solid black
-	memset(_curPlanes[0],   0,  width       *  height      );
-	memset(_curPlanes[1],   0, (width >> 1) * (height >> 1));
-	memset(_curPlanes[2],   0, (width >> 1) * (height >> 1));
-	memset(_curPlanes[3], 255,  width       *  height      );
-	memset(_oldPlanes[0],   0,  width       *  height      );
-	memset(_oldPlanes[1],   0, (width >> 1) * (height >> 1));
-	memset(_oldPlanes[2],   0, (width >> 1) * (height >> 1));
-	memset(_oldPlanes[3], 255,  width       *  height      );
+	// The pitches cover all blocks, including a 16x16 one in the last
+	// column. The planes get a bit of extra space below that, too.
+	uint32 blockWidth[2]  = { (uint32)(_surface.w + 7) >> 3, (uint32)(_surface.w + 15) >> 4 };
+	uint32 blockHeight[2] = { (uint32)(_surface.h + 7) >> 3, (uint32)(_surface.h + 15) >> 4 };
+
+	for (int i = 0; i < 4; i++) {
+		const int  type  = ((i == 1) || (i == 2)) ? 1 : 0; // U and V have 1/4 resolution
+		const byte color = (i == 3) ? 255 : 0;             // Solid black, opaque
+
+		if ((i == 3) && !_hasAlpha)
+			continue;
+
+		_pitches[i] = (blockWidth[type] * 8 + 15) & ~15;
+
+		const uint32 size = _pitches[i] * (blockHeight[type] * 8 + 32);
+
+		_curPlanes[i] = new byte[size];
+		_oldPlanes[i] = new byte[size];
+
+		memset(_curPlanes[i], color, size);
+		memset(_oldPlanes[i], color, size);
+
+		_blocks[i] = new Block[blockWidth[type] * blockHeight[type]];
+	}
+
+	_slicesPerPlane = (blockHeight[0] + kSliceBlockRows - 1) / kSliceBlockRows;
+	_planeSlices.resize(4 * _slicesPerPlane);
+
+	_convertSlices.resize((_surface.h + kConvertSliceRows - 1) / kConvertSliceRows);
+	for (uint32 i = 0; i < _convertSlices.size(); i++) {
+		ConvertSlice &slice = _convertSlices[i];
+
+		const uint32 y = i * kConvertSliceRows;
+
+		slice.dst        = _surface;
+		slice.dst.h      = MIN<uint32>(kConvertSliceRows, _surface.h - y);
+		slice.dst.pixels = _surface.getBasePtr(0, y);
+
+		slice.yPitch  = _pitches[0];
+		slice.uvPitch = _pitches[1];
+	}
 
 	initBundles();
 	initHuffman();
@@ -710,8 +773,8 @@ void BinkDecoder::initBundles() {
 		_bundles[i].dataEnd = _bundles[i].data + blocks * 64;
 	}
 
-	uint32 cbw[2] = { (_surface.w + 7) >> 3, (_surface.w  + 15) >> 4 };
-	uint32 cw [2] = {  _surface.w          ,  _surface.w        >> 1 };
+	uint32 cbw[2] = { (uint32)(_surface.w + 7) >> 3, (uint32)(_surface.w  + 15) >> 4 };
+	uint32 cw [2] = { (uint32) _surface.w          , (uint32) _surface.w        >> 1 };
 
 	// Calculate the lengths of an element count in bits
 	for (int i = 0; i < 2; i++) {
@@ -769,115 +832,38 @@ uint32 BinkDecoder::readBundleCount(VideoFrame &video, Bundle &bundle) {
 }
 
 void BinkDecoder::blockSkip(DecodeContext &ctx) {
-	byte *dest = ctx.dest;
-	byte *prev = ctx.prev;
-
-	for (int j = 0; j < 8; j++, dest += ctx.pitch, prev += ctx.pitch)
-		memcpy(dest, prev, 8);
-}
-
-void BinkDecoder::blockScaledSkip(DecodeContext &ctx) {
-	byte *dest = ctx.dest;
-	byte *prev = ctx.prev;
-
-	for (int j = 0; j < 16; j++, dest += ctx.pitch, prev += ctx.pitch)
-		memcpy(dest, prev, 16);
+	ctx.block->op     = kOpCopy;
+	ctx.block->motion = 0;
 }
 
 void BinkDecoder::blockScaledRun(DecodeContext &ctx) {
-	const uint8 *scan = binkPatterns[ctx.video->bits->getBits(4)];
-
-	int i = 0;
-	do {
-		int run = getBundleValue(kSourceRun) + 1;
-
-		i += run;
-		if (i > 64)
-			error("Run went out of bounds");
+	blockRun(ctx);
 
-		if (ctx.video->bits->getBit()) {
-
-			byte v = getBundleValue(kSourceColors);
-			for (int j = 0; j < run; j++, scan++)
-				ctx.dest[ctx.coordScaledMap1[*scan]] =
-				ctx.dest[ctx.coordScaledMap2[*scan]] =
-				ctx.dest[ctx.coordScaledMap3[*scan]] =
-				ctx.dest[ctx.coordScaledMap4[*scan]] = v;
-
-		} else
-			for (int j = 0; j < run; j++, scan++)
-				ctx.dest[ctx.coordScaledMap1[*scan]] =
-				ctx.dest[ctx.coordScaledMap2[*scan]] =
-				ctx.dest[ctx.coordScaledMap3[*scan]] =
-				ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
-
-	} while (i < 63);
-
-	if (i == 63)
-		ctx.dest[ctx.coordScaledMap1[*scan]] =
-		ctx.dest[ctx.coordScaledMap2[*scan]] =
-		ctx.dest[ctx.coordScaledMap3[*scan]] =
-		ctx.dest[ctx.coordScaledMap4[*scan]] = getBundleValue(kSourceColors);
+	ctx.block->op = kOpScaledPixels;
 }
 
 void BinkDecoder::blockScaledIntra(DecodeContext &ctx) {
-	int16 block[64];
-	memset(block, 0, 64 * sizeof(int16));
-
-	block[0] = getBundleValue(kSourceIntraDC);
-
-	readDCTCoeffs(*ctx.video, block, true);
+	blockIntra(ctx);
 
-	IDCT(block);
-
-	int16 *src   = block;
-	byte  *dest1 = ctx.dest;
-	byte  *dest2 = ctx.dest + ctx.pitch;
-	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16, src += 8) {
-
-		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
-			dest1[0] = dest1[1] = dest2[0] = dest2[1] = src[i];
-
-	}
+	ctx.block->op = kOpScaledIntra;
 }
 
 void BinkDecoder::blockScaledFill(DecodeContext &ctx) {
-	byte v = getBundleValue(kSourceColors);
+	blockFill(ctx);
 
-	byte *dest = ctx.dest;
-	for (int i = 0; i < 16; i++, dest += ctx.pitch)
-		memset(dest, v, 16);
+	ctx.block->op = kOpScaledPixels;
 }
 
 void BinkDecoder::blockScaledPattern(DecodeContext &ctx) {
-	byte col[2];
+	blockPattern(ctx);
 
-	for (int i = 0; i < 2; i++)
-		col[i] = getBundleValue(kSourceColors);
-
-	byte *dest1 = ctx.dest;
-	byte *dest2 = ctx.dest + ctx.pitch;
-	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16) {
-		byte v = getBundleValue(kSourcePattern);
-
-		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2, v >>= 1)
-			dest1[0] = dest1[1] = dest2[0] = dest2[1] = col[v & 1];
-	}
+	ctx.block->op = kOpScaledPixels;
 }
 
 void BinkDecoder::blockScaledRaw(DecodeContext &ctx) {
-	byte row[8];
-
-	byte *dest1 = ctx.dest;
-	byte *dest2 = ctx.dest + ctx.pitch;
-	for (int j = 0; j < 8; j++, dest1 += (ctx.pitch << 1) - 16, dest2 += (ctx.pitch << 1) - 16) {
-		memcpy(row, _bundles[kSourceColors].curPtr, 8);
+	blockRaw(ctx);
 
-		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
-			dest1[0] = dest1[1] = dest2[0] = dest2[1] = row[i];
-
-		_bundles[kSourceColors].curPtr += 8;
-	}
+	ctx.block->op = kOpScaledPixels;
 }
 
 void BinkDecoder::blockScaled(DecodeContext &ctx) {
@@ -908,8 +894,11 @@ void BinkDecoder::blockScaled(DecodeContext &ctx) {
 			error("Invalid 16x16 block type: %d", blockType);
 	}
 
+	if (ctx.blockX + 1 < ctx.blockWidth)
+		ctx.block[1].op = kOpNone;
+
 	ctx.blockX += 1;
-	ctx.dest   += 8;
+	ctx.block  += 1;
 	ctx.prev   += 8;
 }
 
@@ -917,17 +906,18 @@ void BinkDecoder::blockMotion(DecodeContext &ctx) {
 	int8 xOff = getBundleValue(kSourceXOff);
 	int8 yOff = getBundleValue(kSourceYOff);
 
-	byte *dest = ctx.dest;
-	byte *prev = ctx.prev + yOff * ((int32) ctx.pitch) + xOff;
+	int32 motion = yOff * ((int32) ctx.pitch) + xOff;
+	byte *prev   = ctx.prev + motion;
 	if ((prev < ctx.prevStart) || (prev > ctx.prevEnd))
 		error("Copy out of bounds (%d | %d)", ctx.blockX * 8 + xOff, ctx.blockY * 8 + yOff);
 
-	for (int j = 0; j < 8; j++, dest += ctx.pitch, prev += ctx.pitch)
-		memcpy(dest, prev, 8);
+	ctx.block->op     = kOpCopy;
+	ctx.block->motion = motion;
 }
 
 void BinkDecoder::blockRun(DecodeContext &ctx) {
 	const uint8 *scan = binkPatterns[ctx.video->bits->getBits(4)];
+	byte *pixels = ctx.block->pixels;
 
 	int i = 0;
 	do {
@@ -941,16 +931,18 @@ void BinkDecoder::blockRun(DecodeContext &ctx) {
 
 			byte v = getBundleValue(kSourceColors);
 			for (int j = 0; j < run; j++)
-				ctx.dest[ctx.coordMap[*scan++]] = v;
+				pixels[*scan++] = v;
 
 		} else
 			for (int j = 0; j < run; j++)
-				ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
+				pixels[*scan++] = getBundleValue(kSourceColors);
 
 	} while (i < 63);
 
 	if (i == 63)
-		ctx.dest[ctx.coordMap[*scan++]] = getBundleValue(kSourceColors);
+		pixels[*scan++] = getBundleValue(kSourceColors);
+
+	ctx.block->op = kOpPixels;
 }
 
 void BinkDecoder::blockResidue(DecodeContext &ctx) {
@@ -958,48 +950,44 @@ void BinkDecoder::blockResidue(DecodeContext &ctx) {
 
 	byte v = ctx.video->bits->getBits(7);
 
-	int16 block[64];
+	int16 *block = ctx.block->coeffs;
 	memset(block, 0, 64 * sizeof(int16));
 
 	readResidue(*ctx.video, block, v);
 
-	byte  *dst = ctx.dest;
-	int16 *src = block;
-	for (int i = 0; i < 8; i++, dst += ctx.pitch, src += 8)
-		for (int j = 0; j < 8; j++)
-			dst[j] += src[j];
+	ctx.block->op = kOpResidue;
 }
 
 void BinkDecoder::blockIntra(DecodeContext &ctx) {
-	int16 block[64];
+	int16 *block = ctx.block->coeffs;
 	memset(block, 0, 64 * sizeof(int16));
 
 	block[0] = getBundleValue(kSourceIntraDC);
 
 	readDCTCoeffs(*ctx.video, block, true);
 
-	IDCTPut(ctx, block);
+	ctx.block->op = kOpIntra;
 }
 
 void BinkDecoder::blockFill(DecodeContext &ctx) {
 	byte v = getBundleValue(kSourceColors);
 
-	byte *dest = ctx.dest;
-	for (int i = 0; i < 8; i++, dest += ctx.pitch)
-		memset(dest, v, 8);
+	memset(ctx.block->pixels, v, 64);
+
+	ctx.block->op = kOpPixels;
 }
 
 void BinkDecoder::blockInter(DecodeContext &ctx) {
 	blockMotion(ctx);
 
-	int16 block[64];
+	int16 *block = ctx.block->coeffs;
 	memset(block, 0, 64 * sizeof(int16));
 
 	block[0] = getBundleValue(kSourceInterDC);
 
 	readDCTCoeffs(*ctx.video, block, false);
 
-	IDCTAdd(ctx, block);
+	ctx.block->op = kOpInter;
 }
 
 void BinkDecoder::blockPattern(DecodeContext &ctx) {
@@ -1008,22 +996,102 @@ void BinkDecoder::blockPattern(DecodeContext &ctx) {
 	for (int i = 0; i < 2; i++)
 		col[i] = getBundleValue(kSourceColors);
 
-	byte *dest = ctx.dest;
-	for (int i = 0; i < 8; i++, dest += ctx.pitch - 8) {
+	byte *dest = ctx.block->pixels;
+	for (int i = 0; i < 8; i++) {
 		byte v = getBundleValue(kSourcePattern);
 
 		for (int j = 0; j < 8; j++, v >>= 1)
 			*dest++ = col[v & 1];
 	}
+
+	ctx.block->op = kOpPixels;
 }
 
 void BinkDecoder::blockRaw(DecodeContext &ctx) {
-	byte *dest = ctx.dest;
-	byte *data = _bundles[kSourceColors].curPtr;
-	for (int i = 0; i < 8; i++, dest += ctx.pitch, data += 8)
-		memcpy(dest, data, 8);
+	memcpy(ctx.block->pixels, _bundles[kSourceColors].curPtr, 64);
 
 	_bundles[kSourceColors].curPtr += 64;
+
+	ctx.block->op = kOpPixels;
+}
+
+void BinkDecoder::drawSlice(void *slice) {
+	PlaneSlice &s = *((PlaneSlice *) slice);
+
+	Block *block = s.blocks;
+	for (uint32 y = 0; y < s.blockRows; y++) {
+		byte *dest = s.dest + 8 * y * s.pitch;
+		byte *prev = s.prev + 8 * y * s.pitch;
+
+		for (uint32 x = 0; x < s.blockWidth; x++, block++, dest += 8, prev += 8)
+			drawBlock(*block, dest, prev, s.pitch);
+	}
+}
+
+static inline void copyBlock(byte *dest, uint32 destPitch, const byte *src, uint32 srcPitch) {
+	for (int j = 0; j < 8; j++, dest += destPitch, src += srcPitch)
+		memcpy(dest, src, 8);
+}
+
+template<typename T>
+static inline void putScaledBlock(byte *dest, const T *src, uint32 pitch) {
+	byte *dest1 = dest;
+	byte *dest2 = dest + pitch;
+	for (int j = 0; j < 8; j++, dest1 += (pitch << 1) - 16, dest2 += (pitch << 1) - 16) {
+
+		for (int i = 0; i < 8; i++, dest1 += 2, dest2 += 2)
+			dest1[0] = dest1[1] = dest2[0] = dest2[1] = *src++;
+
+	}
+}
+
+void BinkDecoder::drawBlock(Block &block, byte *dest, const byte *prev, uint32 pitch) {
+	switch (block.op) {
+		case kOpNone:
+			break;
+
+		case kOpCopy:
+			copyBlock(dest, pitch, prev + block.motion, pitch);
+			break;
+
+		case kOpPixels:
+			copyBlock(dest, pitch, block.pixels, 8);
+			break;
+
+		case kOpScaledPixels:
+			putScaledBlock(dest, block.pixels, pitch);
+			break;
+
+		case kOpIntra:
+			IDCTPut(dest, pitch, block.coeffs);
+			break;
+
+		case kOpScaledIntra:
+			IDCT(block.coeffs);
+			putScaledBlock(dest, block.coeffs, pitch);
+			break;
+
+		case kOpInter:
+			copyBlock(dest, pitch, prev + block.motion, pitch);
+			IDCTAdd(dest, pitch, block.coeffs);
+			break;
+
+		case kOpResidue: {
+			copyBlock(dest, pitch, prev + block.motion, pitch);
+
+			const int16 *src = block.coeffs;
+			for (int i = 0; i < 8; i++, dest += pitch, src += 8)
+				for (int j = 0; j < 8; j++)
+					dest[j] += src[j];
+			break;
+		}
+	}
+}
+
+void BinkDecoder::convertSlice(void *slice) {
+	ConvertSlice &s = *((ConvertSlice *) slice);
+
+	Graphics::convertYUV420ToRGB(&s.dst, s.y, s.u, s.v, s.dst.w, s.dst.h, s.yPitch, s.uvPitch);
 }
 
 void BinkDecoder::readRuns(VideoFrame &video, Bundle &bundle) {
@@ -1627,23 +1695,22 @@ void BinkDecoder::IDCT(int16 *block) {
 	}
 }
 
-void BinkDecoder::IDCTAdd(DecodeContext &ctx, int16 *block) {
+void BinkDecoder::IDCTAdd(byte *dest, uint32 pitch, int16 *block) {
 	int i, j;
 
 	IDCT(block);
-	byte *dest = ctx.dest;
-	for (i = 0; i < 8; i++, dest += ctx.pitch, block += 8)
+	for (i = 0; i < 8; i++, dest += pitch, block += 8)
 		for (j = 0; j < 8; j++)
 			 dest[j] += block[j];
 }
 
-void BinkDecoder::IDCTPut(DecodeContext &ctx, int16 *block) {
+void BinkDecoder::IDCTPut(byte *dest, uint32 pitch, int16 *block) {
 	int i;
 	int16 temp[64];
 	for (i = 0; i < 8; i++)
 		IDCTCol(&temp[i], &block[i]);
 	for (i = 0; i < 8; i++) {
-		IDCT_ROW( (&ctx.dest[i*ctx.pitch]), (&temp[8*i]) );
+		IDCT_ROW( (&dest[i*pitch]), (&temp[8*i]) );
 	}
 }
 
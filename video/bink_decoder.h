@@ -34,6 +34,7 @@
 #include "audio/audiostream.h"
 #include "audio/mixer.h"
 #include "common/array.h"
+#include "common/bitstream.h"
 #include "common/rational.h"
 
 #include "graphics/surface.h"
@@ -42,8 +43,8 @@
 
 namespace Common {
 	class SeekableReadStream;
-	class BitStream;
 	class Huffman;
+	class JobGroup;
 
 	class RDFT;
 	class DCT;
@@ -82,6 +83,11 @@ protected:
 	static const int kAudioChannelsMax  = 2;
 	static const int kAudioBlockSizeMax = (kAudioChannelsMax << 11);
 
+	/** Rows of blocks drawn by one job. Even, so that no 16x16 block is split. */
+	static const uint32 kSliceBlockRows = 8;
+	/** Rows of pixels converted to RGB by one job. */
+	static const uint32 kConvertSliceRows = 64;
+
 	/** IDs for different data types used in Bink video codec. */
 	enum Source {
 		kSourceBlockTypes    = 0, ///< 8x8 block types.
@@ -111,6 +117,49 @@ protected:
 		kBlockRaw           ///< Uncoded 8x8 block.
 	};
 
+	/** How a block is drawn once it has been read. */
+	enum BlockOp {
+		kOpNone = 0,     ///< Nothing to draw, the block is part of a 16x16 block.
+		kOpCopy,         ///< Copy from the last frame.
+		kOpPixels,       ///< Put the pixels.
+		kOpScaledPixels, ///< Put the pixels, scaled to 16x16.
+		kOpIntra,        ///< Put the IDCT of the coefficients.
+		kOpScaledIntra,  ///< Put the IDCT of the coefficients, scaled to 16x16.
+		kOpInter,        ///< Copy from the last frame and add the IDCT of the coefficients.
+		kOpResidue       ///< Copy from the last frame and add the coefficients.
+	};
+
+	/** An 8x8 block which has been read from the bitstream, but not drawn yet. */
+	struct Block {
+		byte  op;     ///< The BlockOp.
+		int32 motion; ///< Offset of the source in the last frame, for copies.
+
+		union {
+			int16 coeffs[64]; ///< DCT coefficients or residue, in raster order.
+			byte  pixels[64]; ///< Pixel values, in raster order.
+		};
+	};
+
+	/** A horizontal slice of a plane, drawn by one job. */
+	struct PlaneSlice {
+		Block *blocks;     ///< The first block of the slice.
+		uint32 blockWidth; ///< Blocks in a row.
+		uint32 blockRows;  ///< Rows of blocks in the slice.
+
+		byte *dest; ///< Top left of the slice in the current frame.
+		byte *prev; ///< Top left of the slice in the last frame.
+
+		uint32 pitch;
+	};
+
+	/** A horizontal band of the output surface, converted to RGB by one job. */
+	struct ConvertSlice {
+		Graphics::Surface dst;
+
+		const byte *y, *u, *v;
+		uint32 yPitch, uvPitch;
+	};
+
 	/** Data structure for decoding and tranlating Huffman'd data. */
 	struct Huffman {
 		int  index;       ///< Index of the Huffman codebook to use.
@@ -150,7 +199,7 @@ protected:
 
 		uint32 sampleCount;
 
-		Common::BitStream *bits;
+		Common::BitStreamMemory32LELSB *bits;
 
 		bool first;
 
@@ -183,7 +232,7 @@ protected:
 		uint32 offset;
 		uint32 size;
 
-		Common::BitStream *bits;
+		Common::BitStreamMemory32LELSB *bits;
 
 		VideoFrame();
 		~VideoFrame();
@@ -197,20 +246,14 @@ protected:
 
 		uint32 blockX;
 		uint32 blockY;
+		uint32 blockWidth;
 
-		byte *dest;
-		byte *prev;
+		Block *block; ///< The block being read.
+		byte  *prev;  ///< Position of the block in the last frame.
 
-		byte *destStart, *destEnd;
 		byte *prevStart, *prevEnd;
 
 		uint32 pitch;
-
-		int coordMap[64];
-		int coordScaledMap1[64];
-		int coordScaledMap2[64];
-		int coordScaledMap3[64];
-		int coordScaledMap4[64];
 	};
 
 	Common::SeekableReadStream *_bink;
@@ -246,6 +289,13 @@ protected:
 
 	byte *_curPlanes[4]; ///< The 4 color planes, YUVA, current frame.
 	byte *_oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
+	uint32 _pitches[4];  ///< Pitches of the 4 color planes.
+
+	Block *_blocks[4]; ///< The blocks of the 4 color planes, waiting to be drawn.
+
+	Common::Array<PlaneSlice>   _planeSlices;   ///< Slices of all planes, _slicesPerPlane each.
+	Common::Array<ConvertSlice> _convertSlices; ///< Bands of the output surface.
+	uint32 _slicesPerPlane;
 
 
 	/** Initialize the bundles. */
@@ -261,8 +311,11 @@ protected:
 	/** Decode a video packet. */
 	virtual void videoPacket(VideoFrame &video);
 
-	/** Decode a plane. */
-	void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
+	/**
+	 * Decode a plane. The blocks are read right away, and drawn by jobs added
+	 * to the group as soon as a slice of them has been read.
+	 */
+	void decodePlane(VideoFrame &video, int planeIdx, bool isChroma, Common::JobGroup &jobs);
 
 	/** Read/Initialize a bundle for decoding a plane. */
 	void readBundle(VideoFrame &video, Source source);
@@ -280,9 +333,8 @@ protected:
 	/** Read a count value out of a bundle. */
 	uint32 readBundleCount(VideoFrame &video, Bundle &bundle);
 
-	// Handle the block types
+	// Read the block types
 	void blockSkip         (DecodeContext &ctx);
-	void blockScaledSkip   (DecodeContext &ctx);
 	void blockScaledRun    (DecodeContext &ctx);
 	void blockScaledIntra  (DecodeContext &ctx);
 	void blockScaledFill   (DecodeContext &ctx);
@@ -323,10 +375,15 @@ protected:
 
 	void floatToInt16Interleave(int16 *dst, const float **src, uint32 length, uint8 channels);
 
+	// Draw the blocks. These only touch the slice, so they may run on any thread.
+	static void drawSlice(void *slice);
+	static void drawBlock(Block &block, byte *dest, const byte *prev, uint32 pitch);
+	static void convertSlice(void *slice);
+
 	// Bink video IDCT
-	void IDCT(int16 *block);
-	void IDCTPut(DecodeContext &ctx, int16 *block);
-	void IDCTAdd(DecodeContext &ctx, int16 *block);
+	static void IDCT(int16 *block);
+	static void IDCTPut(byte *dest, uint32 pitch, int16 *block);
+	static void IDCTAdd(byte *dest, uint32 pitch, int16 *block);
 
 	/** Start playing the audio track */
 	void startAudio();
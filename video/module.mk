@@ -5,6 +5,7 @@ MODULE_OBJS := \
 	coktel_decoder.o \
 	dxa_decoder.o \
 	flic_decoder.o \
+	prefetching_decoder.o \
 	psx_decoder.o \
 	qt_decoder.o \
 	smk_decoder.o \
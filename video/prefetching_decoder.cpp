@@ -0,0 +1,418 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "video/prefetching_decoder.h"
+
+#include "common/atomic.h"
+#include "common/system.h"
+#include "common/textconsole.h"
+#include "common/workerpool.h"
+
+namespace Video {
+
+PrefetchingVideoDecoder::PrefetchingVideoDecoder(VideoDecoder *decoder, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint queueSize) {
+	init(decoder, disposeAfterUse, pool, queueSize);
+}
+
+PrefetchingVideoDecoder::PrefetchingVideoDecoder(RewindableVideoDecoder *decoder, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint queueSize) {
+	init(decoder, disposeAfterUse, pool, queueSize);
+	_rewindable = decoder;
+}
+
+PrefetchingVideoDecoder::PrefetchingVideoDecoder(SeekableVideoDecoder *decoder, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint queueSize) {
+	init(decoder, disposeAfterUse, pool, queueSize);
+	_rewindable = decoder;
+	_seekable = decoder;
+}
+
+void PrefetchingVideoDecoder::init(VideoDecoder *decoder, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint queueSize) {
+	assert(decoder);
+	assert(queueSize > 0);
+
+	_decoder = decoder;
+	_rewindable = 0;
+	_seekable = 0;
+	_disposeDecoder = disposeAfterUse;
+
+	_queueSize = queueSize;
+	_frames = new Frame[queueSize + 1];
+	for (uint i = 0; i <= queueSize; ++i)
+		_frames[i].hasSurface = false;
+	_queueStart = 0;
+	_queueCount = 0;
+
+	_loaded = _decoder->isVideoLoaded();
+	_decoderEnded = _decoder->endOfVideo();
+	_curFrame = _decoder->getCurFrame();
+	_started = _curFrame >= 0;
+	_dropLateFrames = false;
+	memset(_palette, 0, sizeof(_palette));
+	takeDecoderPalette();
+	_underruns = 0;
+	_droppedFrames = 0;
+
+	// Without worker threads, the job would only run when waited for
+	_pool = pool && pool->getThreadCount() > 0 ? pool : 0;
+	_pendingPrefetch = 0;
+	_prefetchQueued = 0;
+	_decoding = false;
+	_prefetchInterrupted = false;
+	requestPrefetch();
+}
+
+PrefetchingVideoDecoder::~PrefetchingVideoDecoder() {
+	if (_pool)
+		_pool->waitForJobs(&_pendingPrefetch);
+
+	for (uint i = 0; i <= _queueSize; ++i)
+		_frames[i].surface.free();
+	delete[] _frames;
+
+	if (_disposeDecoder == DisposeAfterUse::YES)
+		delete _decoder;
+}
+
+bool PrefetchingVideoDecoder::loadStream(Common::SeekableReadStream *stream) {
+	Common::StackLock lock(_decoderMutex);
+
+	const bool result = _decoder->loadStream(stream);
+
+	reset();
+	takeDecoderPalette();
+	flushQueue();
+
+	{
+		Common::StackLock queueLock(_queueMutex);
+		_loaded = _decoder->isVideoLoaded();
+	}
+
+	requestPrefetch();
+	return result;
+}
+
+void PrefetchingVideoDecoder::close() {
+	Common::StackLock lock(_decoderMutex);
+
+	_decoder->close();
+
+	reset();
+	_dirtyPalette = false;
+	flushQueue();
+
+	Common::StackLock queueLock(_queueMutex);
+	_loaded = false;
+}
+
+bool PrefetchingVideoDecoder::isVideoLoaded() const {
+	return _loaded;
+}
+
+// The video's properties do not change while it is being decoded, so these
+// do not need to wait for a decode in progress.
+
+uint16 PrefetchingVideoDecoder::getWidth() const {
+	return _decoder->getWidth();
+}
+
+uint16 PrefetchingVideoDecoder::getHeight() const {
+	return _decoder->getHeight();
+}
+
+Graphics::PixelFormat PrefetchingVideoDecoder::getPixelFormat() const {
+	return _decoder->getPixelFormat();
+}
+
+uint32 PrefetchingVideoDecoder::getFrameCount() const {
+	return _decoder->getFrameCount();
+}
+
+uint32 PrefetchingVideoDecoder::getElapsedTime() const {
+	Common::StackLock lock(_decoderMutex);
+	return _decoder->getElapsedTime();
+}
+
+uint32 PrefetchingVideoDecoder::getTimeToNextFrame() const {
+	{
+		Common::StackLock lock(_queueMutex);
+
+		if (_queueCount > 0) {
+			const uint32 dueTime = _frames[_queueStart].dueTime;
+			const uint32 now = g_system->getMillis();
+			return (int32)(dueTime - now) > 0 ? dueTime - now : 0;
+		}
+
+		if (!_loaded || _decoderEnded)
+			return 0;
+	}
+
+	// Nothing decoded ahead, so the wrapped decoder is at our frame
+	Common::StackLock lock(_decoderMutex);
+	return _decoder->getTimeToNextFrame();
+}
+
+const Graphics::Surface *PrefetchingVideoDecoder::decodeNextFrame() {
+	_dirtyPalette = false;
+
+	_queueMutex.lock();
+	if (_queueCount == 0) {
+		_queueMutex.unlock();
+
+		{
+			Common::StackLock lock(_decoderMutex);
+			decodeFrame();
+		}
+
+		_queueMutex.lock();
+		if (_queueCount == 0) {
+			// The end of the video
+			_queueMutex.unlock();
+			return 0;
+		}
+
+		// Only count it if prefetching was supposed to prevent this
+		if (_pool)
+			_underruns++;
+	}
+
+	Frame *frame = &_frames[_queueStart];
+	_queueStart = (_queueStart + 1) % (_queueSize + 1);
+	_queueCount--;
+
+	if (_dropLateFrames) {
+		const uint32 now = g_system->getMillis();
+
+		// Skip the frame if the next one is due already. A frame without
+		// a surface keeps the previous one on screen, so it can't replace
+		// the skipped one.
+		while (_queueCount > 0) {
+			Frame *next = &_frames[_queueStart];
+			if ((int32)(next->dueTime - now) > 0 || !next->hasSurface)
+				break;
+
+			if (frame->dirtyPalette) {
+				memcpy(_palette, frame->palette, sizeof(_palette));
+				_dirtyPalette = true;
+			}
+
+			frame = next;
+			_queueStart = (_queueStart + 1) % (_queueSize + 1);
+			_queueCount--;
+			_droppedFrames++;
+		}
+	}
+	_queueMutex.unlock();
+
+	// Refill the queue while the engine shows this frame. The job does not
+	// touch the frame, as it is outside the queue now.
+	requestPrefetch();
+
+	if (frame->dirtyPalette) {
+		memcpy(_palette, frame->palette, sizeof(_palette));
+		_dirtyPalette = true;
+	}
+
+	_curFrame = frame->number;
+	return frame->hasSurface ? &frame->surface : 0;
+}
+
+bool PrefetchingVideoDecoder::endOfVideo() const {
+	Common::StackLock lock(_queueMutex);
+	return !_loaded || (_queueCount == 0 && _decoderEnded);
+}
+
+void PrefetchingVideoDecoder::rewind() {
+	if (!_rewindable) {
+		warning("PrefetchingVideoDecoder::rewind(): The video decoder cannot rewind");
+		return;
+	}
+
+	{
+		Common::StackLock lock(_decoderMutex);
+
+		_rewindable->rewind();
+		flushQueue();
+		_curFrame = _decoder->getCurFrame();
+	}
+
+	requestPrefetch();
+}
+
+void PrefetchingVideoDecoder::seekToTime(Audio::Timestamp time) {
+	if (!_seekable) {
+		warning("PrefetchingVideoDecoder::seekToTime(): The video decoder cannot seek");
+		return;
+	}
+
+	{
+		Common::StackLock lock(_decoderMutex);
+
+		_seekable->seekToTime(time);
+		flushQueue();
+		_curFrame = _decoder->getCurFrame();
+	}
+
+	requestPrefetch();
+}
+
+uint32 PrefetchingVideoDecoder::getDuration() const {
+	return _seekable ? _seekable->getDuration() : 0;
+}
+
+uint PrefetchingVideoDecoder::getQueueDepth() const {
+	Common::StackLock lock(_queueMutex);
+	return _queueCount;
+}
+
+void PrefetchingVideoDecoder::requestPrefetch() {
+	if (_pool && canPrefetch() && Common::atomicCompareAndSwap(&_prefetchQueued, 0U, 1U))
+		_pool->addJob(&prefetchJob, this, &_pendingPrefetch);
+}
+
+void PrefetchingVideoDecoder::prefetchJob(void *param) {
+	PrefetchingVideoDecoder *decoder = (PrefetchingVideoDecoder *)param;
+
+	{
+		// A pool may run the job on a thread which waits for other jobs
+		// while decoding a frame, i.e. from inside decodeFrame(). Since the
+		// mutex is recursive, it does not keep the job out then: keep the
+		// job marked as queued, and have decodeFrame() queue it again.
+		Common::StackLock lock(decoder->_decoderMutex);
+		if (decoder->_decoding) {
+			decoder->_prefetchInterrupted = true;
+			return;
+		}
+	}
+
+	do {
+		while (decoder->prefetch())
+			;
+
+		Common::atomicStore(&decoder->_prefetchQueued, 0U);
+
+		// A frame may have been taken after the queue was found full, but
+		// before the job was marked as done. Nobody queued the job then.
+	} while (decoder->canPrefetch() && Common::atomicCompareAndSwap(&decoder->_prefetchQueued, 0U, 1U));
+}
+
+bool PrefetchingVideoDecoder::prefetch() {
+	// The due times of frames decoded during a pause would be off, and
+	// there is no hurry anyway
+	if (isPaused())
+		return false;
+
+	Common::StackLock lock(_decoderMutex);
+	return decodeFrame();
+}
+
+bool PrefetchingVideoDecoder::canPrefetch() const {
+	if (isPaused())
+		return false;
+
+	Common::StackLock lock(_queueMutex);
+	return _loaded && !_decoderEnded && _queueCount < _queueSize;
+}
+
+void PrefetchingVideoDecoder::pauseVideoIntern(bool pause) {
+	Common::StackLock lock(_decoderMutex);
+	_decoder->pauseVideo(pause);
+}
+
+void PrefetchingVideoDecoder::addPauseTime(uint32 ms) {
+	VideoDecoder::addPauseTime(ms);
+
+	// The frames decoded ahead are due later now
+	{
+		Common::StackLock lock(_queueMutex);
+		for (uint i = 0; i < _queueCount; ++i)
+			_frames[(_queueStart + i) % (_queueSize + 1)].dueTime += ms;
+	}
+
+	// This is the end of a pause, so carry on decoding ahead
+	requestPrefetch();
+}
+
+bool PrefetchingVideoDecoder::decodeFrame() {
+	uint index;
+	{
+		Common::StackLock lock(_queueMutex);
+		if (!_loaded || _decoderEnded || _queueCount == _queueSize)
+			return false;
+		index = (_queueStart + _queueCount) % (_queueSize + 1);
+	}
+
+	// Before the first frame the time base of the wrapped decoder is not
+	// set up yet; the first frame is due right away
+	const uint32 now = g_system->getMillis();
+	Frame &frame = _frames[index];
+	frame.dueTime = _started ? now + _decoder->getTimeToNextFrame() : now;
+	_started = true;
+
+	_decoding = true;
+	const Graphics::Surface *surface = _decoder->decodeNextFrame();
+	_decoding = false;
+
+	if (_prefetchInterrupted) {
+		_prefetchInterrupted = false;
+		_pool->addJob(&prefetchJob, this, &_pendingPrefetch);
+	}
+
+	frame.number = _decoder->getCurFrame();
+	frame.hasSurface = surface != 0;
+	if (surface) {
+		if (frame.surface.w != surface->w || frame.surface.h != surface->h || frame.surface.format != surface->format) {
+			frame.surface.free();
+			frame.surface.create(surface->w, surface->h, surface->format);
+		}
+
+		const uint rowSize = surface->w * surface->format.bytesPerPixel;
+		for (int y = 0; y < surface->h; ++y)
+			memcpy(frame.surface.getBasePtr(0, y), surface->getBasePtr(0, y), rowSize);
+	}
+
+	frame.dirtyPalette = _decoder->hasDirtyPalette();
+	if (frame.dirtyPalette)
+		memcpy(frame.palette, _decoder->getPalette(), sizeof(frame.palette));
+
+	Common::StackLock lock(_queueMutex);
+	_queueCount++;
+	_decoderEnded = _decoder->endOfVideo();
+	return true;
+}
+
+void PrefetchingVideoDecoder::takeDecoderPalette() {
+	// Loading a video may set up a palette before the first frame
+	_dirtyPalette = _decoder->hasDirtyPalette();
+	if (_dirtyPalette)
+		memcpy(_palette, _decoder->getPalette(), sizeof(_palette));
+}
+
+void PrefetchingVideoDecoder::flushQueue() {
+	Common::StackLock lock(_queueMutex);
+	_queueCount = 0;
+	_decoderEnded = !_decoder->isVideoLoaded() || _decoder->endOfVideo();
+
+	// The next frame comes from the wrapped decoder's new position, whose
+	// timing is valid once it has decoded a frame
+	_started = _decoder->getCurFrame() >= 0;
+}
+
+} // End of namespace Video
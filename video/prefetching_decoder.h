@@ -0,0 +1,218 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef VIDEO_PREFETCHING_DECODER_H
+#define VIDEO_PREFETCHING_DECODER_H
+
+#include "common/mutex.h"
+#include "common/types.h"
+
+#include "graphics/pixelformat.h"
+#include "graphics/surface.h"
+
+#include "video/video_decoder.h"
+
+namespace Common {
+class WorkerPool;
+}
+
+namespace Video {
+
+/**
+ * A VideoDecoder which decodes the frames of another decoder ahead of
+ * time, so that decodeNextFrame() usually only has to hand out a frame
+ * which is already there. This moves the work of decoding Bink, Smacker,
+ * QuickTime, AVI, ... videos off the engine's main loop.
+ *
+ * The frames are decoded by a job on a worker pool into a set of surfaces,
+ * which is reused for the whole video. The job is queued whenever there is
+ * room in the queue and runs until the queue is full. Without a pool, with
+ * a pool without threads, or when the queue ran dry, the frames are decoded
+ * synchronously like without the wrapper.
+ * The wrapped decoder has to follow the rules for WorkerPool jobs while
+ * decoding: it may read the clock and queue audio on the mixer, but must
+ * not use any other part of OSystem.
+ *
+ * The time a frame is due is taken from the wrapped decoder's
+ * getTimeToNextFrame() while decoding it, so that getTimeToNextFrame() and
+ * needsUpdate() behave like those of the wrapped decoder.
+ *
+ * Seeking and rewinding are passed on to the wrapped decoder if it
+ * supports them, and drop all frames decoded ahead.
+ *
+ * The wrapped decoder must not be used otherwise while the wrapper exists.
+ */
+class PrefetchingVideoDecoder : public SeekableVideoDecoder {
+public:
+	/**
+	 * Create a wrapper for the given decoder.
+	 *
+	 * @param decoder          the decoder to decode ahead
+	 * @param disposeAfterUse  whether to delete the decoder along with the wrapper
+	 * @param pool             the worker pool to decode on, usually
+	 *                         g_system->getWorkerPool(), or 0
+	 * @param queueSize        how many frames to decode ahead at most
+	 */
+	PrefetchingVideoDecoder(VideoDecoder *decoder, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint queueSize = 4);
+	PrefetchingVideoDecoder(RewindableVideoDecoder *decoder, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint queueSize = 4);
+	PrefetchingVideoDecoder(SeekableVideoDecoder *decoder, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint queueSize = 4);
+	virtual ~PrefetchingVideoDecoder();
+
+	bool loadStream(Common::SeekableReadStream *stream);
+	void close();
+	bool isVideoLoaded() const;
+
+	uint16 getWidth() const;
+	uint16 getHeight() const;
+	Graphics::PixelFormat getPixelFormat() const;
+
+	const byte *getPalette() { _dirtyPalette = false; return _palette; }
+	bool hasDirtyPalette() const { return _dirtyPalette; }
+
+	uint32 getFrameCount() const;
+	uint32 getElapsedTime() const;
+	uint32 getTimeToNextFrame() const;
+	const Graphics::Surface *decodeNextFrame();
+	bool endOfVideo() const;
+
+	/** Whether the wrapped decoder supports rewind() */
+	bool isRewindable() const { return _rewindable != 0; }
+	/** Whether the wrapped decoder supports seekToTime() and getDuration() */
+	bool isSeekable() const { return _seekable != 0; }
+
+	void rewind();
+	void seekToTime(Audio::Timestamp time);
+	uint32 getDuration() const;
+
+	/**
+	 * When enabled, decodeNextFrame() skips frames which are already
+	 * overdue because the next one is due as well. This lets a slow engine
+	 * catch up with the audio instead of showing every frame late. Off by
+	 * default.
+	 */
+	void setDropLateFrames(bool drop) { _dropLateFrames = drop; }
+
+	/** Return the number of frames which are decoded and waiting. */
+	uint getQueueDepth() const;
+
+	/** Return the maximum number of frames decoded ahead. */
+	uint getQueueSize() const { return _queueSize; }
+
+	/**
+	 * Return how often decodeNextFrame() had to decode synchronously,
+	 * because no frame was decoded ahead.
+	 */
+	uint32 getUnderrunCount() const { return _underruns; }
+
+	/** Return the number of frames skipped because of setDropLateFrames(). */
+	uint32 getDroppedFrameCount() const { return _droppedFrames; }
+
+protected:
+	void pauseVideoIntern(bool pause);
+	void addPauseTime(uint32 ms);
+
+private:
+	struct Frame {
+		Graphics::Surface surface;
+		bool hasSurface;
+		bool dirtyPalette;
+		byte palette[256 * 3];
+		int32 number;
+		/** getMillis() time at which the frame is due */
+		uint32 dueTime;
+	};
+
+	void init(VideoDecoder *decoder, DisposeAfterUse::Flag disposeAfterUse, Common::WorkerPool *pool, uint queueSize);
+
+	/** Queue the job decoding ahead, unless it is queued already. */
+	void requestPrefetch();
+
+	/** The job decoding ahead, until the queue is full. */
+	static void prefetchJob(void *param);
+
+	/** Decode one frame ahead if there is room in the queue. */
+	bool prefetch();
+
+	/** Return whether prefetch() would decode a frame. */
+	bool canPrefetch() const;
+
+	/**
+	 * Decode the next frame into the queue, if there is room. Must be
+	 * called with _decoderMutex locked.
+	 */
+	bool decodeFrame();
+
+	/** Take over a pending palette change of the wrapped decoder. */
+	void takeDecoderPalette();
+
+	/** Drop all frames decoded ahead. Must be called with _decoderMutex locked. */
+	void flushQueue();
+
+	VideoDecoder *_decoder;
+	RewindableVideoDecoder *_rewindable;
+	SeekableVideoDecoder *_seekable;
+	DisposeAfterUse::Flag _disposeDecoder;
+
+	/** Serializes all accesses to _decoder */
+	mutable Common::Mutex _decoderMutex;
+	/** Protects the queue positions, which the engine and the job both use */
+	mutable Common::Mutex _queueMutex;
+
+	/** The pool decoding ahead, or 0 if everything is decoded synchronously */
+	Common::WorkerPool *_pool;
+	/** The number of jobs on the pool, which is waited for on destruction */
+	int32 _pendingPrefetch;
+	/** Whether the job is queued or running */
+	volatile uint32 _prefetchQueued;
+	/** Whether decodeFrame() is running. Protected by _decoderMutex. */
+	bool _decoding;
+	/**
+	 * Whether the job ran from inside decodeFrame() and has to be queued
+	 * again. Protected by _decoderMutex.
+	 */
+	bool _prefetchInterrupted;
+
+	/**
+	 * The frames are a ring of _queueSize + 1 entries: the queue starts at
+	 * _queueStart and holds _queueCount frames. The entry just before the
+	 * queue is the frame last returned by decodeNextFrame().
+	 */
+	Frame *_frames;
+	uint _queueSize;
+	uint _queueStart;
+	uint _queueCount;
+
+	bool _loaded;
+	bool _decoderEnded;
+	bool _started;
+	bool _dropLateFrames;
+
+	byte _palette[256 * 3];
+	bool _dirtyPalette;
+
+	uint32 _underruns;
+	uint32 _droppedFrames;
+};
+
+} // End of namespace Video
+
+#endif